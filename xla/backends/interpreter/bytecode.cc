@@ -0,0 +1,474 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/backends/interpreter/bytecode.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/layout_util.h"
+#include "xla/literal.h"
+#include "xla/shape.h"
+#include "xla/shape_util.h"
+#include "xla/status_macros.h"
+#include "xla/util.h"
+#include "xla/xla_data.pb.h"
+#include "tsl/platform/errors.h"
+
+namespace xla {
+namespace interpreter {
+namespace {
+
+// Elementwise operations, with the same semantics as in HloEvaluator.
+struct NegateOp {
+  template <typename T>
+  static T Apply(T x) {
+    return -x;
+  }
+};
+struct AbsOp {
+  template <typename T>
+  static T Apply(T x) {
+    return std::abs(x);
+  }
+};
+struct ExpOp {
+  template <typename T>
+  static T Apply(T x) {
+    return std::exp(x);
+  }
+};
+struct LogOp {
+  template <typename T>
+  static T Apply(T x) {
+    return std::log(x);
+  }
+};
+struct SqrtOp {
+  template <typename T>
+  static T Apply(T x) {
+    return std::sqrt(x);
+  }
+};
+struct TanhOp {
+  template <typename T>
+  static T Apply(T x) {
+    return std::tanh(x);
+  }
+};
+struct CopyOp {
+  template <typename T>
+  static T Apply(T x) {
+    return x;
+  }
+};
+struct AddOp {
+  template <typename T>
+  static T Apply(T x, T y) {
+    return x + y;
+  }
+};
+struct SubtractOp {
+  template <typename T>
+  static T Apply(T x, T y) {
+    return x - y;
+  }
+};
+struct MultiplyOp {
+  template <typename T>
+  static T Apply(T x, T y) {
+    return x * y;
+  }
+};
+struct DivideOp {
+  template <typename T>
+  static T Apply(T x, T y) {
+    return x / y;
+  }
+};
+// Maximum and minimum propagate NaNs.
+struct MaximumOp {
+  template <typename T>
+  static T Apply(T x, T y) {
+    if (std::isnan(x)) {
+      return x;
+    }
+    if (std::isnan(y)) {
+      return y;
+    }
+    return std::max(x, y);
+  }
+};
+struct MinimumOp {
+  template <typename T>
+  static T Apply(T x, T y) {
+    if (std::isnan(x)) {
+      return x;
+    }
+    if (std::isnan(y)) {
+      return y;
+    }
+    return std::min(x, y);
+  }
+};
+
+template <typename T, typename Op>
+void UnaryKernel(const BytecodeInstruction& instruction, void* const* slots) {
+  T* out = static_cast<T*>(slots[instruction.result]);
+  const T* in = static_cast<const T*>(slots[instruction.operands[0]]);
+  for (int64_t i = 0; i < instruction.num_elements; ++i) {
+    out[i] = Op::Apply(in[i]);
+  }
+}
+
+template <typename T, typename Op>
+void BinaryKernel(const BytecodeInstruction& instruction, void* const* slots) {
+  T* out = static_cast<T*>(slots[instruction.result]);
+  const T* lhs = static_cast<const T*>(slots[instruction.operands[0]]);
+  const T* rhs = static_cast<const T*>(slots[instruction.operands[1]]);
+  for (int64_t i = 0; i < instruction.num_elements; ++i) {
+    out[i] = Op::Apply(lhs[i], rhs[i]);
+  }
+}
+
+template <typename T>
+void SelectKernel(const BytecodeInstruction& instruction, void* const* slots) {
+  T* out = static_cast<T*>(slots[instruction.result]);
+  const bool* pred = static_cast<const bool*>(slots[instruction.operands[0]]);
+  const T* on_true = static_cast<const T*>(slots[instruction.operands[1]]);
+  const T* on_false = static_cast<const T*>(slots[instruction.operands[2]]);
+  for (int64_t i = 0; i < instruction.num_elements; ++i) {
+    out[i] = pred[i] ? on_true[i] : on_false[i];
+  }
+}
+
+template <typename T>
+void BroadcastKernel(const BytecodeInstruction& instruction,
+                     void* const* slots) {
+  T* out = static_cast<T*>(slots[instruction.result]);
+  const T value = *static_cast<const T*>(slots[instruction.operands[0]]);
+  std::fill(out, out + instruction.num_elements, value);
+}
+
+template <typename Op>
+BytecodeKernel GetUnaryKernel(PrimitiveType type) {
+  switch (type) {
+    case F32:
+      return &UnaryKernel<float, Op>;
+    case F64:
+      return &UnaryKernel<double, Op>;
+    default:
+      return nullptr;
+  }
+}
+
+template <typename Op>
+BytecodeKernel GetBinaryKernel(PrimitiveType type) {
+  switch (type) {
+    case F32:
+      return &BinaryKernel<float, Op>;
+    case F64:
+      return &BinaryKernel<double, Op>;
+    default:
+      return nullptr;
+  }
+}
+
+BytecodeKernel GetSelectKernel(PrimitiveType type) {
+  switch (type) {
+    case F32:
+      return &SelectKernel<float>;
+    case F64:
+      return &SelectKernel<double>;
+    default:
+      return nullptr;
+  }
+}
+
+BytecodeKernel GetBroadcastKernel(PrimitiveType type) {
+  switch (type) {
+    case F32:
+      return &BroadcastKernel<float>;
+    case F64:
+      return &BroadcastKernel<double>;
+    default:
+      return nullptr;
+  }
+}
+
+// Returns the kernel computing `instruction`, or nullptr if there is none.
+BytecodeKernel GetKernel(const HloInstruction& instruction) {
+  const PrimitiveType type = instruction.shape().element_type();
+  switch (instruction.opcode()) {
+    case HloOpcode::kNegate:
+      return GetUnaryKernel<NegateOp>(type);
+    case HloOpcode::kAbs:
+      return GetUnaryKernel<AbsOp>(type);
+    case HloOpcode::kExp:
+      return GetUnaryKernel<ExpOp>(type);
+    case HloOpcode::kLog:
+      return GetUnaryKernel<LogOp>(type);
+    case HloOpcode::kSqrt:
+      return GetUnaryKernel<SqrtOp>(type);
+    case HloOpcode::kTanh:
+      return GetUnaryKernel<TanhOp>(type);
+    case HloOpcode::kCopy:
+      return GetUnaryKernel<CopyOp>(type);
+    case HloOpcode::kAdd:
+      return GetBinaryKernel<AddOp>(type);
+    case HloOpcode::kSubtract:
+      return GetBinaryKernel<SubtractOp>(type);
+    case HloOpcode::kMultiply:
+      return GetBinaryKernel<MultiplyOp>(type);
+    case HloOpcode::kDivide:
+      return GetBinaryKernel<DivideOp>(type);
+    case HloOpcode::kMaximum:
+      return GetBinaryKernel<MaximumOp>(type);
+    case HloOpcode::kMinimum:
+      return GetBinaryKernel<MinimumOp>(type);
+    case HloOpcode::kSelect:
+      return GetSelectKernel(type);
+    case HloOpcode::kBroadcast:
+      return GetBroadcastKernel(type);
+    default:
+      return nullptr;
+  }
+}
+
+// Returns true if values of `shape` can be held in a slot.
+bool IsSupportedArray(const Shape& shape) {
+  return shape.IsArray() && shape.is_static() && LayoutUtil::HasLayout(shape) &&
+         LayoutUtil::IsDenseArray(shape) &&
+         (shape.element_type() == F32 || shape.element_type() == F64 ||
+          shape.element_type() == PRED);
+}
+
+// Returns true if elements of `a` and `b` are laid out identically, so that
+// elementwise operations can work on the linear index.
+bool HaveSameLayout(const Shape& a, const Shape& b) {
+  return ShapeUtil::SameDimensions(a, b) &&
+         a.layout().minor_to_major() == b.layout().minor_to_major();
+}
+
+absl::Status CheckOperands(const HloInstruction& instruction) {
+  const Shape& shape = instruction.shape();
+  for (int64_t i = 0; i < instruction.operand_count(); ++i) {
+    const Shape& operand_shape = instruction.operand(i)->shape();
+    if (!IsSupportedArray(operand_shape)) {
+      return Unimplemented("Unsupported operand shape %s in %s",
+                           ShapeUtil::HumanStringWithLayout(operand_shape),
+                           instruction.name());
+    }
+    if (instruction.opcode() == HloOpcode::kBroadcast) {
+      if (!ShapeUtil::IsScalar(operand_shape)) {
+        return Unimplemented("Only scalar broadcasts are supported: %s",
+                             instruction.name());
+      }
+    } else if (!HaveSameLayout(operand_shape, shape)) {
+      return Unimplemented("Operand layouts of %s differ from its result",
+                           instruction.name());
+    }
+    const PrimitiveType expected_type =
+        instruction.opcode() == HloOpcode::kSelect && i == 0
+            ? PRED
+            : shape.element_type();
+    if (operand_shape.element_type() != expected_type) {
+      return Unimplemented("Unexpected operand type in %s", instruction.name());
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+/*static*/ absl::StatusOr<std::unique_ptr<BytecodeProgram>>
+BytecodeProgram::Compile(const HloComputation& computation) {
+  auto program = absl::WrapUnique(new BytecodeProgram());
+  const std::vector<HloInstruction*> post_order =
+      computation.MakeInstructionPostOrder();
+  const HloInstruction* root = computation.root_instruction();
+
+  // Values in the result keep their buffer until the end of the program.
+  std::vector<const HloInstruction*> outputs;
+  if (root->opcode() == HloOpcode::kTuple) {
+    outputs.assign(root->operands().begin(), root->operands().end());
+  } else {
+    outputs.push_back(root);
+  }
+  absl::flat_hash_set<const HloInstruction*> live_out(outputs.begin(),
+                                                      outputs.end());
+
+  absl::flat_hash_map<const HloInstruction*, int64_t> last_use;
+  for (int64_t i = 0; i < post_order.size(); ++i) {
+    for (const HloInstruction* operand : post_order[i]->operands()) {
+      last_use[operand] = i;
+    }
+  }
+
+  // Intermediate values get a buffer, which is returned to `free_buffers`
+  // (keyed by byte size) after their last use.
+  absl::flat_hash_map<const HloInstruction*, int32_t> slots;
+  absl::flat_hash_map<int32_t, int64_t> slot_buffers;
+  absl::flat_hash_map<int64_t, std::vector<int64_t>> free_buffers;
+  absl::flat_hash_set<const HloInstruction*> released;
+  auto add_slot = [&](const HloInstruction* instruction, void* data) {
+    int32_t slot = program->slots_.size();
+    program->slots_.push_back(data);
+    slots[instruction] = slot;
+    return slot;
+  };
+  auto release = [&](const HloInstruction* instruction) {
+    auto it = slot_buffers.find(slots.at(instruction));
+    if (it == slot_buffers.end() || live_out.contains(instruction) ||
+        !released.insert(instruction).second) {
+      return;
+    }
+    free_buffers[ShapeUtil::ByteSizeOf(instruction->shape())].push_back(
+        it->second);
+  };
+
+  for (int64_t i = 0; i < post_order.size(); ++i) {
+    const HloInstruction* instruction = post_order[i];
+    if (instruction == root && root->opcode() == HloOpcode::kTuple) {
+      continue;
+    }
+    const Shape& shape = instruction->shape();
+    if (!IsSupportedArray(shape)) {
+      return Unimplemented("Unsupported shape %s of %s",
+                           ShapeUtil::HumanStringWithLayout(shape),
+                           instruction->name());
+    }
+    switch (instruction->opcode()) {
+      case HloOpcode::kParameter:
+        program->parameters_.push_back(
+            {instruction->parameter_number(),
+             add_slot(instruction, nullptr), shape});
+        continue;
+      case HloOpcode::kConstant:
+        add_slot(instruction,
+                 const_cast<void*>(instruction->literal().untyped_data()));
+        continue;
+      default:
+        break;
+    }
+
+    BytecodeKernel kernel = GetKernel(*instruction);
+    if (kernel == nullptr) {
+      return Unimplemented("No bytecode for %s", instruction->ToString());
+    }
+    TF_RETURN_IF_ERROR(CheckOperands(*instruction));
+
+    BytecodeInstruction bytecode{kernel, ShapeUtil::ElementsIn(shape),
+                                 /*result=*/-1, /*operands=*/{-1, -1, -1}};
+    TF_RET_CHECK(instruction->operand_count() <=
+                 static_cast<int64_t>(bytecode.operands.size()));
+    for (int64_t j = 0; j < instruction->operand_count(); ++j) {
+      bytecode.operands[j] = slots.at(instruction->operand(j));
+    }
+    // Release operands before assigning the result, so that the result can
+    // reuse the buffer of an operand; kernels read every element of their
+    // operands before writing the same element of their result.
+    for (const HloInstruction* operand : instruction->unique_operands()) {
+      if (last_use.at(operand) == i) {
+        release(operand);
+      }
+    }
+
+    int64_t buffer;
+    std::vector<int64_t>& free = free_buffers[ShapeUtil::ByteSizeOf(shape)];
+    if (!free.empty()) {
+      buffer = free.back();
+      free.pop_back();
+    } else {
+      buffer = program->buffers_.size();
+      program->buffers_.push_back(Literal(shape));
+    }
+    bytecode.result = add_slot(instruction, nullptr);
+    slot_buffers[bytecode.result] = buffer;
+    program->instructions_.push_back(bytecode);
+
+    if (!last_use.contains(instruction)) {
+      release(instruction);
+    }
+  }
+
+  // Buffers do not move anymore, so their data pointers can be recorded.
+  for (const auto& [slot, buffer] : slot_buffers) {
+    program->slots_[slot] = program->buffers_[buffer].untyped_data();
+  }
+
+  program->result_shape_ = root->shape();
+  for (const HloInstruction* output : outputs) {
+    program->result_slots_.push_back(slots.at(output));
+  }
+  return program;
+}
+
+absl::StatusOr<Literal> BytecodeProgram::Execute(
+    absl::Span<const Literal> arguments) {
+  // Arguments whose layout differs from the parameter are relaid out first.
+  // Reserve so that the data of these literals does not move.
+  std::vector<Literal> relaid_out_arguments;
+  relaid_out_arguments.reserve(parameters_.size());
+  for (const Parameter& parameter : parameters_) {
+    TF_RET_CHECK(parameter.number < arguments.size());
+    const Literal& argument = arguments[parameter.number];
+    const Shape& shape = argument.shape();
+    if (!shape.IsArray() || !shape.is_static() ||
+        !ShapeUtil::SameElementType(shape, parameter.shape) ||
+        !ShapeUtil::SameDimensions(shape, parameter.shape)) {
+      return InvalidArgument(
+          "Argument %d has shape %s, expected %s", parameter.number,
+          ShapeUtil::HumanString(shape),
+          ShapeUtil::HumanString(parameter.shape));
+    }
+    if (shape.has_layout() && HaveSameLayout(shape, parameter.shape)) {
+      slots_[parameter.slot] = const_cast<void*>(argument.untyped_data());
+    } else {
+      relaid_out_arguments.push_back(
+          argument.Relayout(parameter.shape.layout()));
+      slots_[parameter.slot] = relaid_out_arguments.back().untyped_data();
+    }
+  }
+
+  void* const* slots = slots_.data();
+  for (const BytecodeInstruction& instruction : instructions_) {
+    instruction.kernel(instruction, slots);
+  }
+
+  Literal result(result_shape_);
+  int64_t output = 0;
+  ShapeUtil::ForEachLeafShape(
+      result_shape_, [&](const Shape& subshape, const ShapeIndex& index) {
+        std::memcpy(result.untyped_data(index),
+                    slots_[result_slots_[output++]], result.size_bytes(index));
+      });
+  return result;
+}
+
+}  // namespace interpreter
+}  // namespace xla
@@ -0,0 +1,105 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_BACKENDS_INTERPRETER_BYTECODE_H_
+#define XLA_BACKENDS_INTERPRETER_BYTECODE_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/literal.h"
+#include "xla/shape.h"
+
+namespace xla {
+namespace interpreter {
+
+struct BytecodeInstruction;
+
+// Computes one instruction. `slots` holds a data pointer for every value.
+using BytecodeKernel = void (*)(const BytecodeInstruction& instruction,
+                                void* const* slots);
+
+// One step of a BytecodeProgram. Operands and the result are slot indices;
+// unused operands are -1.
+struct BytecodeInstruction {
+  BytecodeKernel kernel;
+  int64_t num_elements;
+  int32_t result;
+  std::array<int32_t, 3> operands;
+};
+
+// A computation lowered to a flat sequence of typed kernels over buffers that
+// are assigned once, when the program is compiled.
+//
+// Compiling resolves the opcode and element type of every instruction to a
+// kernel function, and assigns every intermediate value a buffer. Buffers are
+// reused once the last user of a value has run, and are kept across calls, so
+// executing a program performs no per-instruction dispatch on the HLO graph
+// and no allocation other than for the result.
+//
+// Only elementwise arithmetic on dense f32 and f64 arrays with matching
+// layouts, scalar broadcasts, parameters and constants are supported; Compile
+// returns an Unimplemented error for anything else, in which case callers
+// should evaluate the computation with HloEvaluator instead.
+class BytecodeProgram {
+ public:
+  // Lowers `computation`, which must outlive the returned program.
+  static absl::StatusOr<std::unique_ptr<BytecodeProgram>> Compile(
+      const HloComputation& computation);
+
+  // Runs the program on `arguments`, which are indexed by parameter number.
+  //
+  // This is not thread-safe: intermediate buffers are owned by the program.
+  absl::StatusOr<Literal> Execute(absl::Span<const Literal> arguments);
+
+  int64_t num_instructions() const { return instructions_.size(); }
+
+  // Returns the number of intermediate buffers, which may be smaller than the
+  // number of instructions thanks to buffer reuse.
+  int64_t num_buffers() const { return buffers_.size(); }
+
+ private:
+  struct Parameter {
+    int64_t number;
+    int32_t slot;
+    Shape shape;
+  };
+
+  BytecodeProgram() = default;
+
+  std::vector<BytecodeInstruction> instructions_;
+  std::vector<Parameter> parameters_;
+  std::vector<Literal> buffers_;
+
+  // Data pointers indexed by slot. Slots of intermediate values point into
+  // buffers_, and slots of constants point into the constant literals of the
+  // computation; parameter slots are set by every call to Execute.
+  std::vector<void*> slots_;
+
+  Shape result_shape_;
+  // The slot of every array in the result, in ShapeUtil::ForEachLeafShape
+  // order.
+  std::vector<int32_t> result_slots_;
+};
+
+}  // namespace interpreter
+}  // namespace xla
+
+#endif  // XLA_BACKENDS_INTERPRETER_BYTECODE_H_
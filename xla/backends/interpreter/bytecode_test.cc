@@ -0,0 +1,199 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/backends/interpreter/bytecode.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "xla/hlo/evaluator/hlo_evaluator.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/layout_util.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/service/hlo_parser.h"
+#include "xla/tests/hlo_test_base.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace interpreter {
+namespace {
+
+class BytecodeProgramTest : public HloTestBase {
+ protected:
+  // Checks that running `module` as bytecode gives the same result as the
+  // evaluator, twice in a row to exercise buffer reuse across calls.
+  void RunAndCompareWithEvaluator(const HloModule& module,
+                                  absl::Span<const Literal> arguments) {
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<BytecodeProgram> program,
+        BytecodeProgram::Compile(*module.entry_computation()));
+    HloEvaluator evaluator;
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal expected,
+        evaluator.Evaluate(*module.entry_computation(), arguments));
+    for (int i = 0; i < 2; ++i) {
+      TF_ASSERT_OK_AND_ASSIGN(Literal actual, program->Execute(arguments));
+      EXPECT_EQ(actual, expected);
+    }
+  }
+};
+
+TEST_F(BytecodeProgramTest, ElementwiseOps) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+
+    ENTRY e {
+      x = f32[2,3] parameter(0)
+      y = f32[2,3] parameter(1)
+      p = pred[2,3] parameter(2)
+      c = f32[2,3] constant({{1, 2, 3}, {4, 5, 6}})
+      half = f32[] constant(0.5)
+      b = f32[2,3] broadcast(half), dimensions={}
+      add = f32[2,3] add(x, y)
+      mul = f32[2,3] multiply(add, c)
+      sub = f32[2,3] subtract(mul, b)
+      div = f32[2,3] divide(sub, c)
+      neg = f32[2,3] negate(div)
+      abs = f32[2,3] abs(neg)
+      exp = f32[2,3] exponential(abs)
+      log = f32[2,3] log(exp)
+      sqrt = f32[2,3] sqrt(log)
+      tanh = f32[2,3] tanh(sqrt)
+      max = f32[2,3] maximum(tanh, x)
+      min = f32[2,3] minimum(max, y)
+      ROOT select = f32[2,3] select(p, min, sub)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  std::vector<Literal> arguments;
+  arguments.push_back(LiteralUtil::CreateR2<float>({{1, -2, 3}, {-4, 5, -6}}));
+  arguments.push_back(LiteralUtil::CreateR2<float>({{6, 5, 4}, {3, 2, 1}}));
+  arguments.push_back(LiteralUtil::CreateR2<bool>(
+      {{true, false, true}, {false, true, false}}));
+  RunAndCompareWithEvaluator(*module, arguments);
+}
+
+TEST_F(BytecodeProgramTest, ReusesBuffers) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+
+    ENTRY e {
+      x = f64[1024] parameter(0)
+      a = f64[1024] add(x, x)
+      b = f64[1024] multiply(a, x)
+      c = f64[1024] negate(b)
+      d = f64[1024] add(c, x)
+      e = f64[1024] multiply(d, d)
+      ROOT t = (f64[1024], f64[1024]) tuple(e, a)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BytecodeProgram> program,
+      BytecodeProgram::Compile(*module->entry_computation()));
+  EXPECT_EQ(program->num_instructions(), 5);
+  // `a` is part of the result, and every other value is dead once the next
+  // one is computed.
+  EXPECT_EQ(program->num_buffers(), 2);
+
+  std::vector<Literal> arguments;
+  arguments.push_back(
+      LiteralUtil::CreateR1<double>(std::vector<double>(1024, 3.0)));
+  RunAndCompareWithEvaluator(*module, arguments);
+}
+
+TEST_F(BytecodeProgramTest, RelaysOutArguments) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+
+    ENTRY e {
+      x = f32[2,2]{1,0} parameter(0)
+      ROOT add = f32[2,2]{1,0} add(x, x)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<BytecodeProgram> program,
+      BytecodeProgram::Compile(*module->entry_computation()));
+  Literal argument = LiteralUtil::CreateR2WithLayout<float>(
+      {{1, 2}, {3, 4}}, LayoutUtil::MakeLayout({0, 1}));
+  TF_ASSERT_OK_AND_ASSIGN(Literal result, program->Execute({&argument, 1}));
+  EXPECT_EQ(result, LiteralUtil::CreateR2<float>({{2, 4}, {6, 8}}));
+}
+
+TEST_F(BytecodeProgramTest, UnsupportedOpsAreRejected) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+
+    ENTRY e {
+      x = f32[2,3] parameter(0)
+      ROOT t = f32[3,2] transpose(x), dimensions={1,0}
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  EXPECT_EQ(BytecodeProgram::Compile(*module->entry_computation())
+                .status()
+                .code(),
+            absl::StatusCode::kUnimplemented);
+}
+
+// Returns a module with `num_ops` small elementwise ops.
+std::string MakeSmallOpChain(int64_t num_ops) {
+  std::string hlo = R"(
+    HloModule m
+
+    ENTRY e {
+      x = f32[16] parameter(0)
+      v0 = f32[16] add(x, x)
+)";
+  for (int64_t i = 1; i < num_ops; ++i) {
+    absl::StrAppend(&hlo, "      v", i, " = f32[16] ",
+                    i % 2 == 0 ? "add" : "multiply", "(v", i - 1, ", x)\n");
+  }
+  absl::StrAppend(&hlo, "      ROOT r = f32[16] negate(v", num_ops - 1,
+                  ")\n    }\n");
+  return hlo;
+}
+
+void BM_SmallOpChain(::testing::benchmark::State& state) {
+  const bool use_bytecode = state.range(0) != 0;
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(MakeSmallOpChain(256)).value();
+  Literal argument = LiteralUtil::CreateR1<float>(std::vector<float>(16, 1));
+  std::unique_ptr<BytecodeProgram> program =
+      BytecodeProgram::Compile(*module->entry_computation()).value();
+  HloEvaluator evaluator;
+  for (auto s : state) {
+    if (use_bytecode) {
+      CHECK_OK(program->Execute({&argument, 1}).status());
+    } else {
+      evaluator.ResetVisitStates();
+      CHECK_OK(evaluator.Evaluate(*module->entry_computation(), {&argument})
+                   .status());
+    }
+  }
+}
+
+BENCHMARK(BM_SmallOpChain)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace interpreter
+}  // namespace xla
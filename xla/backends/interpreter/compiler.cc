@@ -24,6 +24,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "xla/backends/interpreter/bytecode.h"
 #include "xla/backends/interpreter/executable.h"
 #include "xla/backends/interpreter/platform_id.h"
 #include "xla/hlo/evaluator/hlo_evaluator.h"
@@ -137,11 +138,25 @@ absl::StatusOr<std::unique_ptr<Executable>> InterpreterCompiler::RunBackend(
       hlo_module->config().debug_options().xla_hlo_evaluator_use_fast_path());
   evaluator->set_custom_call_handler(HandleEvaluatorCustomCall);
 
+  // Lower the entry computation to bytecode if requested. Computations that
+  // cannot be lowered are run with the evaluator.
+  std::unique_ptr<BytecodeProgram> program;
+  if (hlo_module->config().debug_options().xla_interpreter_use_bytecode()) {
+    absl::StatusOr<std::unique_ptr<BytecodeProgram>> compiled =
+        BytecodeProgram::Compile(*hlo_module->entry_computation());
+    if (compiled.ok()) {
+      program = *std::move(compiled);
+    } else {
+      VLOG(1) << "Falling back to HloEvaluator for " << hlo_module->name()
+              << ": " << compiled.status();
+    }
+  }
+
   // Create executable from only the Hlo module.
   std::unique_ptr<Executable> executable =
       std::make_unique<InterpreterExecutable>(
           std::move(hlo_module), std::move(evaluator),
-          std::move(dynamic_dimension_inference));
+          std::move(dynamic_dimension_inference), std::move(program));
 
   return std::move(executable);
 }
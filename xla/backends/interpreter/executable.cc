@@ -25,6 +25,7 @@ limitations under the License.
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "xla/backends/interpreter/bytecode.h"
 #include "xla/backends/interpreter/executable_base.h"
 #include "xla/hlo/evaluator/hlo_evaluator.h"
 #include "xla/hlo/ir/hlo_computation.h"
@@ -42,9 +43,11 @@ namespace interpreter {
 InterpreterExecutable::InterpreterExecutable(
     std::unique_ptr<HloModule> hlo_module,
     std::unique_ptr<HloEvaluator> evaluator,
-    std::optional<DynamicDimensionInference> dynamic_dymension_inference)
+    std::optional<DynamicDimensionInference> dynamic_dymension_inference,
+    std::unique_ptr<BytecodeProgram> program)
     : InterpreterExecutableBase(std::move(hlo_module)),
       evaluator_(std::move(evaluator)),
+      program_(std::move(program)),
       dynamic_dimension_inference_(std::move(dynamic_dymension_inference)) {
   if (dynamic_dimension_inference_.has_value()) {
     evaluator_->set_dynamic_dimension_inference(
@@ -55,8 +58,11 @@ InterpreterExecutable::InterpreterExecutable(
 absl::StatusOr<Literal> InterpreterExecutable::Evaluate(
     const ServiceExecutableRunOptions* run_options,
     const HloComputation& computation, absl::Span<const Literal> arg_literals) {
-  // Execute the graph using the HloEvaluator.
   absl::MutexLock lock(&evaluator_lock_);
+  if (program_ != nullptr && &computation == module().entry_computation()) {
+    return program_->Execute(arg_literals);
+  }
+  // Execute the graph using the HloEvaluator.
   evaluator_->ResetVisitStates();
   return evaluator_->Evaluate(computation, arg_literals);
 }
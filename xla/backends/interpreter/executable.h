@@ -17,11 +17,13 @@ limitations under the License.
 #define XLA_BACKENDS_INTERPRETER_EXECUTABLE_H_
 
 #include <memory>
+#include <optional>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "xla/backends/interpreter/bytecode.h"
 #include "xla/backends/interpreter/executable_base.h"
 #include "xla/hlo/evaluator/hlo_evaluator.h"
 #include "xla/hlo/ir/hlo_computation.h"
@@ -49,7 +51,8 @@ class InterpreterExecutable : public InterpreterExecutableBase {
   InterpreterExecutable(
       std::unique_ptr<HloModule> hlo_module,
       std::unique_ptr<HloEvaluator> evaluator,
-      std::optional<DynamicDimensionInference> dynamic_dymension_inference);
+      std::optional<DynamicDimensionInference> dynamic_dymension_inference,
+      std::unique_ptr<BytecodeProgram> program = nullptr);
 
   static int64_t ShapeSizeBytes(const Shape& shape);
 
@@ -64,6 +67,10 @@ class InterpreterExecutable : public InterpreterExecutableBase {
   std::unique_ptr<HloEvaluator> evaluator_ ABSL_PT_GUARDED_BY(evaluator_lock_);
   mutable absl::Mutex evaluator_lock_;
 
+  // If set, the entry computation is run with this program instead of the
+  // evaluator.
+  std::unique_ptr<BytecodeProgram> program_ ABSL_PT_GUARDED_BY(evaluator_lock_);
+
  private:
   std::optional<DynamicDimensionInference> dynamic_dimension_inference_;
   InterpreterExecutable(const InterpreterExecutable&) = delete;
@@ -72,6 +72,7 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
   opts.set_xla_dump_include_timestamp(false);
   opts.set_xla_dump_max_hlo_modules(-1);
   opts.set_xla_dump_module_metadata(false);
+  opts.set_xla_dump_compile_profile(false);
   opts.set_xla_dump_hlo_as_long_text(false);
   opts.set_xla_dump_large_constants(false);
   opts.set_xla_dump_enable_mlir_pretty_form(true);
@@ -281,6 +282,8 @@ DebugOptions DefaultDebugOptionsIgnoringFlags() {
 
   opts.set_xla_enable_command_buffers_during_profiling(false);
 
+  opts.set_xla_interpreter_use_bytecode(false);
+
   return opts;
 }
 
@@ -983,6 +986,13 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
       debug_options->xla_dump_module_metadata(),
       "Dumps HloModuleMetadata as text protos to the directory specified "
       "by --xla_dump_to."));
+  flag_list->push_back(tsl::Flag(
+      "xla_dump_compile_profile",
+      bool_setter_for(&DebugOptions::set_xla_dump_compile_profile),
+      debug_options->xla_dump_compile_profile(),
+      "Dumps the time, peak memory growth and change in HLO size of every HLO "
+      "pass, as a tree of pipelines, to compile_profile.json in the directory "
+      "specified by --xla_dump_to."));
   flag_list->push_back(
       tsl::Flag("xla_dump_compress_protos",
                 bool_setter_for(&DebugOptions::set_xla_dump_compress_protos),
@@ -1834,6 +1844,13 @@ void MakeDebugOptionsFlags(std::vector<tsl::Flag>* flag_list,
       "Experimental: Enable command buffers while a profiling active. "
       "By default, enabling profiling switches from command buffers to "
       "op-by-op mode."));
+  flag_list->push_back(tsl::Flag(
+      "xla_interpreter_use_bytecode",
+      bool_setter_for(&DebugOptions::set_xla_interpreter_use_bytecode),
+      debug_options->xla_interpreter_use_bytecode(),
+      "Lower the entry computation to bytecode over preassigned buffers when "
+      "compiling for the interpreter backend. Computations with unsupported "
+      "ops are run with the HLO evaluator."));
 }  // NOLINT(readability/fn_size)
 
 // Allocates flag_values and flag_objects; this function must not be called more
@@ -86,6 +86,7 @@ limitations under the License.
 #include "tsl/platform/logging.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -1155,6 +1156,25 @@ DimensionVector HloEvaluator::MakeDimMultipliers(const Shape& shape) {
   return v;
 }
 
+bool HloEvaluator::HaveSameDenseLayout(
+    const Literal& result, absl::Span<const Literal* const> operands) {
+  const Shape& shape = result.shape();
+  if (!LayoutUtil::IsDenseArray(shape) || !shape.is_static()) {
+    return false;
+  }
+  for (const Literal* operand : operands) {
+    const Shape& operand_shape = operand->shape();
+    if (!LayoutUtil::IsDenseArray(operand_shape) ||
+        !operand_shape.is_static() ||
+        !ShapeUtil::SameDimensions(shape, operand_shape) ||
+        LayoutUtil::MinorToMajor(shape) !=
+            LayoutUtil::MinorToMajor(operand_shape)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 absl::Status HloEvaluator::EvaluateInternal(
     const HloInstruction* instruction, const ShapeIndex& shape_index,
     bool recursively_evaluate_nonconstant_operands) {
@@ -4653,69 +4673,107 @@ namespace {
 template <typename T>
 std::unique_ptr<Array2D<T>> MatmulArray2DImpl(
     const Array2D<T>& lhs, const Array2D<T>& rhs,
+    tsl::thread::ThreadPool* thread_pool,
     const std::function<void(const void* run_options_ptr, T* out, T* lhs,
                              T* rhs, int64_t m, int64_t n, int64_t k,
                              int32_t transpose_lhs, int32_t transpose_rhs)>&
         impl_fn) {
   CHECK_EQ(lhs.width(), rhs.height());
-  int m = lhs.height();
-  int n = rhs.width();
-  int k = lhs.width();
+  int64_t m = lhs.height();
+  int64_t n = rhs.width();
+  int64_t k = lhs.width();
   auto result = std::make_unique<Array2D<T>>(m, n);
-  // Because Eigen is a header-oriented library, make sure that the Eigen code
-  // is the same as the code used by the CPU backend (otherwise the linker will
-  // randomly pick *some* definition).
-  impl_fn(
-      /*run_options_ptr=*/nullptr, result->data(), rhs.data(), lhs.data(), n, m,
-      k,
-      /*transpose_lhs=*/0,
-      /*transpose_rhs=*/0);
+  if (thread_pool == nullptr) {
+    // Because Eigen is a header-oriented library, make sure that the Eigen
+    // code is the same as the code used by the CPU backend (otherwise the
+    // linker will randomly pick *some* definition).
+    impl_fn(
+        /*run_options_ptr=*/nullptr, result->data(), rhs.data(), lhs.data(), n,
+        m, k,
+        /*transpose_lhs=*/0,
+        /*transpose_rhs=*/0);
+    return result;
+  }
+  if (m == 0) {
+    return result;
+  }
+  // With a thread pool, the result is computed in fixed blocks of rows, so
+  // that the result does not depend on the number of threads.
+  constexpr int64_t kRowsPerBlock = 256;
+  const int64_t num_blocks = CeilOfRatio(m, kRowsPerBlock);
+  auto compute_blocks = [&](int64_t begin, int64_t end) {
+    for (int64_t block = begin; block < end; ++block) {
+      int64_t row = block * kRowsPerBlock;
+      int64_t rows = std::min(kRowsPerBlock, m - row);
+      // The runtime works on column-major matrices, so the row-major result
+      // block is computed as the transposed product rhs^T x lhs_block^T.
+      impl_fn(
+          /*run_options_ptr=*/nullptr, result->data() + row * n, rhs.data(),
+          lhs.data() + row * k, n, rows, k,
+          /*transpose_lhs=*/0,
+          /*transpose_rhs=*/0);
+    }
+  };
+  if (num_blocks == 1) {
+    compute_blocks(0, num_blocks);
+  } else {
+    thread_pool->ParallelFor(num_blocks,
+                             /*cost_per_unit=*/kRowsPerBlock * n * k,
+                             compute_blocks);
+  }
   return result;
 }
 }  // namespace
 
 std::unique_ptr<Array2D<Eigen::half>> HloEvaluator::MatmulArray2D(
-    const Array2D<Eigen::half>& lhs, const Array2D<Eigen::half>& rhs) {
+    const Array2D<Eigen::half>& lhs, const Array2D<Eigen::half>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<Eigen::half>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulF16);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulF16);
 }
 
 std::unique_ptr<Array2D<float>> HloEvaluator::MatmulArray2D(
-    const Array2D<float>& lhs, const Array2D<float>& rhs) {
+    const Array2D<float>& lhs, const Array2D<float>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<float>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulF32);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulF32);
 }
 
 std::unique_ptr<Array2D<double>> HloEvaluator::MatmulArray2D(
-    const Array2D<double>& lhs, const Array2D<double>& rhs) {
+    const Array2D<double>& lhs, const Array2D<double>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<double>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulF64);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulF64);
 }
 
 std::unique_ptr<Array2D<std::complex<float>>> HloEvaluator::MatmulArray2D(
     const Array2D<std::complex<float>>& lhs,
-    const Array2D<std::complex<float>>& rhs) {
+    const Array2D<std::complex<float>>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<std::complex<float>>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulC64);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulC64);
 }
 
 std::unique_ptr<Array2D<std::complex<double>>> HloEvaluator::MatmulArray2D(
     const Array2D<std::complex<double>>& lhs,
-    const Array2D<std::complex<double>>& rhs) {
+    const Array2D<std::complex<double>>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<std::complex<double>>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulC128);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulC128);
 }
 
 std::unique_ptr<Array2D<int32_t>> HloEvaluator::MatmulArray2D(
-    const Array2D<int32_t>& lhs, const Array2D<int32_t>& rhs) {
+    const Array2D<int32_t>& lhs, const Array2D<int32_t>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<int32_t>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulS32);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulS32);
 }
 
 std::unique_ptr<Array2D<uint8_t>> HloEvaluator::MatmulArray2D(
-    const Array2D<uint8_t>& lhs, const Array2D<uint8_t>& rhs) {
+    const Array2D<uint8_t>& lhs, const Array2D<uint8_t>& rhs,
+    tsl::thread::ThreadPool* thread_pool) {
   return MatmulArray2DImpl<uint8_t>(
-      lhs, rhs, __xla_cpu_runtime_EigenSingleThreadedMatMulU8);
+      lhs, rhs, thread_pool, __xla_cpu_runtime_EigenSingleThreadedMatMulU8);
 }
 
 }  // namespace xla
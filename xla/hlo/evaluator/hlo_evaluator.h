@@ -29,6 +29,7 @@ limitations under the License.
 #include "tsl/platform/errors.h"
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -52,6 +53,7 @@ limitations under the License.
 #include "xla/shape_util.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -220,6 +222,17 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
   // Use fast path that doesn't use embedded evaluators in reduce.
   void set_reduce_use_fast_path(bool value) { use_fast_path_reduce_ = value; }
 
+  // Runs expensive operations on `thread_pool`, which must outlive the
+  // evaluator. This also enables the Eigen fast path for f32 and f64 dots.
+  // Work is divided into blocks that depend only on the shapes involved, so
+  // results do not depend on the number of threads in the pool.
+  //
+  // The pool is not handed to embedded evaluators, which may themselves run on
+  // threads of the pool.
+  void set_thread_pool(tsl::thread::ThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+
   // Handles evaluation of a custom-call op.
   // Operand literals are provided in |operands| and implementations must
   // populate |output| before returning.
@@ -244,23 +257,32 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
     trace_mac_handler_ = std::move(handler);
   }
 
-  // Returns the result of a matrix multiply `lhs x rhs`.
+  // Returns the result of a matrix multiply `lhs x rhs`. If `thread_pool` is
+  // not null, fixed blocks of rows of the result are computed in parallel on
+  // it.
   static std::unique_ptr<Array2D<Eigen::half>> MatmulArray2D(
-      const Array2D<Eigen::half>& lhs, const Array2D<Eigen::half>& rhs);
+      const Array2D<Eigen::half>& lhs, const Array2D<Eigen::half>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
   static std::unique_ptr<Array2D<float>> MatmulArray2D(
-      const Array2D<float>& lhs, const Array2D<float>& rhs);
+      const Array2D<float>& lhs, const Array2D<float>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
   static std::unique_ptr<Array2D<double>> MatmulArray2D(
-      const Array2D<double>& lhs, const Array2D<double>& rhs);
+      const Array2D<double>& lhs, const Array2D<double>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
   static std::unique_ptr<Array2D<std::complex<float>>> MatmulArray2D(
       const Array2D<std::complex<float>>& lhs,
-      const Array2D<std::complex<float>>& rhs);
+      const Array2D<std::complex<float>>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
   static std::unique_ptr<Array2D<std::complex<double>>> MatmulArray2D(
       const Array2D<std::complex<double>>& lhs,
-      const Array2D<std::complex<double>>& rhs);
+      const Array2D<std::complex<double>>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
   static std::unique_ptr<Array2D<int32_t>> MatmulArray2D(
-      const Array2D<int32_t>& lhs, const Array2D<int32_t>& rhs);
+      const Array2D<int32_t>& lhs, const Array2D<int32_t>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
   static std::unique_ptr<Array2D<uint8_t>> MatmulArray2D(
-      const Array2D<uint8_t>& lhs, const Array2D<uint8_t>& rhs);
+      const Array2D<uint8_t>& lhs, const Array2D<uint8_t>& rhs,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
 
  protected:
   // Evaluates the given instruction, and stores the evaluation result in the
@@ -466,7 +488,36 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
   // Use fast path that doesn't use embedded evaluators in reduce.
   bool use_fast_path_reduce_ = true;
 
+  // Optional thread pool for expensive operations. Not owned.
+  tsl::thread::ThreadPool* thread_pool_ = nullptr;
+
  private:
+  // Returns true if `result` and all `operands` are static dense arrays with
+  // the same dimensions and minor-to-major order, so that an elementwise op
+  // can walk all of them with a single linear index.
+  static bool HaveSameDenseLayout(const Literal& result,
+                                  absl::Span<const Literal* const> operands);
+
+  // Calls `fn(begin, end)` on consecutive ranges covering [0, n). Large
+  // ranges are split across the ForEachIndexParallel thread pool.
+  template <typename Fn>
+  static void ForEachLinearIndexRange(int64_t n, Fn&& fn) {
+    constexpr int64_t kMinElementsPerRange = 16 * 1024;
+    const int64_t num_ranges =
+        std::min<int64_t>(ShapeUtil::GetForEachIndexParallelThreadCount(),
+                          n / kMinElementsPerRange);
+    if (num_ranges <= 1) {
+      fn(int64_t{0}, n);
+      return;
+    }
+    ShapeUtil::ForEachIndexParallel(
+        ShapeUtil::MakeShape(S64, {num_ranges}),
+        [&](absl::Span<const int64_t> index, int) -> absl::StatusOr<bool> {
+          fn(index[0] * n / num_ranges, (index[0] + 1) * n / num_ranges);
+          return true;
+        });
+  }
+
   template <typename ReturnT, typename NativeT>
   static absl::StatusOr<Literal> ElementWiseUnaryOpImpl(
       const HloInstruction* instruction,
@@ -477,6 +528,16 @@ class HloEvaluator : public ConstDfsHloVisitorWithDefault {
     TF_RET_CHECK(ShapeUtil::SameDimensions(shape, operand->shape()));
 
     Literal result(shape);
+    if (HaveSameDenseLayout(result, {&operand_literal})) {
+      absl::Span<ReturnT> out = result.data<ReturnT>();
+      absl::Span<const NativeT> in = operand_literal.data<NativeT>();
+      ForEachLinearIndexRange(out.size(), [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          out[i] = unary_op(in[i]);
+        }
+      });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return unary_op(operand_literal.Get<NativeT>(multi_index));
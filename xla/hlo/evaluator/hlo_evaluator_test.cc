@@ -63,10 +63,13 @@ limitations under the License.
 #include "xla/types.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
 #include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -2650,6 +2653,88 @@ void BM_ReducePrecisely(::testing::benchmark::State& state) {
 
 BENCHMARK(BM_ReducePrecisely);
 
+// Evaluates a chain of elementwise ops over a large array, which materializes
+// one literal per op.
+void BM_ElementwiseChain(::testing::benchmark::State& state) {
+  const int64_t num_elements = state.range(0);
+  HloComputation::Builder b("BM_ElementwiseChain");
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  HloModule module("BM_ElementwiseChain", config);
+
+  const Shape shape = ShapeUtil::MakeShape(F32, {num_elements});
+  std::vector<float> v(num_elements);
+  std::iota(v.begin(), v.end(), 0.0f);
+  HloInstruction* x = b.AddInstruction(
+      HloInstruction::CreateConstant(LiteralUtil::CreateR1<float>(v)));
+  HloInstruction* pred = b.AddInstruction(HloInstruction::CreateBroadcast(
+      ShapeUtil::ChangeElementType(shape, PRED),
+      b.AddInstruction(
+          HloInstruction::CreateConstant(LiteralUtil::CreateR0<bool>(true))),
+      {}));
+  HloInstruction* value = x;
+  for (int i = 0; i < 4; ++i) {
+    value = b.AddInstruction(
+        HloInstruction::CreateBinary(shape, HloOpcode::kMultiply, value, x));
+    value = b.AddInstruction(
+        HloInstruction::CreateBinary(shape, HloOpcode::kAdd, value, x));
+    value = b.AddInstruction(
+        HloInstruction::CreateUnary(shape, HloOpcode::kNegate, value));
+    value = b.AddInstruction(HloInstruction::CreateTernary(
+        shape, HloOpcode::kSelect, pred, value, x));
+  }
+  module.AddEntryComputation(b.Build());
+
+  for (auto s : state) {
+    HloEvaluator hlo_eval;
+    CHECK_OK(hlo_eval.Evaluate(*module.entry_computation(), {}).status());
+  }
+  state.SetItemsProcessed(state.iterations() * num_elements);
+}
+
+BENCHMARK(BM_ElementwiseChain)->Range(1 << 10, 1 << 22);
+
+// Evaluates a square f32 dot, with a thread pool if the second argument is
+// non-zero.
+void BM_Dot(::testing::benchmark::State& state) {
+  const int64_t size = state.range(0);
+  const bool use_thread_pool = state.range(1) != 0;
+  HloComputation::Builder b("BM_Dot");
+  HloModuleConfig config;
+  config.set_debug_options(GetDebugOptionsFromFlags());
+  HloModule module("BM_Dot", config);
+
+  const Shape shape = ShapeUtil::MakeShape(F32, {size, size});
+  Array2D<float> array(size, size);
+  array.FillRandom(1.0f);
+  HloInstruction* x = b.AddInstruction(HloInstruction::CreateConstant(
+      LiteralUtil::CreateR2FromArray2D<float>(array)));
+  DotDimensionNumbers dnums;
+  dnums.add_lhs_contracting_dimensions(1);
+  dnums.add_rhs_contracting_dimensions(0);
+  b.AddInstruction(HloInstruction::CreateDot(
+      shape, x, x, dnums, HloTestBase::DefaultPrecisionConfig(2)));
+  module.AddEntryComputation(b.Build());
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "BM_Dot",
+                                      tsl::port::MaxParallelism());
+  for (auto s : state) {
+    HloEvaluator hlo_eval;
+    hlo_eval.set_use_fast_path(true);
+    if (use_thread_pool) {
+      hlo_eval.set_thread_pool(&thread_pool);
+    }
+    CHECK_OK(hlo_eval.Evaluate(*module.entry_computation(), {}).status());
+  }
+  state.SetItemsProcessed(state.iterations() * size * size * size);
+}
+
+BENCHMARK(BM_Dot)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->ArgPair(1024, 0)
+    ->ArgPair(1024, 1);
+
 TEST_P(HloEvaluatorBf16Test, ReduceAdd) {
   HloComputation::Builder b(TestName());
 
@@ -4530,6 +4615,84 @@ TEST_F(HloEvaluatorTest, PreserveMOFusionOutputLayout) {
       absl::c_equal(args[0].data<float>(), actual_literals[0].data<float>()));
 }
 
+TEST_F(HloEvaluatorTest, ElementwiseOpsWithMixedLayouts) {
+  const absl::string_view hlo_text = R"(
+    HloModule ElementwiseOpsWithMixedLayouts
+
+    ENTRY kernel_entry {
+      row_major = f32[2,3]{1,0} constant({{1, 2, 3}, {4, 5, 6}})
+      col_major = f32[2,3]{0,1} constant({{10, 20, 30}, {40, 50, 60}})
+      pred = pred[2,3]{0,1} constant({{1, 0, 1}, {0, 1, 0}})
+      same = f32[2,3]{1,0} add(row_major, row_major)
+      mixed = f32[2,3]{1,0} add(row_major, col_major)
+      negated = f32[2,3]{0,1} negate(col_major)
+      selected = f32[2,3]{0,1} select(pred, same, col_major)
+      ROOT tuple = (f32[2,3]{1,0}, f32[2,3]{1,0}, f32[2,3]{0,1},
+                    f32[2,3]{0,1}) tuple(same, mixed, negated, selected)
+    })";
+
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+  TF_ASSERT_OK_AND_ASSIGN(Literal actual_tuple, Evaluate());
+  std::vector<Literal> actual = actual_tuple.DecomposeTuple();
+  ASSERT_EQ(actual.size(), 4);
+  const Layout row_major = LayoutUtil::GetDefaultLayoutForRank(2);
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{2, 4, 6}, {8, 10, 12}}),
+      actual[0].Relayout(row_major)));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{11, 22, 33}, {44, 55, 66}}),
+      actual[1].Relayout(row_major)));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{-10, -20, -30}, {-40, -50, -60}}),
+      actual[2].Relayout(row_major)));
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{2, 20, 6}, {40, 10, 60}}),
+      actual[3].Relayout(row_major)));
+}
+
+TEST_F(HloEvaluatorTest, DotWithThreadPoolMatchesSingleThreaded) {
+  const absl::string_view hlo_text = R"(
+    HloModule DotWithThreadPool
+
+    ENTRY kernel_entry {
+      lhs = f32[1000,96]{1,0} parameter(0)
+      rhs = f32[96,40]{1,0} parameter(1)
+      ROOT dot = f32[1000,40]{1,0} dot(lhs, rhs), lhs_contracting_dims={1},
+                                                  rhs_contracting_dims={0}
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(m_, ParseAndReturnVerifiedModule(hlo_text));
+
+  Array2D<float> lhs_array(1000, 96);
+  lhs_array.FillRandom(1.0f);
+  Array2D<float> rhs_array(96, 40);
+  rhs_array.FillRandom(1.0f);
+  Literal lhs = LiteralUtil::CreateR2FromArray2D<float>(lhs_array);
+  Literal rhs = LiteralUtil::CreateR2FromArray2D<float>(rhs_array);
+
+  tsl::thread::ThreadPool single_thread(tsl::Env::Default(), "evaluator", 1);
+  HloEvaluator single_threaded;
+  single_threaded.set_thread_pool(&single_thread);
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal expected,
+      single_threaded.Evaluate(*m_->entry_computation(), {&lhs, &rhs}));
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "evaluator", 4);
+  HloEvaluator multi_threaded;
+  multi_threaded.set_thread_pool(&thread_pool);
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal actual,
+      multi_threaded.Evaluate(*m_->entry_computation(), {&lhs, &rhs}));
+
+  // Blocks do not depend on the number of threads, so results are identical.
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, actual));
+
+  HloEvaluator slow_path;
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal reference,
+      slow_path.Evaluate(*m_->entry_computation(), {&lhs, &rhs}));
+  EXPECT_TRUE(LiteralTestUtil::Near(reference, actual, ErrorSpec(1e-4, 1e-4)));
+}
+
 // Tests that custom_calls fail to evaluate when no handler is specified.
 TEST_F(HloEvaluatorTest, EvaluateCustomCall_NoHandler) {
   const absl::string_view hlo_text = R"(
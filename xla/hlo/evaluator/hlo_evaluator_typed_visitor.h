@@ -1031,7 +1031,7 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
 
   absl::Status HandleDot(const HloInstruction* dot) override {
     if (dot->dot_dimension_numbers().rhs_contracting_dimensions_size() == 1 &&
-        parent_->use_fast_path_ &&
+        (parent_->use_fast_path_ || parent_->thread_pool_ != nullptr) &&
         ShapeUtil::SameElementType(dot->operand(0)->shape(), dot->shape()) &&
         ShapeUtil::SameElementType(dot->operand(1)->shape(), dot->shape())) {
       return HandleDot<ElementwiseT>(dot);
@@ -1039,9 +1039,16 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
     return HandleDotSlowPath(dot);
   }
 
-  template <typename NativeT, typename std::enable_if_t<
-                                  std::is_same_v<NativeT, float>>* = nullptr>
+  template <typename NativeT,
+            typename std::enable_if_t<std::is_same_v<NativeT, float> ||
+                                      std::is_same_v<NativeT, double>>* =
+                nullptr>
   absl::Status HandleDot(const HloInstruction* dot) {
+    // The f64 fast path is only used with a thread pool, which keeps the
+    // numerics of existing set_use_fast_path users unchanged.
+    if (std::is_same_v<NativeT, double> && parent_->thread_pool_ == nullptr) {
+      return HandleDotSlowPath(dot);
+    }
     const HloInstruction* lhs = dot->operand(0);
     const HloInstruction* rhs = dot->operand(1);
     CHECK(dot->shape().IsArray());
@@ -1096,7 +1103,8 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
                                rhs->shape().dimensions(1));
     rhs_array.SetValues(rhs_literal.data<NativeT>());
     std::unique_ptr<Array2D<NativeT>> result_array =
-        HloEvaluator::MatmulArray2D(lhs_array, rhs_array);
+        HloEvaluator::MatmulArray2D(lhs_array, rhs_array,
+                                    parent_->thread_pool_);
     Literal result(ShapeUtil::MakeShape(native_ty, dot->shape().dimensions()));
     result.PopulateR2FromArray2D(*result_array);
     parent_->evaluated_[dot] =
@@ -1104,8 +1112,10 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
     return absl::OkStatus();
   }
 
-  template <typename NativeT, typename std::enable_if_t<
-                                  !std::is_same_v<NativeT, float>>* = nullptr>
+  template <typename NativeT,
+            typename std::enable_if_t<!std::is_same_v<NativeT, float> &&
+                                      !std::is_same_v<NativeT, double>>* =
+                nullptr>
   absl::Status HandleDot(const HloInstruction* dot) {
     return HandleDotSlowPath(dot);
   }
@@ -1657,11 +1667,28 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    auto apply = [&binary_op](ReturnT lhs_elem, ReturnT rhs_elem) {
+      return static_cast<ReturnT>(
+          binary_op(static_cast<ElementwiseT>(lhs_elem),
+                    static_cast<ElementwiseT>(rhs_elem)));
+    };
+    if (HloEvaluator::HaveSameDenseLayout(result,
+                                          {&lhs_literal, &rhs_literal})) {
+      absl::Span<ReturnT> out = result.data<ReturnT>();
+      absl::Span<const ReturnT> lhs_data = lhs_literal.data<ReturnT>();
+      absl::Span<const ReturnT> rhs_data = rhs_literal.data<ReturnT>();
+      HloEvaluator::ForEachLinearIndexRange(
+          out.size(), [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              out[i] = apply(lhs_data[i], rhs_data[i]);
+            }
+          });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
-          return ConvertBinaryFunction(binary_op)(
-              lhs_literal.Get<ReturnT>(multi_index),
-              rhs_literal.Get<ReturnT>(multi_index));
+          return apply(lhs_literal.Get<ReturnT>(multi_index),
+                       rhs_literal.Get<ReturnT>(multi_index));
         }));
     return std::move(result);
   }
@@ -1684,6 +1711,20 @@ class HloEvaluatorTypedVisitor : public ConstDfsHloVisitorWithDefault {
 
     Literal result(shape);
 
+    if (HloEvaluator::HaveSameDenseLayout(
+            result, {&lhs_literal, &rhs_literal, &ehs_literal})) {
+      absl::Span<ReturnT> out = result.data<ReturnT>();
+      absl::Span<const LhsType> lhs_data = lhs_literal.data<LhsType>();
+      absl::Span<const RhsType> rhs_data = rhs_literal.data<RhsType>();
+      absl::Span<const EhsType> ehs_data = ehs_literal.data<EhsType>();
+      HloEvaluator::ForEachLinearIndexRange(
+          out.size(), [&](int64_t begin, int64_t end) {
+            for (int64_t i = begin; i < end; ++i) {
+              out[i] = ternary_op(lhs_data[i], rhs_data[i], ehs_data[i]);
+            }
+          });
+      return std::move(result);
+    }
     TF_RETURN_IF_ERROR(result.PopulateParallel<ReturnT>(
         [&](absl::Span<const int64_t> multi_index, int) {
           return ternary_op(lhs_literal.Get<LhsType>(multi_index),
@@ -1746,6 +1746,19 @@ bool HloConstantInstruction::IsElementwiseImpl(
   return true;
 }
 
+absl::Status HloConstantInstruction::SetLiteral(Literal literal) {
+  if (literal_) {
+    return FailedPrecondition("Constant %s already has a literal", name());
+  }
+  if (!Shape::Equal().MinorToMajorOnlyInLayout()(literal.shape(), shape())) {
+    return InvalidArgument(
+        "Literal shape %s does not match the shape %s of constant %s",
+        literal.shape().ToString(true), shape().ToString(true), name());
+  }
+  literal_ = std::make_shared<Literal>(std::move(literal));
+  return absl::OkStatus();
+}
+
 void HloConstantInstruction::RelayoutConstant(const Layout& new_layout,
                                               const ShapeIndex& shape_index) {
   Shape* mutable_array_subshape =
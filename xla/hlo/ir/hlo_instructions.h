@@ -1295,6 +1295,9 @@ class HloConstantInstruction : public HloInstruction {
   }
   // Returns whether there is literal associated with this instruction.
   bool HasLiteral() const { return static_cast<bool>(literal_); }
+  // Sets the literal of a constant that was created without one, e.g. because
+  // its literal is stored separately from the rest of a serialized module.
+  absl::Status SetLiteral(Literal literal);
   // Returns a serialized representation of this instruction.
   HloInstructionProto ToProto() const override;
 
@@ -437,6 +437,15 @@ absl::Cord HloModule::ToCord(const HloPrintOptions& options) const {
 }
 
 HloModuleProto HloModule::ToProto() const {
+  HloModuleProto proto = ToProtoWithoutComputations();
+  for (const HloComputation* computation : MakeComputationPostOrder()) {
+    HloComputationProto computation_proto = computation->ToProto();
+    proto.add_computations()->Swap(&computation_proto);
+  }
+  return proto;
+}
+
+HloModuleProto HloModule::ToProtoWithoutComputations() const {
   HloModuleProto proto;
   proto.set_id(unique_id_);
   proto.set_name(name_);
@@ -447,10 +456,6 @@ HloModuleProto HloModule::ToProto() const {
     *proto.mutable_host_program_shape() =
         entry_computation_layout().ComputeProgramShape().ToProto();
   }
-  for (const HloComputation* computation : MakeComputationPostOrder()) {
-    HloComputationProto computation_proto = computation->ToProto();
-    proto.add_computations()->Swap(&computation_proto);
-  }
   if (has_schedule()) {
     *proto.mutable_schedule() = schedule().ToProto().value();
   }
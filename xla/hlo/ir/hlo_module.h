@@ -453,6 +453,9 @@ class HloModule {
 
   // Convert an HloModule to or from a proto.
   HloModuleProto ToProto() const;
+  // Like ToProto, but leaves out the computations. Used by serialization
+  // formats that store each computation separately.
+  HloModuleProto ToProtoWithoutComputations() const;
   static absl::StatusOr<std::unique_ptr<HloModule>> CreateFromProto(
       const HloModuleProto& proto, const HloModuleConfig& module_config,
       bool prohibit_empty_literal = true);
@@ -585,6 +585,12 @@ namespace {
 
 // Copies the elements in 'src' to 'dest'. The shape and layout of the data in
 // the array slices are indicated by dest_shape and src_shape respectively.
+//
+// 'dest' is written in physical order, and the matching offset into 'src' is
+// maintained with per-dimension strides instead of being recomputed from a
+// multi-dimensional index for every element. If the minor-most dimensions of
+// the two layouts differ, those two dimensions are copied in square tiles so
+// that both the reads and the writes of a tile stay in cache.
 template <typename NativeT>
 void CopyElementsBetween(absl::Span<NativeT> dest,
                          absl::Span<const NativeT> src, const Shape& dest_shape,
@@ -595,11 +601,88 @@ void CopyElementsBetween(absl::Span<NativeT> dest,
   if (ShapeUtil::IsZeroElementArray(dest_shape)) {
     return;
   }
-  std::vector<int64_t> index(dest_shape.rank());
-  do {
-    dest[IndexUtil::MultidimensionalIndexToLinearIndex(dest_shape, index)] =
-        src[IndexUtil::MultidimensionalIndexToLinearIndex(src_shape, index)];
-  } while (IndexUtil::BumpIndices(dest_shape, absl::MakeSpan(index)));
+  const int64_t rank = dest_shape.rank();
+  if (rank == 0) {
+    dest[0] = src[0];
+    return;
+  }
+
+  // Element strides of every logical dimension in both layouts.
+  absl::InlinedVector<int64_t, 8> dest_strides(rank);
+  absl::InlinedVector<int64_t, 8> src_strides(rank);
+  auto compute_strides = [](const Shape& shape, absl::Span<int64_t> strides) {
+    int64_t stride = 1;
+    for (int64_t dim : shape.layout().minor_to_major()) {
+      strides[dim] = stride;
+      stride *= shape.dimensions(dim);
+    }
+  };
+  compute_strides(dest_shape, absl::MakeSpan(dest_strides));
+  compute_strides(src_shape, absl::MakeSpan(src_strides));
+
+  // `inner` is contiguous in 'dest'. If it is not contiguous in 'src', the
+  // dimension that is (`tiled`) is iterated together with it in tiles.
+  const int64_t inner = dest_shape.layout().minor_to_major(0);
+  const int64_t src_minor = src_shape.layout().minor_to_major(0);
+  const int64_t tiled = src_minor == inner ? -1 : src_minor;
+  const int64_t inner_size = dest_shape.dimensions(inner);
+  const int64_t inner_src_stride = src_strides[inner];
+  const int64_t tiled_size = tiled < 0 ? 1 : dest_shape.dimensions(tiled);
+  const int64_t tiled_dest_stride = tiled < 0 ? 0 : dest_strides[tiled];
+
+  // The remaining dimensions are iterated in the physical order of 'dest'.
+  absl::InlinedVector<int64_t, 8> outer_dims;
+  for (int64_t dim : dest_shape.layout().minor_to_major()) {
+    if (dim != inner && dim != tiled) {
+      outer_dims.push_back(dim);
+    }
+  }
+  absl::InlinedVector<int64_t, 8> outer_index(outer_dims.size(), 0);
+
+  constexpr int64_t kTileSize = 32;
+  int64_t dest_offset = 0;
+  int64_t src_offset = 0;
+  while (true) {
+    NativeT* dest_data = dest.data() + dest_offset;
+    const NativeT* src_data = src.data() + src_offset;
+    if (tiled < 0) {
+      for (int64_t i = 0; i < inner_size; ++i) {
+        dest_data[i] = src_data[i * inner_src_stride];
+      }
+    } else {
+      for (int64_t t0 = 0; t0 < tiled_size; t0 += kTileSize) {
+        const int64_t t1 = std::min(t0 + kTileSize, tiled_size);
+        for (int64_t i0 = 0; i0 < inner_size; i0 += kTileSize) {
+          const int64_t i1 = std::min(i0 + kTileSize, inner_size);
+          for (int64_t t = t0; t < t1; ++t) {
+            // `tiled` is the minor-most dimension of 'src', so its stride
+            // there is 1.
+            NativeT* dest_row = dest_data + t * tiled_dest_stride;
+            const NativeT* src_row = src_data + t;
+            for (int64_t i = i0; i < i1; ++i) {
+              dest_row[i] = src_row[i * inner_src_stride];
+            }
+          }
+        }
+      }
+    }
+
+    int64_t k = 0;
+    for (; k < outer_dims.size(); ++k) {
+      const int64_t dim = outer_dims[k];
+      if (++outer_index[k] < dest_shape.dimensions(dim)) {
+        dest_offset += dest_strides[dim];
+        src_offset += src_strides[dim];
+        break;
+      }
+      dest_offset -= dest_strides[dim] * (outer_index[k] - 1);
+      src_offset -= src_strides[dim] * (outer_index[k] - 1);
+      outer_index[k] = 0;
+    }
+    if (k == outer_dims.size()) {
+      return;
+    }
+  }
 }
 }  // namespace
 
@@ -1688,6 +1771,20 @@ void ConvertBetweenNativeTypes(absl::Span<const NativeSrcT> src_data,
   };
 
   NativeDestT* dest_data = static_cast<NativeDestT*>(dst_base);
+  // Conversions from f32 to f16 and from f16 and bf16 to f32 have vectorized
+  // implementations in Eigen, which round exactly like the scalar ones.
+  if constexpr ((std::is_same_v<NativeSrcT, float> &&
+                 std::is_same_v<NativeDestT, half>) ||
+                ((std::is_same_v<NativeSrcT, half> ||
+                  std::is_same_v<NativeSrcT, bfloat16>) &&
+                 std::is_same_v<NativeDestT, float>)) {
+    using SrcArray = Eigen::Array<NativeSrcT, Eigen::Dynamic, 1>;
+    using DestArray = Eigen::Array<NativeDestT, Eigen::Dynamic, 1>;
+    Eigen::Map<DestArray>(dest_data, src_data.size()) =
+        Eigen::Map<const SrcArray>(src_data.data(), src_data.size())
+            .template cast<NativeDestT>();
+    return;
+  }
   for (const NativeSrcT& src : src_data) {
     *(dest_data++) = converter(src);
   }
@@ -2748,6 +2845,12 @@ BorrowingLiteral::BorrowingLiteral(const char* src_buf_ptr, const Shape& shape)
   root_piece_.set_buffer(const_cast<char*>(src_buf_ptr));
 }
 
+BorrowingLiteral::BorrowingLiteral(const char* src_buf_ptr, const Shape& shape,
+                                   std::shared_ptr<const void> keep_alive)
+    : BorrowingLiteral(src_buf_ptr, shape) {
+  keep_alive_ = std::move(keep_alive);
+}
+
 BorrowingLiteral::BorrowingLiteral(absl::Span<const char* const> src_buf_ptrs,
                                    const Shape& shape)
     : LiteralBase(), shape_(std::make_unique<Shape>(shape)) {
@@ -1508,6 +1508,16 @@ class BorrowingLiteral : public LiteralBase {
   // buffers for each shape index.
   explicit BorrowingLiteral(ShapeTree<const char*> src_buf_ptrs);
 
+  // Like the array constructor above, but the literal shares ownership of
+  // `keep_alive`, which must keep the buffer alive. This allows borrowing from
+  // buffers with a lifetime of their own, such as memory-mapped files, without
+  // copying them.
+  BorrowingLiteral(const char* src_buf_ptr, const Shape& shape,
+                   std::shared_ptr<const void> keep_alive);
+
+  // Returns the object keeping the borrowed buffers alive, if any.
+  const std::shared_ptr<const void>& keep_alive() const { return keep_alive_; }
+
  private:
   // Accessor for the root piece of this literal.
   const Piece& root_piece() const override { return root_piece_; };
@@ -1517,6 +1527,8 @@ class BorrowingLiteral : public LiteralBase {
   // construction of this class would be trivially correct: the pointer to Shape
   // root_piece_ stores will still point to the correct address.
   std::unique_ptr<Shape> shape_;
+
+  std::shared_ptr<const void> keep_alive_;
 };
 
 template <typename NativeT, typename OutputIterator>
@@ -21,9 +21,11 @@ limitations under the License.
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <optional>
 #include <set>
@@ -322,18 +324,30 @@ class NearComparator {
     // Adjust the bucket containing the absolute values of the 'actual'
     // elements.
     const double abs_value = FpAbsoluteValue(value);
-    for (int i = 0; i < abs_value_buckets_.size(); ++i) {
-      if (i == abs_value_buckets_.size() - 1 ||
-          (abs_value >= kAbsValueBucketBounds[i] &&
-           abs_value < kAbsValueBucketBounds[i + 1])) {
-        // The first value of the pair is the count of elements in the bucket,
-        // the second is the count of mismatches in the bucket.
-        abs_value_buckets_[i].first++;
-        if (is_mismatch) {
-          abs_value_buckets_[i].second++;
-        }
-        return;
-      }
+    // Values that fall in no bucket (e.g. NaN or infinity) are counted in the
+    // last one.
+    int64_t i = std::upper_bound(kAbsValueBucketBounds.begin(),
+                                 kAbsValueBucketBounds.end(), abs_value) -
+                kAbsValueBucketBounds.begin() - 1;
+    if (i < 0 || i >= abs_value_buckets_.size()) {
+      i = abs_value_buckets_.size() - 1;
+    }
+    // The first value of the pair is the count of elements in the bucket, the
+    // second is the count of mismatches in the bucket.
+    abs_value_buckets_[i].first++;
+    if (is_mismatch) {
+      abs_value_buckets_[i].second++;
+    }
+  }
+
+  // Records a bitwise-equal pair of elements. This has the same effect as
+  // CompareValues, since such a pair is never a mismatch.
+  void UpdateAbsValueBucketForEqual(NativeT value) {
+    if constexpr (is_complex_v<NativeT>) {
+      UpdateAbsValueBucket(NativeT(value.real()), /*is_mismatch=*/false);
+      UpdateAbsValueBucket(NativeT(value.imag()), /*is_mismatch=*/false);
+    } else {
+      UpdateAbsValueBucket(value, /*is_mismatch=*/false);
     }
   }
 
@@ -503,6 +517,27 @@ class NearComparator {
       absl::Span<const NativeT> expected_data = expected_.data<NativeT>();
       absl::Span<const NativeT> actual_data = actual_.data<NativeT>();
       const int64_t len = expected_data.size();
+      // Bitwise-equal elements have zero error and are never mismatches when
+      // both bounds are non-negative. Blocks of such elements are found with
+      // memcmp and only contribute to the value histogram.
+      if (error_.abs >= 0 && error_.rel >= 0) {
+        constexpr int64_t kBlockSize = 1024;
+        for (int64_t start = 0; start < len; start += kBlockSize) {
+          const int64_t end = std::min(start + kBlockSize, len);
+          if (std::memcmp(expected_data.data() + start,
+                          actual_data.data() + start,
+                          (end - start) * sizeof(NativeT)) == 0) {
+            for (int64_t i = start; i < end; ++i) {
+              UpdateAbsValueBucketForEqual(actual_data[i]);
+            }
+            continue;
+          }
+          for (int64_t i = start; i < end; ++i) {
+            CompareValues(expected_data[i], actual_data[i], i);
+          }
+        }
+        return;
+      }
       for (int64_t i = 0; i < len; ++i) {
         CompareValues(expected_data[i], actual_data[i], i);
       }
@@ -696,6 +731,17 @@ absl::Status EqualHelper(const LiteralSlice& expected,
       next_index.pop_back();
     }
   } else {
+    // Identical buffers are equal under the bitwise comparison below, so skip
+    // the elementwise walk.
+    if (expected.shape().is_static() && actual.shape().is_static() &&
+        LayoutUtil::IsDenseArray(expected.shape()) &&
+        LayoutUtil::Equal(expected.shape().layout(), actual.shape().layout()) &&
+        expected.size_bytes() > 0 &&
+        expected.size_bytes() == actual.size_bytes() &&
+        std::memcmp(expected.untyped_data(), actual.untyped_data(),
+                    expected.size_bytes()) == 0) {
+      return absl::OkStatus();
+    }
     std::vector<int64_t> multi_index(expected.shape().dimensions_size(), 0);
     auto index = absl::MakeSpan(multi_index);
 
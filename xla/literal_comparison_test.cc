@@ -15,12 +15,20 @@ limitations under the License.
 
 #include "xla/literal_comparison.h"
 
+#include <cstdint>
+#include <limits>
+#include <vector>
+
 #include <gtest/gtest.h>
+#include "absl/log/check.h"
+#include "absl/status/status.h"
 #include "xla/error_spec.h"
+#include "xla/literal.h"
 #include "xla/literal_util.h"
 #include "xla/test_helpers.h"
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tsl/platform/ml_dtypes.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -198,5 +206,47 @@ TEST(LiteralComparisonTest, FloatUsingF8E4M3B11FNUZCompareNear_NotEqual_4ulps) {
                                         /*miscompare_callback=*/nullptr));
 }
 
+TEST(LiteralComparisonTest, NearFindsMismatchAmongEqualBlocks) {
+  std::vector<float> values(4096);
+  for (int i = 0; i < values.size(); ++i) {
+    values[i] = i * 0.5f;
+  }
+  values[7] = std::numeric_limits<float>::quiet_NaN();
+  auto expected = LiteralUtil::CreateR1<float>(values);
+  EXPECT_IS_OK(literal_comparison::Near(expected, expected.Clone(),
+                                        ErrorSpec(0.0, 0.0),
+                                        /*detailed_message=*/true,
+                                        /*miscompare_callback=*/nullptr));
+
+  values[3000] = -values[3000];
+  auto actual = LiteralUtil::CreateR1<float>(values);
+  absl::Status status = literal_comparison::Near(
+      expected, actual, ErrorSpec(0.1, 0.1), /*detailed_message=*/true,
+      /*miscompare_callback=*/nullptr);
+  EXPECT_IS_NOT_OK(status);
+  EXPECT_THAT(status.message(), ::testing::HasSubstr("Mismatch count 1 "));
+}
+
+TEST(LiteralComparisonTest, EqualFindsSingleDifference) {
+  std::vector<int32_t> values(1024, 3);
+  auto expected = LiteralUtil::CreateR1<int32_t>(values);
+  TF_EXPECT_OK(literal_comparison::Equal(expected, expected.Clone()));
+  values[1000] = 4;
+  EXPECT_IS_NOT_OK(literal_comparison::Equal(
+      expected, LiteralUtil::CreateR1<int32_t>(values)));
+}
+
+void BM_NearIdentical(::testing::benchmark::State& state) {
+  const int64_t n = state.range(0);
+  auto expected = LiteralUtil::CreateR1<float>(std::vector<float>(n, 1.5f));
+  Literal actual = expected.Clone();
+  for (auto s : state) {
+    CHECK_OK(literal_comparison::Near(expected, actual, ErrorSpec(1e-5, 1e-5),
+                                      /*detailed_message=*/false,
+                                      /*miscompare_callback=*/nullptr));
+  }
+}
+BENCHMARK(BM_NearIdentical)->Arg(1 << 10)->Arg(1 << 20);
+
 }  // namespace
 }  // namespace xla
@@ -21,6 +21,7 @@ limitations under the License.
 #include <cstdint>
 #include <functional>
 #include <limits>
+#include <memory>
 #include <random>
 #include <string>
 #include <tuple>
@@ -951,6 +952,27 @@ TEST_F(LiteralUtilTest, TestR4RelayoutEquivalence) {
   EXPECT_EQ(literal_r4_2x2x3x3_dim0minor_, dim0major_relaid_to_dim0minor);
 }
 
+TEST_F(LiteralUtilTest, RelayoutAcrossTiles) {
+  // Dimensions that are not multiples of the copy tile size, so that partial
+  // tiles are exercised.
+  Literal original(ShapeUtil::MakeShapeWithDenseLayout(S32, {37, 70, 3},
+                                                       {2, 1, 0}));
+  TF_ASSERT_OK(original.Populate<int32_t>(
+      [](absl::Span<const int64_t> indices) -> int32_t {
+        return indices[0] * 1000 + indices[1] * 10 + indices[2];
+      }));
+  std::vector<int64_t> minor_to_major = {0, 1, 2};
+  do {
+    Literal relaid = original.Relayout(LayoutUtil::MakeLayout(minor_to_major));
+    EXPECT_EQ(relaid.shape().layout(), LayoutUtil::MakeLayout(minor_to_major));
+    original.EachCell<int32_t>(
+        [&](absl::Span<const int64_t> indices, int32_t value) {
+          EXPECT_EQ(relaid.Get<int32_t>(indices), value);
+        });
+    EXPECT_EQ(relaid.Relayout(original.shape().layout()), original);
+  } while (std::next_permutation(minor_to_major.begin(), minor_to_major.end()));
+}
+
 template <bool kIsLayoutSensitive>
 struct HashTester {
   template <typename H>
@@ -1563,6 +1585,41 @@ TEST_F(LiteralUtilTest, ConvertR4) {
   EXPECT_EQ(expected, converted);
 }
 
+TEST_F(LiteralUtilTest, ConvertFloatToAndFromHalfMatchesScalarCast) {
+  std::vector<float> values = {0.0f,
+                               -0.0f,
+                               1.0f,
+                               -2.5f,
+                               1e-8f,
+                               65504.0f,
+                               70000.0f,
+                               3.14159f,
+                               std::numeric_limits<float>::infinity(),
+                               std::numeric_limits<float>::denorm_min()};
+  for (int i = 0; i < 100; ++i) {
+    values.push_back(i * 0.37f - 17.0f);
+  }
+  Literal f32 = LiteralUtil::CreateR1<float>(values);
+
+  TF_ASSERT_OK_AND_ASSIGN(Literal f16, f32.Convert(F16));
+  for (int64_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(Eigen::numext::bit_cast<uint16_t>(f16.Get<half>({i})),
+              Eigen::numext::bit_cast<uint16_t>(static_cast<half>(values[i])));
+  }
+  TF_ASSERT_OK_AND_ASSIGN(Literal f16_to_f32, f16.Convert(F32));
+  for (int64_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(f16_to_f32.Get<float>({i}),
+              static_cast<float>(f16.Get<half>({i})));
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(Literal bf16, f32.Convert(BF16));
+  TF_ASSERT_OK_AND_ASSIGN(Literal bf16_to_f32, bf16.Convert(F32));
+  for (int64_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(bf16_to_f32.Get<float>({i}),
+              static_cast<float>(bf16.Get<bfloat16>({i})));
+  }
+}
+
 TEST_F(LiteralUtilTest, ConvertIfTypesMatch) {
   // clang-format off
   auto s8 = LiteralUtil::CreateR4WithLayout<int8_t>({{
@@ -2015,6 +2072,25 @@ TEST_F(LiteralUtilTest, BorrowingLiteralFromOneBufferPtr) {
   EXPECT_EQ(literal.Get<int64_t>({2}), 3);
 }
 
+TEST_F(LiteralUtilTest, BorrowingLiteralKeepsBufferAlive) {
+  auto int64_values = std::make_shared<std::vector<int64_t>>(
+      std::vector<int64_t>{1, 2, 3});
+  const Shape literal_shape = ShapeUtil::MakeShape(S64, {3});
+
+  BorrowingLiteral literal(
+      reinterpret_cast<const char*>(int64_values->data()), literal_shape,
+      int64_values);
+  std::weak_ptr<std::vector<int64_t>> weak_values = int64_values;
+  int64_values.reset();
+
+  {
+    BorrowingLiteral moved = std::move(literal);
+    EXPECT_FALSE(weak_values.expired());
+    EXPECT_EQ(moved, LiteralUtil::CreateR1<int64_t>({1, 2, 3}));
+  }
+  EXPECT_TRUE(weak_values.expired());
+}
+
 TEST_F(LiteralUtilTest, BorrowingLiteralFromMultipleBufferPtrs) {
   std::vector<int64_t> one_two_three = {1, 2, 3};
   const Shape one_two_three_shape = ShapeUtil::MakeShape(S64, {3});
@@ -3006,5 +3082,29 @@ BENCHMARK(BM_BroadcastVectorToMatrix)
     ->ArgPair(16, 1024)
     ->ArgPair(1024, 1024);
 
+void BM_Relayout(::testing::benchmark::State& state) {
+  const int64_t n = state.range(0);
+  Literal literal(ShapeUtil::MakeShapeWithDenseLayout(F32, {n, n}, {1, 0}));
+  literal.PopulateWithValue<float>(1.0f);
+  const Layout transposed = LayoutUtil::MakeLayout({0, 1});
+  for (auto s : state) {
+    Literal relaid = literal.Relayout(transposed);
+    tsl::testing::DoNotOptimize(relaid);
+  }
+  state.SetBytesProcessed(state.iterations() * n * n * sizeof(float));
+}
+BENCHMARK(BM_Relayout)->Arg(64)->Arg(1024);
+
+void BM_ConvertF32ToF16(::testing::benchmark::State& state) {
+  const int64_t n = state.range(0);
+  Literal literal = LiteralUtil::CreateR1<float>(std::vector<float>(n, 1.5f));
+  for (auto s : state) {
+    TF_ASSERT_OK_AND_ASSIGN(Literal converted, literal.Convert(F16));
+    tsl::testing::DoNotOptimize(converted);
+  }
+  state.SetBytesProcessed(state.iterations() * n * sizeof(float));
+}
+BENCHMARK(BM_ConvertF32ToF16)->Arg(1 << 10)->Arg(1 << 20);
+
 }  // namespace
 }  // namespace xla
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "xla/packed_literal_reader.h"
 
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <string>
@@ -23,11 +24,15 @@ limitations under the License.
 #include "absl/base/casts.h"
 #include "xla/layout_util.h"
 #include "xla/literal.h"
+#include "xla/shape.h"
 #include "xla/shape_util.h"
 #include "xla/status_macros.h"
 #include "xla/types.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/file_system.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/protobuf.h"
 
@@ -88,4 +93,36 @@ bool PackedLiteralReader::IsExhausted() const {
   return !s.ok();
 }
 
+absl::StatusOr<BorrowingLiteral> MapPackedLiteral(const std::string& path,
+                                                  const Shape& shape,
+                                                  uint64_t offset,
+                                                  tsl::Env* env) {
+  if (!shape.IsArray() || !shape.is_static() ||
+      !LayoutUtil::HasLayout(shape) || !LayoutUtil::IsDenseArray(shape)) {
+    return InvalidArgument(
+        "Only static dense arrays with a layout can be mapped, got %s",
+        ShapeUtil::HumanStringWithLayout(shape));
+  }
+  const int64_t element_size =
+      ShapeUtil::ByteSizeOfPrimitiveType(shape.element_type());
+  if (offset % element_size != 0) {
+    return InvalidArgument("Offset %d is not aligned to the element size %d",
+                           offset, element_size);
+  }
+
+  std::unique_ptr<tsl::ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(path, &region));
+  const uint64_t bytes = ShapeUtil::ByteSizeOf(shape);
+  if (offset > region->length() || bytes > region->length() - offset) {
+    return InvalidArgument(
+        "File %s has %d bytes, too few for %d bytes of %s at offset %d", path,
+        region->length(), bytes, ShapeUtil::HumanString(shape), offset);
+  }
+  const char* data = static_cast<const char*>(region->data()) + offset;
+  VLOG(3) << "mapped shape from file: " << ShapeUtil::HumanString(shape);
+  return BorrowingLiteral(data, shape,
+                          std::shared_ptr<tsl::ReadOnlyMemoryRegion>(
+                              std::move(region)));
+}
+
 }  // namespace xla
@@ -16,10 +16,13 @@ limitations under the License.
 #ifndef XLA_PACKED_LITERAL_READER_H_
 #define XLA_PACKED_LITERAL_READER_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 
 #include "absl/status/statusor.h"
 #include "xla/literal.h"
+#include "xla/shape.h"
 #include "xla/types.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/env.h"
@@ -55,6 +58,18 @@ class PackedLiteralReader {
   PackedLiteralReader& operator=(const PackedLiteralReader&) = delete;
 };
 
+// Memory-maps the file at `path` and returns a literal of array shape `shape`
+// that refers to the packed data at byte `offset` of the file, without copying
+// it. The literal keeps the mapping alive, so it can be passed anywhere a
+// LiteralSlice is accepted (e.g. TransferManager::TransferLiteralToDevice)
+// and the file data is read only as it is accessed.
+//
+// `shape` must have a dense layout, which describes how the data is laid out
+// in the file, and `offset` must be aligned to the size of its elements.
+absl::StatusOr<BorrowingLiteral> MapPackedLiteral(
+    const std::string& path, const Shape& shape, uint64_t offset = 0,
+    tsl::Env* env = tsl::Env::Default());
+
 }  // namespace xla
 
 #endif  // XLA_PACKED_LITERAL_READER_H_
@@ -0,0 +1,83 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/packed_literal_reader.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/shape_util.h"
+#include "xla/test.h"
+#include "xla/xla_data.pb.h"
+#include "tsl/platform/env.h"
+
+namespace xla {
+namespace {
+
+// Writes `header` followed by the bytes of `values` to a temporary file.
+std::string WritePackedFile(absl::string_view name, absl::string_view header,
+                            const std::vector<float>& values) {
+  std::string contents(header);
+  contents.append(reinterpret_cast<const char*>(values.data()),
+                  values.size() * sizeof(float));
+  std::string fname = tsl::testing::TmpDir() + "/" + std::string(name);
+  EXPECT_TRUE(
+      tsl::WriteStringToFile(tsl::Env::Default(), fname, contents).ok());
+  return fname;
+}
+
+TEST(PackedLiteralReaderTest, MapsR2File) {
+  std::string fname =
+      WritePackedFile("MapsR2File.data", "", {1.5, 2.5, 3.5, 4.5, 5.5, 6.5});
+
+  BorrowingLiteral literal =
+      MapPackedLiteral(fname, ShapeUtil::MakeShape(F32, {2, 3})).value();
+  EXPECT_NE(literal.keep_alive(), nullptr);
+  EXPECT_EQ(literal, LiteralUtil::CreateR2<float>(
+                         {{1.5, 2.5, 3.5}, {4.5, 5.5, 6.5}}));
+
+  // The literal keeps the mapping alive after it is moved.
+  BorrowingLiteral moved = std::move(literal);
+  EXPECT_EQ(moved.Get<float>({1, 2}), 6.5);
+}
+
+TEST(PackedLiteralReaderTest, MapsAtOffsetWithLayout) {
+  std::string fname =
+      WritePackedFile("MapsAtOffsetWithLayout.data", "abcd", {1, 2, 3, 4});
+
+  Shape shape = ShapeUtil::MakeShapeWithDenseLayout(F32, {2, 2}, {0, 1});
+  BorrowingLiteral literal = MapPackedLiteral(fname, shape, 4).value();
+  EXPECT_EQ(literal.Get<float>({0, 1}), 3);
+  EXPECT_EQ(literal.Get<float>({1, 0}), 2);
+}
+
+TEST(PackedLiteralReaderTest, RejectsBadRequests) {
+  std::string fname = WritePackedFile("RejectsBadRequests.data", "", {1, 2});
+
+  // Too large for the file.
+  EXPECT_FALSE(MapPackedLiteral(fname, ShapeUtil::MakeShape(F32, {3})).ok());
+  EXPECT_FALSE(MapPackedLiteral(fname, ShapeUtil::MakeShape(F32, {2}), 4).ok());
+  // Misaligned.
+  EXPECT_FALSE(MapPackedLiteral(fname, ShapeUtil::MakeShape(F32, {1}), 2).ok());
+  // Not an array.
+  EXPECT_FALSE(MapPackedLiteral(fname, ShapeUtil::MakeTupleShape({})).ok());
+}
+
+}  // namespace
+}  // namespace xla
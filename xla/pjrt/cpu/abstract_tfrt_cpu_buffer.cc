@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "xla/pjrt/cpu/abstract_tfrt_cpu_buffer.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
@@ -25,12 +27,12 @@ limitations under the License.
 #include <vector>
 
 #include "absl/algorithm/container.h"
-#include "absl/base/casts.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -68,6 +70,49 @@ namespace {
 
 constexpr size_t kSmallDataTransferByteSize = 102400;  // 100 KiB
 
+// Host-to-device copies larger than this are split into chunks of this size
+// that are copied in parallel.
+constexpr size_t kParallelCopyChunkByteSize = 4 * 1024 * 1024;  // 4 MiB
+
+// Copies `size` bytes from `src` to `dst` on `async_work_runner` and calls
+// `on_done` once the copy is complete. Large copies are split into chunks so
+// that a single transfer can use all of the threads of the runner.
+void CopyOnWorkRunner(AsyncWorkRunner* async_work_runner, void* dst,
+                      const void* src, size_t size,
+                      absl::AnyInvocable<void() &&> on_done) {
+  size_t num_chunks = CeilOfRatio(size, kParallelCopyChunkByteSize);
+  if (num_chunks <= 1) {
+    async_work_runner->Schedule(
+        [dst, src, size, on_done = std::move(on_done)]() mutable {
+          tsl::profiler::TraceMe traceme("H2D Dispatch");
+          std::memcpy(dst, src, size);
+          std::move(on_done)();
+        });
+    return;
+  }
+
+  struct CopyState {
+    std::atomic<size_t> num_pending;
+    absl::AnyInvocable<void() &&> on_done;
+  };
+  auto state = std::make_shared<CopyState>();
+  state->num_pending = num_chunks;
+  state->on_done = std::move(on_done);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    size_t begin = i * kParallelCopyChunkByteSize;
+    size_t chunk_size = std::min(kParallelCopyChunkByteSize, size - begin);
+    async_work_runner->Schedule([state, dst = static_cast<char*>(dst) + begin,
+                                 src = static_cast<const char*>(src) + begin,
+                                 chunk_size]() {
+      tsl::profiler::TraceMe traceme("H2D Dispatch");
+      std::memcpy(dst, src, chunk_size);
+      if (state->num_pending.fetch_sub(1) == 1) {
+        std::move(state->on_done)();
+      }
+    });
+  }
+}
+
 // Unpacks and copies the packed data at `input` into the literal at the given
 // ShapeIndex.
 void UnpackIntNToLiteral(PrimitiveType input_element_type,
@@ -136,6 +181,15 @@ ShapedBuffer AsShapedBuffer(
 
 }  //  namespace
 
+size_t MinimumAlignmentForBuffer(size_t byte_size) {
+  // Mirrors LLVMTargetMachineFeatures::minimum_alignment_for_allocation, which
+  // the IR emitter uses for the alignment of parameters.
+  if (byte_size == 0) {
+    return 1;
+  }
+  return std::min(absl::bit_ceil(byte_size), cpu_function_runtime::MinAlign());
+}
+
 AbstractTfrtCpuBuffer::AbstractTfrtCpuBuffer(
     Shape on_device_shape,
     std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer)
@@ -483,7 +537,8 @@ AbstractTfrtCpuBuffer::CopyToDeviceAcrossClients(PjRtDevice* dst_device) {
 }
 
 absl::StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
-AbstractTfrtCpuBuffer::CopyToDeviceHelper(AsyncWorkRunner* async_work_runner) {
+AbstractTfrtCpuBuffer::CopyToDeviceHelper(AsyncWorkRunner* async_work_runner,
+                                          CpuMemoryPool* memory_pool) {
   // Copy each leaf buffer to a destination buffer.
   auto usage_event = tsl::MakeConstructedAsyncValueRef<CpuEvent>();
   auto* src_device_buffer = AcquireUsage(usage_event);
@@ -517,7 +572,7 @@ AbstractTfrtCpuBuffer::CopyToDeviceHelper(AsyncWorkRunner* async_work_runner) {
 
   auto copy_task = [num_leaf_buffers, src_buffers = std::move(src_buffers),
                     dst_buffers_copies = dst_buffers, dst_definition_events,
-                    src_definition_event,
+                    src_definition_event, memory_pool,
                     ready_on_exit = std::move(ready_on_exit)]() mutable {
     tsl::profiler::TraceMe traceme("D2D Dispatch");
     if (auto* error = src_definition_event.GetErrorIfPresent()) {
@@ -534,7 +589,8 @@ AbstractTfrtCpuBuffer::CopyToDeviceHelper(AsyncWorkRunner* async_work_runner) {
       // `src_buffers` are available because `src_definition_event` should have
       // been ready.
       CHECK(src_buffers[i].IsConcrete());
-      auto dst_memory = MaybeOwningCpuMemory::Allocate(src_buffers[i]->size());
+      auto dst_memory =
+          MaybeOwningCpuMemory::Allocate(src_buffers[i]->size(), memory_pool);
       if (!dst_memory.ok()) {
         dst_definition_events[i].SetError(dst_memory.status());
         continue;
@@ -615,50 +671,34 @@ void AbstractTfrtCpuBuffer::CopyFromLiteral(
   auto usage_event = tsl::MakeAvailableAsyncValueRef<CpuEvent>();
   auto* device_buffer = AcquireUsage(std::move(usage_event));
   CHECK(device_buffer);
-  if (!shape.IsTuple()) {
-    // It is OK to capture `buffer` pointer because the `output_buffer` can't be
-    // deleted until all the usage holds have gone away.
-    async_work_runner->Schedule(
-        [literal, av = (*avs)[0].CopyRef(), device_buffer, shape]() mutable {
-          tsl::profiler::TraceMe traceme("H2D Dispatch");
-          const tsl::AsyncValueRef<MaybeOwningCpuMemory>& b =
-              device_buffer->Buffers()[0];
-          CHECK(b.IsConcrete());
-          CHECK_EQ(literal.size_bytes(), b->size());
-          std::memcpy(b->data(), literal.untyped_data(), b->size());
-          // Signal copy is complete.
-          av->SetStateConcrete();
-        });
-  } else {
-    // For tuple, transfer leaf literal individually in parallel.
-    for (int i = 0; i < shape.tuple_shapes_size(); ++i) {
-      // It is OK to capture `buffer` pointer because the `output_buffer` can't
-      // be deleted until all the usage holds have gone away.
-      async_work_runner->Schedule([i, literal, av = (*avs)[i].CopyRef(), shape,
-                                   device_buffer]() mutable {
-        tsl::profiler::TraceMe traceme("H2D Dispatch");
-        auto slice = LiteralSlice(literal, {i});
-        const tsl::AsyncValueRef<MaybeOwningCpuMemory>& b =
-            device_buffer->Buffers()[i];
-        CHECK(b.IsConcrete());
-        CHECK_EQ(slice.size_bytes(), b->size());
-        std::memcpy(b->data(), slice.untyped_data(), slice.size_bytes());
-        // Signal copy is complete.
-        av->SetStateConcrete();
-      });
-    }
+  // It is OK to use the buffers of `device_buffer` because the buffer can't be
+  // deleted until all the usage holds have gone away. For tuples, leaf
+  // literals are transferred individually in parallel.
+  int num_leaf_buffers = shape.IsTuple() ? shape.tuple_shapes_size() : 1;
+  for (int i = 0; i < num_leaf_buffers; ++i) {
+    LiteralSlice slice = shape.IsTuple() ? LiteralSlice(literal, {i}) : literal;
+    const tsl::AsyncValueRef<MaybeOwningCpuMemory>& b =
+        device_buffer->Buffers()[i];
+    CHECK(b.IsConcrete());
+    CHECK_EQ(slice.size_bytes(), b->size());
+    CopyOnWorkRunner(async_work_runner, b->data(), slice.untyped_data(),
+                     slice.size_bytes(),
+                     // Signal copy is complete.
+                     [av = (*avs)[i].CopyRef()]() { av->SetStateConcrete(); });
   }
 }
 
 /*static*/ absl::StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
 AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
     const Shape& on_device_shape,
-    absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events) {
+    absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events,
+    CpuMemoryPool* memory_pool) {
   absl::InlinedVector<tsl::AsyncValueRef<MaybeOwningCpuMemory>, 4> buffers;
   if (!on_device_shape.IsTuple()) {
     size_t byte_size = ShapeUtil::ByteSizeOf(on_device_shape);
-    TF_ASSIGN_OR_RETURN(tsl::AsyncValueRef<MaybeOwningCpuMemory> device_buffer,
-                        MaybeOwningCpuMemory::AllocateAvailableAvr(byte_size));
+    TF_ASSIGN_OR_RETURN(
+        tsl::AsyncValueRef<MaybeOwningCpuMemory> device_buffer,
+        MaybeOwningCpuMemory::AllocateAvailableAvr(byte_size, memory_pool));
     buffers.push_back(std::move(device_buffer));
     return std::make_unique<TrackedTfrtCpuDeviceBuffer>(
         /*is_tuple=*/false, /*owns_buffers=*/true, std::move(buffers),
@@ -668,8 +708,9 @@ AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
   buffers.reserve(on_device_shape.tuple_shapes().size());
   for (const auto& leaf_shape : on_device_shape.tuple_shapes()) {
     size_t byte_size = ShapeUtil::ByteSizeOf(leaf_shape);
-    TF_ASSIGN_OR_RETURN(tsl::AsyncValueRef<MaybeOwningCpuMemory> device_buffer,
-                        MaybeOwningCpuMemory::AllocateAvailableAvr(byte_size));
+    TF_ASSIGN_OR_RETURN(
+        tsl::AsyncValueRef<MaybeOwningCpuMemory> device_buffer,
+        MaybeOwningCpuMemory::AllocateAvailableAvr(byte_size, memory_pool));
     buffers.push_back(std::move(device_buffer));
   }
   return std::make_unique<TrackedTfrtCpuDeviceBuffer>(
@@ -698,19 +739,22 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
     PjRtClient::HostBufferSemantics host_buffer_semantics,
     absl::AnyInvocable<void() &&> on_done_with_host_buffer, const Shape& shape,
     AsyncWorkRunner* async_work_runner, absl::Mutex* transpose_mu,
-    TransposePlanCache* transpose_cache) {
+    TransposePlanCache* transpose_cache, CpuMemoryPool* memory_pool) {
   bool has_default_layout =
       !byte_strides || HasMajorToMinorLayout(type, dims, *byte_strides);
   const int bit_width = primitive_util::BitWidth(type);
   // Packed arrays are unpacked on host and packed on device.
   bool is_packed = primitive_util::IsSubByteNonPredType(type);
 
+  size_t byte_size = ShapeUtil::ByteSizeOf(shape);
+
   // If the input buffer has a default layout and is sufficiently aligned, we
-  // can simply point to the input array's data without any further copies. At
-  // the time of writing we require a 16-byte alignment because XLA may generate
-  // code which requires it.
-  bool is_aligned_data = ((absl::bit_cast<std::uintptr_t>(data) &
-                           (cpu_function_runtime::MinAlign() - 1)) == 0);
+  // can simply point to the input array's data without any further copies.
+  // XLA may generate code which requires a 16-byte alignment for large
+  // buffers, but small buffers only need to be aligned to their size.
+  // Executables copy arguments that are less aligned than they require.
+  bool is_aligned_data =
+      IsAlignedTo(data, MinimumAlignmentForBuffer(byte_size));
 
   using HostBufferSemantics = PjRtClient::HostBufferSemantics;
   bool immutable_zero_copy_semantics =
@@ -725,7 +769,6 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
   absl::InlinedVector<tsl::AsyncValueRef<MaybeOwningCpuMemory>, 4> buffers;
   absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events;
   absl::AnyInvocable<void() &&> on_delete_callback;
-  size_t byte_size = ShapeUtil::ByteSizeOf(shape);
   bool owns_buffers = true;
 
   if (can_use_zero_copy && mutable_zero_copy_semantics) {
@@ -751,17 +794,22 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
         is_packed ? CeilOfRatio<size_t>(byte_size, 8 / bit_width) : byte_size;
     TF_ASSIGN_OR_RETURN(
         tsl::AsyncValueRef<MaybeOwningCpuMemory> device_buffer,
-        MaybeOwningCpuMemory::AllocateAvailableAvr(dst_byte_size));
+        MaybeOwningCpuMemory::AllocateAvailableAvr(dst_byte_size,
+                                                   memory_pool));
     auto dst_data_ptr = device_buffer->data();
     buffers.push_back(device_buffer);
+    bool should_sync_copy =
+        host_buffer_semantics ==
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall ||
+        (byte_size < kSmallDataTransferByteSize);
     if (!has_default_layout || is_packed) {
       // If the input array does not have a major-to-minor layout, transpose it
-      // into major-to-minor layout. Currently we choose to always do this
-      // synchronously.
-      // TODO(phawkins): consider performing the transpose asynchronously.
+      // into major-to-minor layout. Like copies, large transposes run
+      // asynchronously unless the host buffer must be consumed during the
+      // call.
       // TODO(phawkins): parallelize the transpose.
       std::shared_ptr<TransposePlan> transpose;
-      {
+      if (!has_default_layout) {
         absl::InlinedVector<int64_t, 4> permutation(dims.size());
         absl::c_iota(permutation, 0);
         TransposePlan::Options options;
@@ -772,29 +820,55 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
         absl::MutexLock lock(transpose_mu);
         TF_ASSIGN_OR_RETURN(transpose, transpose_cache->GetOrCreate(options));
       }
-      if (!is_packed) {
-        transpose->Execute(data, dst_data_ptr);
-      } else {
+      auto convert = [transpose = std::move(transpose), data, dst_data_ptr,
+                      byte_size, dst_byte_size, bit_width, is_packed]() {
+        if (!is_packed) {
+          transpose->Execute(data, dst_data_ptr);
+          return;
+        }
         // First transpose the unpacked data into a new temporary buffer, then
         // pack the data.
-        // TODO(reedwm): Fuse the transpose and packing by having TransposePlan
-        // support packing.
-        auto data_transposed = std::make_unique<char[]>(byte_size);
-        transpose->Execute(data, data_transposed.get());
-        absl::Span<const char> src_data_span(data_transposed.get(), byte_size);
+        // TODO(reedwm): Fuse the transpose and packing by having
+        // TransposePlan support packing.
+        std::unique_ptr<char[]> data_transposed;
+        const void* unpacked = data;
+        if (transpose != nullptr) {
+          data_transposed = std::make_unique<char[]>(byte_size);
+          transpose->Execute(data, data_transposed.get());
+          unpacked = data_transposed.get();
+        }
+        absl::Span<const char> src_data_span(
+            static_cast<const char*>(unpacked), byte_size);
         absl::Span<char> dst_data_span(static_cast<char*>(dst_data_ptr),
                                        dst_byte_size);
         PackIntN(bit_width, src_data_span, dst_data_span);
-      }
-      if (on_done_with_host_buffer) {
-        std::move(on_done_with_host_buffer)();
-        on_done_with_host_buffer = nullptr;
+      };
+      if (should_sync_copy) {
+        convert();
+        if (on_done_with_host_buffer) {
+          std::move(on_done_with_host_buffer)();
+          on_done_with_host_buffer = nullptr;
+        }
+      } else {
+        tsl::AsyncValueRef<CpuEvent> convert_event =
+            tsl::MakeConstructedAsyncValueRef<CpuEvent>();
+        definition_events.push_back(convert_event.CopyRef());
+        async_work_runner->Schedule(
+            [device_buffer = std::move(device_buffer),
+             convert = std::move(convert),
+             convert_event = std::move(convert_event),
+             on_done_with_host_buffer =
+                 std::move(on_done_with_host_buffer)]() mutable {
+              tsl::profiler::TraceMe traceme("H2D Transpose");
+              convert();
+              if (on_done_with_host_buffer) {
+                std::move(on_done_with_host_buffer)();
+                on_done_with_host_buffer = nullptr;
+              }
+              convert_event.SetStateConcrete();
+            });
       }
     } else {
-      bool should_sync_copy =
-          host_buffer_semantics ==
-              PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall ||
-          (byte_size < kSmallDataTransferByteSize);
       if (should_sync_copy) {
         std::memcpy(dst_data_ptr, data, byte_size);
         if (on_done_with_host_buffer) {
@@ -805,13 +879,12 @@ AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
         tsl::AsyncValueRef<CpuEvent> copy_event =
             tsl::MakeConstructedAsyncValueRef<CpuEvent>();
         definition_events.push_back(copy_event.CopyRef());
-        async_work_runner->Schedule(
-            [device_buffer = std::move(device_buffer), dst_data_ptr, data,
-             byte_size, copy_event = std::move(copy_event),
+        CopyOnWorkRunner(
+            async_work_runner, dst_data_ptr, data, byte_size,
+            [device_buffer = std::move(device_buffer),
+             copy_event = std::move(copy_event),
              on_done_with_host_buffer =
                  std::move(on_done_with_host_buffer)]() mutable {
-              tsl::profiler::TraceMe traceme("H2D Dispatch");
-              std::memcpy(dst_data_ptr, data, byte_size);
               if (on_done_with_host_buffer) {
                 std::move(on_done_with_host_buffer)();
                 on_done_with_host_buffer = nullptr;
@@ -899,10 +972,16 @@ AbstractAsyncHostToHostMemoryTransferManager::TransferRawDataToBuffer(
 
 // The definition events of `device_buffers_` must be ready before calling this
 // function.
+//
+// Transfers to the same buffer are independent of each other and are copied
+// concurrently, so producers can stream a buffer in chunks without waiting for
+// previous chunks to land. Consumers only wait for the definition event of the
+// buffer, which is set once its last transfer completes.
 absl::Status
 AbstractAsyncHostToHostMemoryTransferManager::TransferRawDataToSubBuffer(
     int buffer_index, const void* data, int64_t offset, int64_t transfer_size,
     bool is_last_transfer, absl::AnyInvocable<void() &&> on_done) {
+  char* dst;
   {
     // We release the lock when out of scope because
     // `async_work_runner_->Schedule` might sometimes run the closure in this
@@ -915,36 +994,38 @@ AbstractAsyncHostToHostMemoryTransferManager::TransferRawDataToSubBuffer(
     CHECK(!last_transfer_finished_[buffer_index]);
     ++buffer_transfers_in_flight_[buffer_index];
     ++transfers_in_flight_;
+
+    const auto& b = device_buffers_[buffer_index]->Buffers()[0];
+    CHECK(b.IsConcrete());
+    dst = reinterpret_cast<char*>(b->data()) + offset;
   }
 
   CHECK(async_work_runner_ != nullptr);
-  async_work_runner_->Schedule([this, data, offset, transfer_size,
-                                is_last_transfer, on_done = std::move(on_done),
-                                buffer_index]() mutable -> void {
-    tsl::RCReference<tsl::AsyncValue> event;
-    {
-      absl::MutexLock l(&mu_);
-      const auto& b = device_buffers_[buffer_index]->Buffers()[0];
-      CHECK(b.IsConcrete());
-      std::memcpy(reinterpret_cast<char*>(b->data()) + offset, data,
-                  transfer_size);
-      if (is_last_transfer) {
-        last_transfer_finished_[buffer_index] = true;
-      }
-      --buffer_transfers_in_flight_[buffer_index];
-      --transfers_in_flight_;
-      if (buffer_transfers_in_flight_[buffer_index] == 0 &&
-          last_transfer_finished_[buffer_index]) {
-        std::swap(event, avs_[buffer_index]);
-      }
-    }
-    // Call on_done outside the lock because it may call
-    // ~AbstractAsyncHostToHostMemoryTransferManager.
-    std::move(on_done)();
-    if (event) {
-      event->SetStateConcrete();
-    }
-  });
+  // The copy itself runs without holding `mu_`.
+  CopyOnWorkRunner(
+      async_work_runner_, dst, data, transfer_size,
+      [this, is_last_transfer, on_done = std::move(on_done),
+       buffer_index]() mutable -> void {
+        tsl::RCReference<tsl::AsyncValue> event;
+        {
+          absl::MutexLock l(&mu_);
+          if (is_last_transfer) {
+            last_transfer_finished_[buffer_index] = true;
+          }
+          --buffer_transfers_in_flight_[buffer_index];
+          --transfers_in_flight_;
+          if (buffer_transfers_in_flight_[buffer_index] == 0 &&
+              last_transfer_finished_[buffer_index]) {
+            std::swap(event, avs_[buffer_index]);
+          }
+        }
+        // Call on_done outside the lock because it may call
+        // ~AbstractAsyncHostToHostMemoryTransferManager.
+        std::move(on_done)();
+        if (event) {
+          event->SetStateConcrete();
+        }
+      });
   return absl::OkStatus();
 }
 
@@ -36,6 +36,7 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "xla/literal.h"
+#include "xla/pjrt/cpu/cpu_memory_pool.h"
 #include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_future.h"
@@ -50,6 +51,17 @@ limitations under the License.
 
 namespace xla {
 
+// Returns the alignment that code compiled by XLA:CPU may assume for an
+// argument buffer of `byte_size` bytes. Buffers smaller than
+// cpu_function_runtime::MinAlign() only need to be aligned to their size
+// rounded up to a power of two, and empty buffers need no alignment.
+size_t MinimumAlignmentForBuffer(size_t byte_size);
+
+// Returns true if `data` is aligned to `alignment`, which is a power of two.
+inline bool IsAlignedTo(const void* data, size_t alignment) {
+  return (reinterpret_cast<uintptr_t>(data) & (alignment - 1)) == 0;
+}
+
 // A RAII helper class used to set an AsyncValueRef<CpuEvent> to a ready state
 // upon destruction. In many cases in PjRt implementation, there will be
 // multiple return statements in the function, all of which require setting some
@@ -210,11 +222,12 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
       AsyncWorkRunner* async_work_runner);
 
   // Allocates a new `TrackedTfrtCpuDeviceBuffer` with the given shape and
-  // definition events.
+  // definition events, from `memory_pool` if it is not null.
   static absl::StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
   AllocateTrackedDeviceBuffer(
       const Shape& on_device_shape,
-      absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events);
+      absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events,
+      CpuMemoryPool* memory_pool = nullptr);
 
   // Allocates new cpu events to `avs` and `definition_events`. If `shape` is a
   // tuple, multiple events will be allocated. Otherwise, `avs` and
@@ -228,6 +241,13 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
   // device buffer from the host buffer (maybe zero-copy or async).
   // `transpose_mu` and `transpose_cache` are used to transpose the input
   // layout.
+  //
+  // With zero-copy semantics, the host buffer is adopted if it has a
+  // major-to-minor layout and is aligned to MinimumAlignmentForBuffer.
+  // Otherwise it is copied, and unless the semantics require the data to be
+  // consumed during the call, large copies and layout transforms run on
+  // `async_work_runner`. Copies are allocated from `memory_pool` if it is not
+  // null.
   static absl::StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
   BufferFromHostBufferHelper(
       const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
@@ -235,7 +255,8 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
       PjRtClient::HostBufferSemantics host_buffer_semantics,
       absl::AnyInvocable<void() &&> on_done_with_host_buffer,
       const Shape& shape, AsyncWorkRunner* async_work_runner,
-      absl::Mutex* transpose_mu, TransposePlanCache* transpose_cache);
+      absl::Mutex* transpose_mu, TransposePlanCache* transpose_cache,
+      CpuMemoryPool* memory_pool = nullptr);
 
  protected:
   virtual absl::string_view buffer_name() const = 0;
@@ -247,7 +268,8 @@ class AbstractTfrtCpuBuffer : public PjRtBuffer {
       PjRtDevice* dst_device);
 
   absl::StatusOr<std::unique_ptr<TrackedTfrtCpuDeviceBuffer>>
-  CopyToDeviceHelper(AsyncWorkRunner* async_work_runner);
+  CopyToDeviceHelper(AsyncWorkRunner* async_work_runner,
+                     CpuMemoryPool* memory_pool = nullptr);
 
   bool IsEmptyTuple() const {
     return on_device_shape_.IsTuple() &&
@@ -18,6 +18,7 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include <algorithm>
+#include <atomic>
 #include <cfenv>  // NOLINT
 #include <cstddef>
 #include <cstdint>
@@ -41,6 +42,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
@@ -49,6 +51,7 @@ limitations under the License.
 #include "xla/array.h"
 #include "xla/client/executable_build_options.h"
 #include "xla/client/xla_computation.h"
+#include "xla/cpu_function_runtime.h"
 #include "xla/debug_options_flags.h"
 #include "xla/executable_run_options.h"
 #include "xla/hlo/ir/hlo_computation.h"
@@ -60,7 +63,10 @@ limitations under the License.
 #include "xla/literal_util.h"
 #include "xla/pjrt/compile_options.pb.h"
 #include "xla/pjrt/cpu/abstract_tfrt_cpu_buffer.h"
+#include "xla/pjrt/cpu/cpu_memory_pool.h"
 #include "xla/pjrt/cpu/cpu_topology.h"
+#include "xla/pjrt/cpu/cross_host_transfer_manager.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
 #include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
 #include "xla/pjrt/host_memory_spaces.h"
 #include "xla/pjrt/mlir_to_hlo.h"
@@ -111,6 +117,7 @@ limitations under the License.
 #include "tsl/platform/denormal.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
 #include "tsl/platform/setround.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/threadpool.h"
@@ -124,27 +131,80 @@ namespace {
 absl::StatusOr<std::unique_ptr<TfrtCpuBuffer>> AllocateDestinationBuffer(
     const Shape& on_device_shape,
     absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events,
-    TfrtCpuDevice* device, TfrtCpuClient* client) {
+    TfrtCpuDevice* device, TfrtCpuClient* client,
+    PjRtMemorySpace* memory_space = nullptr) {
+  if (memory_space == nullptr) {
+    TF_ASSIGN_OR_RETURN(memory_space, device->default_memory_space());
+  }
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer,
       AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
-          on_device_shape, std::move(definition_events)));
-  return std::make_unique<TfrtCpuBuffer>(
-      on_device_shape, std::move(tracked_device_buffer), client, device,
-      *device->default_memory_space());
+          on_device_shape, std::move(definition_events),
+          device->memory_pool(memory_space)));
+  return std::make_unique<TfrtCpuBuffer>(on_device_shape,
+                                         std::move(tracked_device_buffer),
+                                         client, device, memory_space);
 }
 
 absl::StatusOr<std::unique_ptr<TfrtCpuBuffer>> AllocateDestinationBufferAndAvs(
     const Shape& shape,
     absl::InlinedVector<tsl::RCReference<tsl::AsyncValue>, 4>* avs,
-    TfrtCpuDevice* device, TfrtCpuClient* client) {
+    TfrtCpuDevice* device, TfrtCpuClient* client,
+    PjRtMemorySpace* memory_space = nullptr) {
   // Add a placeholder definition event for each leaf buffer when creating the
   // buffer.
   absl::InlinedVector<tsl::AsyncValueRef<CpuEvent>, 4> definition_events;
   AbstractTfrtCpuBuffer::AllocateAvsAndEvents(shape, avs, &definition_events);
   return AllocateDestinationBuffer(
       shape, std::move(definition_events),
-      tensorflow::down_cast<TfrtCpuDevice*>(device), client);
+      tensorflow::down_cast<TfrtCpuDevice*>(device), client, memory_space);
+}
+
+constexpr char kNoCrossHostTransportError[] =
+    "Cross-host transfers require CpuClientOptions::cross_host_transport.";
+
+// Returns the byte offsets and sizes of `slices` of the combined major
+// `dimensions` of `shape`, see PjRtClient::GatherDetails and
+// PjRtBuffer::ScatterDetails.
+absl::StatusOr<std::vector<std::pair<int64_t, int64_t>>> MajorDimensionSlices(
+    const Shape& shape, absl::Span<const int> dimensions,
+    absl::Span<const std::pair<int64_t, int64_t>> slices) {
+  if (!shape.IsArray()) {
+    return Unimplemented("Cross-host transfers of %s are not supported.",
+                         shape.ToString());
+  }
+  const Layout& layout = shape.has_layout()
+                             ? shape.layout()
+                             : LayoutUtil::GetDefaultLayoutForShape(shape);
+  if (!layout.tiles().empty()) {
+    return Unimplemented(
+        "Cross-host transfers of tiled arrays are not supported.");
+  }
+  int64_t num_indices = 1;
+  for (int i = 0; i < dimensions.size(); ++i) {
+    if (i >= shape.rank() ||
+        dimensions[i] != layout.minor_to_major(shape.rank() - 1 - i)) {
+      return InvalidArgument(
+          "Dimensions {%s} are not the major dimensions of the layout of %s.",
+          absl::StrJoin(dimensions, ","),
+          shape.ToString(/*print_layout=*/true));
+    }
+    num_indices *= shape.dimensions(dimensions[i]);
+  }
+  int64_t byte_size = ShapeUtil::ByteSizeOf(shape);
+  int64_t index_byte_size = num_indices == 0 ? 0 : byte_size / num_indices;
+
+  std::vector<std::pair<int64_t, int64_t>> byte_slices;
+  byte_slices.reserve(slices.size());
+  for (const auto& [start, end] : slices) {
+    if (start < 0 || start > end || end > num_indices) {
+      return InvalidArgument("Slice [%d, %d) is out of bounds for %d indices.",
+                             start, end, num_indices);
+    }
+    byte_slices.push_back(
+        {start * index_byte_size, (end - start) * index_byte_size});
+  }
+  return byte_slices;
 }
 
 const char kCpuPlatformName[] = "cpu";
@@ -314,11 +374,54 @@ TfrtCpuTopologyDescription::DeviceDescriptions() const {
   return devices;
 }
 
-TfrtCpuDevice::TfrtCpuDevice(int process_id, int local_device_id,
-                             int max_inflight_computations)
+TfrtCpuDevice::TfrtCpuDevice(
+    int process_id, int local_device_id, int max_inflight_computations,
+    std::shared_ptr<CpuMemoryPool> memory_pool,
+    std::shared_ptr<CpuMemoryPool> huge_page_memory_pool)
     : description_(process_id, local_device_id),
       max_inflight_computations_semaphore_(
-          /*capacity=*/max_inflight_computations) {}
+          /*capacity=*/max_inflight_computations),
+      memory_pool_(std::move(memory_pool)),
+      huge_page_memory_pool_(std::move(huge_page_memory_pool)) {}
+
+CpuMemoryPool* TfrtCpuDevice::memory_pool(
+    const PjRtMemorySpace* memory_space) const {
+  if (memory_space->kind_id() == HugePageHostMemorySpace::kKindId) {
+    return huge_page_memory_pool_.get();
+  }
+  return memory_pool_.get();
+}
+
+absl::StatusOr<tsl::AllocatorStats> TfrtCpuDevice::GetAllocatorStats() const {
+  if (memory_pool_ == nullptr && huge_page_memory_pool_ == nullptr) {
+    return Unimplemented(
+        "GetAllocatorStats requires CpuClientOptions::enable_memory_pool, "
+        "CpuClientOptions::memory_limit_per_device or "
+        "CpuClientOptions::enable_huge_page_memory_space.");
+  }
+  if (huge_page_memory_pool_ == nullptr) {
+    return memory_pool_->GetStats();
+  }
+  if (memory_pool_ == nullptr) {
+    return huge_page_memory_pool_->GetStats();
+  }
+  // Both memory spaces count towards the stats of the device. The peaks of the
+  // two pools may be reached at different times, so their sum is an upper
+  // bound of the peak of the device.
+  tsl::AllocatorStats stats = memory_pool_->GetStats();
+  tsl::AllocatorStats huge_page_stats = huge_page_memory_pool_->GetStats();
+  stats.num_allocs += huge_page_stats.num_allocs;
+  stats.bytes_in_use += huge_page_stats.bytes_in_use;
+  stats.peak_bytes_in_use += huge_page_stats.peak_bytes_in_use;
+  stats.largest_alloc_size =
+      std::max(stats.largest_alloc_size, huge_page_stats.largest_alloc_size);
+  if (stats.bytes_limit.has_value() && huge_page_stats.bytes_limit) {
+    *stats.bytes_limit += *huge_page_stats.bytes_limit;
+  }
+  *stats.pool_bytes += *huge_page_stats.pool_bytes;
+  *stats.peak_pool_bytes += *huge_page_stats.peak_pool_bytes;
+  return stats;
+}
 
 absl::Status TfrtCpuDevice::TransferToInfeed(const LiteralSlice& literal) {
   return TransferLiteralToInfeedOnCpu(local_hardware_id().value(), literal);
@@ -387,15 +490,39 @@ absl::StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
 
   std::vector<std::unique_ptr<TfrtCpuDevice>> devices;
   for (int i = 0; i < cpu_device_count; ++i) {
+    std::shared_ptr<CpuMemoryPool> memory_pool;
+    if (options.enable_memory_pool ||
+        options.memory_limit_per_device.has_value()) {
+      CpuMemoryPool::Options pool_options;
+      pool_options.memory_limit = options.memory_limit_per_device;
+      if (!options.enable_memory_pool) {
+        // Only enforce the memory limit.
+        pool_options.max_cached_bytes = 0;
+      }
+      memory_pool = CpuMemoryPool::Create(pool_options);
+    }
+    std::shared_ptr<CpuMemoryPool> huge_page_memory_pool;
+    if (options.enable_huge_page_memory_space) {
+      CpuMemoryPool::Options pool_options;
+      pool_options.memory_limit = options.memory_limit_per_device;
+      if (!options.enable_memory_pool) {
+        pool_options.max_cached_bytes = 0;
+      }
+      pool_options.use_huge_pages = true;
+      huge_page_memory_pool = CpuMemoryPool::Create(pool_options);
+    }
     auto device = std::make_unique<TfrtCpuDevice>(
         options.process_id, /*local_device_id=*/i,
-        options.max_inflight_computations_per_device);
+        options.max_inflight_computations_per_device, std::move(memory_pool),
+        std::move(huge_page_memory_pool));
     devices.push_back(std::move(device));
   }
 
   return std::unique_ptr<PjRtClient>(std::make_unique<TfrtCpuClient>(
       options.process_id, std::move(devices), std::move(options.collectives),
-      num_threads, options.asynchronous));
+      num_threads, options.asynchronous, options.compile_cache_size,
+      options.cross_host_transport, options.intra_op_thread_partitions,
+      options.max_inflight_computations_per_executable));
 }
 
 // An upper bound on the number of threads to use for intra-op parallelism. It
@@ -416,7 +543,10 @@ static tsl::ThreadOptions GetThreadOptions() {
 TfrtCpuClient::TfrtCpuClient(
     int process_index, std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
     std::shared_ptr<cpu::CollectivesInterface> collectives, size_t num_threads,
-    bool asynchronous)
+    bool asynchronous, int compile_cache_size,
+    std::shared_ptr<cpu::CrossHostTransport> cross_host_transport,
+    int intra_op_thread_partitions,
+    int max_inflight_computations_per_executable)
     : process_index_(process_index),
       owned_devices_(std::move(devices)),
       computation_placer_(std::make_unique<ComputationPlacer>()),
@@ -425,16 +555,23 @@ TfrtCpuClient::TfrtCpuClient(
                                       "XLATfrtCpuClient", num_threads)),
       async_work_runner_(std::make_unique<ThreadPoolAsyncWorkRunner>(
           pjrt_client_thread_pool_.get())),
-      eigen_intraop_pool_(new tsl::thread::ThreadPool(
-          tsl::Env::Default(), "XLAEigen",
-          std::min(num_threads, kMaxIntraOpThreads))),
-      eigen_intraop_device_(
-          new Eigen::ThreadPoolDevice(eigen_intraop_pool_->AsEigenThreadPool(),
-                                      eigen_intraop_pool_->NumThreads())),
+      intra_op_partitions_(
+          static_cast<int>(std::min(num_threads, kMaxIntraOpThreads)),
+          intra_op_thread_partitions),
+      max_inflight_computations_per_executable_(
+          max_inflight_computations_per_executable),
       last_collective_launch_event_(
           tsl::MakeAvailableAsyncValueRef<CpuEvent>()),
       transpose_cache_(1024),
+      compile_cache_lru_list_(compile_cache_size),
+      compile_cache_(&compile_cache_lru_list_),
       collectives_(std::move(collectives)),
+      cross_host_transfer_manager_(
+          cross_host_transport == nullptr
+              ? nullptr
+              : std::make_unique<cpu::CrossHostTransferManager>(
+                    std::move(cross_host_transport),
+                    cpu::CrossHostTransferManager::Options())),
       topology_(TfrtCpuTopologyDescription::Create(
           platform_id(), platform_name(), platform_version(), owned_devices_,
           cpu::DetectMachineAttributes())),
@@ -468,6 +605,19 @@ TfrtCpuClient::TfrtCpuClient(
     memory_spaces_.push_back(memory_space.get());
     owned_memory_spaces_.push_back(std::move(memory_space));
   }
+  for (auto* device : addressable_devices_) {
+    auto* cpu_device = tensorflow::down_cast<TfrtCpuDevice*>(device);
+    if (cpu_device->huge_page_memory_pool() == nullptr) {
+      continue;
+    }
+    // Offset the ids past the ids of the unpinned host memory spaces above.
+    const int id =
+        device->id() + static_cast<int>(addressable_devices_.size());
+    auto memory_space = std::make_unique<HugePageHostMemorySpace>(id, device);
+    cpu_device->AttachMemorySpace(memory_space.get());
+    memory_spaces_.push_back(memory_space.get());
+    owned_memory_spaces_.push_back(std::move(memory_space));
+  }
 
   LOG(INFO) << "TfrtCpuClient created.";
 }
@@ -735,6 +885,68 @@ static absl::StatusOr<std::unique_ptr<xla::Executable>> JitCompile(
                              compile_options);
 }
 
+// Returns a fingerprint of the features of the host CPU, which the CPU
+// compiler targets.
+static tsl::Fprint128 HostTargetFingerprint() {
+  static const tsl::Fprint128 fingerprint = [] {
+    std::vector<std::string> attributes = cpu::DetectMachineAttributes();
+    absl::c_sort(attributes);
+    return tsl::Fingerprint128(absl::StrJoin(attributes, ","));
+  }();
+  return fingerprint;
+}
+
+// Returns the key of the compile cache entry for compiling `computation` with
+// the given options, which are those passed to JitCompile.
+static absl::StatusOr<tsl::Fprint128> CompileCacheKey(
+    const XlaComputation& computation,
+    absl::Span<const Shape* const> argument_layouts,
+    const ExecutionOptions& execution_options) {
+  std::string serialized;
+  if (!tsl::SerializeToStringDeterministic(computation.proto(), &serialized)) {
+    return Internal("Failed to serialize the computation.");
+  }
+  tsl::Fprint128 key = tsl::FingerprintCat128(HostTargetFingerprint(),
+                                              tsl::Fingerprint128(serialized));
+  if (!tsl::SerializeToStringDeterministic(execution_options, &serialized)) {
+    return Internal("Failed to serialize the execution options.");
+  }
+  key = tsl::FingerprintCat128(key, tsl::Fingerprint128(serialized));
+  for (const Shape* layout : argument_layouts) {
+    if (!tsl::SerializeToStringDeterministic(layout->ToProto(), &serialized)) {
+      return Internal("Failed to serialize an argument layout.");
+    }
+    key = tsl::FingerprintCat128(key, tsl::Fingerprint128(serialized));
+  }
+  return key;
+}
+
+absl::StatusOr<std::shared_ptr<Executable>>
+TfrtCpuClient::CompileOrGetCachedExecutable(
+    const tsl::Fprint128& key,
+    absl::FunctionRef<absl::StatusOr<std::unique_ptr<Executable>>()>
+        compile) {
+  bool inserted = false;
+  std::shared_ptr<CompileCacheEntry> entry;
+  {
+    absl::MutexLock lock(&compile_cache_mu_);
+    entry = compile_cache_.GetOrCreateIfAbsent(key, [&](const tsl::Fprint128&) {
+      inserted = true;
+      return std::make_shared<CompileCacheEntry>();
+    });
+  }
+  if (!inserted) {
+    tsl::profiler::TraceMe traceme("TfrtCpuClient::Compile (cache hit)");
+    entry->compiled.WaitForNotification();
+    return entry->executable;
+  }
+  // Failures are cached too, like in TransposePlanCache: compiling the same
+  // computation with the same options again would fail the same way.
+  entry->executable = compile();
+  entry->compiled.Notify();
+  return entry->executable;
+}
+
 absl::StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
     const XlaComputation& computation, CompileOptions options) {
   tsl::profiler::TraceMe traceme("TfrtCpuClient::Compile (XlaComputation)");
@@ -819,11 +1031,23 @@ absl::StatusOr<std::unique_ptr<PjRtLoadedExecutable>> TfrtCpuClient::Compile(
   if (!compile_options.thread_pool) {
     compile_options.thread_pool = pjrt_client_thread_pool();
   }
-  TF_ASSIGN_OR_RETURN(
-      std::unique_ptr<Executable> cpu_executable,
-      JitCompile(computation, argument_layout_pointers, build_options,
-                 execution_options, compile_options,
-                 eigen_intraop_device()->getPool()->NumThreads()));
+  auto jit_compile = [&]() {
+    return JitCompile(computation, argument_layout_pointers, build_options,
+                      execution_options, compile_options,
+                      intra_op_partitions_.max_threads_per_partition());
+  };
+  std::shared_ptr<Executable> cpu_executable;
+  // Layout canonicalization callbacks can't be part of the cache key.
+  if (compile_cache_lru_list_.Capacity() > 0 &&
+      !build_options.layout_canonicalization_callback()) {
+    TF_ASSIGN_OR_RETURN(tsl::Fprint128 key,
+                        CompileCacheKey(computation, argument_layout_pointers,
+                                        execution_options));
+    TF_ASSIGN_OR_RETURN(cpu_executable,
+                        CompileOrGetCachedExecutable(key, jit_compile));
+  } else {
+    TF_ASSIGN_OR_RETURN(cpu_executable, jit_compile());
+  }
   auto cpu_executable_ptr =
       tensorflow::down_cast<cpu::CpuExecutable*>(cpu_executable.get());
 
@@ -941,13 +1165,162 @@ TfrtCpuClient::CreateBuffersForAsyncHostToDevice(
   return CreateBuffersForAsyncHostToDevice(shapes, memory_space->devices()[0]);
 }
 
+absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+TfrtCpuClient::MakeCrossHostReceiveBuffers(absl::Span<const Shape> shapes,
+                                           PjRtDevice* device,
+                                           PjRtCrossHostRecvNotifier notifier) {
+  std::vector<std::vector<std::pair<int64_t, int64_t>>> slices;
+  slices.reserve(shapes.size());
+  for (const Shape& shape : shapes) {
+    TF_ASSIGN_OR_RETURN(
+        slices.emplace_back(),
+        MajorDimensionSlices(shape, /*dimensions=*/{}, {{0, 1}}));
+  }
+  return MakeCrossHostReceiveBuffersHelper(shapes, slices, device,
+                                           std::move(notifier));
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+TfrtCpuClient::MakeCrossHostReceiveBuffersForGather(
+    absl::Span<const Shape> shapes, std::vector<GatherDetails> gather_details,
+    PjRtDevice* device, PjRtCrossHostRecvNotifier notifier) {
+  if (gather_details.size() != shapes.size()) {
+    return InvalidArgument("Got %d gather details for %d shapes.",
+                           gather_details.size(), shapes.size());
+  }
+  std::vector<std::vector<std::pair<int64_t, int64_t>>> slices;
+  slices.reserve(shapes.size());
+  for (int i = 0; i < shapes.size(); ++i) {
+    // Slice boundaries are cumulative.
+    std::vector<std::pair<int64_t, int64_t>> gather_slices;
+    int64_t start = 0;
+    for (int64_t end : gather_details[i].slice_boundaries) {
+      gather_slices.push_back({start, end});
+      start = end;
+    }
+    TF_ASSIGN_OR_RETURN(
+        slices.emplace_back(),
+        MajorDimensionSlices(shapes[i], gather_details[i].dimensions,
+                             gather_slices));
+  }
+  return MakeCrossHostReceiveBuffersHelper(shapes, slices, device,
+                                           std::move(notifier));
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+TfrtCpuClient::MakeCrossHostReceiveBuffersHelper(
+    absl::Span<const Shape> shapes,
+    absl::Span<const std::vector<std::pair<int64_t, int64_t>>> slices,
+    PjRtDevice* device, PjRtCrossHostRecvNotifier notifier) {
+  tsl::profiler::TraceMe traceme("TfrtCpuClient::MakeCrossHostReceiveBuffers");
+  if (cross_host_transfer_manager_ == nullptr) {
+    return absl::UnimplementedError(kNoCrossHostTransportError);
+  }
+  if (device->client() != this) {
+    return InvalidArgument("Device is not attached to this client");
+  }
+
+  // None of the buffers becomes ready until all of the receives complete.
+  auto definition_event = tsl::MakeConstructedAsyncValueRef<CpuEvent>();
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers;
+  std::vector<tsl::AsyncValueRef<MaybeOwningCpuMemory>> memories;
+  int num_receives = 0;
+  for (int i = 0; i < shapes.size(); ++i) {
+    TF_ASSIGN_OR_RETURN(
+        std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer,
+        AbstractTfrtCpuBuffer::AllocateTrackedDeviceBuffer(
+            shapes[i], {definition_event.CopyRef()},
+            tensorflow::down_cast<TfrtCpuDevice*>(device)->memory_pool()));
+    memories.push_back(tracked_device_buffer->Buffers()[0]);
+    buffers.push_back(std::make_unique<TfrtCpuBuffer>(
+        shapes[i], std::move(tracked_device_buffer), this,
+        tensorflow::down_cast<TfrtCpuDevice*>(device),
+        *device->default_memory_space()));
+    num_receives += slices[i].size();
+  }
+
+  struct ReceiveState {
+    explicit ReceiveState(int num_receives) : num_pending(num_receives) {}
+    std::atomic<int> num_pending;
+    absl::Mutex mu;
+    absl::Status status ABSL_GUARDED_BY(mu);
+  };
+  auto state = std::make_shared<ReceiveState>(num_receives);
+  auto on_received = [state, definition_event](absl::Status status) {
+    if (!status.ok()) {
+      absl::MutexLock lock(&state->mu);
+      state->status.Update(status);
+    }
+    if (state->num_pending.fetch_sub(1) == 1) {
+      absl::MutexLock lock(&state->mu);
+      if (state->status.ok()) {
+        definition_event.SetStateConcrete();
+      } else {
+        definition_event.SetError(state->status);
+      }
+    }
+  };
+  if (num_receives == 0) {
+    definition_event.SetStateConcrete();
+  }
+
+  PjRtCrossHostRecvState recv_state;
+  recv_state.descriptors.resize(shapes.size());
+  for (int i = 0; i < shapes.size(); ++i) {
+    for (const auto& [offset, size] : slices[i]) {
+      recv_state.descriptors[i].serialized_descriptors.push_back(
+          cross_host_transfer_manager_->Receive(memories[i], offset, size,
+                                                on_received));
+    }
+  }
+  recv_state.cancel_notifier =
+      [manager = cross_host_transfer_manager_.get()](
+          absl::string_view serialized_descriptor, absl::Status reason,
+          std::function<void(absl::Status)> on_canceled) {
+        on_canceled(
+            manager->CancelReceive(serialized_descriptor, std::move(reason)));
+      };
+  notifier(std::move(recv_state));
+  return buffers;
+}
+
 absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
     const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
     std::optional<absl::Span<int64_t const>> byte_strides,
     HostBufferSemantics host_buffer_semantics,
     absl::AnyInvocable<void() &&> on_done_with_host_buffer,
     PjRtDevice* device) {
+  TF_ASSIGN_OR_RETURN(PjRtMemorySpace * memory_space,
+                      device->default_memory_space());
+  return BufferFromHostBuffer(data, type, dims, byte_strides,
+                              host_buffer_semantics,
+                              std::move(on_done_with_host_buffer), memory_space,
+                              /*device_layout=*/nullptr);
+}
+
+absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
+    const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
+    std::optional<absl::Span<int64_t const>> byte_strides,
+    HostBufferSemantics host_buffer_semantics,
+    absl::AnyInvocable<void() &&> on_done_with_host_buffer,
+    PjRtMemorySpace* memory_space, const Layout* device_layout) {
   tsl::profiler::TraceMe traceme("TfrtCpuClient::BufferFromHostBuffer");
+  if (device_layout != nullptr) {
+    return absl::UnimplementedError(absl::StrCat(
+        "BufferFromHostBuffer with an optional device layout is not "
+        "implemented on platform: ",
+        platform_name()));
+  }
+  CHECK_EQ(memory_space->devices().size(), 1);
+  PjRtDevice* device = memory_space->devices()[0];
+  if (memory_space->kind_id() == HugePageHostMemorySpace::kKindId &&
+      (host_buffer_semantics == HostBufferSemantics::kImmutableZeroCopy ||
+       host_buffer_semantics == HostBufferSemantics::kMutableZeroCopy)) {
+    // Adopting the caller's memory would leave the buffer without huge pages,
+    // so copy it into the huge page memory space instead.
+    host_buffer_semantics =
+        HostBufferSemantics::kImmutableUntilTransferCompletes;
+  }
   Shape shape = ShapeUtil::MakeShape(type, dims);
   VLOG(2) << "TfrtCpuClient::BufferFromHostBuffer: shape: " << shape.ToString()
           << " device: " << device->DebugString();
@@ -961,12 +1334,13 @@ absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
       AbstractTfrtCpuBuffer::BufferFromHostBufferHelper(
           data, type, dims, byte_strides, host_buffer_semantics,
           std::move(on_done_with_host_buffer), shape, async_work_runner(),
-          &transpose_mu_, &transpose_cache_));
+          &transpose_mu_, &transpose_cache_,
+          tensorflow::down_cast<TfrtCpuDevice*>(device)->memory_pool(
+              memory_space)));
 
   return std::unique_ptr<PjRtBuffer>(std::make_unique<TfrtCpuBuffer>(
       shape, std::move(tracked_device_buffer), this,
-      tensorflow::down_cast<TfrtCpuDevice*>(device),
-      *device->default_memory_space()));
+      tensorflow::down_cast<TfrtCpuDevice*>(device), memory_space));
 }
 
 absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
@@ -986,46 +1360,37 @@ absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
                               std::move(on_done_with_host_buffer), device);
 }
 
-absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuClient::BufferFromHostBuffer(
-    const void* data, PrimitiveType type, absl::Span<int64_t const> dims,
-    std::optional<absl::Span<int64_t const>> byte_strides,
-    HostBufferSemantics host_buffer_semantics,
-    absl::AnyInvocable<void() &&> on_done_with_host_buffer,
-    PjRtMemorySpace* memory_space, const Layout* device_layout) {
-  CHECK_EQ(memory_space->devices().size(), 1);
-  return BufferFromHostBuffer(data, type, dims, byte_strides,
-                              host_buffer_semantics,
-                              std::move(on_done_with_host_buffer),
-                              memory_space->devices()[0], device_layout);
+absl::StatusOr<std::unique_ptr<PjRtBuffer>>
+TfrtCpuClient::BufferFromHostLiteral(const LiteralSlice& literal,
+                                     PjRtDevice* device) {
+  TF_ASSIGN_OR_RETURN(PjRtMemorySpace * memory_space,
+                      device->default_memory_space());
+  return BufferFromHostLiteral(literal, memory_space);
 }
 
 absl::StatusOr<std::unique_ptr<PjRtBuffer>>
 TfrtCpuClient::BufferFromHostLiteral(const LiteralSlice& literal,
-                                     PjRtDevice* device) {
+                                     PjRtMemorySpace* memory_space) {
   tsl::profiler::TraceMe traceme("TfrtCpuClient::BufferFromHostLiteral");
+  CHECK_EQ(memory_space->devices().size(), 1);
+  PjRtDevice* device = memory_space->devices()[0];
   VLOG(1) << "TfrtCpuClient::BufferFromHostLiteral: shape: "
           << literal.shape().DebugString()
-          << " device: " << device->DebugString();
+          << " memory space: " << memory_space->DebugString();
   const Shape& shape = literal.shape();
 
   absl::InlinedVector<tsl::RCReference<tsl::AsyncValue>, 4> avs;
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<TfrtCpuBuffer> output_buffer,
       AllocateDestinationBufferAndAvs(
-          shape, &avs, tensorflow::down_cast<TfrtCpuDevice*>(device), this));
+          shape, &avs, tensorflow::down_cast<TfrtCpuDevice*>(device), this,
+          memory_space));
 
   output_buffer->CopyFromLiteral(literal, shape, &avs, async_work_runner());
 
   return std::unique_ptr<PjRtBuffer>(std::move(output_buffer));
 }
 
-absl::StatusOr<std::unique_ptr<PjRtBuffer>>
-TfrtCpuClient::BufferFromHostLiteral(const LiteralSlice& literal,
-                                     PjRtMemorySpace* memory_space) {
-  CHECK_EQ(memory_space->devices().size(), 1);
-  return BufferFromHostLiteral(literal, memory_space->devices()[0]);
-}
-
 TfrtCpuBuffer::TfrtCpuBuffer(
     Shape on_device_shape,
     std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer,
@@ -1076,32 +1441,158 @@ absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuBuffer::CopyToDevice(
     return CopyToDeviceAcrossClients(dst_device);
   }
 
+  TF_ASSIGN_OR_RETURN(PjRtMemorySpace * dst_memory_space,
+                      dst_device->default_memory_space());
+  return CopyToMemorySpace(dst_memory_space);
+}
+
+absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuBuffer::CopyToMemorySpace(
+    PjRtMemorySpace* dst_memory_space) {
+  tsl::profiler::TraceMe traceme("TfrtCpuBuffer::CopyToMemorySpace");
+  CHECK_EQ(dst_memory_space->devices().size(), 1);
+  PjRtDevice* dst_device = dst_memory_space->devices()[0];
+  if (dst_memory_space == memory_space_) {
+    return InvalidArgument(
+        "CopyToMemorySpace cannot accept the same source and destination "
+        "memory spaces");
+  }
+
+  // Copying across PjRtClients involves a copy through the host.
+  if (dst_device->client() != client_) {
+    return CopyToDeviceAcrossClients(dst_device);
+  }
+
   if (!dst_device->IsAddressable()) {
     return InvalidArgument("Cannot copy array to non-addressable device %s",
                            dst_device->DebugString());
   }
 
+  auto* tfrt_dst_device = tensorflow::down_cast<TfrtCpuDevice*>(dst_device);
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<TrackedTfrtCpuDeviceBuffer> tracked_device_buffer,
-      CopyToDeviceHelper(client()->async_work_runner()));
+      CopyToDeviceHelper(client()->async_work_runner(),
+                         tfrt_dst_device->memory_pool(dst_memory_space)));
 
   return std::unique_ptr<PjRtBuffer>(std::make_unique<TfrtCpuBuffer>(
       on_device_shape_, std::move(tracked_device_buffer), client(),
-      tensorflow::down_cast<TfrtCpuDevice*>(dst_device),
-      *dst_device->default_memory_space()));
+      tfrt_dst_device, dst_memory_space));
 }
 
-absl::StatusOr<std::unique_ptr<PjRtBuffer>> TfrtCpuBuffer::CopyToMemorySpace(
-    PjRtMemorySpace* dst_memory_space) {
-  CHECK_EQ(dst_memory_space->devices().size(), 1);
-  return CopyToDevice(dst_memory_space->devices()[0]);
+void TfrtCpuBuffer::CopyToRemoteDevice(
+    PjRtFuture<std::string> serialized_descriptor,
+    RemoteSendCallback on_done) {
+  auto slices =
+      MajorDimensionSlices(on_device_shape_, /*dimensions=*/{}, {{0, 1}});
+  if (!slices.ok()) {
+    on_done(slices.status(), /*sends_were_enqueued=*/false);
+    return;
+  }
+  auto send = PrepareRemoteSend(*std::move(slices), {std::move(on_done)});
+  if (send == nullptr) {
+    return;
+  }
+  serialized_descriptor.OnReady(
+      [send = std::move(send)](
+          const absl::StatusOr<std::string>& serialized_descriptor) {
+        if (!serialized_descriptor.ok()) {
+          send(serialized_descriptor.status());
+          return;
+        }
+        send(std::vector<std::string>{*serialized_descriptor});
+      });
+}
+
+void TfrtCpuBuffer::CopyToRemoteDeviceScattered(
+    PjRtFuture<std::vector<std::string>> serialized_descriptors,
+    std::vector<RemoteSendCallback> callbacks,
+    const ScatterDetails& scatter_details) {
+  auto slices = MajorDimensionSlices(
+      on_device_shape_, scatter_details.dimensions, scatter_details.slices);
+  if (slices.ok() && slices->size() != callbacks.size()) {
+    slices = InvalidArgument("Got %d callbacks for %d slices.",
+                             callbacks.size(), slices->size());
+  }
+  if (!slices.ok()) {
+    for (const RemoteSendCallback& on_done : callbacks) {
+      on_done(slices.status(), /*sends_were_enqueued=*/false);
+    }
+    return;
+  }
+  auto send = PrepareRemoteSend(*std::move(slices), std::move(callbacks));
+  if (send == nullptr) {
+    return;
+  }
+  serialized_descriptors.OnReady(std::move(send));
+}
+
+std::function<void(absl::StatusOr<std::vector<std::string>>)>
+TfrtCpuBuffer::PrepareRemoteSend(
+    std::vector<std::pair<int64_t, int64_t>> slices,
+    std::vector<RemoteSendCallback> callbacks) {
+  auto fail = [&](absl::Status status) {
+    for (const RemoteSendCallback& on_done : callbacks) {
+      on_done(status, /*sends_were_enqueued=*/false);
+    }
+    return nullptr;
+  };
+  cpu::CrossHostTransferManager* manager =
+      client_->cross_host_transfer_manager();
+  if (manager == nullptr) {
+    return fail(absl::UnimplementedError(kNoCrossHostTransportError));
+  }
+  auto usage_event = tsl::MakeConstructedAsyncValueRef<CpuEvent>();
+  auto* device_buffer = AcquireUsage(usage_event);
+  if (device_buffer == nullptr) {
+    return fail(InvalidArgument(
+        "CopyToRemoteDevice called on deleted or donated buffer"));
+  }
+
+  // Sends once both the descriptors and the buffer are ready. The usage event
+  // is set once all of the sends are done.
+  return [manager, slices = std::move(slices),
+          callbacks = std::move(callbacks),
+          memory = device_buffer->Buffers()[0],
+          definition_event = device_buffer->definition_event(),
+          usage_event = std::move(usage_event)](
+             absl::StatusOr<std::vector<std::string>> serialized_descriptors) {
+    definition_event.AndThen([=]() {
+      absl::Status status = serialized_descriptors.status();
+      if (auto* error = definition_event.GetErrorIfPresent()) {
+        status = *error;
+      } else if (status.ok() &&
+                 serialized_descriptors->size() != slices.size()) {
+        status = InvalidArgument("Got %d descriptors for %d slices.",
+                                 serialized_descriptors->size(),
+                                 slices.size());
+      }
+      if (!status.ok() || slices.empty()) {
+        for (const RemoteSendCallback& on_done : callbacks) {
+          on_done(status, /*sends_were_enqueued=*/false);
+        }
+        usage_event.SetStateConcrete();
+        return;
+      }
+      auto num_pending = std::make_shared<std::atomic<int>>(slices.size());
+      for (int i = 0; i < slices.size(); ++i) {
+        manager->Send(memory, slices[i].first, slices[i].second,
+                      (*serialized_descriptors)[i],
+                      [on_done = callbacks[i], num_pending, usage_event](
+                          absl::Status status, bool sends_were_enqueued) {
+                        on_done(std::move(status), sends_were_enqueued);
+                        if (num_pending->fetch_sub(1) == 1) {
+                          usage_event.SetStateConcrete();
+                        }
+                      });
+      }
+    });
+  };
 }
 
 TfrtCpuExecutable::TfrtCpuExecutable(
     int num_replicas, int num_partitions,
     std::shared_ptr<DeviceAssignment> device_assignment,
     bool parameter_is_tupled_arguments, CompileOptions compile_options,
-    std::unique_ptr<Executable> cpu_executable,
+    std::shared_ptr<Executable> cpu_executable,
     BufferAllocation::Index result_buffer_index,
     absl::InlinedVector<BufferAllocation::Index, 4> result_buffer_indices,
     std::vector<LogicalDeviceIds> addressable_device_logical_ids,
@@ -1127,6 +1618,13 @@ TfrtCpuExecutable::TfrtCpuExecutable(
   // It is a crude heuristic to find computation less than the thread context
   // switch time (~5us).
   cheap_computation_ = hlo_cost_analysis->flop_count() < 1000;
+  if (client_->max_inflight_computations_per_executable_ > 0) {
+    for (const PjRtDevice* device : client_->addressable_devices()) {
+      inflight_computations_semaphores_[device] = std::make_shared<Semaphore>(
+          client_->max_inflight_computations_per_executable_);
+    }
+  }
+  SetUpParameterAlignments();
 
   const auto& computation_layout =
       cpu_executable_->module().entry_computation_layout();
@@ -1162,6 +1660,32 @@ absl::StatusOr<std::optional<std::string>> TfrtCpuExecutable::Fingerprint()
   return std::optional<std::string>();
 }
 
+absl::StatusOr<std::string> TfrtCpuExecutable::FingerprintExecutable() const {
+  const tsl::Fprint128 fingerprint = tsl::FingerprintCat128(
+      HostTargetFingerprint(),
+      tsl::Fingerprint128(cpu_executable_->module().ToString(
+          HloPrintOptions::ModuleFingerprint())));
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+void TfrtCpuExecutable::SetUpParameterAlignments() {
+  auto* cpu_executable =
+      tensorflow::down_cast<cpu::CpuExecutable*>(cpu_executable_.get());
+  const BufferAssignment& assignment = cpu_executable->buffer_assignment();
+  parameter_alignments_.assign(assignment.Allocations().size(), 1);
+  for (const BufferAllocation& allocation : assignment.Allocations()) {
+    if (!allocation.is_entry_computation_parameter()) continue;
+    // Host kernels of the thunk runtime assume that all buffers are aligned
+    // to the minimum alignment, while code emitted for the whole module only
+    // assumes alignment up to the size of each parameter.
+    parameter_alignments_[allocation.index()] =
+        cpu_executable->has_thunks() && allocation.size() > 0
+            ? cpu_function_runtime::MinAlign()
+            : MinimumAlignmentForBuffer(allocation.size());
+  }
+}
+
 absl::Status TfrtCpuExecutable::SetUpDonation(bool tuple_inputs) {
   TF_ASSIGN_OR_RETURN(parameters_that_must_be_donated_,
                       ComputeParametersThatMustBeDonated(
@@ -1183,10 +1707,12 @@ struct BufferAlloc {
   // All data members should have the same size.
   absl::InlinedVector<tsl::AsyncValueRef<MaybeOwningCpuMemory>, 4> buffers;
   absl::InlinedVector<size_t, 4> allocation_sizes;
+  CpuMemoryPool* memory_pool = nullptr;
 
   void Allocate() {
     for (int i = 0; i < buffers.size(); ++i) {
-      auto memory = MaybeOwningCpuMemory::Allocate(allocation_sizes[i]);
+      auto memory =
+          MaybeOwningCpuMemory::Allocate(allocation_sizes[i], memory_pool);
       if (!memory.ok()) {
         buffers[i].SetError(memory.status());
         return;
@@ -1203,10 +1729,12 @@ struct BufferAllocAndCopy {
   absl::InlinedVector<tsl::AsyncValueRef<MaybeOwningCpuMemory>, 4> src_buffers;
   absl::InlinedVector<tsl::AsyncValueRef<MaybeOwningCpuMemory>, 4> dst_buffers;
   absl::InlinedVector<size_t, 4> allocation_sizes;
+  CpuMemoryPool* memory_pool = nullptr;
 
   void AllocateAndCopy() {
     for (int i = 0; i < src_buffers.size(); ++i) {
-      auto memory = MaybeOwningCpuMemory::Allocate(allocation_sizes[i]);
+      auto memory =
+          MaybeOwningCpuMemory::Allocate(allocation_sizes[i], memory_pool);
       if (!memory.ok()) {
         dst_buffers[i].SetError(memory.status());
         return;
@@ -1221,10 +1749,31 @@ struct BufferAllocAndCopy {
 
 }  // namespace
 
+// Keeps the semaphore alive until the reservation is released.
+class TfrtCpuExecutable::ExecutableReservation {
+ public:
+  explicit ExecutableReservation(std::shared_ptr<Semaphore> semaphore)
+      : semaphore_(std::move(semaphore)),
+        reservation_(semaphore_->ScopedAcquire(1)) {}
+
+ private:
+  std::shared_ptr<Semaphore> semaphore_;
+  Semaphore::ScopedReservation reservation_;
+};
+
+std::unique_ptr<TfrtCpuExecutable::ExecutableReservation>
+TfrtCpuExecutable::AcquireExecutableReservation(const PjRtDevice* device) {
+  auto it = inflight_computations_semaphores_.find(device);
+  if (it == inflight_computations_semaphores_.end()) {
+    return nullptr;
+  }
+  return std::make_unique<ExecutableReservation>(it->second);
+}
+
 // The following few helpers are adapted from XLA:CPU to create a buffer table
 // and assemble the buffer pointers in order to call into CpuExecutable.
 static absl::StatusOr<BufferInfo> MemoryForAllocation(
-    const BufferAllocation& allocation,
+    const BufferAllocation& allocation, size_t alignment,
     absl::Span<const cpu::CpuExecutable::ConstantAllocation> constants,
     absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const> arguments,
     BufferAlloc& buffer_alloc, BufferAllocAndCopy& buffer_alloc_and_copy) {
@@ -1237,10 +1786,17 @@ static absl::StatusOr<BufferInfo> MemoryForAllocation(
         << "Size mismatch on param " << allocation.parameter_number()
         << " at shape index " << allocation.param_shape_index().ToString();
 
+    // Buffers allocated by the client are always sufficiently aligned, but
+    // adopted host buffers and views of external memory may be less aligned
+    // than the executable requires, in which case they are copied.
+    bool is_underaligned =
+        out.IsAvailable() && !IsAlignedTo(out->data(), alignment);
+
     // If we don't own the buffer, we can't overwrite it or donate it. For
     // example we might be pointing to a buffer owned by the client whose
     // lifetime will not extend past the lifetime of the donated input buffer.
-    if ((!can_donate || !arg->owns_buffers()) && !allocation.is_readonly()) {
+    if (((!can_donate || !arg->owns_buffers()) && !allocation.is_readonly()) ||
+        is_underaligned) {
       auto copy = tsl::MakeUnconstructedAsyncValueRef<MaybeOwningCpuMemory>();
 
       buffer_alloc_and_copy.src_buffers.push_back(std::move(out));
@@ -1290,6 +1846,7 @@ static absl::StatusOr<BufferInfo> MemoryForAllocation(
 
 static absl::StatusOr<std::vector<BufferInfo>> CreateBufferTable(
     const BufferAssignment& assignment,
+    absl::Span<const size_t> parameter_alignments,
     absl::Span<const cpu::CpuExecutable::ConstantAllocation> constants,
     absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const> arguments,
     BufferAlloc& buffer_alloc, BufferAllocAndCopy& buffer_alloc_and_copy) {
@@ -1298,8 +1855,8 @@ static absl::StatusOr<std::vector<BufferInfo>> CreateBufferTable(
     const BufferAllocation& allocation = assignment.GetAllocation(i);
     TF_ASSIGN_OR_RETURN(
         buffer_table[i],
-        MemoryForAllocation(allocation, constants, arguments, buffer_alloc,
-                            buffer_alloc_and_copy));
+        MemoryForAllocation(allocation, parameter_alignments[i], constants,
+                            arguments, buffer_alloc, buffer_alloc_and_copy));
   }
   return std::move(buffer_table);
 }
@@ -1336,11 +1893,92 @@ absl::Status TfrtCpuExecutable::CheckBufferCompatibilities(
   return absl::OkStatus();
 }
 
+// Launches on one device that are dispatched together by
+// TfrtCpuClient::ExecuteBatch. All launches share one execute event and one
+// compute reservation, and run back-to-back in a single task once the inputs of
+// every launch are ready.
+class TfrtCpuExecuteBatch {
+ public:
+  explicit TfrtCpuExecuteBatch(TfrtCpuDevice* device)
+      : device_(device),
+        execute_event_(tsl::MakeConstructedAsyncValueRef<CpuEvent>()),
+        ready_on_exit_(execute_event_.CopyRef()) {}
+
+  tsl::AsyncValueRef<CpuEvent> execute_event() const {
+    return execute_event_.CopyRef();
+  }
+
+  // Adds a computation that runs after `input_deps` are ready and after all
+  // computations added before it.
+  void Add(std::vector<tsl::RCReference<tsl::AsyncValue>> input_deps,
+           bool execute_inline,
+           absl::AnyInvocable<absl::Status()> computation) {
+    for (auto& dep : input_deps) {
+      // Computations of the batch run in order, so a computation that uses the
+      // outputs of an earlier one does not wait for the batch itself.
+      if (dep.get() == execute_event_.GetAsyncValue()) {
+        continue;
+      }
+      input_deps_.push_back(std::move(dep));
+    }
+    execute_inline_ = execute_inline_ && execute_inline;
+    computations_.push_back(std::move(computation));
+  }
+
+  // Returns the events that the batch waits for.
+  absl::Span<const tsl::RCReference<tsl::AsyncValue>> input_deps() const {
+    return input_deps_;
+  }
+
+  // Runs the computations of the batch, on the calling thread if they are all
+  // cheap enough and have no pending inputs, or else on `client`'s thread pool.
+  // The compute reservation is only taken here, so that batches waiting to be
+  // launched do not hold slots of the device. Batches that are never launched
+  // drop their computations, which aborts their donations, and mark their
+  // execute event ready when destroyed.
+  void Launch(TfrtCpuClient* client) && {
+    auto compute_reservation = std::make_unique<Semaphore::ScopedReservation>(
+        device_->max_inflight_computations_semaphore().ScopedAcquire(1));
+    auto last_enqueue_event = client->GetLastEnqueueEvent();
+    if (!last_enqueue_event.IsAvailable()) {
+      input_deps_.push_back(std::move(last_enqueue_event));
+    }
+    auto run = [computations = std::move(computations_),
+                compute_reservation = std::move(compute_reservation),
+                execute_event = std::move(ready_on_exit_).Release()]() mutable {
+      for (auto& computation : computations) {
+        absl::Status status = computation();
+        if (!status.ok()) {
+          execute_event.SetError(std::move(status));
+          return;
+        }
+      }
+      execute_event.SetStateConcrete();
+    };
+    if (input_deps_.empty() && execute_inline_) {
+      run();
+      return;
+    }
+    client->SetLastEnqueueEvent(execute_event_.CopyRef());
+    EnqueueWorkWhenReady(client->pjrt_client_thread_pool(), input_deps_,
+                         std::move(run));
+  }
+
+ private:
+  TfrtCpuDevice* device_;
+  tsl::AsyncValueRef<CpuEvent> execute_event_;
+  MarkEventReadyOnExit ready_on_exit_;
+  std::vector<tsl::RCReference<tsl::AsyncValue>> input_deps_;
+  bool execute_inline_ = true;
+  std::vector<absl::AnyInvocable<absl::Status()>> computations_;
+};
+
 absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
     absl::Span<PjRtBuffer* const> argument_handles, int replica, int partition,
     const RunId& run_id, const ExecuteOptions& options,
     tsl::AsyncValueRef<CpuEvent> last_collective_launch_event, bool fill_future,
-    TfrtCpuDevice* device) {
+    TfrtCpuDevice* device, TfrtCpuExecuteBatch* batch,
+    std::unique_ptr<ExecutableReservation> executable_reservation) {
   tsl::profiler::TraceMe traceme("TfrtCpuExecutable::ExecuteHelper");
 
   std::shared_ptr<DeviceAssignment> device_assignment;
@@ -1378,9 +2016,14 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
   }
 
   // `execute_event` indicates whether cpu computation is complete and whether
-  // there was an error.
-  auto execute_event = tsl::MakeConstructedAsyncValueRef<CpuEvent>();
-  MarkEventReadyOnExit ready_on_exit(execute_event);
+  // there was an error. Launches of a batch share the batch's event, which the
+  // batch is responsible for marking ready.
+  auto execute_event = batch != nullptr
+                           ? batch->execute_event()
+                           : tsl::MakeConstructedAsyncValueRef<CpuEvent>();
+  MarkEventReadyOnExit ready_on_exit(
+      batch != nullptr ? tsl::AsyncValueRef<CpuEvent>()
+                       : execute_event.CopyRef());
 
   absl::InlinedVector<TfrtCpuBuffer::DonationTransaction, 4>
       donation_transactions;
@@ -1494,12 +2137,14 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
   // `buffer_alloc` and `buffer_alloc_and_copy` are used to do real memory
   // allocation and copy work.
   BufferAlloc buffer_alloc;
+  buffer_alloc.memory_pool = device->memory_pool();
   BufferAllocAndCopy buffer_alloc_and_copy;
+  buffer_alloc_and_copy.memory_pool = device->memory_pool();
   TF_ASSIGN_OR_RETURN(
       std::vector<BufferInfo> buffer_table,
       CreateBufferTable(cpu_executable->buffer_assignment(),
-                        cpu_executable->constants(), tracked_buffers,
-                        buffer_alloc, buffer_alloc_and_copy));
+                        parameter_alignments_, cpu_executable->constants(),
+                        tracked_buffers, buffer_alloc, buffer_alloc_and_copy));
   auto result_buffers_info =
       CreateResultBufferInfo(result_buffer_indices_, buffer_table);
 
@@ -1507,16 +2152,31 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
   // pacing to avoid problems such as memory fragmentation and running ahead
   // too far, not for correctness. Placing it before the executable launch
   // allows the inputs for the next executable to be fetched even if the
-  // launch is delayed.
-  auto compute_reservation = std::make_unique<Semaphore::ScopedReservation>(
-      device->max_inflight_computations_semaphore().ScopedAcquire(1));
+  // launch is delayed. A batch holds a single reservation for all of its
+  // launches.
+  //
+  // The reservation of the executable is taken first, so that an executable
+  // waiting for its own computations does not hold a slot of the device.
+  std::unique_ptr<Semaphore::ScopedReservation> compute_reservation;
+  if (batch == nullptr) {
+    if (executable_reservation == nullptr) {
+      executable_reservation = AcquireExecutableReservation(device);
+    }
+    compute_reservation = std::make_unique<Semaphore::ScopedReservation>(
+        device->max_inflight_computations_semaphore().ScopedAcquire(1));
+  }
+
+  // Intra-op work runs on one partition of the intra-op threads for the whole
+  // execution.
+  IntraOpThreadPartitions::Lease intra_op_lease =
+      client_->intra_op_partitions().Acquire();
 
   ExecutableRunOptions run_options;
   run_options.set_run_id(run_id);
   run_options.set_device_ordinal(device->id());
   // Need to keep device_assignment alive until execution completes.
   run_options.set_device_assignment(device_assignment.get());
-  run_options.set_intra_op_thread_pool(client_->eigen_intraop_device());
+  run_options.set_intra_op_thread_pool(intra_op_lease.device());
 
   auto cpu_run_options = std::make_shared<cpu::CpuExecutableRunOptions>();
   cpu_run_options->set_collectives(client_->collectives_.get());
@@ -1528,9 +2188,9 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
   // launch or not.
   if (is_a_collective_launch) {
     input_deps.push_back(std::move(last_collective_launch_event));
-  } else {
+  } else if (batch == nullptr) {
     // This is a non-parallel computation. Add the last enqueue event as a
-    // dependency.
+    // dependency. Batches are ordered after the last enqueue event as a whole.
     auto last_enqueue_event = client_->GetLastEnqueueEvent();
     if (!last_enqueue_event.IsAvailable()) {
       input_deps.push_back(std::move(last_enqueue_event));
@@ -1550,7 +2210,7 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
     execute_inline = true;
   }
 
-  if (input_deps.empty() && execute_inline) {
+  if (batch == nullptr && input_deps.empty() && execute_inline) {
     // Synchronously call generated function or thunk sequence.
 
     // Set denormal and rounding behavior to match the default TF
@@ -1642,21 +2302,9 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
 
   } else {
     // Asynchronously call generated function.
-
-    // We only created enough threads for one collective to complete.
-    // The next collective launch will not be scheduled onto threadpool until
-    // this one completes.
-    if (is_a_collective_launch) {
-      client_->SetLastCollectiveLaunchEvent(execute_event.CopyRef());
-    } else {
-      // This is a non-parallel computation. Set the execute event as the new
-      // last enqueue event.
-      client_->SetLastEnqueueEvent(execute_event.CopyRef());
-    }
     std::vector<tsl::RCReference<tsl::AsyncValue>> input_deps_avs_copy =
         CopyAsyncValues(input_deps);
-    EnqueueWorkWhenReady(
-        client()->pjrt_client_thread_pool(), input_deps,
+    auto computation =
         [cpu_executable, buffer_alloc = std::move(buffer_alloc),
          buffer_alloc_and_copy = std::move(buffer_alloc_and_copy),
          result_buffer_index = result_buffer_index_,
@@ -1665,128 +2313,145 @@ absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteHelper(
          cpu_executable_copy = cpu_executable_,
          device_assignment = std::move(device_assignment),
          cpu_run_options = std::move(cpu_run_options),
-         compute_reservation = std::move(compute_reservation),
          tuplized_arg = std::move(tuplized_arg),
          donation_transactions = std::move(donation_transactions),
-         execute_event = std::move(ready_on_exit).Release(),
          input_deps_avs = std::move(input_deps_avs_copy),
-         eigen_device = client()->eigen_intraop_device()]() mutable {
-          // Because `input_deps` contains the definition events of all inputs,
-          // when it is ready, all input buffers must have been allocated. So,
-          // we are safe to allocate and copy memory here. Since `execute_event`
-          // may error out, we need to do it early.
-          buffer_alloc.Allocate();
-          buffer_alloc_and_copy.AllocateAndCopy();
-
-          for (const auto& av : input_deps_avs) {
-            if (auto* error = av->GetErrorIfPresent()) {
-              execute_event.SetError(absl::StrCat(
-                  "Error dispatching computation: %s", error->message()));
-              return;
-            }
-          }
+         intra_op_lease = std::move(intra_op_lease)]() mutable
+        -> absl::Status {
+      // Because `input_deps` contains the definition events of all inputs,
+      // when it is ready, all input buffers must have been allocated. So, we
+      // are safe to allocate and copy memory here. Since `execute_event` may
+      // error out, we need to do it early.
+      buffer_alloc.Allocate();
+      buffer_alloc_and_copy.AllocateAndCopy();
+
+      for (const auto& av : input_deps_avs) {
+        if (auto* error = av->GetErrorIfPresent()) {
+          return absl::InternalError(absl::StrCat(
+              "Error dispatching computation: %s", error->message()));
+        }
+      }
 
-          // Set denormal and rounding behavior to match the default TF
-          // ThreadPool behavior.
-          tsl::port::ScopedFlushDenormal flush;
-          tsl::port::ScopedSetRound round(FE_TONEAREST);
-
-          // Prepare for computation.
-          std::vector<void*> buffer_pointers;
-          buffer_pointers.reserve(buffer_table.size());
-          for (const auto& buffer_info : buffer_table) {
-            CHECK(buffer_info.buffer.IsAvailable());
-            if (buffer_info.buffer.IsError()) {
-              execute_event.SetError(
-                  absl::StrCat("Error preparing computation: %s",
-                               buffer_info.buffer.GetError().message()));
-              return;
-            }
-            buffer_pointers.push_back(buffer_info.buffer->data());
-          }
-          void* result_buffer = buffer_pointers[result_buffer_index];
+      // Set denormal and rounding behavior to match the default TF
+      // ThreadPool behavior.
+      tsl::port::ScopedFlushDenormal flush;
+      tsl::port::ScopedSetRound round(FE_TONEAREST);
 
-          absl::Status status;
+      // Prepare for computation.
+      std::vector<void*> buffer_pointers;
+      buffer_pointers.reserve(buffer_table.size());
+      for (const auto& buffer_info : buffer_table) {
+        CHECK(buffer_info.buffer.IsAvailable());
+        if (buffer_info.buffer.IsError()) {
+          return absl::InternalError(
+              absl::StrCat("Error preparing computation: %s",
+                           buffer_info.buffer.GetError().message()));
+        }
+        buffer_pointers.push_back(buffer_info.buffer->data());
+      }
+      void* result_buffer = buffer_pointers[result_buffer_index];
 
-          if (cpu_executable->has_compute_function()) {
-            // Call jit-compiled function implementing XLA executable.
-            XlaCustomCallStatus compute_function_status;
+      absl::Status status;
 
-            cpu_executable->compute_function()(
-                result_buffer, &run_options, nullptr, buffer_pointers.data(),
-                &compute_function_status, nullptr);
-            if (auto error_message =
-                    xla::CustomCallStatusGetMessage(&compute_function_status)) {
-              status =
-                  Internal("Generated function failed: %s", *error_message);
-            }
+      if (cpu_executable->has_compute_function()) {
+        // Call jit-compiled function implementing XLA executable.
+        XlaCustomCallStatus compute_function_status;
 
-          } else if (cpu_executable->has_thunks()) {
-            // Call interpreted thunk sequence implementing XLA executable.
-            absl::InlinedVector<MaybeOwningDeviceMemory, 8> buffer_device_mem;
-            buffer_device_mem.reserve(buffer_table.size());
-            for (const auto& buffer_info : buffer_table) {
-              buffer_device_mem.emplace_back(se::DeviceMemoryBase(
-                  buffer_info.buffer->data(), buffer_info.buffer->size()));
-            }
+        cpu_executable->compute_function()(
+            result_buffer, &run_options, nullptr, buffer_pointers.data(),
+            &compute_function_status, nullptr);
+        if (auto error_message =
+                xla::CustomCallStatusGetMessage(&compute_function_status)) {
+          status = Internal("Generated function failed: %s", *error_message);
+        }
 
-            cpu::BufferAllocations allocations(buffer_device_mem);
-
-            absl::StatusOr<cpu::Thunk::CollectiveExecuteParams>
-                collective_params =
-                    cpu::Thunk::CollectiveExecuteParams::Create(&run_options);
-
-            absl::StatusOr<cpu::Thunk::CustomCallExecuteParams>
-                custom_call_params =
-                    cpu::Thunk::CustomCallExecuteParams::Create(&run_options);
-
-            cpu::Thunk::TaskRunner task_runner =
-                [&run_options](cpu::Thunk::Task task) {
-                  run_options.intra_op_thread_pool()->getPool()->Schedule(
-                      std::move(task));
-                };
-
-            if (collective_params.ok()) {
-              cpu::Thunk::ExecuteParams execute_params = {
-                  &cpu_executable->function_registry(),
-                  &allocations,
-                  cpu::runtime::GetXfeedManager(run_options.device_ordinal()),
-                  run_options.intra_op_thread_pool(),
-                  &task_runner,
-                  &*collective_params,
-                  &*custom_call_params};
-
-              auto thunks_execute_event =
-                  cpu_executable->thunks().Execute(execute_params);
-
-              tsl::profiler::TraceMe trace(
-                  "ThunkExecutor::Execute (wait for completion)");
-              tsl::BlockUntilReady(thunks_execute_event);
-              status = thunks_execute_event.IsError()
-                           ? thunks_execute_event.GetError()
-                           : absl::OkStatus();
-            } else {
-              status = collective_params.status();
-            }
+      } else if (cpu_executable->has_thunks()) {
+        // Call interpreted thunk sequence implementing XLA executable.
+        absl::InlinedVector<MaybeOwningDeviceMemory, 8> buffer_device_mem;
+        buffer_device_mem.reserve(buffer_table.size());
+        for (const auto& buffer_info : buffer_table) {
+          buffer_device_mem.emplace_back(se::DeviceMemoryBase(
+              buffer_info.buffer->data(), buffer_info.buffer->size()));
+        }
 
-          } else {
-            status =
-                Internal("CpuExecutable has no compute function or thunks.");
-          }
+        cpu::BufferAllocations allocations(buffer_device_mem);
+
+        absl::StatusOr<cpu::Thunk::CollectiveExecuteParams> collective_params =
+            cpu::Thunk::CollectiveExecuteParams::Create(&run_options);
+
+        absl::StatusOr<cpu::Thunk::CustomCallExecuteParams>
+            custom_call_params =
+                cpu::Thunk::CustomCallExecuteParams::Create(&run_options);
+
+        cpu::Thunk::TaskRunner task_runner =
+            [&run_options](cpu::Thunk::Task task) {
+              run_options.intra_op_thread_pool()->getPool()->Schedule(
+                  std::move(task));
+            };
+
+        if (collective_params.ok()) {
+          cpu::Thunk::ExecuteParams execute_params = {
+              &cpu_executable->function_registry(),
+              &allocations,
+              cpu::runtime::GetXfeedManager(run_options.device_ordinal()),
+              run_options.intra_op_thread_pool(),
+              &task_runner,
+              &*collective_params,
+              &*custom_call_params};
+
+          auto thunks_execute_event =
+              cpu_executable->thunks().Execute(execute_params);
+
+          tsl::profiler::TraceMe trace(
+              "ThunkExecutor::Execute (wait for completion)");
+          tsl::BlockUntilReady(thunks_execute_event);
+          status = thunks_execute_event.IsError()
+                       ? thunks_execute_event.GetError()
+                       : absl::OkStatus();
+        } else {
+          status = collective_params.status();
+        }
 
-          for (auto& donation_transaction : donation_transactions) {
-            std::move(donation_transaction).Commit();
-          }
+      } else {
+        status = Internal("CpuExecutable has no compute function or thunks.");
+      }
 
-          if (!status.ok()) {
-            // CPU computation fails with an error.
-            execute_event.SetError(std::move(status));
-            return;
-          }
+      for (auto& donation_transaction : donation_transactions) {
+        std::move(donation_transaction).Commit();
+      }
+      return status;
+    };
+
+    if (batch != nullptr) {
+      batch->Add(std::move(input_deps), execute_inline, std::move(computation));
+    } else {
+      // We only created enough threads for one collective to complete.
+      // The next collective launch will not be scheduled onto threadpool until
+      // this one completes.
+      if (is_a_collective_launch) {
+        client_->SetLastCollectiveLaunchEvent(execute_event.CopyRef());
+      } else {
+        // This is a non-parallel computation. Set the execute event as the new
+        // last enqueue event.
+        client_->SetLastEnqueueEvent(execute_event.CopyRef());
+      }
+      EnqueueWorkWhenReady(
+          client()->pjrt_client_thread_pool(), input_deps,
+          [computation = std::move(computation),
+           executable_reservation = std::move(executable_reservation),
+           compute_reservation = std::move(compute_reservation),
+           execute_event = std::move(ready_on_exit).Release()]() mutable {
+            absl::Status status = computation();
+            if (!status.ok()) {
+              // CPU computation fails with an error.
+              execute_event.SetError(std::move(status));
+              return;
+            }
 
-          // CPU computation completes.
-          execute_event.SetStateConcrete();
-        });
+            // CPU computation completes.
+            execute_event.SetStateConcrete();
+          });
+    }
   }
 
   // Create output TFRT buffers.
@@ -1951,6 +2616,17 @@ TfrtCpuExecutable::Execute(
     tsl::AsyncValueRef<CpuEvent> last_collective_launch_event =
         client_->GetLastCollectiveLaunchEvent();
 
+    // The replicas may wait for each other in collectives, so the slots of
+    // this executable are taken for all of them before any is launched, and
+    // always in the same order, so that concurrent calls cannot each hold
+    // some of the slots that the other one needs.
+    std::vector<std::unique_ptr<ExecutableReservation>> executable_reservations(
+        num_addressable_devices);
+    for (int i = 0; i < num_addressable_devices; ++i) {
+      executable_reservations[i] =
+          AcquireExecutableReservation(addressable_devices_[i]);
+    }
+
     absl::Mutex mu;
     int running = num_addressable_devices;
     int failed = 0;
@@ -1962,10 +2638,11 @@ TfrtCpuExecutable::Execute(
 
       auto* thread_pool = client()->pjrt_client_thread_pool();
       EnqueueWork(thread_pool, [&, replica, partition, i] {
-        auto statusor =
-            ExecuteHelper(argument_handles[i], replica, partition, run_id,
-                          options, last_collective_launch_event.CopyRef(),
-                          returned_futures.has_value());
+        auto statusor = ExecuteHelper(
+            argument_handles[i], replica, partition, run_id, options,
+            last_collective_launch_event.CopyRef(),
+            returned_futures.has_value(), /*device=*/nullptr,
+            /*batch=*/nullptr, std::move(executable_reservations[i]));
         if (statusor.ok()) {
           wrapped_results[i] = std::move(statusor->buffers);
           if (returned_futures.has_value()) {
@@ -2068,4 +2745,121 @@ TfrtCpuExecutable::ExecutePortable(
   returned_future = std::move(result.future);
   return std::move(result.buffers);
 }
+
+absl::StatusOr<PjRtLoadedExecutable::Result> TfrtCpuExecutable::ExecuteBatched(
+    absl::Span<PjRtBuffer* const> argument_handles, PjRtDevice* device,
+    const ExecuteOptions& options, bool fill_future,
+    TfrtCpuExecuteBatch& batch) {
+  if (device_assignment_ == nullptr) {
+    if (num_replicas() != 1 || num_partitions() != 1) {
+      return InvalidArgument(
+          "ExecuteBatch expects a single-core portable executable but gets "
+          "one with %d replica %d partition",
+          num_replicas(), num_partitions());
+    }
+    return ExecuteHelper(
+        argument_handles, /*replica=*/0, /*partition=*/0, RunId(), options,
+        /*last_collective_launch_event=*/tsl::AsyncValueRef<CpuEvent>(),
+        fill_future, tensorflow::down_cast<TfrtCpuDevice*>(device), &batch);
+  }
+  for (int i = 0; i < addressable_devices_.size(); ++i) {
+    if (addressable_devices_[i] == device) {
+      return ExecuteHelper(
+          argument_handles, addressable_device_logical_ids_[i].replica,
+          addressable_device_logical_ids_[i].partition, RunId(), options,
+          /*last_collective_launch_event=*/tsl::AsyncValueRef<CpuEvent>(),
+          fill_future, /*device=*/nullptr, &batch);
+    }
+  }
+  return InvalidArgument(
+      "ExecuteBatch attempted to execute %s on device id %d which is not "
+      "assigned to it",
+      name(), device->id());
+}
+
+absl::StatusOr<std::vector<std::vector<std::unique_ptr<PjRtBuffer>>>>
+TfrtCpuClient::ExecuteBatch(
+    absl::Span<const PjRtBatchedLaunch> launches, const ExecuteOptions& options,
+    std::optional<std::vector<PjRtFuture<>>>& returned_futures) {
+  tsl::profiler::TraceMe traceme("TfrtCpuClient::ExecuteBatch");
+  const bool fill_future = returned_futures.has_value();
+
+  // Open batches by device. A batch is closed, and later launches on its
+  // device start a new batch, once a launch of another batch waits for it.
+  // Batches then only ever wait for batches closed before them, so they
+  // cannot wait for each other. Nothing is launched until every launch has
+  // been accepted: if one fails, the batches are dropped, which aborts their
+  // donations, and none of the launches run.
+  absl::flat_hash_map<PjRtDevice*, int> batch_index;
+  absl::flat_hash_map<const tsl::AsyncValue*, int> batch_by_event;
+  std::vector<std::unique_ptr<TfrtCpuExecuteBatch>> batches;
+  std::vector<bool> closed;
+  std::vector<int> launch_order;
+  std::vector<std::vector<std::unique_ptr<PjRtBuffer>>> results;
+  results.reserve(launches.size());
+  std::vector<PjRtFuture<>> futures;
+  futures.reserve(launches.size());
+  for (const PjRtBatchedLaunch& launch : launches) {
+    if (launch.executable->client() != this) {
+      return InvalidArgument(
+          "ExecuteBatch got an executable %s that is not loaded by this "
+          "client",
+          launch.executable->name());
+    }
+    if (launch.device == nullptr || launch.device->client() != this) {
+      return InvalidArgument(
+          "ExecuteBatch expects devices that are addressable by this client");
+    }
+    auto [it, inserted] =
+        batch_index.try_emplace(launch.device, batches.size());
+    if (inserted) {
+      batches.push_back(std::make_unique<TfrtCpuExecuteBatch>(
+          tensorflow::down_cast<TfrtCpuDevice*>(launch.device)));
+      closed.push_back(false);
+      batch_by_event[batches.back()->execute_event().GetAsyncValue()] =
+          it->second;
+    }
+    TfrtCpuExecuteBatch& batch = *batches[it->second];
+    const size_t num_input_deps = batch.input_deps().size();
+    TF_ASSIGN_OR_RETURN(
+        PjRtLoadedExecutable::Result result,
+        tensorflow::down_cast<TfrtCpuExecutable*>(launch.executable)
+            ->ExecuteBatched(launch.argument_handles, launch.device, options,
+                             fill_future, batch));
+    for (const auto& dep : batch.input_deps().subspan(num_input_deps)) {
+      auto other = batch_by_event.find(dep.get());
+      if (other == batch_by_event.end()) {
+        continue;
+      }
+      const int index = other->second;
+      batch_by_event.erase(other);
+      for (auto device_it = batch_index.begin(); device_it != batch_index.end();
+           ++device_it) {
+        if (device_it->second == index) {
+          batch_index.erase(device_it);
+          break;
+        }
+      }
+      closed[index] = true;
+      launch_order.push_back(index);
+    }
+    results.push_back(std::move(result.buffers));
+    if (fill_future) {
+      futures.push_back(std::move(*result.future));
+    }
+  }
+
+  for (int i = 0; i < batches.size(); ++i) {
+    if (!closed[i]) {
+      launch_order.push_back(i);
+    }
+  }
+  for (int index : launch_order) {
+    std::move(*batches[index]).Launch(this);
+  }
+  if (fill_future) {
+    returned_futures = std::move(futures);
+  }
+  return results;
+}
 }  // namespace xla
@@ -29,11 +29,13 @@ limitations under the License.
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/types/span.h"
 #include "unsupported/Eigen/CXX11/Tensor"
 #include "mlir/IR/BuiltinOps.h"
@@ -43,8 +45,13 @@ limitations under the License.
 #include "xla/layout.h"
 #include "xla/literal.h"
 #include "xla/pjrt/cpu/abstract_tfrt_cpu_buffer.h"
+#include "xla/pjrt/cpu/cpu_memory_pool.h"
 #include "xla/pjrt/cpu/cpu_topology.h"
+#include "xla/pjrt/cpu/cross_host_transfer_manager.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
+#include "xla/pjrt/cpu/intra_op_thread_partitions.h"
 #include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
+#include "xla/pjrt/lru_cache.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_common.h"
 #include "xla/pjrt/pjrt_compiler.h"
@@ -62,6 +69,7 @@ limitations under the License.
 #include "xla/service/hlo_cost_analysis.h"
 #include "xla/shape.h"
 #include "xla/tsl/concurrency/async_value_ref.h"
+#include "xla/tsl/framework/allocator.h"
 #include "xla/util.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/errors.h"
@@ -71,6 +79,7 @@ limitations under the License.
 namespace xla {
 
 class TfrtCpuDevice;  // forward declare
+class TfrtCpuExecuteBatch;  // forward declare
 
 class TfrtCpuDeviceDescription final : public PjRtDeviceDescription {
  public:
@@ -190,8 +199,14 @@ class TfrtCpuTopologyDescription : public PjRtTopologyDescription {
 
 class TfrtCpuDevice final : public PjRtDevice {
  public:
-  explicit TfrtCpuDevice(int process_id, int local_device_id,
-                         int max_inflight_computations = 32);
+  // Buffers of the device are allocated from `memory_pool`, or directly from
+  // the system if it is null. If `huge_page_memory_pool` is set, the client
+  // attaches a HugePageHostMemorySpace to the device whose buffers are
+  // allocated from it.
+  explicit TfrtCpuDevice(
+      int process_id, int local_device_id, int max_inflight_computations = 32,
+      std::shared_ptr<CpuMemoryPool> memory_pool = nullptr,
+      std::shared_ptr<CpuMemoryPool> huge_page_memory_pool = nullptr);
 
   const TfrtCpuDeviceDescription& description() const override {
     return description_;
@@ -241,6 +256,23 @@ class TfrtCpuDevice final : public PjRtDevice {
     return nullptr;
   }
 
+  // Returns the pool that buffers of this device are allocated from, or null.
+  CpuMemoryPool* memory_pool() const { return memory_pool_.get(); }
+
+  // Returns the pool that buffers in `memory_space` of this device are
+  // allocated from, or null.
+  CpuMemoryPool* memory_pool(const PjRtMemorySpace* memory_space) const;
+
+  // Returns the pool backing the huge page memory space, or null if the device
+  // has none.
+  CpuMemoryPool* huge_page_memory_pool() const {
+    return huge_page_memory_pool_.get();
+  }
+
+  // Returns the combined stats of the pools of all memory spaces of the
+  // device.
+  absl::StatusOr<tsl::AllocatorStats> GetAllocatorStats() const override;
+
  private:
   PjRtClient* client_ = nullptr;
   TfrtCpuDeviceDescription description_;
@@ -251,6 +283,9 @@ class TfrtCpuDevice final : public PjRtDevice {
   // Semaphore used to limit how many programs can be enqueued by the host
   // ahead of the device.
   Semaphore max_inflight_computations_semaphore_;
+
+  std::shared_ptr<CpuMemoryPool> memory_pool_;
+  std::shared_ptr<CpuMemoryPool> huge_page_memory_pool_;
 };
 
 class TfrtCpuClient final : public PjRtClient {
@@ -258,7 +293,12 @@ class TfrtCpuClient final : public PjRtClient {
   TfrtCpuClient(int process_index,
                 std::vector<std::unique_ptr<TfrtCpuDevice>> devices,
                 std::shared_ptr<cpu::CollectivesInterface> collectives,
-                size_t num_threads, bool asynchronous);
+                size_t num_threads, bool asynchronous,
+                int compile_cache_size = 0,
+                std::shared_ptr<cpu::CrossHostTransport> cross_host_transport =
+                    nullptr,
+                int intra_op_thread_partitions = 1,
+                int max_inflight_computations_per_executable = 0);
   ~TfrtCpuClient() override;
 
   int process_index() const override { return process_index_; }
@@ -314,6 +354,14 @@ class TfrtCpuClient final : public PjRtClient {
       absl::string_view serialized,
       std::optional<CompileOptions> options) override;
 
+  // Launches on the same device share one completion event and run
+  // back-to-back in a single task once all of their inputs are ready.
+  absl::StatusOr<std::vector<std::vector<std::unique_ptr<PjRtBuffer>>>>
+  ExecuteBatch(
+      absl::Span<const PjRtBatchedLaunch> launches,
+      const ExecuteOptions& options,
+      std::optional<std::vector<PjRtFuture<>>>& returned_futures) override;
+
   absl::StatusOr<std::unique_ptr<PjRtBuffer>> CreateErrorBuffer(
       absl::Status error, const Shape& shape, PjRtDevice* device) override;
 
@@ -358,20 +406,17 @@ class TfrtCpuClient final : public PjRtClient {
   absl::StatusOr<std::unique_ptr<PjRtBuffer>> BufferFromHostLiteral(
       const LiteralSlice& literal, PjRtMemorySpace* memory_space) override;
 
+  // Cross-host transfers require CpuClientOptions::cross_host_transport.
+  // Only array shapes are supported.
   absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
   MakeCrossHostReceiveBuffers(absl::Span<const Shape> shapes,
                               PjRtDevice* device,
-                              PjRtCrossHostRecvNotifier notifier) override {
-    return Unimplemented("MakeCrossHostReceiveBuffers not implemented.");
-  }
+                              PjRtCrossHostRecvNotifier notifier) override;
 
   absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
   MakeCrossHostReceiveBuffersForGather(
       absl::Span<const Shape> shapes, std::vector<GatherDetails> gather_details,
-      PjRtDevice* device, PjRtCrossHostRecvNotifier notifier) override {
-    return Unimplemented(
-        "MakeCrossHostReceiveBuffersForGather not implemented.");
-  }
+      PjRtDevice* device, PjRtCrossHostRecvNotifier notifier) override;
 
   absl::StatusOr<std::unique_ptr<PjRtBuffer>> CreateViewOfDeviceBuffer(
       void* device_ptr, const Shape& shape, PjRtDevice* device,
@@ -400,8 +445,18 @@ class TfrtCpuClient final : public PjRtClient {
     return async_work_runner_.get();
   }
 
+  // Returns nullptr if the client has no cross-host transport.
+  cpu::CrossHostTransferManager* cross_host_transfer_manager() const {
+    return cross_host_transfer_manager_.get();
+  }
+
+  // Returns the device of the first intra-op thread partition.
   Eigen::ThreadPoolDevice* eigen_intraop_device() const {
-    return eigen_intraop_device_.get();
+    return intra_op_partitions_.default_device();
+  }
+
+  IntraOpThreadPartitions& intra_op_partitions() {
+    return intra_op_partitions_;
   }
 
   tsl::AsyncValueRef<CpuEvent> GetLastCollectiveLaunchEvent() {
@@ -430,6 +485,31 @@ class TfrtCpuClient final : public PjRtClient {
  private:
   friend class TfrtCpuExecutable;
 
+  // An executable that is being, or has been, compiled. Threads that find an
+  // entry in the cache wait for `compiled` before reading `executable`.
+  struct CompileCacheEntry {
+    absl::Notification compiled;
+    absl::StatusOr<std::shared_ptr<Executable>> executable;
+  };
+  using CompileCache = LRUCache<tsl::Fprint128,
+                                std::shared_ptr<CompileCacheEntry>,
+                                tsl::Fprint128Hasher>;
+
+  // Returns the executable cached under `key`, calling `compile` to create it
+  // if it is absent. Concurrent calls with the same key compile only once.
+  absl::StatusOr<std::shared_ptr<Executable>> CompileOrGetCachedExecutable(
+      const tsl::Fprint128& key,
+      absl::FunctionRef<absl::StatusOr<std::unique_ptr<Executable>>()>
+          compile);
+
+  // Allocates buffers for `shapes` and starts receiving the byte ranges
+  // `slices[i]` of buffer `i`, each from its own sender.
+  absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>>
+  MakeCrossHostReceiveBuffersHelper(
+      absl::Span<const Shape> shapes,
+      absl::Span<const std::vector<std::pair<int64_t, int64_t>>> slices,
+      PjRtDevice* device, PjRtCrossHostRecvNotifier notifier);
+
   int process_index_;
   // Includes all devices, including non-addressable devices.
   std::vector<std::unique_ptr<TfrtCpuDevice>> owned_devices_;
@@ -451,8 +531,11 @@ class TfrtCpuClient final : public PjRtClient {
   std::unique_ptr<AsyncWorkRunner> async_work_runner_;
 
   // TODO(zhangqiaorjc): Use tsl::compat::EigenHostContextThreadPool.
-  std::unique_ptr<tsl::thread::ThreadPool> eigen_intraop_pool_;
-  std::unique_ptr<Eigen::ThreadPoolDevice> eigen_intraop_device_;
+  IntraOpThreadPartitions intra_op_partitions_;
+
+  // The number of computations of each executable that may be in flight at a
+  // time, or zero if it is unlimited.
+  int max_inflight_computations_per_executable_;
 
   // Launching collectives are prone to deadlock when we use fixed-sized
   // threadpools since ExecuteHelper will block until all replicas reach the
@@ -474,8 +557,19 @@ class TfrtCpuClient final : public PjRtClient {
   absl::Mutex transpose_mu_;
   TransposePlanCache transpose_cache_ ABSL_GUARDED_BY(transpose_mu_);
 
+  // A cache of compiled executables, keyed by a fingerprint of everything
+  // that determines the result of compilation. Disabled if its capacity is
+  // zero.
+  absl::Mutex compile_cache_mu_;
+  CompileCache::LRUList compile_cache_lru_list_;
+  CompileCache compile_cache_ ABSL_GUARDED_BY(compile_cache_mu_);
+
   std::shared_ptr<cpu::CollectivesInterface> collectives_;
 
+  // Implements cross-host transfers. Null if the client has no cross-host
+  // transport.
+  std::unique_ptr<cpu::CrossHostTransferManager> cross_host_transfer_manager_;
+
   xla::TfrtCpuTopologyDescription topology_;
 
   // Used to control whether asynchronous computation dispatch is available for
@@ -519,9 +613,25 @@ class TfrtCpuBuffer final : public AbstractTfrtCpuBuffer {
   absl::StatusOr<std::unique_ptr<PjRtBuffer>> CopyToMemorySpace(
       PjRtMemorySpace* dst_memory_space) override;
 
+  void CopyToRemoteDevice(PjRtFuture<std::string> serialized_descriptor,
+                          RemoteSendCallback on_done) override;
+
+  void CopyToRemoteDeviceScattered(
+      PjRtFuture<std::vector<std::string>> serialized_descriptors,
+      std::vector<RemoteSendCallback> callbacks,
+      const ScatterDetails& scatter_details) override;
+
  private:
   absl::string_view buffer_name() const override { return "TfrtCpuBuffer"; }
 
+  // Acquires a usage of the buffer and returns a function that sends the byte
+  // ranges `slices` of it to the receives in its argument once the buffer is
+  // defined. Returns nullptr, after calling `callbacks` with an error, if the
+  // buffer cannot be sent.
+  std::function<void(absl::StatusOr<std::vector<std::string>>)>
+  PrepareRemoteSend(std::vector<std::pair<int64_t, int64_t>> slices,
+                    std::vector<RemoteSendCallback> callbacks);
+
   TfrtCpuClient* client_;
   TfrtCpuDevice* const device_;
   PjRtMemorySpace* const memory_space_;
@@ -533,7 +643,7 @@ class TfrtCpuExecutable final : public PjRtLoadedExecutable {
       int num_replicas, int num_partitions,
       std::shared_ptr<DeviceAssignment> device_assignment,
       bool parameter_is_tupled_arguments, CompileOptions compile_options,
-      std::unique_ptr<Executable> cpu_executable,
+      std::shared_ptr<Executable> cpu_executable,
       BufferAllocation::Index result_buffer_index,
       absl::InlinedVector<BufferAllocation::Index, 4> result_buffer_indices,
       std::vector<LogicalDeviceIds> addressable_device_logical_ids,
@@ -623,9 +733,9 @@ class TfrtCpuExecutable final : public PjRtLoadedExecutable {
 
   std::shared_ptr<Executable> cpu_executable() const { return cpu_executable_; }
 
-  absl::StatusOr<std::string> FingerprintExecutable() const override {
-    return Unimplemented("Fingerprinting executable is not supported.");
-  }
+  // Returns a fingerprint of the optimized HLO module and of the features of
+  // the host CPU it was compiled for.
+  absl::StatusOr<std::string> FingerprintExecutable() const override;
 
   absl::StatusOr<CompileOptions> GetCompileOptions() const override {
     return compile_options_;
@@ -636,17 +746,42 @@ class TfrtCpuExecutable final : public PjRtLoadedExecutable {
 
   absl::Status SetUpDonation(bool tuple_inputs);
 
+  // Records the alignment the compiled code requires for each parameter
+  // allocation of the buffer assignment.
+  void SetUpParameterAlignments();
+
   // Checks that the input buffers passed in by the user have the correct size
   // on device for the compiled program.
   absl::Status CheckBufferCompatibilities(
       absl::Span<std::pair<bool, TrackedTfrtCpuDeviceBuffer*> const>
           input_buffers) const;
 
+  // A reservation of an in-flight slot of this executable on one device.
+  class ExecutableReservation;
+
+  // Waits for an in-flight slot of this executable on `device`. Returns null
+  // if the client does not limit the computations of an executable.
+  std::unique_ptr<ExecutableReservation> AcquireExecutableReservation(
+      const PjRtDevice* device);
+
+  // If `batch` is not null, the computation is added to `batch` instead of
+  // being launched, and its outputs are defined by the batch's execute event.
+  // If `executable_reservation` is null, a slot of this executable is acquired
+  // on the device, unless the computation is added to a batch.
   absl::StatusOr<Result> ExecuteHelper(
       absl::Span<PjRtBuffer* const> argument_handles, int replica,
       int partition, const RunId& run_id, const ExecuteOptions& options,
       tsl::AsyncValueRef<CpuEvent> last_collective_launch_event,
-      bool fill_future, TfrtCpuDevice* device = nullptr);
+      bool fill_future, TfrtCpuDevice* device = nullptr,
+      TfrtCpuExecuteBatch* batch = nullptr,
+      std::unique_ptr<ExecutableReservation> executable_reservation = nullptr);
+
+  // Adds an execution on `device` to `batch`, as ExecuteSharded or
+  // ExecutePortable would run it.
+  absl::StatusOr<Result> ExecuteBatched(
+      absl::Span<PjRtBuffer* const> argument_handles, PjRtDevice* device,
+      const ExecuteOptions& options, bool fill_future,
+      TfrtCpuExecuteBatch& batch);
 
   TfrtCpuClient* client_;
 
@@ -658,6 +793,11 @@ class TfrtCpuExecutable final : public PjRtLoadedExecutable {
 
   std::shared_ptr<Executable> cpu_executable_;
 
+  // The alignment required for each allocation of the buffer assignment,
+  // indexed by allocation index. Arguments that are less aligned are copied
+  // before execution.
+  std::vector<size_t> parameter_alignments_;
+
   // Caching `result_buffer_index_` and `result_buffer_indices_` to avoid lookup
   // HLO dataflow analysis data structures in program execution critical path.
 
@@ -690,6 +830,15 @@ class TfrtCpuExecutable final : public PjRtLoadedExecutable {
   // Cached result of comparing HloCostAnalysis FLOP estimate for execute
   // critical path.
   bool cheap_computation_;
+
+  // Limit the computations of this executable that are in flight on each
+  // device, so that one executable cannot take all the in-flight slots of a
+  // device. The replicas of a computation run on different devices and may
+  // wait for each other in collectives, so each device has its own semaphore.
+  // Empty if the client does not limit them. Shared with in-flight
+  // computations, which may outlive the executable.
+  absl::flat_hash_map<const PjRtDevice*, std::shared_ptr<Semaphore>>
+      inflight_computations_semaphores_;
 };
 
 struct CpuClientOptions {
@@ -709,9 +858,52 @@ struct CpuClientOptions {
   // My process ID.
   int process_id = 0;
 
+  // How many compiled executables to keep in a client-level cache. Compiling
+  // a computation with the same options as a cached one reuses its executable
+  // instead of running the compiler again, and concurrent compilations of the
+  // same computation run the compiler once. Zero disables the cache.
+  int compile_cache_size = 0;
+
+  // Whether each device caches freed buffer memory in a CpuMemoryPool for
+  // reuse by later allocations, instead of returning it to the system. Each
+  // pool may keep up to CpuMemoryPool::Options::max_cached_bytes of freed
+  // memory, so this is off by default.
+  bool enable_memory_pool = false;
+
+  // If set, allocating a buffer on a device fails with a ResourceExhausted
+  // error once the buffers of the device would use more than this many bytes.
+  std::optional<int64_t> memory_limit_per_device = std::nullopt;
+
+  // Whether each device has a memory space of kind
+  // HugePageHostMemorySpace::kKind in addition to its default memory space.
+  // Buffers of at least 2 MiB placed there, with BufferFromHostBuffer or
+  // CopyToMemorySpace, are backed by huge pages, which reduces TLB misses
+  // when executables access large arguments such as weights or embedding
+  // tables. The memory space has its own memory_limit_per_device.
+  bool enable_huge_page_memory_space = false;
+
+  // The number of partitions that the intra-op threads are split into. Each
+  // execution runs its parallel work on the partition with the fewest
+  // executions in flight, so that independent executables running at the same
+  // time do not compete for the same threads. One partition shares all
+  // threads between all executions.
+  int intra_op_thread_partitions = 1;
+
+  // The number of computations of any one executable that may be in flight on
+  // each device at a time, which keeps a busy executable from taking all the
+  // in-flight slots of a device (see max_inflight_computations_per_device)
+  // from the others. Execute takes the slots of all replicas before launching
+  // any of them. Zero means unlimited.
+  int max_inflight_computations_per_executable = 0;
+
   // Distributed collectives implementation. Optional. If not provided, an
   // in-process collectives implementation will be used.
   std::shared_ptr<cpu::CollectivesInterface> collectives;
+
+  // Moves the data of MakeCrossHostReceiveBuffers and CopyToRemoteDevice
+  // between processes. Optional. If not provided, cross-host transfers are
+  // unimplemented.
+  std::shared_ptr<cpu::CrossHostTransport> cross_host_transport;
 };
 absl::StatusOr<std::unique_ptr<PjRtClient>> GetTfrtCpuClient(
     const CpuClientOptions& options);
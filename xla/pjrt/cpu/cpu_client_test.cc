@@ -23,39 +23,56 @@ limitations under the License.
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "xla/client/xla_computation.h"
 #include "xla/ffi/ffi.h"
 #include "xla/ffi/ffi_api.h"
 #include "xla/literal.h"
 #include "xla/literal_util.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
+#include "xla/pjrt/distributed/in_memory_key_value_store.h"
+#include "xla/pjrt/distributed/key_value_store_interface.h"
 #include "xla/pjrt/host_memory_spaces.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_executable.h"
+#include "xla/pjrt/pjrt_future.h"
+#include "xla/service/executable.h"
 #include "xla/service/hlo_parser.h"
 #include "xla/shape.h"
 #include "xla/shape_util.h"
 #include "xla/tests/literal_test_util.h"
 #include "xla/tests/test_utils.h"
+#include "xla/tsl/framework/allocator.h"
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/util.h"
+#include "tsl/platform/casts.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/file_system.h"
 #include "tsl/platform/status_matchers.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -98,6 +115,517 @@ TEST(TfrtCpuClientTest, MemorySpace) {
   }
 }
 
+constexpr char kAddProgram[] = R"(
+    HloModule add
+    ENTRY add {
+      x = f32[3,2] parameter(0)
+      y = f32[3,2] parameter(1)
+      ROOT add = f32[3,2] add(x, y)
+    })";
+
+constexpr char kMultiplyProgram[] = R"(
+    HloModule multiply
+    ENTRY multiply {
+      x = f32[3,2] parameter(0)
+      y = f32[3,2] parameter(1)
+      ROOT multiply = f32[3,2] multiply(x, y)
+    })";
+
+absl::StatusOr<XlaComputation> ParseComputation(absl::string_view program) {
+  TF_ASSIGN_OR_RETURN(auto hlo_module,
+                      ParseAndReturnUnverifiedModule(program, {}));
+  return XlaComputation(hlo_module->ToProto());
+}
+
+std::shared_ptr<Executable> GetCpuExecutable(
+    const PjRtLoadedExecutable& executable) {
+  return tensorflow::down_cast<const TfrtCpuExecutable&>(executable)
+      .cpu_executable();
+}
+
+TEST(TfrtCpuClientTest, CompileCacheReusesExecutables) {
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 1;
+  cpu_options.compile_cache_size = 4;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(cpu_options));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation add, ParseComputation(kAddProgram));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation multiply,
+                          ParseComputation(kMultiplyProgram));
+
+  TF_ASSERT_OK_AND_ASSIGN(auto add1, client->Compile(add, {}));
+  TF_ASSERT_OK_AND_ASSIGN(auto add2, client->Compile(add, {}));
+  TF_ASSERT_OK_AND_ASSIGN(auto multiply1, client->Compile(multiply, {}));
+  EXPECT_EQ(GetCpuExecutable(*add1), GetCpuExecutable(*add2));
+  EXPECT_NE(GetCpuExecutable(*add1), GetCpuExecutable(*multiply1));
+
+  // Different compile options must not share an executable.
+  CompileOptions fast_math;
+  fast_math.executable_build_options.mutable_debug_options()
+      ->set_xla_cpu_enable_fast_math(true);
+  TF_ASSERT_OK_AND_ASSIGN(auto add3, client->Compile(add, fast_math));
+  EXPECT_NE(GetCpuExecutable(*add1), GetCpuExecutable(*add3));
+
+  // Both executables sharing a compiled program still run.
+  std::vector<float> data{1, 2, 3, 4, 5, 6};
+  Shape shape = ShapeUtil::MakeShape(F32, {3, 2});
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), shape.element_type(), shape.dimensions(),
+          /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          client->addressable_devices()[0]));
+  for (auto* executable : {add1.get(), add2.get()}) {
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto result, executable->Execute({{buffer.get(), buffer.get()}}, {}));
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                            result[0][0]->ToLiteralSync());
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        LiteralUtil::CreateR2<float>({{2, 4}, {6, 8}, {10, 12}}), *literal));
+  }
+}
+
+TEST(TfrtCpuClientTest, CompileCacheCoalescesConcurrentCompiles) {
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 1;
+  cpu_options.compile_cache_size = 4;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(cpu_options));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation add, ParseComputation(kAddProgram));
+
+  constexpr int kNumThreads = 8;
+  std::vector<std::unique_ptr<PjRtLoadedExecutable>> executables(kNumThreads);
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "compile", kNumThreads);
+    for (int i = 0; i < kNumThreads; ++i) {
+      pool.Schedule(
+          [&, i] { executables[i] = client->Compile(add, {}).value(); });
+    }
+  }
+  for (const auto& executable : executables) {
+    EXPECT_EQ(GetCpuExecutable(*executable), GetCpuExecutable(*executables[0]));
+  }
+}
+
+TEST(TfrtCpuClientTest, FingerprintExecutable) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation add, ParseComputation(kAddProgram));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation multiply,
+                          ParseComputation(kMultiplyProgram));
+  TF_ASSERT_OK_AND_ASSIGN(auto add1, client->Compile(add, {}));
+  TF_ASSERT_OK_AND_ASSIGN(auto add2, client->Compile(add, {}));
+  TF_ASSERT_OK_AND_ASSIGN(auto multiply1, client->Compile(multiply, {}));
+
+  TF_ASSERT_OK_AND_ASSIGN(std::string add1_fingerprint,
+                          add1->FingerprintExecutable());
+  EXPECT_EQ(add1_fingerprint.size(), 32);
+  EXPECT_THAT(add2->FingerprintExecutable(), IsOkAndHolds(add1_fingerprint));
+  TF_ASSERT_OK_AND_ASSIGN(std::string multiply1_fingerprint,
+                          multiply1->FingerprintExecutable());
+  EXPECT_NE(add1_fingerprint, multiply1_fingerprint);
+}
+
+TEST(TfrtCpuClientTest, ExecuteBatch) {
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 2;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(cpu_options));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation add, ParseComputation(kAddProgram));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation multiply,
+                          ParseComputation(kMultiplyProgram));
+  CompileOptions compile_options;
+  compile_options.compile_portable_executable = true;
+  TF_ASSERT_OK_AND_ASSIGN(auto add_executable,
+                          client->Compile(add, compile_options));
+  TF_ASSERT_OK_AND_ASSIGN(auto multiply_executable,
+                          client->Compile(multiply, compile_options));
+
+  std::vector<float> data{1, 2, 3, 4, 5, 6};
+  Shape shape = ShapeUtil::MakeShape(F32, {3, 2});
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers;
+  std::vector<PjRtBatchedLaunch> launches;
+  for (PjRtDevice* device : client->addressable_devices()) {
+    TF_ASSERT_OK_AND_ASSIGN(
+        std::unique_ptr<PjRtBuffer> buffer,
+        client->BufferFromHostBuffer(
+            data.data(), shape.element_type(), shape.dimensions(),
+            /*byte_strides=*/std::nullopt,
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+            device));
+    buffers.push_back(std::move(buffer));
+    PjRtBuffer* argument = buffers.back().get();
+    launches.push_back({add_executable.get(), device, {argument, argument}});
+    launches.push_back(
+        {multiply_executable.get(), device, {argument, argument}});
+  }
+
+  std::optional<std::vector<PjRtFuture<>>> futures;
+  futures.emplace();
+  TF_ASSERT_OK_AND_ASSIGN(auto results,
+                          client->ExecuteBatch(launches, {}, futures));
+  ASSERT_EQ(results.size(), launches.size());
+  ASSERT_EQ(futures->size(), launches.size());
+  for (int i = 0; i < launches.size(); ++i) {
+    TF_ASSERT_OK((*futures)[i].Await());
+    ASSERT_EQ(results[i].size(), 1);
+    EXPECT_EQ(results[i][0]->device(), launches[i].device);
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                            results[i][0]->ToLiteralSync());
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        i % 2 == 0
+            ? LiteralUtil::CreateR2<float>({{2, 4}, {6, 8}, {10, 12}})
+            : LiteralUtil::CreateR2<float>({{1, 4}, {9, 16}, {25, 36}}),
+        *literal));
+  }
+
+  // A launch that fails validation fails the whole batch without leaving the
+  // inputs of the other launches in use.
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto deleted,
+      client->BufferFromHostBuffer(
+          data.data(), shape.element_type(), shape.dimensions(),
+          /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          client->addressable_devices()[0]));
+  deleted->Delete();
+  launches.push_back({add_executable.get(), client->addressable_devices()[0],
+                      {deleted.get(), deleted.get()}});
+  EXPECT_THAT(client->ExecuteBatch(launches, {}, futures).status().message(),
+              HasSubstr("buffer has been deleted or donated"));
+  launches.pop_back();
+  TF_ASSERT_OK_AND_ASSIGN(results, client->ExecuteBatch(launches, {}, futures));
+  for (auto& future : *futures) {
+    TF_EXPECT_OK(future.Await());
+  }
+}
+
+TEST(TfrtCpuClientTest, ExecuteBatchChainsLaunches) {
+  static constexpr char kDoubleInPlaceProgram[] = R"(
+    HloModule double, input_output_alias={ {}: (0, {}, must-alias) }
+    ENTRY double {
+      x = f32[3,2] parameter(0)
+      ROOT add = f32[3,2] add(x, x)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  PjRtDevice* device = client->addressable_devices()[0];
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto add_executable,
+      client->Compile(ParseComputation(kAddProgram).value(), {}));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto double_executable,
+      client->Compile(ParseComputation(kDoubleInPlaceProgram).value(), {}));
+
+  std::vector<float> data{1, 2, 3, 4, 5, 6};
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), F32, {3, 2}, /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+          device));
+  ExecuteOptions options;
+  options.execution_mode = ExecuteOptions::ExecutionMode::kAsynchronous;
+  std::vector<PjRtBatchedLaunch> launches = {
+      {add_executable.get(), device, {buffer.get(), buffer.get()}}};
+  std::optional<std::vector<PjRtFuture<>>> futures;
+  TF_ASSERT_OK_AND_ASSIGN(auto first,
+                          client->ExecuteBatch(launches, options, futures));
+
+  // The second batch takes the output of the first batch, which may still be
+  // pending. Its first launch reads the output and its second launch donates
+  // it, so the second launch waits for the first one within the same batch.
+  PjRtBuffer* intermediate = first[0][0].get();
+  launches = {{add_executable.get(), device, {intermediate, intermediate}},
+              {double_executable.get(), device, {intermediate}}};
+  futures.emplace();
+  TF_ASSERT_OK_AND_ASSIGN(auto second,
+                          client->ExecuteBatch(launches, options, futures));
+  for (auto& future : *futures) {
+    TF_ASSERT_OK(future.Await());
+  }
+  EXPECT_TRUE(intermediate->IsDeleted());
+  for (const auto& result : second) {
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                            result[0]->ToLiteralSync());
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        LiteralUtil::CreateR2<float>({{4, 8}, {12, 16}, {20, 24}}),
+        *literal));
+  }
+}
+
+TEST(TfrtCpuClientTest, ExecuteBatchRunsNoLaunchWhenOneIsRejected) {
+  static constexpr char kDoubleInPlaceProgram[] = R"(
+    HloModule double, input_output_alias={ {}: (0, {}, must-alias) }
+    ENTRY double {
+      x = f32[3,2] parameter(0)
+      ROOT add = f32[3,2] add(x, x)
+    })";
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 2;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(cpu_options));
+  CompileOptions compile_options;
+  compile_options.compile_portable_executable = true;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto add_executable,
+      client->Compile(ParseComputation(kAddProgram).value(), compile_options));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto double_executable,
+      client->Compile(ParseComputation(kDoubleInPlaceProgram).value(),
+                      compile_options));
+
+  std::vector<float> data{1, 2, 3, 4, 5, 6};
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers;
+  for (PjRtDevice* device : client->addressable_devices()) {
+    TF_ASSERT_OK_AND_ASSIGN(
+        auto buffer,
+        client->BufferFromHostBuffer(
+            data.data(), F32, {3, 2}, /*byte_strides=*/std::nullopt,
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall, nullptr,
+            device));
+    buffers.push_back(std::move(buffer));
+  }
+  PjRtBuffer* donated = buffers[0].get();
+  PjRtBuffer* deleted = buffers[1].get();
+  deleted->Delete();
+
+  // The first launch is accepted and donates its input, but the second one is
+  // rejected, so the call fails before anything runs or donates.
+  std::vector<PjRtBatchedLaunch> launches = {
+      {double_executable.get(), client->addressable_devices()[0], {donated}},
+      {add_executable.get(), client->addressable_devices()[1],
+       {deleted, deleted}}};
+  std::optional<std::vector<PjRtFuture<>>> futures;
+  EXPECT_THAT(client->ExecuteBatch(launches, {}, futures).status().message(),
+              HasSubstr("buffer has been deleted or donated"));
+  EXPECT_FALSE(donated->IsDeleted());
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                          donated->ToLiteralSync());
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{1, 2}, {3, 4}, {5, 6}}), *literal));
+}
+
+// Returns a pointer into `storage` that is aligned to 8 but not to 16 bytes.
+float* UnderalignedData(std::vector<float>& storage) {
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage.data());
+  std::uintptr_t aligned = (address + 15) & ~std::uintptr_t{15};
+  return reinterpret_cast<float*>(aligned + 8);
+}
+
+TEST(TfrtCpuClientTest, SmallUnderalignedHostBufferIsAdoptedZeroCopy) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  static constexpr char kProgram[] = R"(
+    HloModule add
+    ENTRY add {
+      x = f32[2] parameter(0)
+      ROOT add = f32[2] add(x, x)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation computation,
+                          ParseComputation(kProgram));
+  TF_ASSERT_OK_AND_ASSIGN(auto executable, client->Compile(computation, {}));
+
+  // An f32[2] only needs an 8-byte alignment.
+  std::vector<float> storage(8);
+  float* data = UnderalignedData(storage);
+  data[0] = 1;
+  data[1] = 2;
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data, F32, {2}, /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableZeroCopy, nullptr,
+          client->addressable_devices()[0]));
+  EXPECT_THAT(client->UnsafeBufferPointer(buffer.get()),
+              IsOkAndHolds(reinterpret_cast<std::uintptr_t>(data)));
+
+  TF_ASSERT_OK_AND_ASSIGN(auto result,
+                          executable->Execute({{buffer.get()}}, {}));
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                          result[0][0]->ToLiteralSync());
+  EXPECT_TRUE(
+      LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>({2, 4}), *literal));
+}
+
+TEST(TfrtCpuClientTest, UnderalignedViewIsCopiedBeforeExecution) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation add, ParseComputation(kAddProgram));
+  TF_ASSERT_OK_AND_ASSIGN(auto executable, client->Compile(add, {}));
+
+  // An f32[3,2] needs a 16-byte alignment, which the view does not have.
+  std::vector<float> storage(16);
+  float* data = UnderalignedData(storage);
+  std::iota(data, data + 6, 1.0f);
+  Shape shape = ShapeUtil::MakeShapeWithDenseLayout(F32, {3, 2}, {1, 0});
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer, client->CreateViewOfDeviceBuffer(
+                       data, shape, client->addressable_devices()[0],
+                       /*on_delete_callback=*/nullptr,
+                       /*stream=*/std::nullopt));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto result, executable->Execute({{buffer.get(), buffer.get()}}, {}));
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                          result[0][0]->ToLiteralSync());
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{2, 4}, {6, 8}, {10, 12}}), *literal));
+}
+
+TEST(TfrtCpuClientTest, DonatedZeroCopyBufferAliasesOutput) {
+  static constexpr char kProgram[] = R"(
+    HloModule add, input_output_alias={ {}: (0, {}, must-alias) }
+    ENTRY add {
+      x = f32[3,2] parameter(0)
+      ROOT add = f32[3,2] add(x, x)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation computation,
+                          ParseComputation(kProgram));
+  TF_ASSERT_OK_AND_ASSIGN(auto executable, client->Compile(computation, {}));
+
+  // std::vector does not guarantee a 16-byte alignment.
+  alignas(16) float data[6] = {1, 2, 3, 4, 5, 6};
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data, F32, {3, 2}, /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kMutableZeroCopy, nullptr,
+          client->addressable_devices()[0]));
+
+  TF_ASSERT_OK_AND_ASSIGN(auto result,
+                          executable->Execute({{buffer.get()}}, {}));
+  EXPECT_TRUE(buffer->IsDeleted());
+  EXPECT_THAT(client->UnsafeBufferPointer(result[0][0].get()),
+              IsOkAndHolds(reinterpret_cast<std::uintptr_t>(data)));
+  TF_ASSERT_OK(result[0][0]->GetReadyFuture().Await());
+  EXPECT_THAT(data, ElementsAre(2, 4, 6, 8, 10, 12));
+}
+
+TEST(TfrtCpuClientTest, LargeTransposedHostBuffer) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  // Large enough to be transposed asynchronously.
+  constexpr int64_t kRows = 256;
+  constexpr int64_t kCols = 128;
+  std::vector<float> data(kRows * kCols);
+  std::iota(data.begin(), data.end(), 0.0f);
+  // Column-major strides.
+  std::vector<int64_t> byte_strides = {sizeof(float),
+                                       kRows * sizeof(float)};
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), F32, {kRows, kCols}, byte_strides,
+          PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes,
+          nullptr, client->addressable_devices()[0]));
+
+  Literal expected(ShapeUtil::MakeShape(F32, {kRows, kCols}));
+  TF_ASSERT_OK(expected.Populate<float>([&](absl::Span<const int64_t> index) {
+    return data[index[1] * kRows + index[0]];
+  }));
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                          buffer->ToLiteralSync());
+  EXPECT_TRUE(LiteralTestUtil::Equal(expected, *literal));
+}
+
+TEST(TfrtCpuClientTest, CrossHostTransfersRequireATransport) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  EXPECT_EQ(client
+                ->MakeCrossHostReceiveBuffers(
+                    {ShapeUtil::MakeShape(F32, {2})},
+                    client->addressable_devices()[0],
+                    [](absl::StatusOr<PjRtCrossHostRecvState> state) {})
+                .status()
+                .code(),
+            absl::StatusCode::kUnimplemented);
+}
+
+// Returns a client for process `process_id` that sends and receives
+// cross-host transfers through `kv_store`.
+absl::StatusOr<std::unique_ptr<PjRtClient>> GetCrossHostClient(
+    std::shared_ptr<KeyValueStoreInterface> kv_store, int process_id) {
+  CpuClientOptions options;
+  options.process_id = process_id;
+  options.cpu_device_count = 1;
+  options.cross_host_transport =
+      std::make_shared<cpu::KeyValueStoreCrossHostTransport>(
+          std::move(kv_store), process_id);
+  return GetTfrtCpuClient(options);
+}
+
+TEST(TfrtCpuClientTest, CrossHostTransfer) {
+  auto kv_store = std::make_shared<InMemoryKeyValueStore>();
+  TF_ASSERT_OK_AND_ASSIGN(auto sender, GetCrossHostClient(kv_store, 0));
+  TF_ASSERT_OK_AND_ASSIGN(auto receiver, GetCrossHostClient(kv_store, 1));
+
+  Literal literal = LiteralUtil::CreateR2<float>({{1, 2}, {3, 4}, {5, 6}});
+  auto descriptor = PjRtFuture<std::string>::CreatePromise();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto dst_buffers,
+      receiver->MakeCrossHostReceiveBuffers(
+          {literal.shape()}, receiver->addressable_devices()[0],
+          [&](absl::StatusOr<PjRtCrossHostRecvState> state) {
+            ASSERT_TRUE(state.ok());
+            ASSERT_EQ(state->descriptors.size(), 1);
+            descriptor.Set(state->descriptors[0].serialized_descriptors[0]);
+          }));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto src_buffer,
+      sender->BufferFromHostLiteral(literal, sender->addressable_devices()[0]));
+  absl::Notification sent;
+  src_buffer->CopyToRemoteDevice(
+      PjRtFuture<std::string>(descriptor),
+      [&](absl::Status status, bool sends_were_enqueued) {
+        TF_EXPECT_OK(status);
+        EXPECT_TRUE(sends_were_enqueued);
+        sent.Notify();
+      });
+
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> received,
+                          dst_buffers[0]->ToLiteralSync());
+  EXPECT_TRUE(LiteralTestUtil::Equal(literal, *received));
+  sent.WaitForNotification();
+}
+
+TEST(TfrtCpuClientTest, CrossHostScatterAndGather) {
+  auto kv_store = std::make_shared<InMemoryKeyValueStore>();
+  TF_ASSERT_OK_AND_ASSIGN(auto sender, GetCrossHostClient(kv_store, 0));
+  TF_ASSERT_OK_AND_ASSIGN(auto receiver, GetCrossHostClient(kv_store, 1));
+
+  Literal literal =
+      LiteralUtil::CreateR2<float>({{1, 2}, {3, 4}, {5, 6}, {7, 8}});
+  // Rows [0, 1) and [1, 4) are sent separately.
+  PjRtClient::GatherDetails gather_details;
+  gather_details.dimensions = {0};
+  gather_details.slice_boundaries = {1, 4};
+  auto descriptors = PjRtFuture<std::vector<std::string>>::CreatePromise();
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto dst_buffers,
+      receiver->MakeCrossHostReceiveBuffersForGather(
+          {literal.shape()}, {gather_details},
+          receiver->addressable_devices()[0],
+          [&](absl::StatusOr<PjRtCrossHostRecvState> state) {
+            ASSERT_TRUE(state.ok());
+            const auto& serialized_descriptors =
+                state->descriptors[0].serialized_descriptors;
+            descriptors.Set(std::vector<std::string>(
+                serialized_descriptors.begin(), serialized_descriptors.end()));
+          }));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto src_buffer,
+      sender->BufferFromHostLiteral(literal, sender->addressable_devices()[0]));
+  PjRtBuffer::ScatterDetails scatter_details;
+  scatter_details.dimensions = {0};
+  scatter_details.slices = {{0, 1}, {1, 4}};
+  std::vector<PjRtBuffer::RemoteSendCallback> callbacks(
+      2, [](absl::Status status, bool sends_were_enqueued) {
+        TF_EXPECT_OK(status);
+      });
+  src_buffer->CopyToRemoteDeviceScattered(
+      PjRtFuture<std::vector<std::string>>(descriptors), std::move(callbacks),
+      scatter_details);
+
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> received,
+                          dst_buffers[0]->ToLiteralSync());
+  EXPECT_TRUE(LiteralTestUtil::Equal(literal, *received));
+}
+
 TEST(TfrtCpuClientTest, DonationWithExecutionError) {
   static constexpr char kProgram[] =
       R"(
@@ -336,6 +864,263 @@ TEST(TfrtCpuClientTest, CreateErrorBuffer) {
       tsl::testing::StatusIs(tsl::error::INTERNAL, HasSubstr("foobar")));
 }
 
+TEST(TfrtCpuClientTest, MemoryLimitPerDevice) {
+  CpuClientOptions options;
+  options.cpu_device_count = 2;
+  options.memory_limit_per_device = 4096;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  std::vector<float> data(512, 1.0f);
+  auto transfer = [&](PjRtDevice* device) {
+    return client->BufferFromHostBuffer(
+        data.data(), F32, {512}, /*byte_strides=*/std::nullopt,
+        PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+        /*on_done_with_host_buffer=*/nullptr, device);
+  };
+
+  PjRtDevice* device = client->addressable_devices()[0];
+  TF_ASSERT_OK_AND_ASSIGN(auto first, transfer(device));
+  TF_ASSERT_OK_AND_ASSIGN(auto second, transfer(device));
+  EXPECT_THAT(transfer(device).status(),
+              tsl::testing::StatusIs(tsl::error::RESOURCE_EXHAUSTED));
+  // The limit applies to each device separately.
+  TF_ASSERT_OK(transfer(client->addressable_devices()[1]).status());
+
+  TF_ASSERT_OK_AND_ASSIGN(tsl::AllocatorStats stats,
+                          device->GetAllocatorStats());
+  EXPECT_EQ(stats.bytes_in_use, 4096);
+  EXPECT_EQ(stats.bytes_limit, 4096);
+
+  // Memory of deleted buffers is reused.
+  first.reset();
+  TF_ASSERT_OK(transfer(device).status());
+}
+
+TEST(TfrtCpuClientTest, ConcurrentExecutablesOnThreadPartitions) {
+  CpuClientOptions options;
+  options.cpu_device_count = 1;
+  options.intra_op_thread_partitions = 2;
+  options.max_inflight_computations_per_executable = 1;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  PjRtDevice* device = client->addressable_devices()[0];
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation add, ParseComputation(kAddProgram));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation multiply,
+                          ParseComputation(kMultiplyProgram));
+  TF_ASSERT_OK_AND_ASSIGN(auto add_executable, client->Compile(add, {}));
+  TF_ASSERT_OK_AND_ASSIGN(auto multiply_executable,
+                          client->Compile(multiply, {}));
+
+  std::vector<float> data{1, 2, 3, 4, 5, 6};
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), F32, {3, 2}, /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+          /*on_done_with_host_buffer=*/nullptr, device));
+
+  constexpr int kNumExecutions = 16;
+  std::vector<std::unique_ptr<PjRtBuffer>> add_results(kNumExecutions);
+  std::vector<std::unique_ptr<PjRtBuffer>> multiply_results(kNumExecutions);
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "execute", 2);
+    auto run = [&](PjRtLoadedExecutable* executable,
+                   std::vector<std::unique_ptr<PjRtBuffer>>& results) {
+      for (int i = 0; i < kNumExecutions; ++i) {
+        auto result = executable->ExecuteSharded({buffer.get(), buffer.get()},
+                                                 device, {});
+        results[i] = std::move(result.value()[0]);
+      }
+    };
+    pool.Schedule([&] { run(add_executable.get(), add_results); });
+    pool.Schedule([&] { run(multiply_executable.get(), multiply_results); });
+  }
+
+  for (int i = 0; i < kNumExecutions; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> add_literal,
+                            add_results[i]->ToLiteralSync());
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        LiteralUtil::CreateR2<float>({{2, 4}, {6, 8}, {10, 12}}),
+        *add_literal));
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> multiply_literal,
+                            multiply_results[i]->ToLiteralSync());
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        LiteralUtil::CreateR2<float>({{1, 4}, {9, 16}, {25, 36}}),
+        *multiply_literal));
+  }
+}
+
+TEST(TfrtCpuClientTest, ExecutableLimitAllowsReplicasToMeetInCollectives) {
+  static constexpr char kProgram[] = R"(
+    HloModule all_reduce, replica_count=2
+    sum {
+      x = f32[] parameter(0)
+      y = f32[] parameter(1)
+      ROOT add = f32[] add(x, y)
+    }
+    ENTRY all_reduce {
+      p = f32[4] parameter(0)
+      ROOT all-reduce = f32[4] all-reduce(p), replica_groups={}, to_apply=sum
+    })";
+  CpuClientOptions options;
+  options.cpu_device_count = 2;
+  options.max_inflight_computations_per_executable = 1;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  TF_ASSERT_OK_AND_ASSIGN(XlaComputation computation,
+                          ParseComputation(kProgram));
+  CompileOptions compile_options;
+  compile_options.executable_build_options.set_num_replicas(2);
+  TF_ASSERT_OK_AND_ASSIGN(auto executable,
+                          client->Compile(computation, compile_options));
+  ASSERT_EQ(executable->addressable_devices().size(), 2);
+
+  std::vector<std::unique_ptr<PjRtBuffer>> buffers;
+  std::vector<std::vector<PjRtBuffer*>> arguments;
+  for (int i = 0; i < 2; ++i) {
+    std::vector<float> data(4, i + 1);
+    TF_ASSERT_OK_AND_ASSIGN(
+        buffers.emplace_back(),
+        client->BufferFromHostBuffer(
+            data.data(), F32, {4}, /*byte_strides=*/std::nullopt,
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+            /*on_done_with_host_buffer=*/nullptr,
+            executable->addressable_devices()[i]));
+    arguments.push_back({buffers.back().get()});
+  }
+
+  // Each replica waits for the other in the all-reduce while it holds the
+  // only slot of the executable on its device, and two threads launch the
+  // executable concurrently.
+  constexpr int kNumExecutions = 8;
+  std::vector<std::vector<std::unique_ptr<PjRtBuffer>>> results;
+  absl::Mutex mu;
+  {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "execute", 2);
+    for (int t = 0; t < 2; ++t) {
+      pool.Schedule([&] {
+        for (int i = 0; i < kNumExecutions; ++i) {
+          auto result = executable->Execute(arguments, ExecuteOptions());
+          TF_ASSERT_OK(result.status());
+          absl::MutexLock lock(&mu);
+          for (auto& replica_results : *result) {
+            results.push_back(std::move(replica_results));
+          }
+        }
+      });
+    }
+  }
+
+  ASSERT_EQ(results.size(), 2 * 2 * kNumExecutions);
+  for (const auto& replica_results : results) {
+    ASSERT_EQ(replica_results.size(), 1);
+    TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                            replica_results[0]->ToLiteralSync());
+    EXPECT_TRUE(LiteralTestUtil::Equal(
+        LiteralUtil::CreateR1<float>({3, 3, 3, 3}), *literal));
+  }
+}
+
+TEST(TfrtCpuClientTest, AllocatorStatsRequireMemoryPool) {
+  // Devices have no memory pool by default.
+  CpuClientOptions options;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  EXPECT_THAT(client->addressable_devices()[0]->GetAllocatorStats().status(),
+              tsl::testing::StatusIs(tsl::error::UNIMPLEMENTED));
+
+  options.enable_memory_pool = true;
+  TF_ASSERT_OK_AND_ASSIGN(client, GetTfrtCpuClient(options));
+  TF_EXPECT_OK(client->addressable_devices()[0]->GetAllocatorStats().status());
+}
+
+TEST(TfrtCpuClientTest, HugePageMemorySpace) {
+  CpuClientOptions options;
+  options.cpu_device_count = 1;
+  options.enable_huge_page_memory_space = true;
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(options));
+  PjRtDevice* device = client->addressable_devices()[0];
+  EXPECT_EQ(client->memory_spaces().size(), 2);
+  TF_ASSERT_OK_AND_ASSIGN(PjRtMemorySpace * default_memory_space,
+                          device->default_memory_space());
+  EXPECT_EQ(default_memory_space->kind(), UnpinnedHostMemorySpace::kKind);
+  TF_ASSERT_OK_AND_ASSIGN(
+      PjRtMemorySpace * huge_page_memory_space,
+      device->memory_space_by_kind(HugePageHostMemorySpace::kKind));
+  EXPECT_EQ(huge_page_memory_space->kind_id(),
+            HugePageHostMemorySpace::kKindId);
+  EXPECT_NE(huge_page_memory_space->id(), default_memory_space->id());
+
+  // Large enough to be backed by huge pages.
+  std::vector<float> data(1 << 20);
+  std::iota(data.begin(), data.end(), 0.0f);
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto buffer,
+      client->BufferFromHostBuffer(
+          data.data(), F32, {static_cast<int64_t>(data.size())},
+          /*byte_strides=*/std::nullopt,
+          PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+          /*on_done_with_host_buffer=*/nullptr, huge_page_memory_space,
+          /*device_layout=*/nullptr));
+  EXPECT_EQ(buffer->memory_space(), huge_page_memory_space);
+  TF_ASSERT_OK_AND_ASSIGN(tsl::AllocatorStats stats,
+                          device->GetAllocatorStats());
+  EXPECT_GE(stats.bytes_in_use, data.size() * sizeof(float));
+
+  // Zero-copy transfers adopt the host memory in the default memory space, but
+  // copy it into the huge page memory space.
+  for (auto semantics : {PjRtClient::HostBufferSemantics::kImmutableZeroCopy,
+                         PjRtClient::HostBufferSemantics::kMutableZeroCopy}) {
+    for (PjRtMemorySpace* memory_space :
+         {default_memory_space, huge_page_memory_space}) {
+      absl::Notification done_with_host_buffer;
+      TF_ASSERT_OK_AND_ASSIGN(
+          auto zero_copy,
+          client->BufferFromHostBuffer(
+              data.data(), F32, {static_cast<int64_t>(data.size())},
+              /*byte_strides=*/std::nullopt, semantics,
+              [&] { done_with_host_buffer.Notify(); }, memory_space,
+              /*device_layout=*/nullptr));
+      EXPECT_EQ(zero_copy->memory_space(), memory_space);
+      TF_ASSERT_OK_AND_ASSIGN(std::uintptr_t pointer,
+                              client->UnsafeBufferPointer(zero_copy.get()));
+      EXPECT_EQ(pointer == reinterpret_cast<std::uintptr_t>(data.data()),
+                memory_space == default_memory_space);
+      TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                              zero_copy->ToLiteralSync());
+      EXPECT_TRUE(
+          LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>(data), *literal));
+      zero_copy.reset();
+      done_with_host_buffer.WaitForNotification();
+    }
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(auto copy,
+                          buffer->CopyToMemorySpace(default_memory_space));
+  EXPECT_EQ(copy->memory_space(), default_memory_space);
+  TF_ASSERT_OK_AND_ASSIGN(auto copy_back,
+                          copy->CopyToMemorySpace(huge_page_memory_space));
+  EXPECT_EQ(copy_back->memory_space(), huge_page_memory_space);
+  TF_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Literal> literal,
+                          copy_back->ToLiteralSync());
+  EXPECT_TRUE(
+      LiteralTestUtil::Equal(LiteralUtil::CreateR1<float>(data), *literal));
+
+  // Executables take arguments from either memory space.
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto executable,
+      client->Compile(ParseComputation(kAddProgram).value(), {}));
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto argument,
+      client->BufferFromHostLiteral(
+          LiteralUtil::CreateR2<float>({{1, 2}, {3, 4}, {5, 6}}),
+          huge_page_memory_space));
+  EXPECT_EQ(argument->memory_space(), huge_page_memory_space);
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto result,
+      executable->ExecuteSharded({argument.get(), argument.get()}, device, {}));
+  EXPECT_EQ(result[0]->memory_space(), default_memory_space);
+  TF_ASSERT_OK_AND_ASSIGN(literal, result[0]->ToLiteralSync());
+  EXPECT_TRUE(LiteralTestUtil::Equal(
+      LiteralUtil::CreateR2<float>({{2, 4}, {6, 8}, {10, 12}}), *literal));
+}
+
 TEST(TfrtCpuClientTest, AsyncTransferRawDataToSubBuffer) {
   TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
   xla::Shape shape = ShapeUtil::MakeShape(U32, {3, 2});
@@ -360,6 +1145,34 @@ TEST(TfrtCpuClientTest, AsyncTransferRawDataToSubBuffer) {
   EXPECT_THAT(literal->data<uint32_t>(), Each(0x42424242));
 }
 
+TEST(TfrtCpuClientTest, AsyncTransferRawDataToSubBufferInChunks) {
+  TF_ASSERT_OK_AND_ASSIGN(auto client, GetTfrtCpuClient(CpuClientOptions()));
+  // Large enough for each chunk to be split into parallel copies.
+  constexpr int64_t kNumElements = 10 * 1024 * 1024 + 3;
+  xla::Shape shape = ShapeUtil::MakeShape(U32, {kNumElements});
+  TF_ASSERT_OK_AND_ASSIGN(auto transfer_manager,
+                          client->CreateBuffersForAsyncHostToDevice(
+                              {shape}, client->addressable_devices()[0]));
+  auto buffer = transfer_manager->RetrieveBuffer(0);
+  std::vector<uint32_t> data(kNumElements);
+  std::iota(data.begin(), data.end(), 0);
+
+  const int64_t byte_size = kNumElements * sizeof(uint32_t);
+  constexpr int64_t kChunkSize = 9 * 1024 * 1024 + 1;
+  std::atomic<int> num_done = 0;
+  for (int64_t offset = 0; offset < byte_size; offset += kChunkSize) {
+    const int64_t size = std::min(kChunkSize, byte_size - offset);
+    TF_ASSERT_OK(transfer_manager->TransferRawDataToSubBuffer(
+        0, reinterpret_cast<const char*>(data.data()) + offset, offset, size,
+        /*is_last_transfer=*/offset + size == byte_size,
+        [&num_done]() { ++num_done; }));
+  }
+  TF_ASSERT_OK(buffer->GetReadyFuture().Await());
+  EXPECT_EQ(num_done.load(), CeilOfRatio(byte_size, kChunkSize));
+  TF_ASSERT_OK_AND_ASSIGN(auto literal, buffer->ToLiteralSync());
+  EXPECT_THAT(literal->data<uint32_t>(), ElementsAreArray(data));
+}
+
 // User-defined data type to be passed to FFI handler via the execute context
 // side channel.
 struct MemsetValue {
@@ -416,5 +1229,268 @@ TEST(TfrtCpuClientTest, ForwardUserDataToFfiHandler) {
       *result_literal));
 }
 
+enum class HostTransferMode { kCopy, kZeroCopy, kTranspose };
+
+// Measures BufferFromHostBuffer for f32[state.range(0), 256] arrays.
+void BM_BufferFromHostBuffer(::testing::benchmark::State& state) {
+  const int64_t rows = state.range(0);
+  const auto mode = static_cast<HostTransferMode>(state.range(1));
+  auto client = GetTfrtCpuClient(CpuClientOptions()).value();
+  PjRtDevice* device = client->addressable_devices()[0];
+
+  constexpr int64_t kCols = 256;
+  std::vector<float> data(rows * kCols, 1.0f);
+  // Column-major strides, which require a transpose.
+  std::vector<int64_t> column_major_strides = {
+      sizeof(float), rows * static_cast<int64_t>(sizeof(float))};
+  std::optional<absl::Span<const int64_t>> byte_strides;
+  if (mode == HostTransferMode::kTranspose) {
+    byte_strides = column_major_strides;
+  }
+  auto semantics =
+      mode == HostTransferMode::kZeroCopy
+          ? PjRtClient::HostBufferSemantics::kImmutableZeroCopy
+          : PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes;
+
+  for (auto s : state) {
+    auto buffer = client
+                      ->BufferFromHostBuffer(data.data(), F32, {rows, kCols},
+                                             byte_strides, semantics,
+                                             /*on_done_with_host_buffer=*/
+                                             nullptr, device)
+                      .value();
+    CHECK_OK(buffer->GetReadyFuture().Await());
+  }
+  state.SetBytesProcessed(state.iterations() * data.size() * sizeof(float));
+}
+
+BENCHMARK(BM_BufferFromHostBuffer)
+    ->ArgsProduct({{1, 64, 1024},
+                   {static_cast<int>(HostTransferMode::kCopy),
+                    static_cast<int>(HostTransferMode::kZeroCopy),
+                    static_cast<int>(HostTransferMode::kTranspose)}});
+
+// Measures streaming a u8[state.range(0) MiB] parameter into a buffer created
+// by CreateBuffersForAsyncHostToDevice in chunks of state.range(1) MiB.
+void BM_AsyncHostToDeviceTransfer(::testing::benchmark::State& state) {
+  const int64_t byte_size = state.range(0) * 1024 * 1024;
+  const int64_t chunk_size = state.range(1) * 1024 * 1024;
+  auto client = GetTfrtCpuClient(CpuClientOptions()).value();
+  PjRtDevice* device = client->addressable_devices()[0];
+  Shape shape = ShapeUtil::MakeShape(U8, {byte_size});
+  std::vector<char> data(byte_size, 1);
+
+  for (auto s : state) {
+    auto transfer_manager =
+        client->CreateBuffersForAsyncHostToDevice({shape}, device).value();
+    auto buffer = transfer_manager->RetrieveBuffer(0);
+    for (int64_t offset = 0; offset < byte_size; offset += chunk_size) {
+      const int64_t size = std::min(chunk_size, byte_size - offset);
+      CHECK_OK(transfer_manager->TransferRawDataToSubBuffer(
+          0, data.data() + offset, offset, size,
+          /*is_last_transfer=*/offset + size == byte_size, []() {}));
+    }
+    CHECK_OK(buffer->GetReadyFuture().Await());
+  }
+  state.SetBytesProcessed(state.iterations() * byte_size);
+}
+
+BENCHMARK(BM_AsyncHostToDeviceTransfer)
+    ->ArgsProduct({{64, 1024, 2048}, {1, 64, 1024}})
+    ->UseRealTime();
+
+// Measures the dispatch overhead of launching state.range(0) tiny executions,
+// one at a time (state.range(1) == 0) or with ExecuteBatch.
+void BM_ExecuteDispatch(::testing::benchmark::State& state) {
+  const int64_t num_launches = state.range(0);
+  const bool batched = state.range(1) != 0;
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 1;
+  auto client = GetTfrtCpuClient(cpu_options).value();
+  PjRtDevice* device = client->addressable_devices()[0];
+  auto executable =
+      client->Compile(ParseComputation(kAddProgram).value(), {}).value();
+
+  std::vector<float> data{1, 2, 3, 4, 5, 6};
+  Shape shape = ShapeUtil::MakeShape(F32, {3, 2});
+  auto buffer =
+      client
+          ->BufferFromHostBuffer(
+              data.data(), shape.element_type(), shape.dimensions(),
+              /*byte_strides=*/std::nullopt,
+              PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+              /*on_done_with_host_buffer=*/nullptr, device)
+          .value();
+  std::vector<PjRtBatchedLaunch> launches(
+      num_launches, {executable.get(), device, {buffer.get(), buffer.get()}});
+
+  for (auto s : state) {
+    std::vector<std::vector<std::unique_ptr<PjRtBuffer>>> results;
+    if (batched) {
+      std::optional<std::vector<PjRtFuture<>>> futures;
+      results = client->ExecuteBatch(launches, {}, futures).value();
+    } else {
+      for (const PjRtBatchedLaunch& launch : launches) {
+        results.push_back(
+            executable->ExecuteSharded(launch.argument_handles, device, {})
+                .value());
+      }
+    }
+    CHECK_OK(results.back()[0]->GetReadyFuture().Await());
+  }
+  state.SetItemsProcessed(state.iterations() * num_launches);
+}
+
+BENCHMARK(BM_ExecuteDispatch)->ArgsProduct({{1, 16, 256}, {0, 1}});
+
+// Returns a program that multiplies a f32[n,n] matrix with itself.
+std::string MakeMatmulProgram(int64_t n) {
+  return absl::StrFormat(R"(
+    HloModule matmul
+    ENTRY matmul {
+      x = f32[%d,%d] parameter(0)
+      ROOT dot = f32[%d,%d] dot(x, x), lhs_contracting_dims={1},
+                                       rhs_contracting_dims={0}
+    })",
+                         n, n, n, n);
+}
+
+// Measures the latency of a small matmul while a large matmul runs
+// continuously on another thread, with the intra-op threads split into
+// state.range(0) partitions.
+void BM_MixedModelLatency(::testing::benchmark::State& state) {
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 1;
+  cpu_options.intra_op_thread_partitions = state.range(0);
+  auto client = GetTfrtCpuClient(cpu_options).value();
+  PjRtDevice* device = client->addressable_devices()[0];
+
+  auto compile = [&](int64_t n) {
+    return client->Compile(ParseComputation(MakeMatmulProgram(n)).value(), {})
+        .value();
+  };
+  auto make_argument = [&](int64_t n) {
+    std::vector<float> data(n * n, 1.0f);
+    return client
+        ->BufferFromHostBuffer(
+            data.data(), F32, {n, n}, /*byte_strides=*/std::nullopt,
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+            /*on_done_with_host_buffer=*/nullptr, device)
+        .value();
+  };
+  auto large = compile(1024);
+  auto large_argument = make_argument(1024);
+  auto small = compile(128);
+  auto small_argument = make_argument(128);
+
+  std::atomic<bool> done = false;
+  std::unique_ptr<tsl::Thread> background(
+      tsl::Env::Default()->StartThread({}, "large_model", [&] {
+        while (!done.load()) {
+          auto result =
+              large->ExecuteSharded({large_argument.get()}, device, {});
+          CHECK_OK(result.value()[0]->GetReadyFuture().Await());
+        }
+      }));
+
+  std::vector<absl::Duration> latencies;
+  for (auto s : state) {
+    absl::Time start = absl::Now();
+    auto result = small->ExecuteSharded({small_argument.get()}, device, {});
+    CHECK_OK(result.value()[0]->GetReadyFuture().Await());
+    latencies.push_back(absl::Now() - start);
+  }
+  done = true;
+  background.reset();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    size_t index = std::min(latencies.size() - 1,
+                            static_cast<size_t>(p * latencies.size()));
+    return absl::ToDoubleMicroseconds(latencies[index]);
+  };
+  state.counters["p50_us"] = percentile(0.50);
+  state.counters["p99_us"] = percentile(0.99);
+}
+
+BENCHMARK(BM_MixedModelLatency)->Arg(1)->Arg(2)->UseRealTime();
+
+// Returns a program that gathers 4096 random rows of a f32[num_rows,64]
+// table.
+std::string MakeGatherProgram(int64_t num_rows) {
+  return absl::StrFormat(R"(
+    HloModule gather
+    ENTRY gather {
+      table = f32[%d,64] parameter(0)
+      indices = s32[4096,1] parameter(1)
+      ROOT gather = f32[4096,64] gather(table, indices), offset_dims={1},
+          collapsed_slice_dims={0}, start_index_map={0}, index_vector_dim=1,
+          slice_sizes={1,64}
+    })",
+                         num_rows);
+}
+
+// Runs a large matmul (state.range(0) == 0) or a gather from a large table
+// (state.range(0) == 1) with arguments in the default memory space
+// (state.range(1) == 0) or the huge page memory space (state.range(1) == 1).
+void BM_HugePageArguments(::testing::benchmark::State& state) {
+  const bool gather = state.range(0) != 0;
+  const bool huge_pages = state.range(1) != 0;
+  CpuClientOptions cpu_options;
+  cpu_options.cpu_device_count = 1;
+  cpu_options.enable_huge_page_memory_space = true;
+  auto client = GetTfrtCpuClient(cpu_options).value();
+  PjRtDevice* device = client->addressable_devices()[0];
+  PjRtMemorySpace* memory_space =
+      huge_pages
+          ? device->memory_space_by_kind(HugePageHostMemorySpace::kKind).value()
+          : device->default_memory_space().value();
+
+  auto make_argument = [&](const void* data, PrimitiveType type,
+                           absl::Span<const int64_t> dims) {
+    return client
+        ->BufferFromHostBuffer(
+            data, type, dims, /*byte_strides=*/std::nullopt,
+            PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+            /*on_done_with_host_buffer=*/nullptr, memory_space,
+            /*device_layout=*/nullptr)
+        .value();
+  };
+  std::unique_ptr<PjRtLoadedExecutable> executable;
+  std::vector<std::unique_ptr<PjRtBuffer>> arguments;
+  if (gather) {
+    constexpr int64_t kNumRows = 1 << 18;
+    executable =
+        client->Compile(ParseComputation(MakeGatherProgram(kNumRows)).value(),
+                        {})
+            .value();
+    std::vector<float> table(kNumRows * 64, 1.0f);
+    std::vector<int32_t> indices(4096);
+    for (int64_t i = 0; i < indices.size(); ++i) {
+      indices[i] = (i * 2654435761u) % kNumRows;
+    }
+    arguments.push_back(make_argument(table.data(), F32, {kNumRows, 64}));
+    arguments.push_back(make_argument(indices.data(), S32, {4096, 1}));
+  } else {
+    constexpr int64_t kSize = 1024;
+    executable =
+        client->Compile(ParseComputation(MakeMatmulProgram(kSize)).value(), {})
+            .value();
+    std::vector<float> matrix(kSize * kSize, 1.0f);
+    arguments.push_back(make_argument(matrix.data(), F32, {kSize, kSize}));
+  }
+  std::vector<PjRtBuffer*> argument_handles;
+  for (const auto& argument : arguments) {
+    argument_handles.push_back(argument.get());
+  }
+
+  for (auto s : state) {
+    auto result = executable->ExecuteSharded(argument_handles, device, {});
+    CHECK_OK(result.value()[0]->GetReadyFuture().Await());
+  }
+}
+
+BENCHMARK(BM_HugePageArguments)->ArgsProduct({{0, 1}, {0, 1}});
+
 }  // namespace
 }  // namespace xla
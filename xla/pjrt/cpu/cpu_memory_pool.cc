@@ -0,0 +1,299 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu/cpu_memory_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/cpu_function_runtime.h"
+#include "xla/tsl/framework/allocator.h"
+#include "xla/util.h"
+#include "tsl/platform/mem.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace xla {
+namespace {
+
+#if defined(__linux__)
+constexpr bool kHugePagesSupported = true;
+#else
+constexpr bool kHugePagesSupported = false;
+#endif
+
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+// Maps explicit huge pages of CpuMemoryPool::kHugePageSize.
+constexpr int kHugeTlbFlags = MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+#else
+constexpr int kHugeTlbFlags = 0;
+#endif
+
+// Every block starts with a header, which is followed by the memory returned
+// to the user.
+struct BlockHeader {
+  // The pool of an allocated block. Empty while the block is cached.
+  std::shared_ptr<CpuMemoryPool> pool;
+  size_t block_size;
+};
+
+constexpr size_t kHeaderSize = cpu_function_runtime::Align();
+static_assert(sizeof(BlockHeader) <= kHeaderSize);
+
+constexpr size_t kMinBlockSize = cpu_function_runtime::Align();
+
+BlockHeader* GetHeader(void* block) {
+  return std::launder(reinterpret_cast<BlockHeader*>(block));
+}
+
+// Returns the free list shard of the calling thread.
+int ThisThreadShard(int num_shards) {
+  static thread_local const size_t hash =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+  return hash % num_shards;
+}
+
+void UpdatePeak(std::atomic<int64_t>& peak, int64_t value) {
+  int64_t current = peak.load(std::memory_order_relaxed);
+  while (current < value &&
+         !peak.compare_exchange_weak(current, value,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<CpuMemoryPool> CpuMemoryPool::Create(Options options) {
+  return std::shared_ptr<CpuMemoryPool>(new CpuMemoryPool(std::move(options)));
+}
+
+CpuMemoryPool::CpuMemoryPool(Options options) : options_(std::move(options)) {}
+
+CpuMemoryPool::~CpuMemoryPool() { Trim(); }
+
+size_t CpuMemoryPool::SizeClass(size_t size) {
+  if (size <= kMinBlockSize) {
+    return kMinBlockSize;
+  }
+  // Four size classes per power of two waste at most a fifth of a block.
+  size_t granule = absl::bit_floor(size - 1) / 4;
+  return RoundUpTo(size, granule);
+}
+
+size_t CpuMemoryPool::BlockSize(size_t size) const {
+  const size_t block_size = SizeClass(size);
+  if (IsHugePageBlock(block_size)) {
+    // Huge page blocks fill whole huge pages together with their header.
+    return RoundUpTo(kHeaderSize + size, kHugePageSize) - kHeaderSize;
+  }
+  return block_size;
+}
+
+bool CpuMemoryPool::IsHugePageBlock(size_t block_size) const {
+  return kHugePagesSupported && options_.use_huge_pages &&
+         kHeaderSize + block_size >= kHugePageSize;
+}
+
+void* CpuMemoryPool::AllocateBlock(size_t block_size) const {
+  if (!IsHugePageBlock(block_size)) {
+    return tsl::port::AlignedMalloc(kHeaderSize + block_size,
+                                    cpu_function_runtime::Align());
+  }
+#if defined(__linux__)
+  const size_t mapped_size = kHeaderSize + block_size;
+  if (kHugeTlbFlags != 0) {
+    void* block = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | kHugeTlbFlags, -1, 0);
+    if (block != MAP_FAILED) {
+      return block;
+    }
+  }
+  // There are no explicit huge pages to spare, so fall back to transparent
+  // huge pages. The kernel only backs huge page aligned ranges with them, so
+  // map one huge page more than needed and unmap the unaligned ends.
+  void* mapped = mmap(nullptr, mapped_size + kHugePageSize,
+                      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+  if (mapped == MAP_FAILED) {
+    return nullptr;
+  }
+  char* begin = static_cast<char*>(mapped);
+  char* block = reinterpret_cast<char*>(RoundUpTo<uintptr_t>(
+      reinterpret_cast<uintptr_t>(begin), kHugePageSize));
+  char* end = begin + mapped_size + kHugePageSize;
+  if (block != begin) {
+    munmap(begin, block - begin);
+  }
+  if (block + mapped_size != end) {
+    munmap(block + mapped_size, end - (block + mapped_size));
+  }
+#if defined(MADV_HUGEPAGE)
+  // Only a hint: transparent huge pages may be disabled on this system.
+  madvise(block, mapped_size, MADV_HUGEPAGE);
+#endif
+  return block;
+#else
+  return nullptr;
+#endif
+}
+
+absl::StatusOr<void*> CpuMemoryPool::Allocate(size_t size) {
+  const size_t block_size = BlockSize(size);
+  void* block = nullptr;
+  if (block_size <= options_.max_cached_allocation_size) {
+    block = TakeCachedBlock(block_size);
+  }
+  if (block == nullptr) {
+    if (!Reserve(block_size)) {
+      // Cached memory counts towards the limit, so return it to the system
+      // before giving up.
+      Trim();
+      if (!Reserve(block_size)) {
+        return ResourceExhausted(
+            "Out of memory allocating %d bytes: the device memory limit of %d "
+            "bytes is exhausted.",
+            size, *options_.memory_limit);
+      }
+    }
+    block = AllocateBlock(block_size);
+    if (block == nullptr) {
+      pool_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+      return ResourceExhausted("Out of memory allocating %d bytes.", size);
+    }
+    new (block) BlockHeader{nullptr, block_size};
+  }
+  GetHeader(block)->pool = shared_from_this();
+
+  num_allocs_.fetch_add(1, std::memory_order_relaxed);
+  UpdatePeak(largest_alloc_size_, size);
+  UpdatePeak(peak_bytes_in_use_,
+             bytes_in_use_.fetch_add(block_size, std::memory_order_relaxed) +
+                 block_size);
+  return static_cast<char*>(block) + kHeaderSize;
+}
+
+/*static*/ void CpuMemoryPool::Free(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  void* block = static_cast<char*>(ptr) - kHeaderSize;
+  BlockHeader* header = GetHeader(block);
+  // Keeps the pool alive until the block is released.
+  std::shared_ptr<CpuMemoryPool> pool = std::move(header->pool);
+  pool->Release(block, header->block_size);
+}
+
+void* CpuMemoryPool::TakeCachedBlock(size_t block_size) {
+  // Look in the shard of this thread first, then steal from the others.
+  const int first_shard = ThisThreadShard(kNumShards);
+  for (int i = 0; i < kNumShards; ++i) {
+    Shard& shard = shards_[(first_shard + i) % kNumShards];
+    absl::MutexLock lock(&shard.mu);
+    auto it = shard.free_blocks.find(block_size);
+    if (it == shard.free_blocks.end() || it->second.empty()) {
+      continue;
+    }
+    void* block = it->second.back();
+    it->second.pop_back();
+    cached_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+    return block;
+  }
+  return nullptr;
+}
+
+void CpuMemoryPool::Release(void* block, size_t block_size) {
+  bytes_in_use_.fetch_sub(block_size, std::memory_order_relaxed);
+  if (block_size <= options_.max_cached_allocation_size) {
+    int64_t cached = cached_bytes_.fetch_add(block_size,
+                                             std::memory_order_relaxed) +
+                     block_size;
+    if (cached <= options_.max_cached_bytes) {
+      Shard& shard = shards_[ThisThreadShard(kNumShards)];
+      absl::MutexLock lock(&shard.mu);
+      shard.free_blocks[block_size].push_back(block);
+      return;
+    }
+    cached_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+  }
+  FreeBlock(block, block_size);
+}
+
+bool CpuMemoryPool::Reserve(size_t block_size) {
+  int64_t current = pool_bytes_.load(std::memory_order_relaxed);
+  do {
+    if (options_.memory_limit.has_value() &&
+        current + static_cast<int64_t>(block_size) > *options_.memory_limit) {
+      return false;
+    }
+  } while (!pool_bytes_.compare_exchange_weak(current, current + block_size,
+                                              std::memory_order_relaxed));
+  UpdatePeak(peak_pool_bytes_, current + block_size);
+  return true;
+}
+
+void CpuMemoryPool::FreeBlock(void* block, size_t block_size) {
+  GetHeader(block)->~BlockHeader();
+  if (IsHugePageBlock(block_size)) {
+#if defined(__linux__)
+    munmap(block, kHeaderSize + block_size);
+#endif
+  } else {
+    tsl::port::AlignedFree(block);
+  }
+  pool_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+}
+
+void CpuMemoryPool::Trim() {
+  for (Shard& shard : shards_) {
+    absl::flat_hash_map<size_t, std::vector<void*>> free_blocks;
+    {
+      absl::MutexLock lock(&shard.mu);
+      std::swap(free_blocks, shard.free_blocks);
+    }
+    for (auto& [block_size, blocks] : free_blocks) {
+      for (void* block : blocks) {
+        cached_bytes_.fetch_sub(block_size, std::memory_order_relaxed);
+        FreeBlock(block, block_size);
+      }
+    }
+  }
+}
+
+tsl::AllocatorStats CpuMemoryPool::GetStats() const {
+  tsl::AllocatorStats stats;
+  stats.num_allocs = num_allocs_.load(std::memory_order_relaxed);
+  stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+  stats.peak_bytes_in_use = peak_bytes_in_use_.load(std::memory_order_relaxed);
+  stats.largest_alloc_size =
+      largest_alloc_size_.load(std::memory_order_relaxed);
+  stats.bytes_limit = options_.memory_limit;
+  stats.pool_bytes = pool_bytes_.load(std::memory_order_relaxed);
+  stats.peak_pool_bytes = peak_pool_bytes_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace xla
@@ -0,0 +1,143 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_CPU_CPU_MEMORY_POOL_H_
+#define XLA_PJRT_CPU_CPU_MEMORY_POOL_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/tsl/framework/allocator.h"
+
+namespace xla {
+
+// A caching allocator for the buffers of a CPU device.
+//
+// Allocation sizes are rounded up to size classes, four per power of two, and
+// freed memory is kept in per-size-class free lists for reuse by later
+// allocations of the same class instead of being returned to the system. Free
+// lists are sharded by thread, so threads that allocate and free concurrently
+// rarely contend.
+//
+// Memory allocated from a pool keeps the pool alive until it is freed, so
+// buffers may outlive the device that created them.
+class CpuMemoryPool : public std::enable_shared_from_this<CpuMemoryPool> {
+ public:
+  struct Options {
+    // If set, allocations fail once the memory in use plus the memory cached
+    // by the pool would exceed this many bytes.
+    std::optional<int64_t> memory_limit;
+
+    // Freed memory beyond this many cached bytes is returned to the system.
+    int64_t max_cached_bytes = int64_t{1} << 30;
+
+    // Allocations larger than this are never cached.
+    size_t max_cached_allocation_size = size_t{256} << 20;
+
+    // Whether to back allocations of at least a huge page (2 MiB) with huge
+    // pages, which makes fewer TLB misses when large buffers are accessed.
+    // Such allocations are rounded up to a multiple of the huge page size.
+    // Explicit huge pages (MAP_HUGETLB) are used if the system has reserved
+    // any, and transparent huge pages (MADV_HUGEPAGE) otherwise. Ignored on
+    // platforms other than Linux.
+    bool use_huge_pages = false;
+  };
+
+  static std::shared_ptr<CpuMemoryPool> Create(Options options);
+
+  ~CpuMemoryPool();
+
+  CpuMemoryPool(const CpuMemoryPool&) = delete;
+  CpuMemoryPool& operator=(const CpuMemoryPool&) = delete;
+
+  // Returns `size` bytes aligned to cpu_function_runtime::Align(), which must
+  // be released with Free().
+  absl::StatusOr<void*> Allocate(size_t size);
+
+  // Releases memory returned by Allocate() of any pool. Null is ignored.
+  static void Free(void* ptr);
+
+  // Returns all cached memory to the system.
+  void Trim();
+
+  // Returns the usage of the pool. `bytes_in_use` and `pool_bytes`, which also
+  // counts cached memory, are measured in size classes.
+  tsl::AllocatorStats GetStats() const;
+
+  // Returns the number of bytes the pool reserves for an allocation of `size`.
+  static size_t SizeClass(size_t size);
+
+  // The size of the huge pages used if `Options::use_huge_pages` is set.
+  static constexpr size_t kHugePageSize = size_t{2} << 20;
+
+ private:
+  static constexpr int kNumShards = 16;
+
+  struct Shard {
+    absl::Mutex mu;
+    // Free blocks by size class.
+    absl::flat_hash_map<size_t, std::vector<void*>> free_blocks
+        ABSL_GUARDED_BY(mu);
+  };
+
+  explicit CpuMemoryPool(Options options);
+
+  // Returns the size of the block that holds an allocation of `size`.
+  size_t BlockSize(size_t size) const;
+
+  // Whether blocks of `block_size` bytes are backed by huge pages.
+  bool IsHugePageBlock(size_t block_size) const;
+
+  // Returns `block_size` bytes of new memory from the system, or null.
+  void* AllocateBlock(size_t block_size) const;
+
+  // Returns a cached block of `block_size` bytes, or null if there is none.
+  void* TakeCachedBlock(size_t block_size);
+
+  // Caches the block or returns it to the system.
+  void Release(void* block, size_t block_size);
+
+  // Accounts for `block_size` more bytes of pool memory, if that stays within
+  // the memory limit.
+  bool Reserve(size_t block_size);
+
+  // Returns `block` to the system.
+  void FreeBlock(void* block, size_t block_size);
+
+  const Options options_;
+  std::array<Shard, kNumShards> shards_;
+
+  std::atomic<int64_t> num_allocs_ = 0;
+  std::atomic<int64_t> largest_alloc_size_ = 0;
+  std::atomic<int64_t> bytes_in_use_ = 0;
+  std::atomic<int64_t> peak_bytes_in_use_ = 0;
+  std::atomic<int64_t> cached_bytes_ = 0;
+  // Bytes in use plus cached bytes.
+  std::atomic<int64_t> pool_bytes_ = 0;
+  std::atomic<int64_t> peak_pool_bytes_ = 0;
+};
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_CPU_CPU_MEMORY_POOL_H_
@@ -0,0 +1,199 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/cpu/cpu_memory_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "xla/tsl/framework/allocator.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/mem.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+namespace {
+
+TEST(CpuMemoryPoolTest, SizeClasses) {
+  EXPECT_EQ(CpuMemoryPool::SizeClass(0), 64);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(1), 64);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(64), 64);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(65), 80);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(128), 128);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(129), 160);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(1000), 1024);
+  EXPECT_EQ(CpuMemoryPool::SizeClass(1025), 1280);
+}
+
+TEST(CpuMemoryPoolTest, ReusesFreedMemory) {
+  auto pool = CpuMemoryPool::Create({});
+  TF_ASSERT_OK_AND_ASSIGN(void* first, pool->Allocate(1000));
+  CpuMemoryPool::Free(first);
+  TF_ASSERT_OK_AND_ASSIGN(void* second, pool->Allocate(1020));
+  EXPECT_EQ(first, second);
+  TF_ASSERT_OK_AND_ASSIGN(void* third, pool->Allocate(1000));
+  EXPECT_NE(second, third);
+  CpuMemoryPool::Free(second);
+  CpuMemoryPool::Free(third);
+
+  tsl::AllocatorStats stats = pool->GetStats();
+  EXPECT_EQ(stats.num_allocs, 3);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.peak_bytes_in_use, 2048);
+  EXPECT_EQ(stats.largest_alloc_size, 1020);
+  EXPECT_EQ(stats.pool_bytes, 2048);
+
+  pool->Trim();
+  EXPECT_EQ(pool->GetStats().pool_bytes, 0);
+}
+
+TEST(CpuMemoryPoolTest, MemoryIsAligned) {
+  auto pool = CpuMemoryPool::Create({});
+  for (size_t size : {1, 17, 100, 4096}) {
+    TF_ASSERT_OK_AND_ASSIGN(void* ptr, pool->Allocate(size));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 64, 0);
+    CpuMemoryPool::Free(ptr);
+  }
+}
+
+TEST(CpuMemoryPoolTest, DoesNotCacheBeyondLimits) {
+  CpuMemoryPool::Options options;
+  options.max_cached_bytes = 1024;
+  options.max_cached_allocation_size = 512;
+  auto pool = CpuMemoryPool::Create(options);
+
+  TF_ASSERT_OK_AND_ASSIGN(void* large, pool->Allocate(1024));
+  CpuMemoryPool::Free(large);
+  EXPECT_EQ(pool->GetStats().pool_bytes, 0);
+
+  std::vector<void*> blocks;
+  for (int i = 0; i < 4; ++i) {
+    TF_ASSERT_OK_AND_ASSIGN(void* block, pool->Allocate(512));
+    blocks.push_back(block);
+  }
+  for (void* block : blocks) {
+    CpuMemoryPool::Free(block);
+  }
+  EXPECT_EQ(pool->GetStats().pool_bytes, 1024);
+}
+
+TEST(CpuMemoryPoolTest, EnforcesMemoryLimit) {
+  CpuMemoryPool::Options options;
+  options.memory_limit = 4096;
+  auto pool = CpuMemoryPool::Create(options);
+
+  TF_ASSERT_OK_AND_ASSIGN(void* first, pool->Allocate(2048));
+  TF_ASSERT_OK_AND_ASSIGN(void* second, pool->Allocate(2048));
+  absl::StatusOr<void*> third = pool->Allocate(1);
+  EXPECT_EQ(third.status().code(), absl::StatusCode::kResourceExhausted);
+  EXPECT_EQ(pool->GetStats().bytes_limit, 4096);
+
+  // Cached memory is returned to the system to make room for allocations of
+  // other size classes.
+  CpuMemoryPool::Free(first);
+  CpuMemoryPool::Free(second);
+  TF_ASSERT_OK_AND_ASSIGN(void* fourth, pool->Allocate(4096));
+  CpuMemoryPool::Free(fourth);
+}
+
+TEST(CpuMemoryPoolTest, MemoryOutlivesPool) {
+  auto pool = CpuMemoryPool::Create({});
+  TF_ASSERT_OK_AND_ASSIGN(void* ptr, pool->Allocate(100));
+  pool.reset();
+  CpuMemoryPool::Free(ptr);
+}
+
+TEST(CpuMemoryPoolTest, HugePageAllocations) {
+#if !defined(__linux__)
+  GTEST_SKIP() << "Huge pages are only supported on Linux.";
+#endif
+  CpuMemoryPool::Options options;
+  options.use_huge_pages = true;
+  auto pool = CpuMemoryPool::Create(options);
+
+  // Allocations smaller than a huge page use the regular size classes.
+  TF_ASSERT_OK_AND_ASSIGN(void* small, pool->Allocate(1000));
+  EXPECT_EQ(pool->GetStats().bytes_in_use, 1024);
+
+  // Larger allocations are rounded up to whole huge pages, including the
+  // header that precedes the memory returned to the user.
+  constexpr size_t kSize = 5 << 20;
+  TF_ASSERT_OK_AND_ASSIGN(void* large, pool->Allocate(kSize));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 64, 0);
+  EXPECT_EQ((pool->GetStats().bytes_in_use - 1024 + 64) %
+                CpuMemoryPool::kHugePageSize,
+            0);
+  std::memset(large, 1, kSize);
+  CpuMemoryPool::Free(large);
+  TF_ASSERT_OK_AND_ASSIGN(void* reused, pool->Allocate(kSize));
+  EXPECT_EQ(large, reused);
+
+  CpuMemoryPool::Free(reused);
+  CpuMemoryPool::Free(small);
+  pool->Trim();
+  EXPECT_EQ(pool->GetStats().pool_bytes, 0);
+}
+
+TEST(CpuMemoryPoolTest, ConcurrentAllocations) {
+  auto pool = CpuMemoryPool::Create({});
+  {
+    tsl::thread::ThreadPool threads(tsl::Env::Default(), "test", 8);
+    for (int t = 0; t < 8; ++t) {
+      threads.Schedule([&pool] {
+        for (int i = 0; i < 1000; ++i) {
+          void* ptr = pool->Allocate(64 * (i % 16 + 1)).value();
+          static_cast<char*>(ptr)[0] = 1;
+          CpuMemoryPool::Free(ptr);
+        }
+      });
+    }
+  }
+  tsl::AllocatorStats stats = pool->GetStats();
+  EXPECT_EQ(stats.num_allocs, 8000);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+}
+
+void BM_AllocateAndFree(::testing::benchmark::State& state) {
+  const size_t size = state.range(0);
+  const bool use_pool = state.range(1) != 0;
+  auto pool = CpuMemoryPool::Create({});
+  for (auto s : state) {
+    if (use_pool) {
+      void* ptr = pool->Allocate(size).value();
+      ::testing::benchmark::DoNotOptimize(ptr);
+      CpuMemoryPool::Free(ptr);
+    } else {
+      void* ptr = tsl::port::AlignedMalloc(size, 64);
+      ::testing::benchmark::DoNotOptimize(ptr);
+      tsl::port::AlignedFree(ptr);
+    }
+  }
+}
+
+BENCHMARK(BM_AllocateAndFree)
+    ->ArgsProduct({{64, 64 << 10, 16 << 20}, {0, 1}})
+    ->ThreadRange(1, 8);
+
+}  // namespace
+}  // namespace xla
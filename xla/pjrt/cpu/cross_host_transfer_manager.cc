@@ -0,0 +1,247 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "xla/pjrt/cpu/cross_host_transfer_manager.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/functional/any_invocable.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "xla/pjrt/cpu/cross_host_transfer.pb.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
+#include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
+#include "xla/tsl/concurrency/async_value_ref.h"
+#include "xla/util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/random.h"
+#include "tsl/platform/threadpool.h"
+#include "tsl/profiler/lib/traceme.h"
+
+namespace xla::cpu {
+
+struct CrossHostTransferManager::PendingReceive {
+  std::string transfer_key;
+  tsl::AsyncValueRef<MaybeOwningCpuMemory> buffer;
+  int64_t offset;
+  int64_t size;
+  int64_t chunk_size;
+
+  // Only accessed by the task that polls for the next chunk, of which there is
+  // at most one at a time.
+  int64_t next_chunk = 0;
+
+  // Called by whoever removes the receive from `receives_`.
+  ReceiveCallback on_done;
+};
+
+CrossHostTransferManager::CrossHostTransferManager(
+    std::shared_ptr<CrossHostTransport> transport, Options options)
+    : transport_(std::move(transport)),
+      options_(options),
+      transfer_key_prefix_(absl::StrCat(absl::Hex(tsl::random::New64()))),
+      thread_pool_(std::make_unique<tsl::thread::ThreadPool>(
+          tsl::Env::Default(), "XLACpuCrossHostTransfers",
+          options.num_threads)) {
+  CHECK_GT(options_.chunk_size, 0);
+}
+
+CrossHostTransferManager::~CrossHostTransferManager() {
+  {
+    absl::MutexLock lock(&mu_);
+    shutting_down_ = true;
+  }
+  // Joins the threads. Polling tasks observe `shutting_down_` and cancel
+  // their receives instead of rescheduling themselves.
+  thread_pool_.reset();
+}
+
+void CrossHostTransferManager::ScheduleLocked(
+    absl::AnyInvocable<void()> task) {
+  // TSL ThreadPool expects a copyable std::function.
+  thread_pool_->Schedule(
+      [task = std::make_shared<absl::AnyInvocable<void()>>(std::move(task))] {
+        (*task)();
+      });
+}
+
+std::string CrossHostTransferManager::Receive(
+    tsl::AsyncValueRef<MaybeOwningCpuMemory> buffer, int64_t offset,
+    int64_t size, ReceiveCallback on_done) {
+  auto receive = std::make_shared<PendingReceive>();
+  receive->buffer = std::move(buffer);
+  receive->offset = offset;
+  receive->size = size;
+  receive->chunk_size = options_.chunk_size;
+  receive->on_done = std::move(on_done);
+
+  absl::ReleasableMutexLock lock(&mu_);
+  receive->transfer_key =
+      absl::StrCat(transfer_key_prefix_, "-", next_transfer_id_++);
+
+  CrossHostTransferDescriptorProto descriptor;
+  descriptor.set_address(transport_->address());
+  descriptor.set_transfer_key(receive->transfer_key);
+  descriptor.set_byte_size(size);
+  descriptor.set_chunk_size(receive->chunk_size);
+
+  if (shutting_down_) {
+    lock.Release();
+    std::move(receive->on_done)(
+        absl::CancelledError("The cross-host transfer manager is shut down."));
+    return descriptor.SerializeAsString();
+  }
+  receives_[receive->transfer_key] = receive;
+  ScheduleLocked([this, receive]() { Poll(receive); });
+  return descriptor.SerializeAsString();
+}
+
+void CrossHostTransferManager::Poll(std::shared_ptr<PendingReceive> receive) {
+  tsl::profiler::TraceMe traceme("CrossHostTransferManager::Poll");
+  const int64_t num_chunks = CeilOfRatio(receive->size, receive->chunk_size);
+  while (receive->next_chunk < num_chunks) {
+    {
+      absl::MutexLock lock(&mu_);
+      if (!receives_.contains(receive->transfer_key)) {
+        return;  // Cancelled.
+      }
+    }
+    int64_t begin = receive->next_chunk * receive->chunk_size;
+    int64_t chunk_size = std::min(receive->chunk_size, receive->size - begin);
+    absl::Span<char> dst(
+        static_cast<char*>(receive->buffer->data()) + receive->offset + begin,
+        chunk_size);
+    absl::Status status =
+        transport_->ReceiveChunk(receive->transfer_key, receive->next_chunk,
+                                 dst, options_.poll_interval);
+    if (absl::IsDeadlineExceeded(status)) {
+      // Yield the thread to other transfers while the sender catches up.
+      absl::ReleasableMutexLock lock(&mu_);
+      if (!shutting_down_) {
+        ScheduleLocked([this, receive]() { Poll(receive); });
+        return;
+      }
+      lock.Release();
+      FinishReceive(*receive, absl::CancelledError(
+                                  "The cross-host transfer manager is shut "
+                                  "down before the transfer completed."));
+      return;
+    }
+    if (!status.ok()) {
+      FinishReceive(*receive, status);
+      return;
+    }
+    ++receive->next_chunk;
+  }
+  FinishReceive(*receive, absl::OkStatus());
+}
+
+void CrossHostTransferManager::FinishReceive(const PendingReceive& receive,
+                                             absl::Status status) {
+  std::shared_ptr<PendingReceive> finished;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = receives_.find(receive.transfer_key);
+    if (it == receives_.end()) {
+      return;
+    }
+    finished = std::move(it->second);
+    receives_.erase(it);
+  }
+  std::move(finished->on_done)(std::move(status));
+}
+
+absl::Status CrossHostTransferManager::CancelReceive(
+    absl::string_view serialized_descriptor, absl::Status reason) {
+  CrossHostTransferDescriptorProto descriptor;
+  if (!descriptor.ParseFromString(serialized_descriptor)) {
+    return InvalidArgument("Malformed cross-host transfer descriptor.");
+  }
+  std::shared_ptr<PendingReceive> cancelled;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = receives_.find(descriptor.transfer_key());
+    if (descriptor.address() != transport_->address() ||
+        it == receives_.end()) {
+      return NotFound("No pending cross-host receive for transfer %s.",
+                      descriptor.transfer_key());
+    }
+    cancelled = std::move(it->second);
+    receives_.erase(it);
+  }
+  std::move(cancelled->on_done)(std::move(reason));
+  return absl::OkStatus();
+}
+
+void CrossHostTransferManager::Send(
+    tsl::AsyncValueRef<MaybeOwningCpuMemory> buffer, int64_t offset,
+    int64_t size, absl::string_view serialized_descriptor,
+    SendCallback on_done) {
+  CrossHostTransferDescriptorProto descriptor;
+  if (!descriptor.ParseFromString(serialized_descriptor)) {
+    std::move(on_done)(
+        InvalidArgument("Malformed cross-host transfer descriptor."),
+        /*sends_were_enqueued=*/false);
+    return;
+  }
+  if (descriptor.byte_size() != size || descriptor.chunk_size() <= 0) {
+    std::move(on_done)(
+        InvalidArgument("Cannot send %d bytes to a cross-host receive of %d "
+                        "bytes in chunks of %d bytes.",
+                        size, descriptor.byte_size(), descriptor.chunk_size()),
+        /*sends_were_enqueued=*/false);
+    return;
+  }
+
+  absl::ReleasableMutexLock lock(&mu_);
+  if (shutting_down_) {
+    lock.Release();
+    std::move(on_done)(
+        absl::CancelledError("The cross-host transfer manager is shut down."),
+        /*sends_were_enqueued=*/false);
+    return;
+  }
+  ScheduleLocked([this, buffer = std::move(buffer), offset, size,
+                  descriptor = std::move(descriptor),
+                  on_done = std::move(on_done)]() mutable {
+    tsl::profiler::TraceMe traceme("CrossHostTransferManager::Send");
+    const char* data = static_cast<const char*>(buffer->data()) + offset;
+    const int64_t chunk_size = descriptor.chunk_size();
+    const int64_t num_chunks = CeilOfRatio(size, chunk_size);
+    for (int64_t i = 0; i < num_chunks; ++i) {
+      int64_t begin = i * chunk_size;
+      absl::Status status = transport_->SendChunk(
+          descriptor.address(), descriptor.transfer_key(), i,
+          absl::string_view(data + begin, std::min(chunk_size, size - begin)));
+      if (!status.ok()) {
+        std::move(on_done)(std::move(status),
+                           /*sends_were_enqueued=*/i > 0);
+        return;
+      }
+    }
+    std::move(on_done)(absl::OkStatus(), /*sends_were_enqueued=*/true);
+  });
+}
+
+}  // namespace xla::cpu
@@ -0,0 +1,125 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef XLA_PJRT_CPU_CROSS_HOST_TRANSFER_MANAGER_H_
+#define XLA_PJRT_CPU_CROSS_HOST_TRANSFER_MANAGER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
+#include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
+#include "xla/tsl/concurrency/async_value_ref.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla::cpu {
+
+// Implements the cross-host transfers of the CPU client on top of a
+// CrossHostTransport.
+//
+// The receiver describes every receive with a serialized
+// CrossHostTransferDescriptorProto, which the user passes to the sender. The
+// sender splits the data into chunks of the size chosen by the receiver, and
+// the receiver copies each chunk into the destination buffer as it arrives,
+// so large transfers are streamed rather than staged in one piece.
+//
+// Transfers run on threads owned by the manager. A pending receive only
+// occupies a thread while it waits for the next chunk for at most
+// `poll_interval`, so a receive whose sender has not started yet does not
+// prevent other transfers from making progress.
+class CrossHostTransferManager {
+ public:
+  struct Options {
+    // Transfers are split into chunks of at most this many bytes.
+    int64_t chunk_size = 1024 * 1024;
+
+    // How long a receive waits for its next chunk before yielding its thread.
+    absl::Duration poll_interval = absl::Milliseconds(100);
+
+    int num_threads = 4;
+  };
+
+  CrossHostTransferManager(std::shared_ptr<CrossHostTransport> transport,
+                           Options options);
+
+  // Waits for running transfers, and fails pending receives with a Cancelled
+  // error.
+  ~CrossHostTransferManager();
+
+  // Starts receiving `size` bytes into `buffer` at `offset`, and returns the
+  // serialized descriptor to pass to the sender. `on_done` is called once all
+  // of the bytes have arrived, or with an error if the receive fails or is
+  // cancelled.
+  using ReceiveCallback = absl::AnyInvocable<void(absl::Status) &&>;
+  std::string Receive(tsl::AsyncValueRef<MaybeOwningCpuMemory> buffer,
+                      int64_t offset, int64_t size, ReceiveCallback on_done);
+
+  // Cancels the pending receive with `serialized_descriptor`, whose callback
+  // is called with `reason`. Returns a NotFound error if there is no such
+  // receive, e.g. because it has already completed.
+  absl::Status CancelReceive(absl::string_view serialized_descriptor,
+                             absl::Status reason);
+
+  // Asynchronously sends `size` bytes of `buffer` at `offset` to the receive
+  // with `serialized_descriptor`. `buffer` must be available. `on_done` is
+  // called with the status of the send, and whether any data was sent, see
+  // PjRtBuffer::CopyToRemoteDevice.
+  using SendCallback =
+      absl::AnyInvocable<void(absl::Status, bool sends_were_enqueued) &&>;
+  void Send(tsl::AsyncValueRef<MaybeOwningCpuMemory> buffer, int64_t offset,
+            int64_t size, absl::string_view serialized_descriptor,
+            SendCallback on_done);
+
+ private:
+  struct PendingReceive;
+
+  // Receives the next chunks of `receive` until it has to wait for one.
+  void Poll(std::shared_ptr<PendingReceive> receive);
+
+  // Removes `receive` from the pending receives and calls its callback with
+  // `status`, unless it has been cancelled already.
+  void FinishReceive(const PendingReceive& receive, absl::Status status);
+
+  void ScheduleLocked(absl::AnyInvocable<void()> task)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  std::shared_ptr<CrossHostTransport> transport_;
+  Options options_;
+
+  // Distinguishes the transfer keys of this manager from those of other
+  // managers that receive on the same address.
+  std::string transfer_key_prefix_;
+
+  absl::Mutex mu_;
+  uint64_t next_transfer_id_ ABSL_GUARDED_BY(mu_) = 0;
+  bool shutting_down_ ABSL_GUARDED_BY(mu_) = false;
+  absl::flat_hash_map<std::string, std::shared_ptr<PendingReceive>> receives_
+      ABSL_GUARDED_BY(mu_);
+
+  std::unique_ptr<tsl::thread::ThreadPool> thread_pool_;
+};
+
+}  // namespace xla::cpu
+
+#endif  // XLA_PJRT_CPU_CROSS_HOST_TRANSFER_MANAGER_H_
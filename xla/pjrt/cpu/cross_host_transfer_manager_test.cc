@@ -0,0 +1,147 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "xla/pjrt/cpu/cross_host_transfer_manager.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
+#include "xla/pjrt/cpu/tracked_tfrt_cpu_device_buffer.h"
+#include "xla/pjrt/distributed/in_memory_key_value_store.h"
+#include "xla/tsl/concurrency/async_value_ref.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla::cpu {
+namespace {
+
+class CrossHostTransferManagerTest : public ::testing::Test {
+ protected:
+  CrossHostTransferManagerTest() {
+    auto kv_store = std::make_shared<InMemoryKeyValueStore>();
+    CrossHostTransferManager::Options options;
+    // Small chunks, so that transfers are split into several of them.
+    options.chunk_size = 3;
+    options.poll_interval = absl::Milliseconds(1);
+    sender_ = std::make_unique<CrossHostTransferManager>(
+        std::make_shared<KeyValueStoreCrossHostTransport>(kv_store, 0),
+        options);
+    receiver_ = std::make_unique<CrossHostTransferManager>(
+        std::make_shared<KeyValueStoreCrossHostTransport>(kv_store, 1),
+        options);
+  }
+
+  static tsl::AsyncValueRef<MaybeOwningCpuMemory> MakeBuffer(
+      absl::string_view data) {
+    auto buffer = MaybeOwningCpuMemory::AllocateAvailableAvr(data.size());
+    CHECK_OK(buffer.status());
+    std::memcpy((*buffer)->data(), data.data(), data.size());
+    return *std::move(buffer);
+  }
+
+  static std::string Contents(
+      const tsl::AsyncValueRef<MaybeOwningCpuMemory>& buffer) {
+    return std::string(static_cast<const char*>(buffer->data()),
+                       buffer->size());
+  }
+
+  std::unique_ptr<CrossHostTransferManager> sender_;
+  std::unique_ptr<CrossHostTransferManager> receiver_;
+};
+
+TEST_F(CrossHostTransferManagerTest, SendAndReceive) {
+  auto dst = MakeBuffer("..........");
+  absl::Notification received;
+  absl::Status receive_status;
+  // Receives into the middle of the destination buffer.
+  std::string descriptor = receiver_->Receive(
+      dst, /*offset=*/2, /*size=*/7, [&](absl::Status status) {
+        receive_status = status;
+        received.Notify();
+      });
+
+  absl::Notification sent;
+  absl::Status send_status;
+  bool sends_were_enqueued = false;
+  sender_->Send(MakeBuffer("xxabcdefg"), /*offset=*/2, /*size=*/7, descriptor,
+                [&](absl::Status status, bool enqueued) {
+                  send_status = status;
+                  sends_were_enqueued = enqueued;
+                  sent.Notify();
+                });
+  sent.WaitForNotification();
+  TF_EXPECT_OK(send_status);
+  EXPECT_TRUE(sends_were_enqueued);
+  received.WaitForNotification();
+  TF_EXPECT_OK(receive_status);
+  EXPECT_EQ(Contents(dst), "..abcdefg.");
+}
+
+TEST_F(CrossHostTransferManagerTest, SendRejectsMismatchedSize) {
+  std::string descriptor =
+      receiver_->Receive(MakeBuffer("...."), /*offset=*/0, /*size=*/4,
+                         [](absl::Status status) {});
+  absl::Notification sent;
+  sender_->Send(MakeBuffer("abc"), /*offset=*/0, /*size=*/3, descriptor,
+                [&](absl::Status status, bool sends_were_enqueued) {
+                  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+                  EXPECT_FALSE(sends_were_enqueued);
+                  sent.Notify();
+                });
+  sent.WaitForNotification();
+  TF_EXPECT_OK(receiver_->CancelReceive(descriptor, absl::CancelledError()));
+}
+
+TEST_F(CrossHostTransferManagerTest, CancelReceive) {
+  absl::Notification received;
+  std::string descriptor =
+      receiver_->Receive(MakeBuffer("...."), /*offset=*/0, /*size=*/4,
+                         [&](absl::Status status) {
+                           EXPECT_EQ(status.message(), "no sender");
+                           received.Notify();
+                         });
+  TF_EXPECT_OK(
+      receiver_->CancelReceive(descriptor, absl::AbortedError("no sender")));
+  received.WaitForNotification();
+  // A receive can only be cancelled once.
+  EXPECT_TRUE(absl::IsNotFound(
+      receiver_->CancelReceive(descriptor, absl::AbortedError("no sender"))));
+}
+
+TEST_F(CrossHostTransferManagerTest, DestructionCancelsPendingReceives) {
+  absl::Notification received;
+  receiver_->Receive(MakeBuffer("...."), /*offset=*/0, /*size=*/4,
+                     [&](absl::Status status) {
+                       EXPECT_TRUE(absl::IsCancelled(status));
+                       received.Notify();
+                     });
+  receiver_.reset();
+  EXPECT_TRUE(received.HasBeenNotified());
+}
+
+}  // namespace
+}  // namespace xla::cpu
@@ -0,0 +1,83 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "xla/pjrt/cpu/cross_host_transport.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xla/pjrt/distributed/key_value_store_interface.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla::cpu {
+
+static std::string ChunkKey(absl::string_view address,
+                            absl::string_view transfer_key,
+                            int64_t chunk_index) {
+  return absl::StrCat("cross_host_transfer/", address, "/", transfer_key, "/",
+                      chunk_index);
+}
+
+KeyValueStoreCrossHostTransport::KeyValueStoreCrossHostTransport(
+    std::shared_ptr<KeyValueStoreInterface> kv_store, int process_index)
+    : kv_store_(std::move(kv_store)), process_index_(process_index) {}
+
+std::string KeyValueStoreCrossHostTransport::address() const {
+  return absl::StrCat(process_index_);
+}
+
+absl::Status KeyValueStoreCrossHostTransport::SendChunk(
+    absl::string_view address, absl::string_view transfer_key,
+    int64_t chunk_index, absl::string_view data) {
+  return kv_store_->Set(ChunkKey(address, transfer_key, chunk_index), data);
+}
+
+absl::Status KeyValueStoreCrossHostTransport::ReceiveChunk(
+    absl::string_view transfer_key, int64_t chunk_index, absl::Span<char> dst,
+    absl::Duration timeout) {
+  std::string key = ChunkKey(address(), transfer_key, chunk_index);
+  absl::StatusOr<std::string> data = kv_store_->Get(key, timeout);
+  // Key-value stores report a missing key either way.
+  if (absl::IsNotFound(data.status()) ||
+      absl::IsDeadlineExceeded(data.status())) {
+    return absl::DeadlineExceededError(
+        absl::StrCat("Chunk ", key, " has not been received yet."));
+  }
+  TF_RETURN_IF_ERROR(data.status());
+  if (data->size() != dst.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Chunk ", key, " has ", data->size(),
+                     " bytes, but the receiver expects ", dst.size()));
+  }
+  std::memcpy(dst.data(), data->data(), data->size());
+  // Every chunk is received exactly once, so it can be dropped from the store.
+  absl::Status deleted = kv_store_->Delete(key);
+  if (absl::IsUnimplemented(deleted)) {
+    return absl::OkStatus();
+  }
+  return deleted;
+}
+
+}  // namespace xla::cpu
@@ -0,0 +1,92 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#ifndef XLA_PJRT_CPU_CROSS_HOST_TRANSPORT_H_
+#define XLA_PJRT_CPU_CROSS_HOST_TRANSPORT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xla/pjrt/distributed/key_value_store_interface.h"
+
+namespace xla::cpu {
+
+// Moves the bytes of cross-host transfers between processes.
+//
+// A transfer is identified by the address of the receiving process and a key
+// that is unique among the transfers received by that process, and is split
+// into chunks that are sent and received independently and in order. The
+// transport only moves chunks; descriptors, buffers and cancellation are
+// handled by CrossHostTransferManager.
+//
+// Implementations must be thread-safe.
+class CrossHostTransport {
+ public:
+  virtual ~CrossHostTransport() = default;
+
+  // Returns the address that remote processes use to send to this process.
+  virtual std::string address() const = 0;
+
+  // Sends `data` as chunk `chunk_index` of the transfer `transfer_key` to the
+  // process at `address`. May return before the chunk has been received.
+  virtual absl::Status SendChunk(absl::string_view address,
+                                 absl::string_view transfer_key,
+                                 int64_t chunk_index,
+                                 absl::string_view data) = 0;
+
+  // Waits for at most `timeout` for chunk `chunk_index` of the transfer
+  // `transfer_key` sent to this process, and copies it into `dst`. Returns a
+  // DeadlineExceeded error if the chunk has not arrived yet, in which case the
+  // caller may try again.
+  virtual absl::Status ReceiveChunk(absl::string_view transfer_key,
+                                    int64_t chunk_index, absl::Span<char> dst,
+                                    absl::Duration timeout) = 0;
+};
+
+// A transport that sends chunks through a key-value store shared by all
+// processes, e.g. the one of the distributed runtime. The receiver deletes each
+// chunk from the store once it has copied it, if the store supports deleting
+// keys. The store is not built for bulk data, so this transport is meant for
+// infrequent transfers and for testing; high-bandwidth deployments should
+// provide their own transport.
+class KeyValueStoreCrossHostTransport : public CrossHostTransport {
+ public:
+  KeyValueStoreCrossHostTransport(
+      std::shared_ptr<KeyValueStoreInterface> kv_store, int process_index);
+
+  std::string address() const override;
+
+  absl::Status SendChunk(absl::string_view address,
+                         absl::string_view transfer_key, int64_t chunk_index,
+                         absl::string_view data) override;
+
+  absl::Status ReceiveChunk(absl::string_view transfer_key,
+                            int64_t chunk_index, absl::Span<char> dst,
+                            absl::Duration timeout) override;
+
+ private:
+  std::shared_ptr<KeyValueStoreInterface> kv_store_;
+  int process_index_;
+};
+
+}  // namespace xla::cpu
+
+#endif  // XLA_PJRT_CPU_CROSS_HOST_TRANSPORT_H_
@@ -0,0 +1,119 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "xla/pjrt/cpu/cross_host_transport.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "xla/pjrt/distributed/in_memory_key_value_store.h"
+#include "xla/pjrt/distributed/key_value_store_interface.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/test.h"
+
+namespace xla::cpu {
+namespace {
+
+TEST(KeyValueStoreCrossHostTransportTest, SendAndReceiveChunks) {
+  auto kv_store = std::make_shared<InMemoryKeyValueStore>();
+  KeyValueStoreCrossHostTransport sender(kv_store, /*process_index=*/0);
+  KeyValueStoreCrossHostTransport receiver(kv_store, /*process_index=*/1);
+
+  std::string chunk(3, '\0');
+  EXPECT_TRUE(absl::IsDeadlineExceeded(receiver.ReceiveChunk(
+      "transfer", /*chunk_index=*/0, absl::MakeSpan(chunk),
+      absl::Milliseconds(1))));
+
+  TF_ASSERT_OK(sender.SendChunk(receiver.address(), "transfer",
+                                /*chunk_index=*/1, "de"));
+  TF_ASSERT_OK(sender.SendChunk(receiver.address(), "transfer",
+                                /*chunk_index=*/0, "abc"));
+  TF_ASSERT_OK(receiver.ReceiveChunk("transfer", /*chunk_index=*/0,
+                                     absl::MakeSpan(chunk), absl::Seconds(1)));
+  EXPECT_EQ(chunk, "abc");
+  std::string last_chunk(2, '\0');
+  TF_ASSERT_OK(receiver.ReceiveChunk("transfer", /*chunk_index=*/1,
+                                     absl::MakeSpan(last_chunk),
+                                     absl::Seconds(1)));
+  EXPECT_EQ(last_chunk, "de");
+
+  // Chunks are addressed to the receiving process only.
+  EXPECT_TRUE(absl::IsDeadlineExceeded(sender.ReceiveChunk(
+      "transfer", /*chunk_index=*/0, absl::MakeSpan(chunk),
+      absl::Milliseconds(1))));
+}
+
+TEST(KeyValueStoreCrossHostTransportTest, DeletesReceivedChunks) {
+  auto kv_store = std::make_shared<InMemoryKeyValueStore>();
+  KeyValueStoreCrossHostTransport transport(kv_store, /*process_index=*/0);
+  TF_ASSERT_OK(transport.SendChunk(transport.address(), "transfer",
+                                   /*chunk_index=*/0, "abc"));
+  std::string chunk(3, '\0');
+  TF_ASSERT_OK(transport.ReceiveChunk("transfer", /*chunk_index=*/0,
+                                      absl::MakeSpan(chunk), absl::Seconds(1)));
+  EXPECT_EQ(chunk, "abc");
+  EXPECT_TRUE(absl::IsDeadlineExceeded(transport.ReceiveChunk(
+      "transfer", /*chunk_index=*/0, absl::MakeSpan(chunk),
+      absl::Milliseconds(1))));
+}
+
+// A store that implements only Get and Set.
+class NonDeletingKeyValueStore : public KeyValueStoreInterface {
+ public:
+  absl::StatusOr<std::string> Get(std::string_view key,
+                                  absl::Duration timeout) override {
+    return kv_store_.Get(key, timeout);
+  }
+
+  absl::Status Set(std::string_view key, std::string_view value) override {
+    return kv_store_.Set(key, value);
+  }
+
+ private:
+  InMemoryKeyValueStore kv_store_;
+};
+
+TEST(KeyValueStoreCrossHostTransportTest, ReceivesFromStoresWithoutDelete) {
+  auto kv_store = std::make_shared<NonDeletingKeyValueStore>();
+  KeyValueStoreCrossHostTransport transport(kv_store, /*process_index=*/0);
+  TF_ASSERT_OK(transport.SendChunk(transport.address(), "transfer",
+                                   /*chunk_index=*/0, "abc"));
+  std::string chunk(3, '\0');
+  TF_ASSERT_OK(transport.ReceiveChunk("transfer", /*chunk_index=*/0,
+                                      absl::MakeSpan(chunk), absl::Seconds(1)));
+  EXPECT_EQ(chunk, "abc");
+}
+
+TEST(KeyValueStoreCrossHostTransportTest, RejectsChunksOfTheWrongSize) {
+  auto kv_store = std::make_shared<InMemoryKeyValueStore>();
+  KeyValueStoreCrossHostTransport transport(kv_store, /*process_index=*/0);
+  TF_ASSERT_OK(transport.SendChunk(transport.address(), "transfer",
+                                   /*chunk_index=*/0, "abcd"));
+  std::string chunk(3, '\0');
+  EXPECT_EQ(transport
+                .ReceiveChunk("transfer", /*chunk_index=*/0,
+                              absl::MakeSpan(chunk), absl::Seconds(1))
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+}  // namespace
+}  // namespace xla::cpu
@@ -0,0 +1,96 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "xla/pjrt/cpu/intra_op_thread_partitions.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/log/check.h"
+#include "unsupported/Eigen/CXX11/Tensor"
+#include "tsl/platform/env.h"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+
+IntraOpThreadPartitions::Lease& IntraOpThreadPartitions::Lease::operator=(
+    Lease&& other) noexcept {
+  if (this != &other) {
+    Release();
+    partition_ = other.partition_;
+    other.partition_ = nullptr;
+  }
+  return *this;
+}
+
+const Eigen::ThreadPoolDevice* IntraOpThreadPartitions::Lease::device() const {
+  CHECK(partition_ != nullptr);
+  return partition_->device.get();
+}
+
+void IntraOpThreadPartitions::Lease::Release() {
+  if (partition_ != nullptr) {
+    partition_->num_leases.fetch_sub(1, std::memory_order_relaxed);
+    partition_ = nullptr;
+  }
+}
+
+IntraOpThreadPartitions::IntraOpThreadPartitions(int num_threads,
+                                                 int num_partitions) {
+  CHECK_GT(num_partitions, 0);
+  num_partitions = std::min(num_partitions, std::max(num_threads, 1));
+  for (int i = 0; i < num_partitions; ++i) {
+    // The first `num_threads % num_partitions` partitions get an extra thread.
+    int partition_threads = std::max(
+        num_threads / num_partitions + (i < num_threads % num_partitions), 1);
+    auto partition = std::make_unique<Partition>();
+    partition->pool = std::make_unique<tsl::thread::ThreadPool>(
+        tsl::Env::Default(), "XLAEigen", partition_threads);
+    partition->device = std::make_unique<Eigen::ThreadPoolDevice>(
+        partition->pool->AsEigenThreadPool(), partition->pool->NumThreads());
+    partitions_.push_back(std::move(partition));
+  }
+}
+
+IntraOpThreadPartitions::~IntraOpThreadPartitions() = default;
+
+IntraOpThreadPartitions::Lease IntraOpThreadPartitions::Acquire() {
+  Partition* least_loaded = partitions_.front().get();
+  if (partitions_.size() > 1) {
+    // The loads may change concurrently, which only makes the choice less
+    // balanced.
+    int64_t min_leases =
+        least_loaded->num_leases.load(std::memory_order_relaxed);
+    for (const auto& partition : partitions_) {
+      int64_t leases = partition->num_leases.load(std::memory_order_relaxed);
+      if (leases < min_leases) {
+        least_loaded = partition.get();
+        min_leases = leases;
+      }
+    }
+  }
+  least_loaded->num_leases.fetch_add(1, std::memory_order_relaxed);
+  return Lease(least_loaded);
+}
+
+int IntraOpThreadPartitions::max_threads_per_partition() const {
+  return partitions_.front()->pool->NumThreads();
+}
+
+}  // namespace xla
@@ -0,0 +1,99 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_PJRT_CPU_INTRA_OP_THREAD_PARTITIONS_H_
+#define XLA_PJRT_CPU_INTRA_OP_THREAD_PARTITIONS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "unsupported/Eigen/CXX11/Tensor"
+#include "tsl/platform/threadpool.h"
+
+namespace xla {
+
+// Splits the threads that run intra-op parallel work of CPU executions into
+// partitions with separate thread pools. Each execution runs on a single
+// partition, so concurrent executions assigned to different partitions do not
+// compete for the same threads.
+//
+// Executions are assigned to the partition with the fewest executions that
+// are in flight on it, which spreads independent executions evenly over the
+// partitions.
+class IntraOpThreadPartitions {
+ private:
+  struct Partition;
+
+ public:
+  // Assigns a partition to an execution for as long as it is alive.
+  class Lease {
+   public:
+    Lease() = default;
+    ~Lease() { Release(); }
+
+    Lease(Lease&& other) noexcept : partition_(other.partition_) {
+      other.partition_ = nullptr;
+    }
+    Lease& operator=(Lease&& other) noexcept;
+
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    // The device that runs intra-op work of the execution.
+    const Eigen::ThreadPoolDevice* device() const;
+
+   private:
+    friend class IntraOpThreadPartitions;
+    explicit Lease(Partition* partition) : partition_(partition) {}
+
+    void Release();
+
+    Partition* partition_ = nullptr;
+  };
+
+  // Splits `num_threads` threads into `num_partitions` partitions of nearly
+  // equal size. Every partition has at least one thread.
+  IntraOpThreadPartitions(int num_threads, int num_partitions);
+  ~IntraOpThreadPartitions();
+
+  // Assigns the least loaded partition to an execution.
+  Lease Acquire();
+
+  int num_partitions() const { return partitions_.size(); }
+
+  // Returns the number of threads of the largest partition.
+  int max_threads_per_partition() const;
+
+  // The device of the first partition.
+  Eigen::ThreadPoolDevice* default_device() const {
+    return partitions_.front()->device.get();
+  }
+
+ private:
+  struct Partition {
+    std::unique_ptr<tsl::thread::ThreadPool> pool;
+    std::unique_ptr<Eigen::ThreadPoolDevice> device;
+    // The number of executions that hold a lease on this partition.
+    std::atomic<int64_t> num_leases = 0;
+  };
+
+  std::vector<std::unique_ptr<Partition>> partitions_;
+};
+
+}  // namespace xla
+
+#endif  // XLA_PJRT_CPU_INTRA_OP_THREAD_PARTITIONS_H_
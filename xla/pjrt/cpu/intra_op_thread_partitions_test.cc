@@ -0,0 +1,66 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "xla/pjrt/cpu/intra_op_thread_partitions.h"
+
+#include <utility>
+
+#include <gtest/gtest.h>
+#include "unsupported/Eigen/CXX11/Tensor"
+
+namespace xla {
+namespace {
+
+TEST(IntraOpThreadPartitionsTest, SplitsThreads) {
+  IntraOpThreadPartitions partitions(/*num_threads=*/5, /*num_partitions=*/2);
+  EXPECT_EQ(partitions.num_partitions(), 2);
+  EXPECT_EQ(partitions.max_threads_per_partition(), 3);
+
+  IntraOpThreadPartitions::Lease first = partitions.Acquire();
+  IntraOpThreadPartitions::Lease second = partitions.Acquire();
+  EXPECT_EQ(first.device()->numThreads(), 3);
+  EXPECT_EQ(second.device()->numThreads(), 2);
+}
+
+TEST(IntraOpThreadPartitionsTest, HasAtMostOnePartitionPerThread) {
+  IntraOpThreadPartitions partitions(/*num_threads=*/2, /*num_partitions=*/4);
+  EXPECT_EQ(partitions.num_partitions(), 2);
+  EXPECT_EQ(partitions.max_threads_per_partition(), 1);
+}
+
+TEST(IntraOpThreadPartitionsTest, AssignsLeastLoadedPartition) {
+  IntraOpThreadPartitions partitions(/*num_threads=*/4, /*num_partitions=*/2);
+  IntraOpThreadPartitions::Lease first = partitions.Acquire();
+  IntraOpThreadPartitions::Lease second = partitions.Acquire();
+  EXPECT_NE(first.device(), second.device());
+
+  // Releasing a lease makes its partition the least loaded one.
+  const Eigen::ThreadPoolDevice* released = first.device();
+  first = IntraOpThreadPartitions::Lease();
+  IntraOpThreadPartitions::Lease third = partitions.Acquire();
+  EXPECT_EQ(third.device(), released);
+
+  // Moved leases keep their partition.
+  IntraOpThreadPartitions::Lease moved = std::move(third);
+  IntraOpThreadPartitions::Lease fourth = partitions.Acquire();
+  IntraOpThreadPartitions::Lease fifth = partitions.Acquire();
+  EXPECT_NE(fourth.device(), fifth.device());
+  EXPECT_EQ(moved.device(), released);
+}
+
+}  // namespace
+}  // namespace xla
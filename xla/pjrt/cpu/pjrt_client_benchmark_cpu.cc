@@ -0,0 +1,31 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/pjrt_client_benchmark.h"
+#include "xla/pjrt/cpu/cpu_client.h"
+
+namespace xla {
+namespace {
+
+// Register CPU as the backend for benchmarks in pjrt_client_benchmark.cc.
+const bool kUnused = (RegisterBenchmarkClientFactory([]() {
+                        CpuClientOptions options;
+                        options.cpu_device_count = 2;
+                        return GetTfrtCpuClient(options);
+                      }),
+                      true);
+
+}  // namespace
+}  // namespace xla
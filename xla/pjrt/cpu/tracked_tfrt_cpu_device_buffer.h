@@ -27,6 +27,7 @@ limitations under the License.
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "xla/cpu_function_runtime.h"
+#include "xla/pjrt/cpu/cpu_memory_pool.h"
 #include "xla/service/cpu/cpu_event.h"
 #include "xla/shape_util.h"
 #include "xla/tsl/concurrency/async_value_ref.h"
@@ -57,14 +58,22 @@ class MaybeOwningCpuMemory {
 
   // Allocates owning memory wrapped in an available `AsyncValueRef`.
   static absl::StatusOr<tsl::AsyncValueRef<MaybeOwningCpuMemory>>
-  AllocateAvailableAvr(size_t size) {
-    TF_ASSIGN_OR_RETURN(auto memory, Allocate(size));
+  AllocateAvailableAvr(size_t size, CpuMemoryPool* pool = nullptr) {
+    TF_ASSIGN_OR_RETURN(auto memory, Allocate(size, pool));
     return tsl::MakeAvailableAsyncValueRef<MaybeOwningCpuMemory>(
         std::move(memory));
   }
 
   // Allocates raw owning memory. The typical usage is for delayed allocation.
-  static absl::StatusOr<MaybeOwningCpuMemory> Allocate(size_t size) {
+  // The memory comes from `pool` if it is not null.
+  static absl::StatusOr<MaybeOwningCpuMemory> Allocate(
+      size_t size, CpuMemoryPool* pool = nullptr) {
+    if (pool != nullptr) {
+      TF_ASSIGN_OR_RETURN(void* data, pool->Allocate(size));
+      return MaybeOwningCpuMemory(
+          OwnedDataPtr{static_cast<uint8_t*>(data), CpuMemoryPool::Free},
+          size);
+    }
     uint8_t* data = static_cast<uint8_t*>(
         tsl::port::AlignedMalloc(size, cpu_function_runtime::MinAlign()));
     if (!data) {
@@ -226,6 +226,10 @@ class DistributedKeyValueStore : public KeyValueStoreInterface {
     return client_->KeyValueSet(absl::StrCat(prefix_, key), value);
   }
 
+  absl::Status Delete(std::string_view key) override {
+    return client_->KeyValueDelete(absl::StrCat(prefix_, key));
+  }
+
  private:
   std::shared_ptr<DistributedRuntimeClient> client_;
   std::string prefix_;
@@ -48,4 +48,10 @@ absl::Status InMemoryKeyValueStore::Set(std::string_view key,
   return absl::OkStatus();
 }
 
+absl::Status InMemoryKeyValueStore::Delete(std::string_view key) {
+  absl::MutexLock lock(&mu_);
+  kv_store_.erase(key);
+  return absl::OkStatus();
+}
+
 }  // namespace xla
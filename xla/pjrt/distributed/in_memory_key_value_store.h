@@ -34,6 +34,8 @@ class InMemoryKeyValueStore : public KeyValueStoreInterface {
 
   absl::Status Set(std::string_view key, std::string_view value) override;
 
+  absl::Status Delete(std::string_view key) override;
+
  private:
   absl::Mutex mu_;
   absl::flat_hash_map<std::string, std::string> kv_store_ ABSL_GUARDED_BY(mu_);
@@ -44,6 +44,13 @@ class KeyValueStoreInterface {
                                           absl::Duration timeout) = 0;
 
   virtual absl::Status Set(std::string_view key, std::string_view value) = 0;
+
+  // Deletes `key` if it exists. Stores that cannot delete keys return an
+  // Unimplemented error.
+  virtual absl::Status Delete(std::string_view key) {
+    return absl::UnimplementedError(
+        "This key-value store does not support deleting keys.");
+  }
 };
 
 struct MultiProcessKeyValueStore {
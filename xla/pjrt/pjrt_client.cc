@@ -16,16 +16,22 @@ limitations under the License.
 #include "xla/pjrt/pjrt_client.h"
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/base/casts.h"
 #include "absl/status/status.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_module.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/pjrt/pjrt_future.h"
 #include "xla/pjrt/utils.h"
 #include "xla/util.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/statusor.h"
 
 namespace xla {
 
@@ -45,6 +51,44 @@ absl::StatusOr<std::uintptr_t> PjRtClient::UnsafeBufferPointer(
   return absl::bit_cast<std::uintptr_t>(ptr);
 }
 
+absl::StatusOr<std::vector<std::vector<std::unique_ptr<PjRtBuffer>>>>
+PjRtClient::ExecuteBatch(
+    absl::Span<const PjRtBatchedLaunch> launches, const ExecuteOptions& options,
+    std::optional<std::vector<PjRtFuture<>>>& returned_futures) {
+  const bool fill_future = returned_futures.has_value();
+  std::vector<std::vector<std::unique_ptr<PjRtBuffer>>> results;
+  results.reserve(launches.size());
+  std::vector<PjRtFuture<>> futures;
+  futures.reserve(launches.size());
+  for (const PjRtBatchedLaunch& launch : launches) {
+    if (launch.executable->client() != this) {
+      return InvalidArgument(
+          "ExecuteBatch got an executable %s that is not loaded by this "
+          "client",
+          launch.executable->name());
+    }
+    std::optional<PjRtFuture<>> future;
+    // Portable executables have no addressable devices of their own.
+    absl::StatusOr<std::vector<std::unique_ptr<PjRtBuffer>>> buffers =
+        launch.executable->addressable_devices().empty()
+            ? launch.executable->ExecutePortable(launch.argument_handles,
+                                                 launch.device, options,
+                                                 future, fill_future)
+            : launch.executable->ExecuteSharded(launch.argument_handles,
+                                                launch.device, options, future,
+                                                fill_future);
+    TF_RETURN_IF_ERROR(buffers.status());
+    results.push_back(*std::move(buffers));
+    if (fill_future) {
+      futures.push_back(std::move(*future));
+    }
+  }
+  if (fill_future) {
+    returned_futures = std::move(futures);
+  }
+  return results;
+}
+
 PjRtFuture<> PjRtBuffer::CopyRawToHostFuture(PjRtFuture<void*> dst,
                                              int64_t offset,
                                              int64_t transfer_size) {
@@ -439,6 +439,15 @@ class PjRtHostMemoryForDeviceManager {
 
 class PjRtLoadedExecutable;
 
+// A single launch of a batch passed to PjRtClient::ExecuteBatch: runs
+// `executable` on `device` with `argument_handles`, as ExecuteSharded (or
+// ExecutePortable for portable executables) would.
+struct PjRtBatchedLaunch {
+  PjRtLoadedExecutable* executable;
+  PjRtDevice* device;
+  std::vector<PjRtBuffer*> argument_handles;
+};
+
 struct PjRtPluginAttributes {
   int64_t pjrt_c_api_major_version;
   int64_t pjrt_c_api_minor_version;
@@ -627,6 +636,23 @@ class PjRtClient {
     return Unimplemented("Loading executable not supported.");
   }
 
+  // Launches a batch of executions, possibly of different executables, in a
+  // single call. Clients may amortize the fixed cost of a launch across the
+  // batch, e.g. by sharing validation and completion events between launches on
+  // the same device, so a failure of one launch may be reported by the outputs
+  // of all launches on that device.
+  //
+  // Returns the outputs of `launches[i]` at index `i`. If
+  // returned_futures.has_value() and ExecuteBatch does not return an error
+  // status, *returned_futures is resized to the number of launches and each
+  // future becomes ready once the corresponding launch has completed.
+  //
+  // The default implementation launches each execution separately.
+  virtual absl::StatusOr<std::vector<std::vector<std::unique_ptr<PjRtBuffer>>>>
+  ExecuteBatch(absl::Span<const PjRtBatchedLaunch> launches,
+               const ExecuteOptions& options,
+               std::optional<std::vector<PjRtFuture<>>>& returned_futures);
+
   // Creates a buffer on the device without initializing or copying any data.
   virtual absl::StatusOr<std::unique_ptr<PjRtBuffer>> CreateUninitializedBuffer(
       const Shape& shape, PjRtDevice* device) = 0;
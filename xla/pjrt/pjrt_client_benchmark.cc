@@ -0,0 +1,270 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/pjrt_client_benchmark.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "xla/client/xla_builder.h"
+#include "xla/client/xla_computation.h"
+#include "xla/literal.h"
+#include "xla/pjrt/pjrt_client.h"
+#include "xla/pjrt/pjrt_executable.h"
+#include "xla/pjrt/pjrt_future.h"
+#include "xla/service/computation_placer.h"
+#include "xla/shape.h"
+#include "xla/shape_util.h"
+#include "xla/xla_data.pb.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace xla {
+namespace {
+
+class BenchmarkClientFactory {
+ public:
+  void Register(
+      std::function<absl::StatusOr<std::unique_ptr<PjRtClient>>()> factory) {
+    absl::MutexLock lock(&mu_);
+    CHECK(!factory_);
+    factory_ = std::move(factory);
+  }
+
+  std::function<absl::StatusOr<std::unique_ptr<PjRtClient>>()> Get() const {
+    absl::MutexLock lock(&mu_);
+    return factory_;
+  }
+
+ private:
+  mutable absl::Mutex mu_;
+  std::function<absl::StatusOr<std::unique_ptr<PjRtClient>>()> factory_
+      ABSL_GUARDED_BY(mu_);
+};
+
+BenchmarkClientFactory& GetGlobalBenchmarkClientFactory() {
+  static auto* const factory = new BenchmarkClientFactory;
+  return *factory;
+}
+
+std::unique_ptr<PjRtClient> GetClient() {
+  auto factory = GetGlobalBenchmarkClientFactory().Get();
+  CHECK(factory) << "No client registered with RegisterBenchmarkClientFactory";
+  return factory().value();
+}
+
+}  // namespace
+
+void RegisterBenchmarkClientFactory(
+    std::function<absl::StatusOr<std::unique_ptr<PjRtClient>>()> factory) {
+  GetGlobalBenchmarkClientFactory().Register(std::move(factory));
+}
+
+namespace {
+
+// Records the latency of every benchmark iteration, and reports the median and
+// the 99th percentile as counters in microseconds.
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(::testing::benchmark::State& state)
+      : state_(state) {}
+
+  ~LatencyRecorder() {
+    if (latencies_.empty()) return;
+    std::sort(latencies_.begin(), latencies_.end());
+    state_.counters["p50_us"] = Percentile(0.50);
+    state_.counters["p99_us"] = Percentile(0.99);
+  }
+
+  void Start() { start_ = absl::Now(); }
+  void Stop() { latencies_.push_back(absl::Now() - start_); }
+
+ private:
+  double Percentile(double p) const {
+    size_t index = std::min(latencies_.size() - 1,
+                            static_cast<size_t>(p * latencies_.size()));
+    return absl::ToDoubleMicroseconds(latencies_[index]);
+  }
+
+  ::testing::benchmark::State& state_;
+  absl::Time start_;
+  std::vector<absl::Duration> latencies_;
+};
+
+// Returns a buffer of u8[`byte_size`] on `device`.
+std::unique_ptr<PjRtBuffer> MakeBuffer(PjRtClient* client, PjRtDevice* device,
+                                       int64_t byte_size) {
+  std::vector<uint8_t> data(byte_size, 1);
+  auto buffer =
+      client
+          ->BufferFromHostBuffer(
+              data.data(), U8, {byte_size}, /*byte_strides=*/std::nullopt,
+              PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+              /*on_done_with_host_buffer=*/nullptr, device)
+          .value();
+  CHECK_OK(buffer->GetReadyFuture().Await());
+  return buffer;
+}
+
+void BM_BufferFromHostBuffer(::testing::benchmark::State& state) {
+  const int64_t byte_size = state.range(0);
+  auto client = GetClient();
+  PjRtDevice* device = client->addressable_devices()[0];
+  std::vector<uint8_t> data(byte_size, 1);
+
+  LatencyRecorder latencies(state);
+  for (auto s : state) {
+    latencies.Start();
+    auto buffer =
+        client
+            ->BufferFromHostBuffer(
+                data.data(), U8, {byte_size}, /*byte_strides=*/std::nullopt,
+                PjRtClient::HostBufferSemantics::
+                    kImmutableUntilTransferCompletes,
+                /*on_done_with_host_buffer=*/nullptr, device)
+            .value();
+    CHECK_OK(buffer->GetReadyFuture().Await());
+    latencies.Stop();
+  }
+  state.SetBytesProcessed(state.iterations() * byte_size);
+}
+
+BENCHMARK(BM_BufferFromHostBuffer)->RangeMultiplier(16)->Range(16, 64 << 20);
+
+// Measures dispatching a trivial program and waiting for its result.
+void BM_ExecuteTrivialProgram(::testing::benchmark::State& state) {
+  auto client = GetClient();
+  PjRtDevice* device = client->addressable_devices()[0];
+
+  XlaBuilder builder("inc");
+  Shape shape = ShapeUtil::MakeShape(S32, {4});
+  Add(Parameter(&builder, 0, shape, "x"), ConstantR0<int32_t>(&builder, 1));
+  XlaComputation computation = builder.Build().value();
+  DeviceAssignment assignment(1, 1);
+  assignment(0, 0) = device->id();
+  CompileOptions options;
+  options.executable_build_options.set_device_assignment(assignment);
+  auto executable = client->Compile(computation, options).value();
+
+  std::vector<int32_t> data(4, 0);
+  auto argument =
+      client
+          ->BufferFromHostBuffer(
+              data.data(), shape.element_type(), shape.dimensions(),
+              /*byte_strides=*/std::nullopt,
+              PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall,
+              /*on_done_with_host_buffer=*/nullptr, device)
+          .value();
+
+  LatencyRecorder latencies(state);
+  for (auto s : state) {
+    latencies.Start();
+    auto results = executable->Execute({{argument.get()}}, {}).value();
+    CHECK_OK(results[0][0]->GetReadyFuture().Await());
+    latencies.Stop();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ExecuteTrivialProgram);
+
+void BM_ToLiteral(::testing::benchmark::State& state) {
+  const int64_t byte_size = state.range(0);
+  auto client = GetClient();
+  auto buffer =
+      MakeBuffer(client.get(), client->addressable_devices()[0], byte_size);
+
+  LatencyRecorder latencies(state);
+  for (auto s : state) {
+    latencies.Start();
+    CHECK_OK(buffer->ToLiteralSync().status());
+    latencies.Stop();
+  }
+  state.SetBytesProcessed(state.iterations() * byte_size);
+}
+
+BENCHMARK(BM_ToLiteral)->RangeMultiplier(16)->Range(16, 64 << 20);
+
+// Measures the time for readiness to propagate through a chain of
+// state.range(0) futures, each of which is fulfilled by the previous one.
+void BM_PjRtFutureChain(::testing::benchmark::State& state) {
+  const int64_t length = state.range(0);
+
+  LatencyRecorder latencies(state);
+  for (auto s : state) {
+    state.PauseTiming();
+    std::vector<PjRtFuture<>::Promise> promises;
+    std::vector<PjRtFuture<>> futures;
+    promises.reserve(length);
+    futures.reserve(length);
+    for (int64_t i = 0; i < length; ++i) {
+      promises.push_back(PjRtFuture<>::CreatePromise());
+      futures.push_back(PjRtFuture<>(promises.back()));
+    }
+    for (int64_t i = 0; i + 1 < length; ++i) {
+      futures[i].OnReady([promise = promises[i + 1]](
+                             absl::Status status) mutable {
+        promise.Set(std::move(status));
+      });
+    }
+    state.ResumeTiming();
+
+    latencies.Start();
+    promises.front().Set();
+    CHECK_OK(futures.back().Await());
+    latencies.Stop();
+  }
+  state.SetItemsProcessed(state.iterations() * length);
+}
+
+BENCHMARK(BM_PjRtFutureChain)->Arg(1)->Arg(16)->Arg(256);
+
+void BM_CopyToDevice(::testing::benchmark::State& state) {
+  const int64_t byte_size = state.range(0);
+  auto client = GetClient();
+  if (client->addressable_device_count() < 2) {
+    state.SkipWithError("CopyToDevice requires two addressable devices");
+    return;
+  }
+  PjRtDevice* dst_device = client->addressable_devices()[1];
+  auto buffer =
+      MakeBuffer(client.get(), client->addressable_devices()[0], byte_size);
+
+  LatencyRecorder latencies(state);
+  for (auto s : state) {
+    latencies.Start();
+    auto copy = buffer->CopyToDevice(dst_device).value();
+    CHECK_OK(copy->GetReadyFuture().Await());
+    latencies.Stop();
+  }
+  state.SetBytesProcessed(state.iterations() * byte_size);
+}
+
+BENCHMARK(BM_CopyToDevice)->RangeMultiplier(16)->Range(16, 64 << 20);
+
+}  // namespace
+}  // namespace xla
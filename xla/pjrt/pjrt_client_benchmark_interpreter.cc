@@ -0,0 +1,29 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/pjrt/interpreter_device.h"
+#include "xla/pjrt/pjrt_client_benchmark.h"
+
+namespace xla {
+namespace {
+
+// Register the interpreter as the backend for benchmarks in
+// pjrt_client_benchmark.cc.
+const bool kUnused =
+    (RegisterBenchmarkClientFactory([]() { return GetInterpreterClient(); }),
+     true);
+
+}  // namespace
+}  // namespace xla
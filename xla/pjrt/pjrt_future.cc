@@ -20,14 +20,34 @@ limitations under the License.
 #include <memory>
 #include <utility>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "xla/tsl/concurrency/async_value.h"
+#include "xla/tsl/concurrency/async_value_ref.h"
+#include "xla/tsl/concurrency/ref_count.h"
 #include "tsl/platform/logging.h"
 
 namespace xla {
 
+namespace internal {
+
+tsl::AsyncValueRef<absl::Status> ReadyOkStatus() {
+  static tsl::AsyncValue* const ready_ok_status = [] {
+    // Never destroyed, as ready futures may outlive static destructors.
+    auto* storage = new tsl::internal::AsyncValueStorage<absl::Status>();
+    auto* value = new tsl::AsyncValueOwningRef<absl::Status>(
+        tsl::MakeAvailableAsyncValueRef<absl::Status>(*storage,
+                                                      absl::OkStatus()));
+    return value->AsPtr().value();
+  }();
+  return tsl::AsyncValueRef<absl::Status>(tsl::FormRef(ready_ok_status));
+}
+
+}  // namespace internal
+
 namespace {
 struct State {
   explicit State(int32_t size)
@@ -48,6 +68,17 @@ PjRtFuture<> JoinFutures(absl::Span<const PjRtFuture<>> futures) {
     return futures.front();
   }
 
+  // Skip the shared state if all futures are already ready.
+  if (absl::c_all_of(futures, [](const PjRtFuture<>& future) {
+        return future.IsKnownReady();
+      })) {
+    absl::Status status;
+    for (const PjRtFuture<>& future : futures) {
+      status.Update(future.Await());
+    }
+    return PjRtFuture<>(std::move(status));
+  }
+
   auto state = std::make_shared<State>(futures.size());
 
   for (const PjRtFuture<>& future : futures) {
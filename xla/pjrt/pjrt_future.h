@@ -98,6 +98,11 @@ struct PjRtFutureHelpers {
 
 namespace internal {
 
+// Returns a reference to a process-wide available async value holding an OK
+// status. It is not reference counted, so ready futures that share it can be
+// created, copied and destroyed without allocations or atomic updates.
+tsl::AsyncValueRef<absl::Status> ReadyOkStatus();
+
 // Detects absl::StatusOr<T> specializations to disable them for PjRtFuture<T>.
 template <typename T>
 struct IsStatusOr : public std::false_type {};
@@ -161,8 +166,8 @@ class PjRtFutureBase : public PjRtFutureMoveControl<unique> {
   explicit PjRtFutureBase(
       T t, PjRtFutureHelpers::OnBlockStartFn on_block_start = nullptr,
       PjRtFutureHelpers::OnBlockEndFn on_block_end = nullptr)
-      : PjRtFutureBase(tsl::MakeAvailableAsyncValueRef<T>(std::move(t)),
-                       std::move(on_block_start), std::move(on_block_end)) {}
+      : PjRtFutureBase(MakeAvailable(std::move(t)), std::move(on_block_start),
+                       std::move(on_block_end)) {}
 
   bool IsValid() const { return promise_ != nullptr; }
 
@@ -175,7 +180,7 @@ class PjRtFutureBase : public PjRtFutureMoveControl<unique> {
   // call to `Await()` has already returned, or any callback passed to
   // `OnReady` has already been triggered. Otherwise IsReady() may block for
   // the duration of a network message on some backends.
-  bool IsReady() {
+  bool IsReady() const {
     CHECK(IsValid());
     return promise_.IsAvailable();
   }
@@ -184,7 +189,7 @@ class PjRtFutureBase : public PjRtFutureMoveControl<unique> {
   // callback passed to `OnReady` has already been triggered. Otherwise,
   // `IsKnownReady()` may return false in some cases in which the future was
   // ready before `IsKnownReady()` was called.
-  bool IsKnownReady() {
+  bool IsKnownReady() const {
     CHECK(IsValid());
     return promise_.IsAvailable();
   }
@@ -306,6 +311,10 @@ class PjRtFutureBase : public PjRtFutureMoveControl<unique> {
                                          !unique>* = nullptr>
   void OnReady(F&& f) const& {
     CHECK(IsValid());
+    if (promise_.IsAvailable()) {
+      f(*promise_);
+      return;
+    }
     promise_.AndThen(
         [promise = promise_.AsPtr(), f = std::forward<F>(f)]() mutable {
           DCHECK(promise.IsConcrete());
@@ -326,6 +335,14 @@ class PjRtFutureBase : public PjRtFutureMoveControl<unique> {
                               : std::is_invocable_v<F, const T&>>* = nullptr>
   void OnReady(F&& f) && {
     CHECK(IsValid());
+    if (promise_.IsAvailable()) {
+      if constexpr (unique) {
+        f(std::move(*promise_));
+      } else {
+        f(*promise_);
+      }
+      return;
+    }
     promise_.AndThen(
         [promise = promise_.AsPtr(), f = std::forward<F>(f)]() mutable {
           DCHECK(promise.IsConcrete());
@@ -341,6 +358,15 @@ class PjRtFutureBase : public PjRtFutureMoveControl<unique> {
   }
 
  private:
+  // Returns an available async value holding `t`. OK statuses share a single
+  // value instead of allocating a new one.
+  static tsl::AsyncValueRef<T> MakeAvailable(T t) {
+    if constexpr (std::is_same_v<T, absl::Status>) {
+      if (t.ok()) return ReadyOkStatus();
+    }
+    return tsl::MakeAvailableAsyncValueRef<T>(std::move(t));
+  }
+
   tsl::AsyncValueRef<T> promise_;
 
   // Function that is called before a thread starts blocking on the promise.
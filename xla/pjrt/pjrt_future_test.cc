@@ -23,6 +23,7 @@ limitations under the License.
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 
@@ -231,4 +232,97 @@ TEST(PjRtFutureTest, JoinErrors) {
   EXPECT_EQ(join_two.Await(), absl::InternalError("error #0"));
 }
 
+TEST(PjRtFutureTest, ReadyFutures) {
+  PjRtFuture<> ok(absl::OkStatus());
+  PjRtFuture<> copy = ok;
+  PjRtFuture<> error(absl::InternalError("error"));
+  EXPECT_TRUE(ok.IsReady());
+  EXPECT_TRUE(copy.IsKnownReady());
+  EXPECT_EQ(ok.Await(), absl::OkStatus());
+  EXPECT_EQ(error.Await(), absl::InternalError("error"));
+
+  // Callbacks of ready futures run inline.
+  bool called = false;
+  copy.OnReady([&](absl::Status status) {
+    EXPECT_EQ(status, absl::OkStatus());
+    called = true;
+  });
+  EXPECT_TRUE(called);
+}
+
+TEST(PjRtFutureTest, JoinReadyFutures) {
+  std::vector<PjRtFuture<>> futures = {
+      PjRtFuture<>(absl::OkStatus()),
+      PjRtFuture<>(absl::InternalError("error #0")),
+      PjRtFuture<>(absl::InternalError("error #1"))};
+  auto join = JoinFutures(futures);
+  EXPECT_TRUE(join.IsReady());
+  EXPECT_EQ(join.Await(), absl::InternalError("error #0"));
+
+  auto promise = PjRtFuture<>::CreatePromise();
+  futures.push_back(PjRtFuture<>(promise));
+  auto join_pending = JoinFutures(futures);
+  EXPECT_FALSE(join_pending.IsReady());
+  promise.Set();
+  EXPECT_EQ(join_pending.Await(), absl::InternalError("error #0"));
+}
+
+void BM_ReadyFuture(::testing::benchmark::State& state) {
+  for (auto s : state) {
+    PjRtFuture<> future(absl::OkStatus());
+    future.OnReady([](absl::Status status) {
+      ::testing::benchmark::DoNotOptimize(status);
+    });
+  }
+}
+
+BENCHMARK(BM_ReadyFuture);
+
+void BM_ReadyValueFuture(::testing::benchmark::State& state) {
+  for (auto s : state) {
+    PjRtFuture<int32_t> future(42);
+    std::move(future).OnReady([](absl::StatusOr<int32_t> value) {
+      ::testing::benchmark::DoNotOptimize(value);
+    });
+  }
+}
+
+BENCHMARK(BM_ReadyValueFuture);
+
+void BM_PromiseChain(::testing::benchmark::State& state) {
+  for (auto s : state) {
+    auto promise = PjRtFuture<>::CreatePromise();
+    PjRtFuture<> future(promise);
+    future.OnReady([](absl::Status status) {
+      ::testing::benchmark::DoNotOptimize(status);
+    });
+    promise.Set();
+  }
+}
+
+BENCHMARK(BM_PromiseChain);
+
+void BM_JoinFutures(::testing::benchmark::State& state) {
+  const bool ready = state.range(0) != 0;
+  for (auto s : state) {
+    std::vector<PjRtFuture<>::Promise> promises;
+    std::vector<PjRtFuture<>> futures;
+    for (int i = 0; i < 8; ++i) {
+      if (ready) {
+        futures.push_back(PjRtFuture<>(absl::OkStatus()));
+      } else {
+        promises.push_back(PjRtFuture<>::CreatePromise());
+        futures.push_back(PjRtFuture<>(promises.back()));
+      }
+    }
+    PjRtFuture<> join = JoinFutures(futures);
+    for (auto& promise : promises) {
+      promise.Set();
+    }
+    ::testing::benchmark::DoNotOptimize(join.Await());
+  }
+}
+
+BENCHMARK(BM_JoinFutures)->Arg(0)->Arg(1);
+
 }  // namespace xla
@@ -82,6 +82,7 @@ limitations under the License.
 #endif  // !_WIN32 && !PLATFORM_GOOGLE
 
 #include "xla/pjrt/cpu/cpu_client.h"
+#include "xla/pjrt/cpu/cross_host_transport.h"
 #include "xla/pjrt/distributed/key_value_store_interface.h"
 #include "xla/pjrt/exceptions.h"
 #include "xla/pjrt/pjrt_api.h"
@@ -325,8 +326,14 @@ NB_MODULE(xla_extension, m_nb) {
       [](bool asynchronous,
          std::shared_ptr<DistributedRuntimeClient> distributed_client,
          int node_id, int num_nodes,
-         std::shared_ptr<xla::cpu::CollectivesInterface> collectives)
-          -> nb_class_ptr<PyClient> {
+         std::shared_ptr<xla::cpu::CollectivesInterface> collectives,
+         bool use_kv_store_cross_host_transport) -> nb_class_ptr<PyClient> {
+        if (use_kv_store_cross_host_transport &&
+            distributed_client == nullptr) {
+          throw nb::value_error(
+              "use_kv_store_cross_host_transport requires a "
+              "distributed_client.");
+        }
         std::unique_ptr<ifrt::PjRtClient> ifrt_client;
         {
           nb::gil_scoped_release gil_release;
@@ -335,6 +342,15 @@ NB_MODULE(xla_extension, m_nb) {
           options.asynchronous = asynchronous;
           options.collectives = std::move(collectives);
           options.process_id = node_id;
+          // The key-value store of the distributed runtime is not meant for
+          // bulk data, so cross-host transfers through it are opt-in.
+          if (use_kv_store_cross_host_transport) {
+            options.cross_host_transport =
+                std::make_shared<cpu::KeyValueStoreCrossHostTransport>(
+                    GetDistributedKeyValueStore(distributed_client,
+                                                /*key_prefix=*/"cpu:"),
+                    node_id);
+          }
           std::unique_ptr<PjRtClient> client =
               xla::ValueOrThrow(GetTfrtCpuClient(options));
           ifrt::PjRtClient::CreateOptions ifrt_options;
@@ -355,7 +371,8 @@ NB_MODULE(xla_extension, m_nb) {
       nb::arg("asynchronous") = true, nb::arg("distributed_client") = nullptr,
       nb::arg("node_id") = 0, nb::arg("num_nodes") = 1,
       nb::arg("collectives").none() =
-          std::shared_ptr<xla::cpu::CollectivesInterface>());
+          std::shared_ptr<xla::cpu::CollectivesInterface>(),
+      nb::arg("use_kv_store_cross_host_transport") = false);
   m_nb.def("pjrt_plugin_loaded", [](std::string platform_name) -> bool {
     absl::StatusOr<const PJRT_Api*> pjrt_api = pjrt::PjrtApi(platform_name);
     return pjrt_api.ok();
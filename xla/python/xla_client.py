@@ -50,7 +50,7 @@ profiler = _xla.profiler
 
 # Just an internal arbitrary increasing number to help with backward-compatible
 # changes. In JAX, reference this via jax._src.lib.xla_extension_version.
-_version = 280
+_version = 281
 
 # Version number for MLIR:Python components.
 mlir_api_version = 57
@@ -70,7 +70,8 @@ def make_cpu_client(
     distributed_client=None,
     node_id=0,
     num_nodes=1,
-    collectives=None
+    collectives=None,
+    use_kv_store_cross_host_transport=False,
 ) -> ...:
   register_custom_call_handler('cpu', _xla.register_custom_call_target)
   return _xla.get_tfrt_cpu_client(
@@ -79,6 +80,7 @@ def make_cpu_client(
       node_id=node_id,
       num_nodes=num_nodes,
       collectives=collectives,
+      use_kv_store_cross_host_transport=use_kv_store_cross_host_transport,
   )
 
 
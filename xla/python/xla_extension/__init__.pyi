@@ -567,6 +567,7 @@ def get_tfrt_cpu_client(
     node_id: int = ...,
     num_nodes: int = ...,
     collectives: Optional[CpuCollectives] = ...,
+    use_kv_store_cross_host_transport: bool = ...,
 ) -> Client: ...
 def get_gpu_client(
     asynchronous: bool = ...,
@@ -51,6 +51,7 @@ limitations under the License.
 #include "xla/service/memory_space_assignment/memory_space_assignment.h"
 #include "xla/shape_util.h"
 #include "tsl/platform/logging.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -653,6 +654,12 @@ class BufferAssigner {
   // LogicalBuffer. If preset_assignments is provided, those pre-set assignment
   // offsets will be used. The caller guarantees that those assignments are
   // valid and they do not overwrite each other.
+  //
+  // If thread_pool is not null, the heap algorithms compared for each color
+  // are finished concurrently on it. They only use the sizes and orderings
+  // recorded while the heap is simulated, so none of the functions passed to
+  // Run are called from the pool; a custom heap_buffer_interval_compare is
+  // always run on the calling thread.
   static absl::StatusOr<std::unique_ptr<BufferAssignment>> Run(
       const HloModule* module, std::unique_ptr<HloOrdering> hlo_ordering,
       BufferValue::SizeFunction buffer_size,
@@ -668,17 +675,20 @@ class BufferAssigner {
           heap_buffer_interval_compare = nullptr,
       std::optional<BufferAssignment::BufferIsolationOptions>
           isolation_options = std::nullopt,
-      std::optional<BufferValue::Color> temp_buffer_color = std::nullopt);
+      std::optional<BufferValue::Color> temp_buffer_color = std::nullopt,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
 
  private:
   BufferAssigner(bool allocate_buffers_for_constants, Colorer colorer,
                  std::optional<MustNotLiveOut> must_not_live_out,
                  std::unique_ptr<memory_space_assignment::PresetAssignments>
-                     preset_assignments)
+                     preset_assignments,
+                 tsl::thread::ThreadPool* thread_pool)
       : allocate_buffers_for_constants_(allocate_buffers_for_constants),
         colorer_(colorer),
         must_not_live_out_(must_not_live_out),
-        preset_assignments_(std::move(preset_assignments)) {}
+        preset_assignments_(std::move(preset_assignments)),
+        thread_pool_(thread_pool) {}
   virtual ~BufferAssigner() = default;
 
   // Create a buffer assignment.
@@ -793,6 +803,10 @@ class BufferAssigner {
   std::unique_ptr<memory_space_assignment::PresetAssignments>
       preset_assignments_;
 
+  // Pool on which ChooseBestHeapAlgorithm finishes its algorithms, or null to
+  // finish them on the calling thread.
+  tsl::thread::ThreadPool* thread_pool_;
+
   BufferAssigner(const BufferAssigner&) = delete;
   BufferAssigner& operator=(const BufferAssigner&) = delete;
 };
@@ -49,7 +49,9 @@ limitations under the License.
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/types.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -2075,6 +2077,41 @@ TEST_F(BufferAssignmentTest, PeakBuffers) {
   EXPECT_THAT(peak_instructions, UnorderedElementsAre(rev, neg, concat));
 }
 
+TEST_F(BufferAssignmentTest, ThreadPoolDoesNotChangeAssignment) {
+  const char* hlo_text = R"(
+HloModule test_module, is_scheduled=true
+
+ENTRY test_module {
+  p = f32[64] parameter(0)
+  a = f32[64] negate(p)
+  b = f32[32] slice(a), slice={[0:32]}
+  c = f32[64] exponential(a)
+  d = f32[32] negate(b)
+  e = f32[64] add(c, a)
+  f = f32[96] concatenate(d, e), dimensions={0}
+  ROOT g = f32[96] negate(f)
+})";
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo_text));
+  auto run = [&](tsl::thread::ThreadPool* thread_pool) {
+    return BufferAssigner::Run(
+               module.get(),
+               std::make_unique<SequentialHloOrdering>(module->schedule()),
+               backend().compiler()->BufferSizeBytesFunction(),
+               [](LogicalBuffer::Color) { return 1; },
+               /*allocate_buffers_for_constants=*/true,
+               BufferAssigner::DefaultColorer(),
+               /*must_not_live_out=*/std::nullopt,
+               /*can_share_buffer=*/nullptr, /*preset_assignments=*/{},
+               /*private_stacks=*/{},
+               /*heap_buffer_interval_compare=*/nullptr,
+               /*isolation_options=*/std::nullopt,
+               /*temp_buffer_color=*/std::nullopt, thread_pool)
+        .value();
+  };
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 2);
+  EXPECT_EQ(run(&thread_pool)->ToString(), run(nullptr)->ToString());
+}
+
 TEST_F(BufferAssignmentTest, AliasedBuffersShouldntCoexistInPeakBuffers) {
   std::string hlo_text = R"(
 HloModule test_module, is_scheduled=true
@@ -0,0 +1,215 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/compile_profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_module_group.h"
+#include "xla/service/compile_profile.pb.h"
+#include "xla/service/dump.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/protobuf.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace xla {
+namespace {
+
+thread_local CompileProfiler* current_profiler = nullptr;
+
+// Returns the peak resident set size of the process, or zero if unknown.
+int64_t PeakRssBytes() {
+#if defined(__linux__) || defined(__APPLE__)
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+  return usage.ru_maxrss;
+#else
+  // Linux reports kilobytes.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+int64_t GroupInstructionCount(const HloModuleGroup& module_group) {
+  int64_t count = 0;
+  for (const HloModule* module : module_group.modules()) {
+    count += module->instruction_count();
+  }
+  return count;
+}
+
+// Appends the passes in `profiles` and their descendants to `passes`.
+void CollectPasses(
+    const tsl::protobuf::RepeatedPtrField<HloPassProfileProto>& profiles,
+    std::vector<const HloPassProfileProto*>& passes) {
+  for (const HloPassProfileProto& profile : profiles) {
+    if (profile.kind() == HloPassProfileProto::PASS) {
+      passes.push_back(&profile);
+    }
+    CollectPasses(profile.children(), passes);
+  }
+}
+
+}  // namespace
+
+CompileProfiler::CompileProfiler(absl::string_view module_name)
+    : previous_(current_profiler),
+      module_name_(module_name),
+      start_usec_(tsl::Env::Default()->NowMicros()) {
+  current_profiler = this;
+}
+
+CompileProfiler::~CompileProfiler() {
+  DCHECK(running_.empty()) << "Profiler destroyed while passes are running";
+  DCHECK_EQ(current_profiler, this) << "Profilers must be destroyed in order";
+  current_profiler = previous_;
+}
+
+CompileProfiler* CompileProfiler::Current() { return current_profiler; }
+
+CompileProfileProto CompileProfiler::ToProto() const {
+  CompileProfileProto proto;
+  proto.set_module_name(module_name_);
+  proto.set_wall_time_usec(tsl::Env::Default()->NowMicros() - start_usec_);
+  for (const HloPassProfileProto& pass : passes_) {
+    *proto.add_passes() = pass;
+  }
+  return proto;
+}
+
+CompileProfiler::ScopedPass::ScopedPass(absl::string_view name,
+                                        HloPassProfileProto::Kind kind,
+                                        const HloModule& module)
+    : profiler_(current_profiler), module_(&module) {
+  if (profiler_ != nullptr) Start(name, kind);
+}
+
+CompileProfiler::ScopedPass::ScopedPass(absl::string_view name,
+                                        HloPassProfileProto::Kind kind,
+                                        const HloModuleGroup& module_group)
+    : profiler_(current_profiler), module_group_(&module_group) {
+  if (profiler_ != nullptr) Start(name, kind);
+}
+
+void CompileProfiler::ScopedPass::Start(absl::string_view name,
+                                        HloPassProfileProto::Kind kind) {
+  profile_.set_name(std::string(name));
+  profile_.set_kind(kind);
+  profile_.set_instruction_count_before(InstructionCount());
+  start_peak_rss_bytes_ = PeakRssBytes();
+  start_usec_ = tsl::Env::Default()->NowMicros();
+  profiler_->running_.push_back(this);
+}
+
+CompileProfiler::ScopedPass::~ScopedPass() {
+  if (profiler_ == nullptr) return;
+  profile_.set_wall_time_usec(tsl::Env::Default()->NowMicros() - start_usec_);
+  profile_.set_peak_rss_delta_bytes(PeakRssBytes() - start_peak_rss_bytes_);
+  profile_.set_instruction_count_after(InstructionCount());
+
+  DCHECK_EQ(profiler_->running_.back(), this);
+  profiler_->running_.pop_back();
+  if (profiler_->running_.empty()) {
+    profiler_->passes_.push_back(std::move(profile_));
+  } else {
+    *profiler_->running_.back()->profile_.add_children() = std::move(profile_);
+  }
+}
+
+int64_t CompileProfiler::ScopedPass::InstructionCount() const {
+  return module_ != nullptr ? module_->instruction_count()
+                            : GroupInstructionCount(*module_group_);
+}
+
+ScopedHloPassesProfile::ScopedHloPassesProfile(absl::string_view name,
+                                               const HloModule& module)
+    : module_(&module) {
+  if (CompileProfiler::Current() == nullptr) {
+    const DebugOptions& debug_options = module.config().debug_options();
+    if (!debug_options.xla_dump_compile_profile() ||
+        !DumpingEnabledForHloModule(module)) {
+      return;
+    }
+    profiler_ = std::make_unique<CompileProfiler>(module.name());
+  }
+  pass_ = std::make_unique<CompileProfiler::ScopedPass>(
+      name, HloPassProfileProto::PIPELINE, module);
+}
+
+ScopedHloPassesProfile::~ScopedHloPassesProfile() {
+  pass_.reset();
+  if (profiler_ == nullptr) return;
+
+  std::string json;
+  tsl::protobuf::util::JsonPrintOptions options;
+  options.add_whitespace = true;
+  options.always_print_primitive_fields = true;
+  if (!tsl::protobuf::util::MessageToJsonString(profiler_->ToProto(), &json,
+                                                options)
+           .ok()) {
+    LOG(WARNING) << "Failed to convert the compile profile of "
+                 << module_->name() << " to JSON";
+    return;
+  }
+  profiler_.reset();
+  DumpToFileInDirOrStdout(*module_, "", "compile_profile.json", json);
+}
+
+std::string FormatTopPasses(const CompileProfileProto& profile, int count) {
+  std::vector<const HloPassProfileProto*> passes;
+  CollectPasses(profile.passes(), passes);
+  std::stable_sort(passes.begin(), passes.end(),
+                   [](const HloPassProfileProto* a,
+                      const HloPassProfileProto* b) {
+                     return a->wall_time_usec() > b->wall_time_usec();
+                   });
+  passes.resize(std::min<size_t>(passes.size(), std::max(count, 0)));
+
+  std::string report = absl::StrFormat(
+      "Slowest HLO passes of %s (%.3f s in total):\n", profile.module_name(),
+      profile.wall_time_usec() * 1e-6);
+  absl::StrAppendFormat(&report, "%-50s %10s %6s %12s %14s\n", "pass",
+                        "time(ms)", "%time", "peak RSS(MB)", "instructions");
+  for (const HloPassProfileProto* pass : passes) {
+    absl::StrAppendFormat(
+        &report, "%-50s %10.2f %6.1f %12.1f %+14d\n", pass->name(),
+        pass->wall_time_usec() * 1e-3,
+        profile.wall_time_usec() > 0
+            ? 100.0 * pass->wall_time_usec() / profile.wall_time_usec()
+            : 0.0,
+        pass->peak_rss_delta_bytes() / (1024.0 * 1024.0),
+        pass->instruction_count_after() - pass->instruction_count_before());
+  }
+  return report;
+}
+
+}  // namespace xla
@@ -0,0 +1,121 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_COMPILE_PROFILER_H_
+#define XLA_SERVICE_COMPILE_PROFILER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_module_group.h"
+#include "xla/service/compile_profile.pb.h"
+
+namespace xla {
+
+// Collects a CompileProfileProto with the time, peak memory growth and HLO
+// size change of every HLO pass run on the calling thread while it is alive.
+//
+// HloPassPipeline and HloPassFix report the passes they run to the profiler
+// that is active on the calling thread, so the profile is a tree of nested
+// pipelines and fixed-point iterations. When no profiler is active, reporting
+// a pass costs a thread-local lookup. Profilers can be nested, in which case
+// passes are only recorded by the innermost one.
+class CompileProfiler {
+ public:
+  explicit CompileProfiler(absl::string_view module_name);
+  ~CompileProfiler();
+
+  CompileProfiler(const CompileProfiler&) = delete;
+  CompileProfiler& operator=(const CompileProfiler&) = delete;
+
+  // Returns the profiler active on the calling thread, or nullptr.
+  static CompileProfiler* Current();
+
+  // Returns the passes that have finished so far.
+  CompileProfileProto ToProto() const;
+
+  // Records a pass run on `module` or `module_group` from construction to
+  // destruction with the active profiler, if any. Passes recorded while this
+  // is alive become its children.
+  class ScopedPass {
+   public:
+    ScopedPass(absl::string_view name, HloPassProfileProto::Kind kind,
+               const HloModule& module);
+    ScopedPass(absl::string_view name, HloPassProfileProto::Kind kind,
+               const HloModuleGroup& module_group);
+    ~ScopedPass();
+
+    ScopedPass(const ScopedPass&) = delete;
+    ScopedPass& operator=(const ScopedPass&) = delete;
+
+    void set_changed(bool changed) {
+      if (profiler_ != nullptr) profile_.set_changed(changed);
+    }
+
+   private:
+    void Start(absl::string_view name, HloPassProfileProto::Kind kind);
+    int64_t InstructionCount() const;
+
+    CompileProfiler* profiler_;
+    const HloModule* module_ = nullptr;
+    const HloModuleGroup* module_group_ = nullptr;
+    HloPassProfileProto profile_;
+    uint64_t start_usec_ = 0;
+    int64_t start_peak_rss_bytes_ = 0;
+  };
+
+ private:
+  CompileProfiler* previous_;
+  std::string module_name_;
+  uint64_t start_usec_;
+  // Passes that have finished at the top level.
+  std::vector<HloPassProfileProto> passes_;
+  // Passes that are running, innermost last.
+  std::vector<ScopedPass*> running_;
+};
+
+// Profiles the passes run by a compiler's RunHloPasses on `module`.
+//
+// If a profiler is active, the passes are recorded with it, under a pipeline
+// named `name`. Otherwise, if --xla_dump_compile_profile is set and dumping
+// is enabled for the module, they are recorded with a profiler of their own,
+// which is dumped as JSON next to the other dumps of the module when this is
+// destroyed.
+class ScopedHloPassesProfile {
+ public:
+  ScopedHloPassesProfile(absl::string_view name, const HloModule& module);
+  ~ScopedHloPassesProfile();
+
+  ScopedHloPassesProfile(const ScopedHloPassesProfile&) = delete;
+  ScopedHloPassesProfile& operator=(const ScopedHloPassesProfile&) = delete;
+
+ private:
+  const HloModule* module_;
+  std::unique_ptr<CompileProfiler> profiler_;
+  std::unique_ptr<CompileProfiler::ScopedPass> pass_;
+};
+
+// Returns a report of the `count` passes (not pipelines or iterations) that
+// took the most time in `profile`, with their share of the total, memory
+// growth and change in instruction count.
+std::string FormatTopPasses(const CompileProfileProto& profile, int count);
+
+}  // namespace xla
+
+#endif  // XLA_SERVICE_COMPILE_PROFILER_H_
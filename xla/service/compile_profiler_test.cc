@@ -0,0 +1,180 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+#include "xla/service/compile_profiler.h"
+
+#include <memory>
+#include <string>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/service/compile_profile.pb.h"
+#include "xla/service/hlo_pass_fix.h"
+#include "xla/service/hlo_pass_pipeline.h"
+#include "xla/tests/hlo_test_base.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+constexpr char kHlo[] = R"(
+HloModule m
+
+ENTRY e {
+  x = f32[4] parameter(0)
+  dead0 = f32[4] negate(x)
+  dead1 = f32[4] exponential(x)
+  ROOT foo = f32[4] add(x, x)
+})";
+
+// Removes one dead instruction per run, so that running it to a fixed point
+// takes several iterations.
+class RemoveOneDeadInstruction : public HloModulePass {
+ public:
+  absl::string_view name() const override { return "remove-one-dead"; }
+
+  using HloPassInterface::Run;
+  absl::StatusOr<bool> Run(HloModule* module,
+                           const absl::flat_hash_set<absl::string_view>&
+                               execution_threads) override {
+    HloComputation* entry = module->entry_computation();
+    for (HloInstruction* instruction : entry->instructions()) {
+      if (instruction->IsDead() &&
+          instruction->opcode() != HloOpcode::kParameter) {
+        TF_RETURN_IF_ERROR(entry->RemoveInstruction(instruction));
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+// Renames the instruction named 'foo' to 'bar'.
+class FooToBar : public HloModulePass {
+ public:
+  absl::string_view name() const override { return "foo2bar"; }
+
+  using HloPassInterface::Run;
+  absl::StatusOr<bool> Run(HloModule* module,
+                           const absl::flat_hash_set<absl::string_view>&
+                               execution_threads) override {
+    HloInstruction* root = module->entry_computation()->root_instruction();
+    if (root->name() != "foo") return false;
+    root->SetAndSanitizeName("bar");
+    return true;
+  }
+};
+
+class CompileProfilerTest : public HloTestBase {
+ protected:
+  // Runs a pipeline with a fixed-point pass and a nested pipeline.
+  void RunPasses(HloModule* module) {
+    HloPassPipeline pipeline("outer");
+    pipeline.AddPass<HloPassFix<RemoveOneDeadInstruction>>();
+    HloPassPipeline& inner = pipeline.AddPass<HloPassPipeline>("inner");
+    inner.AddPass<FooToBar>();
+    ASSERT_TRUE(pipeline.Run(module).value());
+  }
+};
+
+TEST_F(CompileProfilerTest, RecordsPassTree) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  CompileProfiler profiler(module->name());
+  EXPECT_EQ(CompileProfiler::Current(), &profiler);
+  RunPasses(module.get());
+  CompileProfileProto profile = profiler.ToProto();
+
+  EXPECT_EQ(profile.module_name(), "m");
+  ASSERT_EQ(profile.passes_size(), 1);
+  const HloPassProfileProto& outer = profile.passes(0);
+  EXPECT_EQ(outer.name(), "outer");
+  EXPECT_EQ(outer.kind(), HloPassProfileProto::PIPELINE);
+  EXPECT_EQ(outer.instruction_count_before(), 4);
+  EXPECT_EQ(outer.instruction_count_after(), 2);
+  EXPECT_TRUE(outer.changed());
+  ASSERT_EQ(outer.children_size(), 2);
+
+  const HloPassProfileProto& fix = outer.children(0);
+  EXPECT_EQ(fix.name(), "remove-one-dead");
+  EXPECT_EQ(fix.kind(), HloPassProfileProto::PASS);
+  EXPECT_TRUE(fix.changed());
+  ASSERT_EQ(fix.children_size(), 3);
+  for (int i = 0; i < fix.children_size(); ++i) {
+    const HloPassProfileProto& iteration = fix.children(i);
+    EXPECT_EQ(iteration.name(),
+              absl::StrCat("remove-one-dead iteration ", i));
+    EXPECT_EQ(iteration.kind(), HloPassProfileProto::FIXED_POINT_ITERATION);
+    EXPECT_EQ(iteration.instruction_count_before(), 4 - i);
+    EXPECT_EQ(iteration.changed(), i < 2);
+  }
+
+  const HloPassProfileProto& inner = outer.children(1);
+  EXPECT_EQ(inner.name(), "inner");
+  EXPECT_EQ(inner.kind(), HloPassProfileProto::PIPELINE);
+  ASSERT_EQ(inner.children_size(), 1);
+  EXPECT_EQ(inner.children(0).name(), "foo2bar");
+  EXPECT_TRUE(inner.children(0).changed());
+}
+
+TEST_F(CompileProfilerTest, InnermostProfilerRecords) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  CompileProfiler outer(module->name());
+  {
+    CompileProfiler inner(module->name());
+    RunPasses(module.get());
+    EXPECT_EQ(inner.ToProto().passes_size(), 1);
+  }
+  EXPECT_EQ(CompileProfiler::Current(), &outer);
+  EXPECT_EQ(outer.ToProto().passes_size(), 0);
+}
+
+TEST_F(CompileProfilerTest, NothingIsRecordedWithoutProfiler) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  EXPECT_EQ(CompileProfiler::Current(), nullptr);
+  RunPasses(module.get());
+}
+
+TEST_F(CompileProfilerTest, FormatTopPassesListsOnlyPasses) {
+  TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(kHlo));
+  CompileProfiler profiler(module->name());
+  RunPasses(module.get());
+  std::string report = FormatTopPasses(profiler.ToProto(), 10);
+  EXPECT_THAT(report, HasSubstr("remove-one-dead"));
+  EXPECT_THAT(report, HasSubstr("foo2bar"));
+  EXPECT_THAT(report, Not(HasSubstr("iteration")));
+  EXPECT_THAT(report, Not(HasSubstr("inner")));
+
+  report = FormatTopPasses(profiler.ToProto(), 1);
+  EXPECT_EQ(
+      absl::StrContains(report, "remove-one-dead") +
+          absl::StrContains(report, "foo2bar"),
+      1);
+}
+
+}  // namespace
+}  // namespace xla
@@ -14,16 +14,14 @@ limitations under the License.
 ==============================================================================*/
 
 #include <cstdint>
-#include <random>
+#include <string>
 #include <string_view>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "xla/literal.h"
-#include "xla/literal_util.h"
 #include "xla/service/cpu/benchmarks/hlo_benchmark_runner.h"
-#include "xla/shape_util.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/test_benchmark.h"
 
@@ -42,14 +40,12 @@ static void BM_AddF32(benchmark::State& state) {
     }
   )";
 
-  std::minstd_rand0 engine;
+  std::string d0_str = absl::StrCat(d0);
+  std::vector<Literal> literals =
+      *MakeHloBenchmarkArguments(hlo, {{"$d0", d0_str}});
 
-  auto shape = ShapeUtil::MakeShape(F32, {1, 2, 1, d0, 256});
-  auto p0 = *LiteralUtil::CreateRandomLiteral<F32>(shape, &engine, 1.0f, 0.1f);
-  auto p1 = *LiteralUtil::CreateRandomLiteral<F32>(shape, &engine, 1.0f, 0.1f);
-
-  std::vector<const Literal*> args = {&p0, &p1};
-  CHECK_OK(RunHloBenchmark(state, hlo, args, {{"$d0", absl::StrCat(d0)}}));
+  std::vector<const Literal*> args = {&literals[0], &literals[1]};
+  CHECK_OK(RunHloBenchmark(state, hlo, args, {{"$d0", d0_str}}));
 }
 
 BENCHMARK(BM_AddF32)
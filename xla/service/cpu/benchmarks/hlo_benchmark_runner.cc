@@ -15,12 +15,19 @@ limitations under the License.
 
 #include "xla/service/cpu/benchmarks/hlo_benchmark_runner.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_replace.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xla/client/xla_computation.h"
 #include "xla/hlo/ir/hlo_module.h"
@@ -30,9 +37,14 @@ limitations under the License.
 #include "xla/pjrt/pjrt_executable.h"
 #include "xla/service/hlo_module_config.h"
 #include "xla/service/hlo_parser.h"
+#include "xla/tests/test_utils.h"
+#include "xla/util.h"
+#include "tsl/platform/cpu_info.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla::cpu {
 
@@ -95,4 +107,91 @@ absl::Status RunHloBenchmark(benchmark::State& state,
   return absl::OkStatus();
 }
 
+absl::StatusOr<std::vector<Literal>> MakeHloBenchmarkArguments(
+    std::string_view hlo_module, StrToStrMapping replacements, uint64_t seed) {
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloModule> module,
+                      ParseAndReturnUnverifiedModule(
+                          absl::StrReplaceAll(hlo_module, replacements),
+                          HloModuleConfig() /* unused */));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "benchmark-args",
+                                      tsl::port::MaxParallelism());
+  return MakeFakeArgumentsWithSeed(module.get(), seed,
+                                   /*use_large_range=*/false,
+                                   /*treat_gte_as_data_formatting=*/false,
+                                   &thread_pool);
+}
+
+HloModuleBenchmark::HloModuleBenchmark(
+    PjRtDevice* device, std::unique_ptr<PjRtLoadedExecutable> executable,
+    std::shared_ptr<HloModule> optimized_module,
+    std::vector<std::unique_ptr<PjRtBuffer>> args)
+    : device_(device),
+      executable_(std::move(executable)),
+      optimized_module_(std::move(optimized_module)),
+      args_(std::move(args)) {
+  args_ptrs_.reserve(args_.size());
+  for (const auto& arg : args_) {
+    args_ptrs_.push_back(arg.get());
+  }
+}
+
+absl::StatusOr<std::unique_ptr<HloModuleBenchmark>> HloModuleBenchmark::Create(
+    PjRtClient* client, const HloModule& module, uint64_t seed) {
+  PjRtDevice* device = client->addressable_devices().front();
+
+  XlaComputation computation(module.ToProto());
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<PjRtLoadedExecutable> executable,
+                      client->Compile(computation, CompileOptions()));
+  TF_ASSIGN_OR_RETURN(std::vector<std::shared_ptr<HloModule>> optimized,
+                      executable->GetHloModules());
+  if (optimized.size() != 1) {
+    return Unimplemented("Expected one optimized module, got %d",
+                         optimized.size());
+  }
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "benchmark-args",
+                                      tsl::port::MaxParallelism());
+  TF_ASSIGN_OR_RETURN(std::vector<Literal> literals,
+                      MakeFakeArgumentsWithSeed(
+                          &module, seed, /*use_large_range=*/false,
+                          /*treat_gte_as_data_formatting=*/false,
+                          &thread_pool));
+  std::vector<std::unique_ptr<PjRtBuffer>> args;
+  args.reserve(literals.size());
+  for (const Literal& literal : literals) {
+    TF_ASSIGN_OR_RETURN(args.emplace_back(),
+                        client->BufferFromHostLiteral(literal, device));
+    TF_RETURN_IF_ERROR(args.back()->GetReadyFuture().Await());
+  }
+
+  return absl::WrapUnique(new HloModuleBenchmark(device, std::move(executable),
+                                                 std::move(optimized[0]),
+                                                 std::move(args)));
+}
+
+absl::Status HloModuleBenchmark::Run() {
+  // Execute in synchronous mode to avoid thread hops.
+  ExecuteOptions execute_options;
+  execute_options.execution_mode = ExecuteOptions::ExecutionMode::kSynchronous;
+  return executable_->ExecuteSharded(args_ptrs_, device_, execute_options)
+      .status();
+}
+
+absl::Status HloModuleBenchmark::Run(benchmark::State& state) {
+  TF_RETURN_IF_ERROR(Run());
+  for (auto _ : state) {
+    TF_RETURN_IF_ERROR(Run());
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<absl::Duration> HloModuleBenchmark::Time(int64_t num_runs) {
+  TF_RETURN_IF_ERROR(Run());
+  absl::Time start = absl::Now();
+  for (int64_t i = 0; i < num_runs; ++i) {
+    TF_RETURN_IF_ERROR(Run());
+  }
+  return (absl::Now() - start) / std::max<int64_t>(num_runs, 1);
+}
+
 }  // namespace xla::cpu
@@ -16,11 +16,19 @@ limitations under the License.
 #ifndef XLA_SERVICE_CPU_BENCHMARKS_HLO_BENCHMARK_RUNNER_H_
 #define XLA_SERVICE_CPU_BENCHMARKS_HLO_BENCHMARK_RUNNER_H_
 
+#include <cstdint>
+#include <memory>
 #include <string_view>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_module.h"
 #include "xla/literal.h"
+#include "xla/pjrt/pjrt_client.h"
+#include "xla/pjrt/pjrt_executable.h"
 #include "tsl/platform/test_benchmark.h"
 
 namespace xla::cpu {
@@ -44,6 +52,48 @@ absl::Status RunHloBenchmark(benchmark::State& state,
                              StrToStrMapping replacements = {},
                              bool disable_parallel_task_assigner = false);
 
+// Generates fake arguments for the HLO module, interpolated with the given
+// replacements, using a thread pool to fill large arguments. The arguments
+// only depend on the module and on `seed`.
+absl::StatusOr<std::vector<Literal>> MakeHloBenchmarkArguments(
+    std::string_view hlo_module, StrToStrMapping replacements = {},
+    uint64_t seed = 0);
+
+// An HLO module compiled once for the CPU backend, with fake arguments for its
+// parameters already transferred to the device, so that it can be run many
+// times without compiling or generating arguments again.
+class HloModuleBenchmark {
+ public:
+  // Compiles `module` with `client`, which must outlive the benchmark.
+  // Arguments are generated with MakeFakeArgumentsWithSeed.
+  static absl::StatusOr<std::unique_ptr<HloModuleBenchmark>> Create(
+      PjRtClient* client, const HloModule& module, uint64_t seed = 0);
+
+  // Runs the module once.
+  absl::Status Run();
+
+  // Runs the module once per benchmark iteration, after a warmup run.
+  absl::Status Run(benchmark::State& state);
+
+  // Returns the mean wall time of `num_runs` runs, after a warmup run.
+  absl::StatusOr<absl::Duration> Time(int64_t num_runs);
+
+  // Returns the module after HLO optimizations.
+  const HloModule& optimized_module() const { return *optimized_module_; }
+
+ private:
+  HloModuleBenchmark(PjRtDevice* device,
+                     std::unique_ptr<PjRtLoadedExecutable> executable,
+                     std::shared_ptr<HloModule> optimized_module,
+                     std::vector<std::unique_ptr<PjRtBuffer>> args);
+
+  PjRtDevice* device_;
+  std::unique_ptr<PjRtLoadedExecutable> executable_;
+  std::shared_ptr<HloModule> optimized_module_;
+  std::vector<std::unique_ptr<PjRtBuffer>> args_;
+  std::vector<PjRtBuffer*> args_ptrs_;
+};
+
 }  // namespace xla::cpu
 
 #endif  // XLA_SERVICE_CPU_BENCHMARKS_HLO_BENCHMARK_RUNNER_H_
@@ -0,0 +1,121 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A tool that benchmarks HLO modules read from files on the CPU backend, and
+// reports the time and estimated cost of their instructions. See kUsage for
+// details.
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/pjrt/cpu/cpu_client.h"
+#include "xla/pjrt/pjrt_client.h"
+#include "xla/service/cpu/benchmarks/hlo_benchmark_runner.h"
+#include "xla/service/cpu/benchmarks/hlo_op_profiler.h"
+#include "xla/tools/hlo_module_loader.h"
+#include "xla/tsl/util/command_line_flags.h"
+#include "tsl/platform/init_main.h"
+#include "tsl/platform/logging.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test_benchmark.h"
+
+namespace {
+const char* const kUsage = R"(
+This tool compiles HLO modules read from files (e.g. modules dumped with
+--xla_dump_to) for the CPU backend, and benchmarks them on fake arguments.
+
+Every module is registered as a Google Benchmark, so the usual --benchmark_*
+flags apply. After the benchmarks, every instruction of every optimized module
+is run on its own, and a table with its time, its HloCostAnalysis estimates
+and its achieved throughput is printed. Pass --peak_gflops and --peak_gbps to
+also place every instruction on a roofline.
+
+Usage:
+
+  bazel run hlo_module_benchmark -- [--peak_gflops=N --peak_gbps=N] \
+    path/to/module1.hlo path/to/module2.hlo
+)";
+}  // namespace
+
+int main(int argc, char** argv) {
+  bool profile_ops = true;
+  int64_t op_runs = 100;
+  double peak_gflops = 0;
+  double peak_gbps = 0;
+  std::vector<tsl::Flag> flag_list = {
+      tsl::Flag("profile_ops", &profile_ops,
+                "Whether to run and report every instruction on its own after "
+                "the benchmarks."),
+      tsl::Flag("op_runs", &op_runs,
+                "The number of times every instruction, and the whole module "
+                "it is compared to, is run when profiling instructions."),
+      tsl::Flag("peak_gflops", &peak_gflops,
+                "The peak compute throughput of the machine in GFLOP/s."),
+      tsl::Flag("peak_gbps", &peak_gbps,
+                "The peak memory bandwidth of the machine in GB/s."),
+  };
+  const std::string kUsageString =
+      absl::StrCat(kUsage, "\n\n", tsl::Flags::Usage(argv[0], flag_list));
+  tsl::testing::InitializeBenchmarks(&argc, argv);
+  bool parse_ok = tsl::Flags::Parse(&argc, argv, flag_list);
+  tsl::port::InitMain(kUsageString.c_str(), &argc, &argv);
+  if (!parse_ok) {
+    LOG(QFATAL) << kUsageString;
+  }
+  QCHECK(argc > 1) << "Input HLO file missing.";
+
+  std::unique_ptr<xla::PjRtClient> client =
+      xla::GetTfrtCpuClient(xla::CpuClientOptions()).value();
+
+  std::vector<std::pair<std::string,
+                        std::shared_ptr<xla::cpu::HloModuleBenchmark>>>
+      benchmarks;
+  for (int i = 1; i < argc; ++i) {
+    std::string path = argv[i];
+    std::unique_ptr<xla::HloModule> module =
+        xla::LoadModuleFromFile(path).value();
+    std::shared_ptr<xla::cpu::HloModuleBenchmark> benchmark =
+        xla::cpu::HloModuleBenchmark::Create(client.get(), *module).value();
+    benchmark::RegisterBenchmark(path.c_str(),
+                                 [benchmark](benchmark::State& state) {
+                                   CHECK_OK(benchmark->Run(state));
+                                 })
+        ->UseRealTime();
+    benchmarks.emplace_back(std::move(path), std::move(benchmark));
+  }
+
+  tsl::testing::RunBenchmarks();
+
+  if (!profile_ops) return 0;
+  xla::cpu::RooflinePeaks peaks{peak_gflops, peak_gbps};
+  for (const auto& [path, benchmark] : benchmarks) {
+    absl::Duration module_time = benchmark->Time(op_runs).value();
+    std::vector<xla::cpu::HloOpProfile> profiles =
+        xla::cpu::ProfileHloModuleOps(client.get(),
+                                      benchmark->optimized_module(), op_runs)
+            .value();
+    std::cout << "\n** " << path << " **\n"
+              << xla::cpu::FormatRooflineTable(profiles, module_time, peaks);
+  }
+  return 0;
+}
@@ -0,0 +1,183 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/benchmarks/hlo_op_profiler.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/pjrt/pjrt_client.h"
+#include "xla/service/cpu/benchmarks/hlo_benchmark_runner.h"
+#include "xla/service/cpu/cpu_executable.h"
+#include "xla/service/hlo_cost_analysis.h"
+#include "xla/tools/hlo_decomposer.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla::cpu {
+namespace {
+
+// Returns true if `instruction` does work at run time, as opposed to
+// instructions that only name buffers.
+bool IsProfiled(const HloInstruction& instruction) {
+  switch (instruction.opcode()) {
+    case HloOpcode::kAddDependency:
+    case HloOpcode::kAfterAll:
+    case HloOpcode::kBitcast:
+    case HloOpcode::kConstant:
+    case HloOpcode::kGetTupleElement:
+    case HloOpcode::kOptimizationBarrier:
+    case HloOpcode::kParameter:
+    case HloOpcode::kTuple:
+      return false;
+    default:
+      return true;
+  }
+}
+
+std::string Category(const HloInstruction& instruction) {
+  if (instruction.opcode() == HloOpcode::kFusion) {
+    return absl::StrCat(HloOpcodeString(instruction.opcode()), ":",
+                        ToString(instruction.fusion_kind()));
+  }
+  return std::string(HloOpcodeString(instruction.opcode()));
+}
+
+double PerSecond(double count, absl::Duration time) {
+  double seconds = absl::ToDoubleSeconds(time);
+  return seconds > 0 ? count / seconds : 0;
+}
+
+}  // namespace
+
+double HloOpProfile::gflops_per_second() const {
+  return PerSecond(flops, time) * 1e-9;
+}
+
+double HloOpProfile::gbytes_per_second() const {
+  return PerSecond(bytes_accessed, time) * 1e-9;
+}
+
+double HloOpProfile::arithmetic_intensity() const {
+  return bytes_accessed > 0 ? static_cast<double>(flops) / bytes_accessed : 0;
+}
+
+absl::StatusOr<std::vector<HloOpProfile>> ProfileHloModuleOps(
+    PjRtClient* client, const HloModule& optimized_module, int64_t num_runs) {
+  const HloComputation* entry = optimized_module.entry_computation();
+  HloCostAnalysis cost_analysis(CpuExecutable::ShapeSizeBytes);
+  TF_RETURN_IF_ERROR(entry->Accept(&cost_analysis));
+
+  std::vector<HloOpProfile> profiles;
+  for (const HloInstruction* instruction : entry->MakeInstructionPostOrder()) {
+    if (!IsProfiled(*instruction)) continue;
+
+    std::unique_ptr<HloModule> module =
+        ExtractInstructionIntoNewModule(*instruction);
+    absl::StatusOr<std::unique_ptr<HloModuleBenchmark>> benchmark =
+        HloModuleBenchmark::Create(client, *module);
+    absl::StatusOr<absl::Duration> time =
+        benchmark.ok() ? (*benchmark)->Time(num_runs)
+                       : absl::StatusOr<absl::Duration>(benchmark.status());
+    if (!time.ok()) {
+      LOG(WARNING) << "Failed to profile " << instruction->name() << ": "
+                   << time.status();
+      continue;
+    }
+
+    HloOpProfile& profile = profiles.emplace_back();
+    profile.name = instruction->name();
+    profile.category = Category(*instruction);
+    profile.time = *time;
+    profile.flops = cost_analysis.flop_count(*instruction);
+    profile.transcendentals = cost_analysis.transcendental_count(*instruction);
+    profile.bytes_accessed = cost_analysis.bytes_accessed(*instruction);
+  }
+
+  std::stable_sort(profiles.begin(), profiles.end(),
+                   [](const HloOpProfile& a, const HloOpProfile& b) {
+                     return a.time > b.time;
+                   });
+  return profiles;
+}
+
+std::string FormatRooflineTable(absl::Span<const HloOpProfile> profiles,
+                                absl::Duration module_time,
+                                const RooflinePeaks& peaks) {
+  const bool has_roofline =
+      peaks.gflops_per_second > 0 && peaks.gbytes_per_second > 0;
+
+  std::string table = absl::StrFormat(
+      "%-40s %-16s %10s %6s %10s %10s %9s %9s %8s", "instruction", "category",
+      "time(us)", "%time", "MFLOP", "MB", "GFLOP/s", "GB/s", "FLOP/B");
+  if (has_roofline) {
+    absl::StrAppend(&table, absl::StrFormat(" %-7s %6s", "bound", "%roof"));
+  }
+  absl::StrAppend(&table, "\n");
+
+  absl::Duration total_time;
+  for (const HloOpProfile& profile : profiles) {
+    total_time += profile.time;
+    absl::StrAppendFormat(
+        &table, "%-40s %-16s %10.2f %6.1f %10.3f %10.3f %9.2f %9.2f %8.2f",
+        profile.name, profile.category,
+        absl::ToDoubleMicroseconds(profile.time),
+        module_time > absl::ZeroDuration()
+            ? 100 * absl::FDivDuration(profile.time, module_time)
+            : 0.0,
+        profile.flops * 1e-6, profile.bytes_accessed * 1e-6,
+        profile.gflops_per_second(), profile.gbytes_per_second(),
+        profile.arithmetic_intensity());
+    if (has_roofline) {
+      // The roofline is the lower of the compute peak and the throughput that
+      // the memory bandwidth allows at the instruction's intensity.
+      double memory_roof =
+          profile.arithmetic_intensity() * peaks.gbytes_per_second;
+      bool memory_bound = memory_roof < peaks.gflops_per_second;
+      double roof = std::min(memory_roof, peaks.gflops_per_second);
+      // Instructions without flops are placed against the bandwidth peak.
+      double achieved = 0;
+      if (profile.flops == 0) {
+        achieved = profile.gbytes_per_second() / peaks.gbytes_per_second;
+      } else if (roof > 0) {
+        achieved = profile.gflops_per_second() / roof;
+      }
+      absl::StrAppendFormat(&table, " %-7s %6.1f",
+                            memory_bound ? "memory" : "compute",
+                            100 * achieved);
+    }
+    absl::StrAppend(&table, "\n");
+  }
+  absl::StrAppendFormat(
+      &table, "%d instructions take %.2f us in isolation, the module %.2f us\n",
+      profiles.size(), absl::ToDoubleMicroseconds(total_time),
+      absl::ToDoubleMicroseconds(module_time));
+  return table;
+}
+
+}  // namespace xla::cpu
@@ -0,0 +1,80 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef XLA_SERVICE_CPU_BENCHMARKS_HLO_OP_PROFILER_H_
+#define XLA_SERVICE_CPU_BENCHMARKS_HLO_OP_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/pjrt/pjrt_client.h"
+
+namespace xla::cpu {
+
+// The estimated cost and the measured time of one instruction of an optimized
+// HLO module.
+struct HloOpProfile {
+  std::string name;
+  // The opcode, and the fusion kind for fusions.
+  std::string category;
+  // The mean time of running the instruction on its own.
+  absl::Duration time;
+
+  // HloCostAnalysis estimates.
+  int64_t flops = 0;
+  int64_t transcendentals = 0;
+  int64_t bytes_accessed = 0;
+
+  double gflops_per_second() const;
+  double gbytes_per_second() const;
+  // Returns the number of flops per byte accessed.
+  double arithmetic_intensity() const;
+};
+
+// Peak compute and memory throughput of the machine, used to place
+// instructions on a roofline. Zero means unknown.
+struct RooflinePeaks {
+  double gflops_per_second = 0;
+  double gbytes_per_second = 0;
+};
+
+// Benchmarks every instruction of the entry computation of `optimized_module`
+// that does work at run time (fusions, dots, sorts, custom calls, ...) on its
+// own, by extracting it into a module of its own that is compiled with `client`
+// and run `num_runs` times on fake arguments. Instructions that cannot be
+// compiled or run on their own are skipped with a warning.
+//
+// Times are measured in isolation, so they do not account for cache reuse or
+// concurrency between instructions, and include the overhead of running an
+// executable. Returns the profiles sorted by decreasing time.
+absl::StatusOr<std::vector<HloOpProfile>> ProfileHloModuleOps(
+    PjRtClient* client, const HloModule& optimized_module, int64_t num_runs);
+
+// Formats `profiles` as a table with the achieved throughput of every
+// instruction next to its cost estimates, and the share of `module_time` it
+// accounts for. If `peaks` are known, also reports whether each instruction
+// is compute or memory bound and how close it gets to the roofline.
+std::string FormatRooflineTable(absl::Span<const HloOpProfile> profiles,
+                                absl::Duration module_time,
+                                const RooflinePeaks& peaks);
+
+}  // namespace xla::cpu
+
+#endif  // XLA_SERVICE_CPU_BENCHMARKS_HLO_OP_PROFILER_H_
@@ -0,0 +1,100 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/cpu/benchmarks/hlo_op_profiler.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/pjrt/cpu/cpu_client.h"
+#include "xla/pjrt/pjrt_client.h"
+#include "xla/service/cpu/benchmarks/hlo_benchmark_runner.h"
+#include "xla/service/hlo_parser.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla::cpu {
+namespace {
+
+TEST(HloOpProfilerTest, ProfilesEveryInstructionThatDoesWork) {
+  constexpr char kHlo[] = R"(
+    HloModule m
+
+    ENTRY e {
+      p0 = f32[64,64] parameter(0)
+      p1 = f32[64,64] parameter(1)
+      dot = f32[64,64] dot(p0, p1), lhs_contracting_dims={1},
+        rhs_contracting_dims={0}
+      ROOT exp = f32[64,64] exponential(dot)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> module,
+                          ParseAndReturnUnverifiedModule(kHlo));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<PjRtClient> client,
+                          GetTfrtCpuClient(CpuClientOptions()));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModuleBenchmark> benchmark,
+                          HloModuleBenchmark::Create(client.get(), *module));
+  TF_ASSERT_OK_AND_ASSIGN(absl::Duration module_time, benchmark->Time(2));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<HloOpProfile> profiles,
+      ProfileHloModuleOps(client.get(), benchmark->optimized_module(),
+                          /*num_runs=*/2));
+  ASSERT_FALSE(profiles.empty());
+  int64_t total_flops = 0;
+  for (const HloOpProfile& profile : profiles) {
+    EXPECT_GT(profile.time, absl::ZeroDuration());
+    EXPECT_GT(profile.bytes_accessed, 0);
+    total_flops += profile.flops;
+  }
+  // The dot does 2 * 64^3 flops.
+  EXPECT_GE(total_flops, 2 * 64 * 64 * 64);
+
+  std::string table = FormatRooflineTable(
+      profiles, module_time,
+      RooflinePeaks{/*gflops_per_second=*/100, /*gbytes_per_second=*/10});
+  EXPECT_TRUE(absl::StrContains(table, profiles.front().name));
+  EXPECT_TRUE(absl::StrContains(table, "compute"));
+}
+
+TEST(HloOpProfilerTest, RooflineColumnsNeedPeaks) {
+  HloOpProfile profile;
+  profile.name = "fusion";
+  profile.category = "fusion:kLoop";
+  profile.time = absl::Microseconds(10);
+  profile.flops = 1000;
+  profile.bytes_accessed = 4000;
+  EXPECT_DOUBLE_EQ(profile.arithmetic_intensity(), 0.25);
+  EXPECT_DOUBLE_EQ(profile.gflops_per_second(), 0.1);
+  EXPECT_DOUBLE_EQ(profile.gbytes_per_second(), 0.4);
+
+  std::string table = FormatRooflineTable({profile}, absl::Microseconds(20),
+                                          RooflinePeaks());
+  EXPECT_TRUE(absl::StrContains(table, "fusion:kLoop"));
+  EXPECT_FALSE(absl::StrContains(table, "%roof"));
+
+  table = FormatRooflineTable(
+      {profile}, absl::Microseconds(20),
+      RooflinePeaks{/*gflops_per_second=*/100, /*gbytes_per_second=*/10});
+  EXPECT_TRUE(absl::StrContains(table, "memory"));
+  EXPECT_TRUE(absl::StrContains(table, "%roof"));
+}
+
+}  // namespace
+}  // namespace xla::cpu
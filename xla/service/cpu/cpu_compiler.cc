@@ -95,6 +95,7 @@ limitations under the License.
 #include "xla/service/change_op_data_type.h"
 #include "xla/service/cholesky_expander.h"
 #include "xla/service/comparison_expander.h"
+#include "xla/service/compile_profiler.h"
 #include "xla/service/compiler.h"
 #include "xla/service/conditional_canonicalizer.h"
 #include "xla/service/conditional_simplifier.h"
@@ -822,6 +823,7 @@ absl::Status CpuCompiler::RunHloPasses(HloModule* module, bool is_aot_compile,
                                        llvm::TargetMachine* target_machine,
                                        const CompileOptions& compile_options,
                                        bool is_mlir_compile) {
+  ScopedHloPassesProfile profile("CpuCompiler::RunHloPasses", *module);
   LLVMTargetMachineFeatures target_machine_features(target_machine);
   TF_RETURN_IF_ERROR(RunHloPassesThroughLayoutAssn(
       module, is_aot_compile, &target_machine_features, is_mlir_compile));
@@ -1126,7 +1128,8 @@ CreateConstantAllocations(const BufferAssignment& assignment) {
 }
 
 absl::StatusOr<std::unique_ptr<CpuExecutable>>
-CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
+CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module,
+                                        tsl::thread::ThreadPool* thread_pool) {
   ModuleHook pre_optimization_ir_hook;
   ModuleHook post_optimization_ir_hook;
   std::tie(pre_optimization_ir_hook, post_optimization_ir_hook) =
@@ -1196,10 +1199,18 @@ CpuCompiler::CompileLegacyCpuExecutable(std::unique_ptr<HloModule> module) {
   // Run buffer allocation on the HLO graph.
   TF_ASSIGN_OR_RETURN(
       std::unique_ptr<BufferAssignment> assignment,
-      BufferAssigner::Run(module.get(),
-                          std::make_unique<SequentialHloOrdering>(schedule),
-                          BufferSizeBytesFunction(), memory_alignment,
-                          /*allocate_buffers_for_constants=*/true));
+      BufferAssigner::Run(
+          module.get(), std::make_unique<SequentialHloOrdering>(schedule),
+          BufferSizeBytesFunction(), memory_alignment,
+          /*allocate_buffers_for_constants=*/true,
+          BufferAssigner::DefaultColorer(),
+          /*must_not_live_out=*/std::nullopt,
+          /*can_share_buffer=*/nullptr,
+          /*preset_assignments=*/{},
+          /*private_stacks=*/{},
+          /*heap_buffer_interval_compare=*/nullptr,
+          /*isolation_options=*/std::nullopt,
+          /*temp_buffer_color=*/std::nullopt, thread_pool));
   DumpHloModuleIfEnabled(*module, *assignment,
                          absl::StrCat("cpu_", kAfterOptimizationsDumpName));
 
@@ -1392,7 +1403,8 @@ absl::StatusOr<std::unique_ptr<Executable>> CpuCompiler::RunBackend(
 
   std::unique_ptr<CpuExecutable> cpu_executable;
   TF_ASSIGN_OR_RETURN(cpu_executable,
-                      CompileLegacyCpuExecutable(std::move(module)));
+                      CompileLegacyCpuExecutable(std::move(module),
+                                                 options.thread_pool));
 
   cpu_executable->set_debug_info(
       cpu_executable->buffer_assignment().GetStats().ToString());
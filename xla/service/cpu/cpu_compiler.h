@@ -40,6 +40,7 @@ limitations under the License.
 #include "xla/service/llvm_compiler.h"
 #include "xla/stream_executor/stream_executor.h"
 #include "xla/util.h"
+#include "tsl/platform/threadpool.h"
 
 namespace mlir {
 class DialectRegistry;
@@ -212,8 +213,11 @@ class CpuCompiler : public LLVMCompiler {
       LLVMTargetMachineFeatures* target_machine_features,
       const CompileOptions& compile_options, bool is_mlir_compile);
 
+  // Buffer assignment finishes its heap simulations on `thread_pool` if it is
+  // not null.
   absl::StatusOr<std::unique_ptr<CpuExecutable>> CompileLegacyCpuExecutable(
-      std::unique_ptr<HloModule> module);
+      std::unique_ptr<HloModule> module,
+      tsl::thread::ThreadPool* thread_pool = nullptr);
 
   CpuCompiler(const CpuCompiler&) = delete;
   CpuCompiler& operator=(const CpuCompiler&) = delete;
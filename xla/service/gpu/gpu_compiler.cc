@@ -86,6 +86,7 @@ limitations under the License.
 #include "xla/service/collective_quantizer.h"
 #include "xla/service/collectives_schedule_linearizer.h"
 #include "xla/service/comparison_expander.h"
+#include "xla/service/compile_profiler.h"
 #include "xla/service/compiler.h"
 #include "xla/service/conditional_canonicalizer.h"
 #include "xla/service/conditional_simplifier.h"
@@ -1593,11 +1594,14 @@ absl::StatusOr<std::unique_ptr<HloModule>> GpuCompiler::RunHloPasses(
       [&] { return absl::StrCat("HLO Transforms:", module->name()); },
       tsl::profiler::TraceMeLevel::kInfo);
 
-  TF_RETURN_IF_ERROR(OptimizeHloModule(module.get(),
-                                       is_deviceless ? nullptr : stream_exec,
-                                       options, gpu_target_config));
+  {
+    ScopedHloPassesProfile profile("GpuCompiler::RunHloPasses", *module);
+    TF_RETURN_IF_ERROR(OptimizeHloModule(module.get(),
+                                         is_deviceless ? nullptr : stream_exec,
+                                         options, gpu_target_config));
 
-  TF_RETURN_IF_ERROR(PrepareHloModuleForIrEmitting(module.get()));
+    TF_RETURN_IF_ERROR(PrepareHloModuleForIrEmitting(module.get()));
+  }
 
   uint64_t end_usecs = tsl::Env::Default()->NowMicros();
 
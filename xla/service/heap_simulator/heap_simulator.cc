@@ -50,6 +50,8 @@ limitations under the License.
 #include "xla/service/hlo_value.h"
 #include "xla/service/time_utils.h"
 #include "xla/util.h"
+#include "tsl/platform/blocking_counter.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -843,26 +845,21 @@ bool BufferIntervalTree::Remove(int64_t start, int64_t end,
   }
   // Found the node to be deleted, enter deletion sequence.
 
-  // Recursively traverse the parents of node and fix up the `subtree_end`
-  // invariant of a node. Recursive lambda need an explicit
-  // std::function declaration.
-  std::function<void(BufferIntervalTreeNode*)> fix_up =
-      [&](BufferIntervalTreeNode* node) {
-        if (node == nullptr) {
-          return;
-        }
-        node->subtree_end = node->end;
-        if (node->left) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->left->subtree_end);
-        }
-        if (node->right) {
-          node->subtree_end =
-              std::max(node->subtree_end, node->right->subtree_end);
-        }
-        // Recursively go up.
-        fix_up(node->parent);
-      };
+  // Traverse the parents of node and fix up the `subtree_end` invariant of
+  // each of them.
+  auto fix_up = [](BufferIntervalTreeNode* node) {
+    for (; node != nullptr; node = node->parent) {
+      node->subtree_end = node->end;
+      if (node->left) {
+        node->subtree_end =
+            std::max(node->subtree_end, node->left->subtree_end);
+      }
+      if (node->right) {
+        node->subtree_end =
+            std::max(node->subtree_end, node->right->subtree_end);
+      }
+    }
+  };
 
   if (to_delete->right == nullptr) {
     // to_delete has no right child, simply move up left child of to_delete if
@@ -951,23 +948,17 @@ bool BufferIntervalTree::Remove(int64_t start, int64_t end,
   return true;
 }
 
-std::vector<Chunk> BufferIntervalTree::ChunksOverlappingInTime(
-    int64_t start, int64_t end) const {
-  std::vector<Chunk> result;
-  for (const BufferIntervalTreeNode* node :
-       NodesOverlappingInTime(start, end)) {
-    result.push_back(node->chunk);
-  }
-  return result;
-}
-
-std::vector<const BufferIntervalTreeNode*>
-BufferIntervalTree::NodesOverlappingInTime(int64_t start, int64_t end) const {
-  std::vector<const BufferIntervalTreeNode*> result;
+template <typename Fn>
+void BufferIntervalTree::ForEachNodeOverlappingInTime(int64_t start,
+                                                      int64_t end,
+                                                      Fn&& fn) const {
   if (root_ == nullptr) {
-    return result;
+    return;
   }
-  std::vector<const BufferIntervalTreeNode*> visiting_stack;
+  // The stack rarely grows beyond a few dozen entries, so keep it inline to
+  // avoid a heap allocation per query; this is called once per buffer (and
+  // colocation) by GlobalDecreasingSizeBestFitHeap.
+  absl::InlinedVector<const BufferIntervalTreeNode*, 64> visiting_stack;
   visiting_stack.push_back(root_);
   while (!visiting_stack.empty()) {
     const BufferIntervalTreeNode* top = visiting_stack.back();
@@ -979,7 +970,7 @@ BufferIntervalTree::NodesOverlappingInTime(int64_t start, int64_t end) const {
       visiting_stack.push_back(top->left);
     }
     if (top->start <= end && top->end >= start) {
-      result.push_back(top);
+      fn(top);
     }
     if (end < top->start) {
       continue;
@@ -988,6 +979,24 @@ BufferIntervalTree::NodesOverlappingInTime(int64_t start, int64_t end) const {
       visiting_stack.push_back(top->right);
     }
   }
+}
+
+std::vector<Chunk> BufferIntervalTree::ChunksOverlappingInTime(
+    int64_t start, int64_t end) const {
+  std::vector<Chunk> result;
+  ForEachNodeOverlappingInTime(start, end,
+                               [&](const BufferIntervalTreeNode* node) {
+                                 result.push_back(node->chunk);
+                               });
+  return result;
+}
+
+std::vector<const BufferIntervalTreeNode*>
+BufferIntervalTree::NodesOverlappingInTime(int64_t start, int64_t end) const {
+  std::vector<const BufferIntervalTreeNode*> result;
+  ForEachNodeOverlappingInTime(
+      start, end,
+      [&](const BufferIntervalTreeNode* node) { result.push_back(node); });
   return result;
 }
 
@@ -2545,19 +2554,41 @@ template <typename BufferType>
 absl::StatusOr<HeapSimulator::Result<BufferType>>
 ChooseBestHeapAlgorithm<BufferType>::Finish() {
   DCHECK(!algorithms_.empty());
-  std::vector<Result> results(algorithms_.size());
+  std::vector<absl::StatusOr<Result>> results(algorithms_.size());
+  // A caller that runs on a thread of the pool, e.g. a compilation scheduled
+  // on the compiler's thread pool, could wait forever for the other
+  // algorithms, so it finishes them itself.
+  if (thread_pool_ != nullptr && algorithms_.size() > 1 &&
+      thread_pool_->CurrentThreadId() == -1) {
+    // Each algorithm only touches its own state in Finish, so they can run
+    // concurrently. The calling thread finishes the first algorithm.
+    tsl::BlockingCounter counter(algorithms_.size() - 1);
+    for (int i = 1; i < algorithms_.size(); ++i) {
+      thread_pool_->Schedule([this, &results, &counter, i] {
+        results[i] = algorithms_[i]->Finish();
+        counter.DecrementCount();
+      });
+    }
+    results[0] = algorithms_[0]->Finish();
+    counter.Wait();
+  } else {
+    for (int i = 0; i < algorithms_.size(); ++i) {
+      results[i] = algorithms_[i]->Finish();
+    }
+  }
+
   int64_t min_size = INT64_MAX;
   int min_size_index = -1;
-  for (int i = 0; i < algorithms_.size(); ++i) {
-    TF_ASSIGN_OR_RETURN(results[i], algorithms_[i]->Finish());
-    if (results[i].heap_size < min_size) {
-      min_size = results[i].heap_size;
+  for (int i = 0; i < results.size(); ++i) {
+    TF_RETURN_IF_ERROR(results[i].status());
+    if (results[i]->heap_size < min_size) {
+      min_size = results[i]->heap_size;
       min_size_index = i;
     }
   }
 
   DCHECK_GE(min_size_index, 0);
-  return results[min_size_index];
+  return *std::move(results[min_size_index]);
 }
 
 template class GlobalDecreasingSizeBestFitHeap<HloValue>;
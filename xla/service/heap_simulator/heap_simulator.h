@@ -47,6 +47,7 @@ limitations under the License.
 #include "xla/service/hlo_alias_analysis.h"
 #include "xla/service/hlo_value.h"
 #include "xla/service/logical_buffer.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -421,6 +422,12 @@ class BufferIntervalTree {
   std::vector<const BufferIntervalTreeNode*> NodesOverlappingInTime(
       int64_t start, int64_t end) const;
 
+  // Calls `fn` on every node overlapping [start, end], in the same order as
+  // NodesOverlappingInTime returns them.
+  template <typename Fn>
+  void ForEachNodeOverlappingInTime(int64_t start, int64_t end,
+                                    Fn&& fn) const;
+
   BufferIntervalTreeNode* root_ = nullptr;
   std::list<BufferIntervalTreeNode> node_storage_;
 };
@@ -1004,10 +1011,18 @@ class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
  public:
   using Result = HeapSimulator::Result<BufferType>;
 
-  ChooseBestHeapAlgorithm(
+  // If `thread_pool` is not null, the algorithms are finished concurrently on
+  // it, so anything they call in Finish, such as buffer interval comparators
+  // and size functions, must be thread-safe. Ties are still broken in favor of
+  // the earliest algorithm, so the result does not depend on the order in
+  // which they complete. With a null `thread_pool` they are finished one after
+  // the other on the calling thread, as they are when Finish is called on a
+  // thread of `thread_pool`.
+  explicit ChooseBestHeapAlgorithm(
       std::unique_ptr<std::vector<std::unique_ptr<HeapAlgorithm<BufferType>>>>
-          algorithms)
-      : algorithms_(std::move(*algorithms)) {}
+          algorithms,
+      tsl::thread::ThreadPool* thread_pool = nullptr)
+      : algorithms_(std::move(*algorithms)), thread_pool_(thread_pool) {}
   ~ChooseBestHeapAlgorithm() override {}
 
   void Alloc(const BufferType* buffer, int64_t size) override {
@@ -1033,6 +1048,7 @@ class ChooseBestHeapAlgorithm : public HeapAlgorithm<BufferType> {
 
  private:
   std::vector<std::unique_ptr<HeapAlgorithm<BufferType>>> algorithms_;
+  tsl::thread::ThreadPool* thread_pool_;
 };
 
 extern template class GlobalDecreasingSizeBestFitHeap<HloValue>;
@@ -19,12 +19,14 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <optional>
+#include <random>
 #include <string>
 #include <tuple>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/log/check.h"
 #include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -35,8 +37,11 @@ limitations under the License.
 #include "xla/service/hlo_value.h"
 #include "xla/tests/hlo_test_base.h"
 #include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/logging.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -1825,6 +1830,103 @@ TEST_F(ConstrainedGlobalDecreasingSizeBestFitHeapTest, ColocatedII) {
   EXPECT_EQ(0, result.heap_results[0].chunk_map.at(buffer_c_).offset);
 }
 
+// Owns `num_buffers` dummy HloValues and feeds them to heap algorithms with a
+// deterministic pseudo-random sequence of allocations and frees.
+class RandomHeapSchedule {
+ public:
+  explicit RandomHeapSchedule(int64_t num_buffers)
+      : builder_("random_heap_schedule") {
+    for (int64_t i = 0; i < num_buffers; ++i) {
+      auto constant = builder_.AddInstruction(
+          HloInstruction::CreateConstant(LiteralUtil::CreateR0<float>(1.0)));
+      buffers_.push_back(std::make_unique<HloValue>(i, constant, ShapeIndex{}));
+    }
+  }
+
+  void Run(HeapAlgorithm<HloValue>* heap) const {
+    std::mt19937 rng(/*seed=*/42);
+    std::vector<std::pair<const HloValue*, int64_t>> live;
+    for (const std::unique_ptr<HloValue>& buffer : buffers_) {
+      int64_t size = 1 + rng() % 4096;
+      heap->Alloc(buffer.get(), size);
+      live.push_back({buffer.get(), size});
+      // Keep a varying number of buffers alive at any point in time.
+      while (live.size() > 1 && rng() % 3 == 0) {
+        std::swap(live[rng() % live.size()], live.back());
+        heap->Free(live.back().first, live.back().second);
+        live.pop_back();
+      }
+    }
+    for (const auto& [buffer, size] : live) {
+      heap->Free(buffer, size);
+    }
+  }
+
+ private:
+  HloComputation::Builder builder_;
+  std::vector<std::unique_ptr<HloValue>> buffers_;
+};
+
+std::unique_ptr<ChooseBestHeapAlgorithm<HloValue>> SpatialOrTemporalHeap(
+    tsl::thread::ThreadPool* thread_pool) {
+  auto algorithms = std::make_unique<
+      std::vector<std::unique_ptr<HeapAlgorithm<HloValue>>>>();
+  algorithms->push_back(
+      std::make_unique<GlobalDecreasingSizeBestFitHeap<HloValue>>(
+          /*alignment=*/64,
+          GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial));
+  algorithms->push_back(
+      std::make_unique<GlobalDecreasingSizeBestFitHeap<HloValue>>(
+          /*alignment=*/64,
+          GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal));
+  return std::make_unique<ChooseBestHeapAlgorithm<HloValue>>(
+      std::move(algorithms), thread_pool);
+}
+
+TEST(ChooseBestHeapAlgorithmTest, ParallelFinishMatchesSequential) {
+  RandomHeapSchedule schedule(/*num_buffers=*/2048);
+
+  int64_t best_heap_size = INT64_MAX;
+  HeapSimulator::Result<HloValue> best;
+  for (auto type : {GlobalDecreasingSizeBestFitHeap<HloValue>::kSpatial,
+                    GlobalDecreasingSizeBestFitHeap<HloValue>::kTemporal}) {
+    GlobalDecreasingSizeBestFitHeap<HloValue> heap(/*alignment=*/64, type);
+    schedule.Run(&heap);
+    TF_ASSERT_OK_AND_ASSIGN(HeapSimulator::Result<HloValue> result,
+                            heap.Finish());
+    if (result.heap_size < best_heap_size) {
+      best_heap_size = result.heap_size;
+      best = std::move(result);
+    }
+  }
+
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 2);
+  auto heap = SpatialOrTemporalHeap(&thread_pool);
+  schedule.Run(heap.get());
+  TF_ASSERT_OK_AND_ASSIGN(HeapSimulator::Result<HloValue> result,
+                          heap->Finish());
+  EXPECT_EQ(result.heap_size, best_heap_size);
+  ASSERT_EQ(result.heap_results.size(), best.heap_results.size());
+  for (int i = 0; i < result.heap_results.size(); ++i) {
+    EXPECT_EQ(result.heap_results[i].heap_size,
+              best.heap_results[i].heap_size);
+    EXPECT_EQ(result.heap_results[i].chunk_map,
+              best.heap_results[i].chunk_map);
+  }
+}
+
+void BM_ChooseBestHeapAlgorithm(::testing::benchmark::State& state) {
+  RandomHeapSchedule schedule(state.range(0));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "benchmark", 2);
+  for (auto s : state) {
+    auto heap = SpatialOrTemporalHeap(&thread_pool);
+    schedule.Run(heap.get());
+    CHECK_OK(heap->Finish());
+  }
+}
+
+BENCHMARK(BM_ChooseBestHeapAlgorithm)->Range(256, 64 << 10);
+
 class IntervalTreeTest : public ::testing::Test {};
 
 TEST_F(IntervalTreeTest, InsertAndRemove) {
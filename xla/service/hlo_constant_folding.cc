@@ -18,43 +18,42 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <list>
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "xla/hlo/evaluator/hlo_evaluator.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/hlo/ir/hlo_opcode.h"
 #include "xla/literal.h"
+#include "xla/service/hlo_cost_analysis.h"
 #include "xla/service/slow_operation_alarm.h"
+#include "xla/shape.h"
 #include "xla/shape_util.h"
+#include "tsl/platform/blocking_counter.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
-// Checks whether instr is or transitively contains an instruction that we
-// shouldn't fold.
-//
-// Specifically, we don't fold kRng or kAfterAll instructions:
-//
-//  - kRng is already marked as side-effecting and so is skipped elsewhere, but
-//    we check for it here.  Even kRng weren't side-effecting and took an
-//    explicit seed, we *still* wouldn't want to constant-fold it, because the
-//    evaluator's handling of rng is not guaranteed to be identical to any
-//    particular backend's rng.
-//
-//  - kAfterAll needs to be skipped because a kAfterAll op with no args can
-//    currently materialize a token "out of thin air".  TODO(b/110532604):
-//    Remove this check once AfterAll requires at least one operand, in which
-//    case constant folding will be impossible.
 static bool IsOrContainsIllegalInstr(const HloInstruction* instr) {
   if (instr->opcode() == HloOpcode::kAfterAll ||
       instr->opcode() == HloOpcode::kRng) {
@@ -68,11 +67,402 @@ static bool IsOrContainsIllegalInstr(const HloInstruction* instr) {
   return false;
 }
 
+namespace {
+
+// Returns whether `instruction` is a candidate for constant folding.
+bool ShouldFold(const HloInstruction* instruction) {
+  // We only handle instructions where
+  //
+  //  - at least one operand is a constant, and
+  //  - all other operands are either constants or broadcast(constant).
+  //
+  // Why this particular set of rules around broadcasts?
+  //
+  //  - We don't want to fold broadcast(constant) on its own, because in
+  //    general it's "simpler" to remember that it's a broadcast.  Also,
+  //    algsimp will fold an all-one-value constant into a broadcast, so
+  //    we'd just end up fighting with it.
+  //
+  //  - We don't want to fold an op where all operands are broadcasts of
+  //    constants, because algsimp will transform op(broadcast(constant) =>
+  //    broadcast(op(constant)).  Then we can constant-fold the smaller op.
+  //
+  //  - So the only remaining case is where some but not all operands are
+  //    broadcasts of constants, e.g. op(constant, broadcast(constant)).
+  //
+  if (!absl::c_any_of(instruction->operands(),
+                      HloPredicateIsOp<HloOpcode::kConstant>) ||
+      !absl::c_all_of(
+          instruction->operands(), [](const HloInstruction* operand) {
+            return operand->opcode() == HloOpcode::kConstant ||
+                   (operand->opcode() == HloOpcode::kBroadcast &&
+                    operand->operand(0)->opcode() == HloOpcode::kConstant);
+          })) {
+    return false;
+  }
+
+  // Don't fold Constant, Parameter, and Tuple instructions.  Tuple
+  // constants are not directly supported by any backends, hence folding
+  // Tuple is not useful and would in fact be expanded back into kTuple by
+  // Algebraic Simplifier.
+  //
+  // (We do allow folding subcomputations that contain these instructions.)
+  if (instruction->opcode() == HloOpcode::kParameter ||
+      instruction->opcode() == HloOpcode::kConstant ||
+      instruction->opcode() == HloOpcode::kTuple) {
+    return false;
+  }
+
+  // Broadcasts dramatically increase the size of constants, which is often
+  // detrimental to performance and memory capacity, so do not fold
+  // broadcasts.
+  if (instruction->opcode() == HloOpcode::kBroadcast ||
+      instruction->opcode() == HloOpcode::kIota) {
+    return false;
+  }
+
+  // Don't fold across async execution thread if it's not supposed to be
+  // changed by this pass.
+  if (instruction->IsAsynchronous() &&
+      instruction->async_execution_thread() !=
+          instruction->parent()->execution_thread()) {
+    return false;
+  }
+
+  // Do not fold FFT. Evaluating it may significantly increase compile time.
+  if (instruction->opcode() == HloOpcode::kFft) {
+    return false;
+  }
+
+  // Check for instructions that we can't fold even if they appear inside of
+  // a subcomputation (e.g. a kCall).
+  if (IsOrContainsIllegalInstr(instruction)) {
+    return false;
+  }
+
+  // Don't constant-fold side-effecting instructions or instructions which
+  // contain side-effecting instructions.
+  if (instruction->HasSideEffect()) {
+    return false;
+  }
+
+  if (instruction->opcode() == HloOpcode::kPad &&
+      instruction->operand(0)->opcode() == HloOpcode::kBroadcast &&
+      instruction->operand(1)->opcode() == HloOpcode::kConstant) {
+    // Reduce the compile time by skipping the constant folding of pad
+    // instruction with broadcast operand. With 45m shape limit the compile
+    // time could be more than 30 seconds. According to the current
+    // benchmarks it does not affect the performance.
+    return false;
+  }
+
+  // Don't constant fold unless output and operand sizes are small.
+  if (instruction->shape().IsArray()) {
+    int64_t elements_in_operands = 0;
+    for (HloInstruction* operand : instruction->operands()) {
+      if (operand->shape().IsArray()) {
+        elements_in_operands += ShapeUtil::ElementsIn(operand->shape());
+      }
+    }
+    int64_t elements_in_constant = ShapeUtil::ElementsIn(instruction->shape());
+
+    static const int64_t kMaximumConstantSizeElements = 45 * 1000 * 1000;
+    if (std::max(elements_in_constant, elements_in_operands) >
+        kMaximumConstantSizeElements) {
+      VLOG(2) << "Ignore constant folding: result shape size is "
+              << elements_in_constant << " total size of arguments is "
+              << elements_in_operands;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the estimated number of flops and transcendentals needed to evaluate
+// `instruction`, or nullopt if HloCostAnalysis does not support it.
+std::optional<int64_t> EstimateCost(const HloInstruction* instruction) {
+  HloCostAnalysis analysis([](const Shape& shape) {
+    return ShapeUtil::ByteSizeOf(shape, sizeof(void*));
+  });
+  if (!instruction->Accept(&analysis).ok()) {
+    return std::nullopt;
+  }
+  return analysis.flop_count(*instruction) +
+         analysis.transcendental_count(*instruction);
+}
+
+// Returns a fingerprint of everything that determines the value of
+// `instruction`, which must have only constant and broadcast(constant)
+// operands.
+tsl::Fprint128 FoldingFingerprint(const HloInstruction* instruction) {
+  // Canonical printing omits names, so identical expressions in different
+  // modules have the same fingerprint. Constants inside called computations
+  // are printed in full.
+  static const auto* const kPrintOptions = new HloPrintOptions(
+      HloPrintOptions::Canonical().set_print_large_constants(true));
+  tsl::Fprint128 fingerprint =
+      tsl::Fingerprint128(instruction->ToString(*kPrintOptions));
+  for (const HloInstruction* operand : instruction->operands()) {
+    const HloInstruction* constant = operand;
+    if (operand->opcode() == HloOpcode::kBroadcast) {
+      fingerprint = tsl::FingerprintCat128(
+          fingerprint, tsl::Fingerprint128(operand->ToString(*kPrintOptions)));
+      constant = operand->operand(0);
+    }
+    const Literal& literal = constant->literal();
+    fingerprint = tsl::FingerprintCat128(
+        fingerprint, tsl::Fingerprint128(
+                         ShapeUtil::HumanStringWithLayout(literal.shape())));
+    ShapeUtil::ForEachSubshape(
+        literal.shape(), [&](const Shape& subshape, const ShapeIndex& index) {
+          if (!subshape.IsArray()) {
+            return;
+          }
+          fingerprint = tsl::FingerprintCat128(
+              fingerprint,
+              tsl::Fingerprint128(absl::string_view(
+                  static_cast<const char*>(literal.untyped_data(index)),
+                  literal.size_bytes(index))));
+        });
+  }
+  return fingerprint;
+}
+
+// Values of folded instructions keyed by FoldingFingerprint, shared by all
+// runs of the pass in the process. The least recently used values are evicted
+// once the cached literals take up more than kMaxSizeBytes.
+class FoldingCache {
+ public:
+  static FoldingCache& Get() {
+    static auto* const cache = new FoldingCache();
+    return *cache;
+  }
+
+  std::optional<Literal> Lookup(const tsl::Fprint128& key) {
+    absl::MutexLock lock(&mu_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return std::nullopt;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    ++hits_;
+    return it->second->second.Clone();
+  }
+
+  void Insert(const tsl::Fprint128& key, const Literal& value) {
+    const int64_t size_bytes = value.size_bytes();
+    if (size_bytes > kMaxSizeBytes) {
+      return;
+    }
+    absl::MutexLock lock(&mu_);
+    if (index_.contains(key)) {
+      return;
+    }
+    entries_.emplace_front(key, value.Clone());
+    index_[key] = entries_.begin();
+    size_bytes_ += size_bytes;
+    while (size_bytes_ > kMaxSizeBytes) {
+      size_bytes_ -= entries_.back().second.size_bytes();
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+  void Clear() {
+    absl::MutexLock lock(&mu_);
+    index_.clear();
+    entries_.clear();
+    size_bytes_ = 0;
+    hits_ = 0;
+  }
+
+  int64_t hits() {
+    absl::MutexLock lock(&mu_);
+    return hits_;
+  }
+
+ private:
+  static constexpr int64_t kMaxSizeBytes = int64_t{256} << 20;
+
+  using Entry = std::pair<tsl::Fprint128, Literal>;
+
+  absl::Mutex mu_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<tsl::Fprint128, std::list<Entry>::iterator,
+                      tsl::Fprint128Hasher>
+      index_ ABSL_GUARDED_BY(mu_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mu_) = 0;
+  // Number of successful lookups since the cache was last cleared.
+  int64_t hits_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+// Replaces all uses of `instruction` with a constant holding `value`.
+absl::Status ReplaceWithConstant(HloInstruction* instruction, Literal value) {
+  VLOG(4) << "Constant folded: " << instruction->ToString();
+  HloInstruction* new_constant = instruction->AddInstruction(
+      HloInstruction::CreateConstant(std::move(value)));
+  if (new_constant->shape().has_layout()) {
+    // Update element_size_in_bits on the new instruction's layout. Literals
+    // always have element_size_in_bits set to 0, and CreateConstant copies
+    // the shape/layout from the Literal, so we need to set
+    // element_size_in_bits here.
+    new_constant->mutable_shape()
+        ->mutable_layout()
+        ->set_element_size_in_bits(
+            instruction->shape().layout().element_size_in_bits());
+  }
+  return instruction->ReplaceAllUsesWith(new_constant);
+}
+
+}  // namespace
+
 /*static*/ std::atomic<int64_t> HloConstantFolding::slow_op_counter_{0};
 
+/*static*/ void HloConstantFolding::ClearCache() {
+  FoldingCache::Get().Clear();
+}
+
+/*static*/ int64_t HloConstantFolding::cache_hits() {
+  return FoldingCache::Get().hits();
+}
+
+bool HloConstantFolding::Evaluate(HloEvaluator& evaluator,
+                                  const HloInstruction* instruction,
+                                  absl::Time deadline, Literal* result) const {
+  if (deadline != absl::InfiniteFuture() && absl::Now() >= deadline) {
+    VLOG(2) << "Constant folding time budget exhausted, skipping: "
+            << instruction->ToString();
+    return false;
+  }
+
+  std::optional<tsl::Fprint128> fingerprint;
+  if (options_.use_cache) {
+    fingerprint = FoldingFingerprint(instruction);
+    if (std::optional<Literal> cached =
+            FoldingCache::Get().Lookup(*fingerprint)) {
+      VLOG(5) << "Constant folding from cache: " << instruction->ToString();
+      *result = std::move(*cached);
+      return true;
+    }
+  }
+
+  VLOG(5) << "Constant folding: " << instruction->ToString();
+
+  absl::Duration slow_timeout =
+      absl::Seconds(uint64_t{1} << slow_op_counter_.load());
+  SlowOperationAlarm slow_alarm(slow_timeout, [instruction, slow_timeout] {
+    const bool ndebug =
+#if NDEBUG
+        true;
+#else
+        false;
+#endif
+    absl::string_view explanation_msg =
+        ndebug
+            ? "This isn't necessarily a bug; constant-folding is "
+              "inherently a trade-off between compilation time and speed "
+              "at runtime. XLA has some guards that attempt to keep "
+              "constant folding from taking too long, but fundamentally "
+              "you'll always be able to come up with an input program that "
+              "takes a long time.\n\n"
+              "If you'd like to file a bug, run with envvar "
+              "XLA_FLAGS=--xla_dump_to=/tmp/foo and attach the results."
+            : "XLA was built without compiler optimizations, which can be "
+              "slow. Try rebuilding with -c opt.";
+    return absl::StrFormat(
+        "Constant folding an instruction is taking > %s:\n\n"
+        "  %s\n\n"  // instruction->name() or instruction->ToString()
+        "%s",       // explanation_msg
+        absl::FormatDuration(slow_timeout), instruction->ToString(),
+        explanation_msg);
+  });
+
+  // Currently we skip unimplemented operations.
+  // TODO(b/35975797): Fold constant computations for more operations.
+  if (!evaluator.TryEvaluate(
+          instruction, result,
+          /*recursively_evaluate_nonconstant_operands=*/true)) {
+    VLOG(2) << "Constant folding failed for instruction: "
+            << instruction->ToString();
+    return false;
+  }
+
+  slow_alarm.cancel();
+  if (slow_alarm.fired()) {
+    slow_op_counter_++;
+  }
+
+  if (fingerprint.has_value()) {
+    FoldingCache::Get().Insert(*fingerprint, *result);
+  }
+  return true;
+}
+
+std::vector<std::optional<Literal>> HloConstantFolding::EvaluateAll(
+    absl::Span<HloInstruction* const> instructions, absl::Time deadline) const {
+  std::vector<std::optional<Literal>> results(instructions.size());
+  auto evaluate = [&](int64_t i, tsl::thread::ThreadPool* dot_thread_pool) {
+    // Limit the constant folding to 0 iterations to skip folding loops. This
+    // retains the behavior from before while loop support in HloEvaluator and
+    // may be revised.
+    HloEvaluator evaluator(/*max_loop_iterations=*/0);
+    // fast-path lets us e.g. use Eigen for matmuls.
+    evaluator.set_use_fast_path(true);
+    evaluator.set_thread_pool(dot_thread_pool);
+    Literal result;
+    if (Evaluate(evaluator, instructions[i], deadline, &result)) {
+      results[i] = std::move(result);
+    }
+  };
+
+  // If the pass itself runs on a thread of the pool, waiting for work
+  // scheduled on the pool could deadlock, so evaluate everything inline.
+  if (options_.thread_pool->CurrentThreadId() != -1) {
+    for (int64_t i = 0; i < instructions.size(); ++i) {
+      evaluate(i, /*dot_thread_pool=*/nullptr);
+    }
+    return results;
+  }
+  // A single instruction is evaluated on the calling thread, where it can use
+  // the pool for its own dots instead.
+  if (instructions.size() == 1) {
+    evaluate(0, options_.thread_pool);
+    return results;
+  }
+  tsl::BlockingCounter counter(instructions.size());
+  for (int64_t i = 0; i < instructions.size(); ++i) {
+    options_.thread_pool->Schedule([&, i] {
+      evaluate(i, /*dot_thread_pool=*/nullptr);
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  return results;
+}
+
 absl::StatusOr<bool> HloConstantFolding::Run(
     HloModule* module,
     const absl::flat_hash_set<absl::string_view>& execution_threads) {
+  const absl::Time deadline = absl::Now() + options_.time_budget;
+
+  // Returns whether `instruction` should be folded, taking the cost limit into
+  // account.
+  auto should_fold = [&](const HloInstruction* instruction) {
+    if (instruction->IsDead() || !ShouldFold(instruction)) {
+      return false;
+    }
+    if (options_.max_estimated_flops >= 0) {
+      std::optional<int64_t> cost = EstimateCost(instruction);
+      if (cost.has_value() && *cost > options_.max_estimated_flops) {
+        VLOG(2) << "Ignore constant folding: estimated cost is " << *cost
+                << " flops";
+        return false;
+      }
+    }
+    return true;
+  };
+
   // Limit the constant folding to 0 iterations to skip folding loops. This
   // retains the behavior from before while loop support in HloEvaluator and may
   // be revised.
@@ -86,182 +476,53 @@ absl::StatusOr<bool> HloConstantFolding::Run(
 
   for (auto* computation :
        module->MakeNonfusionComputations(execution_threads)) {
-    for (auto* instruction : computation->MakeInstructionPostOrder()) {
-      // Skip dead code.
-      if (instruction->IsDead()) {
-        continue;
-      }
-
-      // We only handle instructions where
-      //
-      //  - at least one operand is a constant, and
-      //  - all other operands are either constants or broadcast(constant).
-      //
-      // Why this particular set of rules around broadcasts?
-      //
-      //  - We don't want to fold broadcast(constant) on its own, because in
-      //    general it's "simpler" to remember that it's a broadcast.  Also,
-      //    algsimp will fold an all-one-value constant into a broadcast, so
-      //    we'd just end up fighting with it.
-      //
-      //  - We don't want to fold an op where all operands are broadcasts of
-      //    constants, because algsimp will transform op(broadcast(constant) =>
-      //    broadcast(op(constant)).  Then we can constant-fold the smaller op.
-      //
-      //  - So the only remaining case is where some but not all operands are
-      //    broadcasts of constants, e.g. op(constant, broadcast(constant)).
-      //
-      if (!absl::c_any_of(instruction->operands(),
-                          HloPredicateIsOp<HloOpcode::kConstant>) ||
-          !absl::c_all_of(
-              instruction->operands(), [](const HloInstruction* operand) {
-                return operand->opcode() == HloOpcode::kConstant ||
-                       (operand->opcode() == HloOpcode::kBroadcast &&
-                        operand->operand(0)->opcode() == HloOpcode::kConstant);
-              })) {
-        continue;
-      }
-
-      // Don't fold Constant, Parameter, and Tuple instructions.  Tuple
-      // constants are not directly supported by any backends, hence folding
-      // Tuple is not useful and would in fact be expanded back into kTuple by
-      // Algebraic Simplifier.
-      //
-      // (We do allow folding subcomputations that contain these instructions.)
-      if (instruction->opcode() == HloOpcode::kParameter ||
-          instruction->opcode() == HloOpcode::kConstant ||
-          instruction->opcode() == HloOpcode::kTuple) {
-        continue;
-      }
-
-      // Broadcasts dramatically increase the size of constants, which is often
-      // detrimental to performance and memory capacity, so do not fold
-      // broadcasts.
-      if (instruction->opcode() == HloOpcode::kBroadcast ||
-          instruction->opcode() == HloOpcode::kIota) {
-        continue;
-      }
-
-      // Don't fold across async execution thread if it's not supposed to be
-      // changed by this pass.
-      if (instruction->IsAsynchronous() &&
-          instruction->async_execution_thread() !=
-              instruction->parent()->execution_thread()) {
-        continue;
-      }
-
-      // Do not fold FFT. Evaluating it may significantly increase compile time.
-      if (instruction->opcode() == HloOpcode::kFft) {
-        continue;
-      }
-
-      // Check for instructions that we can't fold even if they appear inside of
-      // a subcomputation (e.g. a kCall).
-      if (IsOrContainsIllegalInstr(instruction)) {
-        continue;
-      }
-
-      // Don't constant-fold side-effecting instructions or instructions which
-      // contain side-effecting instructions.
-      if (instruction->HasSideEffect()) {
-        continue;
-      }
-
-      if (instruction->opcode() == HloOpcode::kPad &&
-          instruction->operand(0)->opcode() == HloOpcode::kBroadcast &&
-          instruction->operand(1)->opcode() == HloOpcode::kConstant) {
-        // Reduce the compile time by skipping the constant folding of pad
-        // instruction with broadcast operand. With 45m shape limit the compile
-        // time could be more than 30 seconds. According to the current
-        // benchmarks it does not affect the performance.
-        continue;
-      }
-
-      // Don't constant fold unless output and operand sizes are small.
-      if (instruction->shape().IsArray()) {
-        int64_t elements_in_operands = 0;
-        for (HloInstruction* operand : instruction->operands()) {
-          if (operand->shape().IsArray()) {
-            elements_in_operands += ShapeUtil::ElementsIn(operand->shape());
-          }
+    if (options_.thread_pool == nullptr) {
+      for (auto* instruction : computation->MakeInstructionPostOrder()) {
+        if (!should_fold(instruction)) {
+          continue;
         }
-        int64_t elements_in_constant =
-            ShapeUtil::ElementsIn(instruction->shape());
-
-        static const int64_t kMaximumConstantSizeElements = 45 * 1000 * 1000;
-        if (std::max(elements_in_constant, elements_in_operands) >
-            kMaximumConstantSizeElements) {
-          VLOG(2) << "Ignore constant folding: result shape size is "
-                  << elements_in_constant << " total size of arguments is "
-                  << elements_in_operands;
+        Literal result;
+        if (!Evaluate(*evaluator, instruction, deadline, &result)) {
           continue;
         }
+        dead_instructions.push_back(instruction);
+        TF_RETURN_IF_ERROR(ReplaceWithConstant(instruction, std::move(result)));
       }
+      continue;
+    }
 
-      VLOG(5) << "Constant folding: " << instruction->ToString();
-
-      absl::Duration slow_timeout =
-          absl::Seconds(uint64_t{1} << slow_op_counter_.load());
-      SlowOperationAlarm slow_alarm(slow_timeout, [instruction, slow_timeout] {
-        const bool ndebug =
-#if NDEBUG
-            true;
-#else
-            false;
-#endif
-        absl::string_view explanation_msg =
-            ndebug
-                ? "This isn't necessarily a bug; constant-folding is "
-                  "inherently a trade-off between compilation time and speed "
-                  "at runtime. XLA has some guards that attempt to keep "
-                  "constant folding from taking too long, but fundamentally "
-                  "you'll always be able to come up with an input program that "
-                  "takes a long time.\n\n"
-                  "If you'd like to file a bug, run with envvar "
-                  "XLA_FLAGS=--xla_dump_to=/tmp/foo and attach the results."
-                : "XLA was built without compiler optimizations, which can be "
-                  "slow. Try rebuilding with -c opt.";
-        return absl::StrFormat(
-            "Constant folding an instruction is taking > %s:\n\n"
-            "  %s\n\n"  // instruction->name() or instruction->ToString()
-            "%s",       // explanation_msg
-            absl::FormatDuration(slow_timeout), instruction->ToString(),
-            explanation_msg);
-      });
-
-      // Currently we skip unimplemented operations.
-      // TODO(b/35975797): Fold constant computations for more operations.
-      Literal result;
-      if (!evaluator->TryEvaluate(
-              instruction, &result,
-              /*recursively_evaluate_nonconstant_operands=*/true)) {
-        VLOG(2) << "Constant folding failed for instruction: "
-                << instruction->ToString();
-        continue;
+    // With a thread pool, instructions are folded in waves: every wave
+    // evaluates all instructions whose operands are constant at that point in
+    // parallel, which may make their users foldable in the next wave.
+    absl::flat_hash_set<const HloInstruction*> attempted;
+    while (true) {
+      std::vector<HloInstruction*> wave;
+      for (auto* instruction : computation->MakeInstructionPostOrder()) {
+        if (!attempted.contains(instruction) && should_fold(instruction)) {
+          wave.push_back(instruction);
+        }
       }
-
-      slow_alarm.cancel();
-      if (slow_alarm.fired()) {
-        slow_op_counter_++;
+      if (wave.empty()) {
+        break;
       }
-
-      VLOG(4) << "Constant folded: " << instruction->ToString();
-      dead_instructions.push_back(instruction);
-      HloInstruction* new_constant = instruction->AddInstruction(
-          HloInstruction::CreateConstant(std::move(result)));
-      if (new_constant->shape().has_layout()) {
-        // Update element_size_in_bits on the new instruction's layout. Literals
-        // always have element_size_in_bits set to 0, and CreateConstant copies
-        // the shape/layout from the Literal, so we need to set
-        // element_size_in_bits here.
-        new_constant->mutable_shape()
-            ->mutable_layout()
-            ->set_element_size_in_bits(
-                instruction->shape().layout().element_size_in_bits());
+      attempted.insert(wave.begin(), wave.end());
+      std::vector<std::optional<Literal>> results = EvaluateAll(wave, deadline);
+      for (int64_t i = 0; i < wave.size(); ++i) {
+        if (!results[i].has_value()) {
+          continue;
+        }
+        dead_instructions.push_back(wave[i]);
+        TF_RETURN_IF_ERROR(
+            ReplaceWithConstant(wave[i], *std::move(results[i])));
       }
-      TF_RETURN_IF_ERROR(instruction->ReplaceAllUsesWith(new_constant));
     }
   }
+  if (deadline != absl::InfiniteFuture() && absl::Now() >= deadline) {
+    LOG(WARNING) << "Constant folding of " << module->name()
+                 << " exceeded its time budget of "
+                 << absl::FormatDuration(options_.time_budget)
+                 << "; some constant expressions were left unfolded.";
+  }
   const bool changed = !dead_instructions.empty();
   for (HloInstruction* dead_instruction : dead_instructions) {
     CHECK(dead_instruction->IsDead());
@@ -18,12 +18,20 @@ limitations under the License.
 
 #include <atomic>
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "xla/hlo/evaluator/hlo_evaluator.h"
+#include "xla/hlo/ir/hlo_instruction.h"
 #include "xla/hlo/ir/hlo_module.h"
+#include "xla/literal.h"
 #include "xla/service/hlo_pass_interface.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -31,6 +39,30 @@ namespace xla {
 // computation on constants.
 class HloConstantFolding : public HloModulePass {
  public:
+  struct Options {
+    // Instructions whose estimated cost, as computed by HloCostAnalysis, is
+    // larger than this many flops plus transcendentals are not folded. A
+    // negative value disables the limit.
+    int64_t max_estimated_flops = -1;
+
+    // Once a run has spent this long evaluating instructions, the remaining
+    // instructions of the module are left unfolded. Evaluations that are
+    // already in progress are not interrupted.
+    absl::Duration time_budget = absl::InfiniteDuration();
+
+    // If set, independent instructions are evaluated in parallel on this pool,
+    // which must outlive the pass.
+    tsl::thread::ThreadPool* thread_pool = nullptr;
+
+    // If true, folded values are kept in a process-wide cache keyed by a
+    // fingerprint of the folded instruction and its constant operands, and
+    // are reused by later runs, e.g. when the same model is compiled again.
+    bool use_cache = false;
+  };
+
+  HloConstantFolding() = default;
+  explicit HloConstantFolding(const Options& options) : options_(options) {}
+
   absl::string_view name() const override { return "constant_folding"; }
 
   // Run constant folding operations on the given module. Returns whether the
@@ -40,7 +72,28 @@ class HloConstantFolding : public HloModulePass {
       HloModule* module,
       const absl::flat_hash_set<absl::string_view>& execution_threads) override;
 
+  // Removes all entries from the cache used when Options::use_cache is set.
+  static void ClearCache();
+
+  // Returns the number of values taken from the cache since it was last
+  // cleared.
+  static int64_t cache_hits();
+
  private:
+  // Evaluates `instruction` into `result`, or looks it up in the cache, unless
+  // `deadline` has passed. Returns whether it succeeded.
+  bool Evaluate(HloEvaluator& evaluator, const HloInstruction* instruction,
+                absl::Time deadline, Literal* result) const;
+
+  // Evaluates all of `instructions`, which must not depend on each other, and
+  // returns their values. Instructions that could not be evaluated have no
+  // value.
+  std::vector<std::optional<Literal>> EvaluateAll(
+      absl::Span<HloInstruction* const> instructions,
+      absl::Time deadline) const;
+
+  Options options_;
+
   // Number of slow constant-folds we've encountered.  Used for firing
   // SlowOperationAlarms.
   static std::atomic<int64_t> slow_op_counter_;
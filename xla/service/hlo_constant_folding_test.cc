@@ -17,10 +17,14 @@ limitations under the License.
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -38,13 +42,18 @@ limitations under the License.
 #include "xla/test.h"
 #include "xla/tests/hlo_test_base.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
 
 namespace op = xla::testing::opcode_matchers;
 namespace m = xla::match;
+
+using ::testing::ElementsAre;
+using ::testing::Gt;
 using HloConstantFoldingTest = HloTestBase;
 
 TEST_F(HloConstantFoldingTest, ConvertF32ToS64) {
@@ -491,5 +500,124 @@ TEST_F(HloConstantFoldingTest, TimingConsumingTest) {
   EXPECT_FALSE(result);
 }
 
+constexpr absl::string_view kChainedConstantsModule = R"(
+  HloModule m
+
+  ENTRY e {
+    a = f32[4] constant({1, 2, 3, 4})
+    b = f32[4] constant({10, 20, 30, 40})
+    c = f32[4] constant({-1, -2, -3, -4})
+    add = f32[4] add(a, b)
+    mul = f32[4] multiply(a, c)
+    sub = f32[4] subtract(add, mul)
+    ROOT tuple = (f32[4], f32[4]) tuple(sub, add)
+  })";
+
+TEST_F(HloConstantFoldingTest, FoldsOnThreadPool) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kChainedConstantsModule));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 4);
+  HloConstantFolding::Options options;
+  options.thread_pool = &thread_pool;
+  HloConstantFolding const_folder(options);
+  TF_ASSERT_OK_AND_ASSIGN(bool result, RunHloPass(&const_folder, module.get()));
+  EXPECT_TRUE(result);
+
+  HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root, GmockMatch(m::Tuple(m::Constant(), m::Constant())));
+  EXPECT_EQ(root->operand(0)->literal(),
+            LiteralUtil::CreateR1<float>({12, 26, 42, 60}));
+  EXPECT_EQ(root->operand(1)->literal(),
+            LiteralUtil::CreateR1<float>({11, 22, 33, 44}));
+}
+
+TEST_F(HloConstantFoldingTest, FoldsOnThreadOfItsThreadPool) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kChainedConstantsModule));
+  tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "test", 1);
+  HloConstantFolding::Options options;
+  options.thread_pool = &thread_pool;
+  HloConstantFolding const_folder(options);
+
+  // The pass runs on the only thread of its pool, as it may in parallel
+  // compilation, so it cannot wait for work scheduled on the pool.
+  absl::StatusOr<bool> result;
+  absl::Notification done;
+  thread_pool.Schedule([&] {
+    result = RunHloPass(&const_folder, module.get());
+    done.Notify();
+  });
+  done.WaitForNotification();
+  TF_ASSERT_OK(result.status());
+  EXPECT_TRUE(*result);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              GmockMatch(m::Tuple(m::Constant(), m::Constant())));
+}
+
+TEST_F(HloConstantFoldingTest, SkipsInstructionsOverCostLimit) {
+  constexpr absl::string_view kModuleStr = R"(
+    HloModule m
+
+    ENTRY e {
+      a = f32[64,64] broadcast(f32[] constant(1)), dimensions={}
+      b = f32[64,64] constant({...})
+      dot = f32[64,64] dot(a, b), lhs_contracting_dims={1},
+                                  rhs_contracting_dims={0}
+      c = f32[2] constant({1, 2})
+      add = f32[2] add(c, c)
+      ROOT tuple = (f32[64,64], f32[2]) tuple(dot, add)
+    })";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnVerifiedModule(kModuleStr));
+  HloConstantFolding::Options options;
+  options.max_estimated_flops = 1000;
+  HloConstantFolding const_folder(options);
+  TF_ASSERT_OK_AND_ASSIGN(bool result, RunHloPass(&const_folder, module.get()));
+  EXPECT_TRUE(result);
+  EXPECT_THAT(module->entry_computation()->root_instruction(),
+              GmockMatch(m::Tuple(m::Dot(), m::Constant())));
+}
+
+TEST_F(HloConstantFoldingTest, StopsWhenTimeBudgetIsExhausted) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      auto module, ParseAndReturnVerifiedModule(kChainedConstantsModule));
+  HloConstantFolding::Options options;
+  options.time_budget = absl::ZeroDuration();
+  HloConstantFolding const_folder(options);
+  TF_ASSERT_OK_AND_ASSIGN(bool result, RunHloPass(&const_folder, module.get()));
+  EXPECT_FALSE(result);
+}
+
+TEST_F(HloConstantFoldingTest, CachedResultsMatchConstants) {
+  HloConstantFolding::ClearCache();
+  HloConstantFolding::Options options;
+  options.use_cache = true;
+  HloConstantFolding const_folder(options);
+
+  // The second module only differs in the values of a constant, so it must
+  // not reuse the results of the first.
+  std::string other_module = std::string(kChainedConstantsModule);
+  other_module.replace(other_module.find("{1, 2, 3, 4}"), 12, "{5, 6, 7, 8}");
+  std::vector<Literal> roots;
+  std::vector<int64_t> cache_hits;
+  for (absl::string_view hlo :
+       {kChainedConstantsModule, absl::string_view(other_module),
+        kChainedConstantsModule}) {
+    TF_ASSERT_OK_AND_ASSIGN(auto module, ParseAndReturnVerifiedModule(hlo));
+    TF_ASSERT_OK_AND_ASSIGN(bool result,
+                            RunHloPass(&const_folder, module.get()));
+    EXPECT_TRUE(result);
+    auto* root = module->entry_computation()->root_instruction();
+    roots.push_back(root->operand(0)->literal().Clone());
+    cache_hits.push_back(HloConstantFolding::cache_hits());
+  }
+  EXPECT_EQ(roots[0], LiteralUtil::CreateR1<float>({12, 26, 42, 60}));
+  EXPECT_EQ(roots[1], LiteralUtil::CreateR1<float>({20, 38, 58, 80}));
+  EXPECT_EQ(roots[2], roots[0]);
+  // Only the repeated first module can be folded from the cache.
+  EXPECT_THAT(cache_hits, ElementsAre(0, 0, Gt(0)));
+  HloConstantFolding::ClearCache();
+}
+
 }  // namespace
 }  // namespace xla
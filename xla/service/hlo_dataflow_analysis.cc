@@ -1283,38 +1283,67 @@ bool HloDataflowAnalysis::UpdateInstructionValueSet(
 }
 
 void HloDataflowAnalysis::Propagate() {
-  using Work = std::pair<int64_t, HloInstruction*>;
   // Avoid duplicating work by preferring work items early in the post order
   // schedule. Intuitively, we start from entry parameters and propagate buffers
   // updates throughout the module only once.
-  std::priority_queue<Work, std::vector<Work>, std::greater<Work>> worklist;
-  absl::flat_hash_set<HloInstruction*> workset;
-  auto priority_map = CalculatePostOrderSchedule(module_);
-  auto add_to_worklist = [&priority_map, &worklist,
-                          &workset](HloInstruction* instruction) {
-    if (workset.insert(instruction).second) {
-      worklist.emplace(priority_map[instruction], instruction);
+  //
+  // Work items are identified by their position in the schedule, so that the
+  // worklist is a heap of integers and membership is a bit vector. This is
+  // considerably cheaper than hashing instructions on every insertion on
+  // modules with deeply nested control flow, where instructions are revisited
+  // many times before reaching the fixed point.
+  absl::flat_hash_map<HloInstruction*, int64_t> priority_map =
+      CalculatePostOrderSchedule(module_);
+  std::vector<std::pair<int64_t, HloInstruction*>> schedule;
+  for (HloComputation* computation : module_.computations()) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      // Instructions that are not reachable from the entry through control
+      // flow (e.g. in fusion computations) are not in the post order schedule
+      // and are processed first.
+      auto it = priority_map.find(instruction);
+      schedule.emplace_back(it == priority_map.end() ? 0 : it->second,
+                            instruction);
+    }
+  }
+  absl::c_stable_sort(schedule, [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  });
+  absl::flat_hash_map<const HloInstruction*, int64_t> position_by_instruction;
+  position_by_instruction.reserve(schedule.size());
+  for (int64_t position = 0; position < schedule.size(); ++position) {
+    position_by_instruction[schedule[position].second] = position;
+  }
+
+  std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>>
+      worklist;
+  std::vector<bool> in_worklist(schedule.size(), false);
+  auto add_to_worklist = [&](HloInstruction* instruction) {
+    auto it = position_by_instruction.find(instruction);
+    CHECK(it != position_by_instruction.end())
+        << instruction->name() << " is not in the module";
+    const int64_t position = it->second;
+    if (!in_worklist[position]) {
+      in_worklist[position] = true;
+      worklist.push(position);
     }
   };
 
-  auto comps = module_.MakeComputationPostOrder();
-  for (HloComputation* computation : comps) {
+  for (HloComputation* computation : module_.computations()) {
     if (!HloInstruction::IsThreadIncluded(computation->execution_thread(),
                                           execution_threads_)) {
       continue;
     }
-    for (HloInstruction* instruction :
-         computation->MakeInstructionPostOrder()) {
+    for (HloInstruction* instruction : computation->instructions()) {
       add_to_worklist(instruction);
     }
   }
   VLOG(1) << "SSA_FORM_: " << ssa_form_;
 
   while (!worklist.empty()) {
-    HloInstruction* instruction = worklist.top().second;
+    const int64_t position = worklist.top();
     worklist.pop();
-
-    workset.erase(workset.find(instruction));
+    in_worklist[position] = false;
+    HloInstruction* instruction = schedule[position].second;
 
     VLOG(3) << "Worklist top: " << instruction->name();
     XLA_VLOG_LINES(3, ToString());
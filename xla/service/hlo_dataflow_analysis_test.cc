@@ -36,6 +36,7 @@ limitations under the License.
 #include "xla/service/hlo_creation_utils.h"
 #include "xla/service/hlo_dce.h"
 #include "xla/service/hlo_ordering.h"
+#include "xla/service/hlo_parser.h"
 #include "xla/service/hlo_value.h"
 #include "xla/shape.h"
 #include "xla/shape_util.h"
@@ -45,6 +46,7 @@ limitations under the License.
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -2142,6 +2144,81 @@ TEST_F(HloDataflowAnalysisTest, AllGatherStartAndDoneWithTuple) {
               UnorderedElementsAre(&analysis.GetValueDefinedAt(start, {1, 1})));
 }
 
+// Returns the text of a module with `depth` levels of nested while loops. Each
+// loop body runs `width` elementwise ops on the loop-carried array and then the
+// next level's loop. Instruction names are suffixed with the loop level.
+std::string MakeNestedWhileModuleText(int64_t depth, int64_t width) {
+  std::string text = "HloModule nested_while\n";
+  for (int64_t level = 0; level < depth; ++level) {
+    const std::string l = absl::StrCat(".", level);
+    absl::StrAppend(&text, "\ncond", l, " {\n",
+                    "  cp", l, " = (s32[], f32[1024]) parameter(0)\n",
+                    "  ci", l, " = s32[] get-tuple-element(cp", l,
+                    "), index=0\n",
+                    "  n", l, " = s32[] constant(4)\n",
+                    "  ROOT lt", l, " = pred[] compare(ci", l, ", n", l,
+                    "), direction=LT\n}\n");
+    absl::StrAppend(&text, "\nbody", l, " {\n",
+                    "  p", l, " = (s32[], f32[1024]) parameter(0)\n",
+                    "  i", l, " = s32[] get-tuple-element(p", l, "), index=0\n",
+                    "  one", l, " = s32[] constant(1)\n",
+                    "  next_i", l, " = s32[] add(i", l, ", one", l, ")\n",
+                    "  x0", l, " = f32[1024] get-tuple-element(p", l,
+                    "), index=1\n");
+    for (int64_t j = 0; j < width; ++j) {
+      absl::StrAppend(&text, "  x", j + 1, l, " = f32[1024] add(x", j, l,
+                      ", x", j, l, ")\n");
+    }
+    if (level == 0) {
+      absl::StrAppend(&text, "  result", l, " = f32[1024] negate(x", width, l,
+                      ")\n");
+    } else {
+      const std::string inner = absl::StrCat(".", level - 1);
+      absl::StrAppend(
+          &text, "  zero", l, " = s32[] constant(0)\n", "  init", l,
+          " = (s32[], f32[1024]) tuple(zero", l, ", x", width, l, ")\n",
+          "  loop", l, " = (s32[], f32[1024]) while(init", l,
+          "), condition=cond", inner, ", body=body", inner, "\n", "  result",
+          l, " = f32[1024] get-tuple-element(loop", l, "), index=1\n");
+    }
+    absl::StrAppend(&text, "  ROOT t", l, " = (s32[], f32[1024]) tuple(next_i",
+                    l, ", result", l, ")\n}\n");
+  }
+  const std::string outer = absl::StrCat(".", depth - 1);
+  absl::StrAppend(&text, "\nENTRY entry {\n",
+                  "  p0 = f32[1024] parameter(0)\n",
+                  "  zero = s32[] constant(0)\n",
+                  "  init = (s32[], f32[1024]) tuple(zero, p0)\n",
+                  "  loop = (s32[], f32[1024]) while(init), condition=cond",
+                  outer, ", body=body", outer, "\n",
+                  "  ROOT result = f32[1024] get-tuple-element(loop), "
+                  "index=1\n}\n");
+  return text;
+}
+
+TEST_P(HloDataflowAnalysisTest, DeeplyNestedWhileLoops) {
+  TF_ASSERT_OK_AND_ASSIGN(
+      module_, ParseAndReturnVerifiedModule(MakeNestedWhileModuleText(
+                   /*depth=*/8, /*width=*/4)));
+  bool ssa_form = GetParam();
+  const HloDataflowAnalysis& analysis = RunAnalysis(ssa_form);
+  TF_EXPECT_OK(analysis.Verify());
+
+  // The innermost loop's result flows out through every enclosing loop.
+  const HloInstruction* innermost_result =
+      module_->GetComputationWithName("body.0")->GetInstructionWithName(
+          "result.0");
+  const HloInstruction* root = module_->entry_computation()->root_instruction();
+  if (ssa_form) {
+    // The outer loop merges the entry parameter with the loop body's result.
+    EXPECT_TRUE(analysis.ValueIsDefinedAt(root->operand(0), /*index=*/{1}));
+  } else {
+    EXPECT_THAT(HloValuesAt(root),
+                ::testing::Contains(
+                    &analysis.GetValueDefinedAt(innermost_result)));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(HloDataflowAnalysisInstantiation,
                          HloDataflowAnalysisTest,
                          ::testing::Values(false, true));
@@ -3440,5 +3517,19 @@ TEST_F(GetInPlaceInputOutputPairsTest, DUSOutputFusionWithCollective) {
   EXPECT_EQ(in_place_pairs, expected_pairs);
 }
 
+void BM_DataflowAnalysisNestedWhile(::testing::benchmark::State& state) {
+  const int64_t depth = state.range(0);
+  std::unique_ptr<HloModule> module =
+      ParseAndReturnUnverifiedModule(
+          MakeNestedWhileModuleText(depth, /*width=*/16))
+          .value();
+  for (auto s : state) {
+    auto analysis = HloDataflowAnalysis::Run(*module, /*ssa_form=*/true);
+    CHECK_OK(analysis.status());
+  }
+}
+
+BENCHMARK(BM_DataflowAnalysisNestedWhile)->RangeMultiplier(2)->Range(1, 64);
+
 }  // namespace
 }  // namespace xla
@@ -43,6 +43,27 @@ bool IsIdentifierChar(char c) {
          c == '.' || c == '_';
 }
 
+// Returns true if `c` can follow a plain number but can not continue a float,
+// dxd, pad or dim labels pattern.
+bool IsNumberDelimiter(const char* ptr, const char* end) {
+  if (ptr == end) {
+    return true;
+  }
+  switch (*ptr) {
+    case ',':
+    case '}':
+    case ']':
+    case ')':
+    case ' ':
+    case '\t':
+    case '\n':
+    case '\r':
+      return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 int HloLexer::GetNextChar() {
@@ -337,7 +358,11 @@ TokKind HloLexer::LexIdentifier() {
 
 #undef KEYWORD
 
-  {
+  // The dim labels and sparsity patterns both contain a character that is not
+  // an identifier character ('?', '>' or '@'), so the identifier scan above
+  // stops right at it. Skip the regexes for all other identifiers.
+  const int next_char = PeekCurrentChar();
+  if (next_char == '?' || next_char == '>' || next_char == '@') {
     absl::string_view consumable = StringViewFromPointers(
         token_state_.token_start, buf_.data() + buf_.size());
     static LazyRE2 dim_labels_pattern = {
@@ -356,7 +381,7 @@ TokKind HloLexer::LexIdentifier() {
     }
   }
 
-  token_state_.str_val = std::string(identifier);
+  token_state_.str_val.assign(identifier.data(), identifier.size());
   return TokKind::kIdent;
 }
 
@@ -388,14 +413,19 @@ TokKind HloLexer::LexPercent() {
 // int ::=  [-]?[0-9]+
 // negative inf ::= '-inf'
 TokKind HloLexer::LexNumberOrPattern() {
+  if (std::optional<TokKind> kind = LexSimpleNumber(); kind.has_value()) {
+    return *kind;
+  }
+
   absl::string_view consumable = StringViewFromPointers(
       token_state_.token_start, buf_.data() + buf_.size());
   static LazyRE2 float_pattern = {
       R"([-]?((\d+|\d+[.]\d*|\d*[.]\d+)([eE][+-]?\d+))|[-]?(\d+[.]\d*|\d*[.]\d+))"};
   if (RE2::Consume(&consumable, *float_pattern)) {
     current_ptr_ = consumable.data();
-    CHECK(absl::SimpleAtod(std::string(token_state_.token_start, current_ptr_),
-                           &token_state_.decimal_val));
+    CHECK(absl::SimpleAtod(
+        StringViewFromPointers(token_state_.token_start, current_ptr_),
+        &token_state_.decimal_val));
     return TokKind::kDecimal;
   }
 
@@ -426,17 +456,8 @@ TokKind HloLexer::LexNumberOrPattern() {
   static LazyRE2 int_pattern = {R"([-]?\d+)"};
   if (RE2::Consume(&consumable, *int_pattern)) {
     current_ptr_ = consumable.data();
-    auto slice = StringViewFromPointers(token_state_.token_start, current_ptr_);
-    if (absl::SimpleAtoi(slice, &token_state_.int64_val)) {
-      return TokKind::kInt;
-    }
-    uint64_t uint64_val;
-    if (absl::SimpleAtoi(slice, &uint64_val)) {
-      token_state_.int64_val = absl::bit_cast<int64_t>(uint64_val);
-      return TokKind::kInt;
-    }
-    LOG(ERROR) << "Failed to parse int literal: " << slice;
-    return TokKind::kError;
+    return LexIntValue(
+        StringViewFromPointers(token_state_.token_start, current_ptr_));
   }
 
   static LazyRE2 neg_inf = {"-inf"};
@@ -464,6 +485,75 @@ TokKind HloLexer::LexNumberOrPattern() {
   return TokKind::kError;
 }
 
+// Hand-written scanner for the common case of a number that is not part of a
+// larger pattern, e.g. the elements of a large constant literal:
+//
+// simple_number ::= [-]?(\d+|\d+[.]\d*|\d*[.]\d+)([eE][+-]?\d+)?
+//
+// followed by a delimiter. Anything else falls back to the regexes in
+// LexNumberOrPattern, so the accepted language is unchanged.
+std::optional<TokKind> HloLexer::LexSimpleNumber() {
+  const char* const end = buf_.data() + buf_.size();
+  const char* ptr = token_state_.token_start;
+  auto consume_digits = [&] {
+    const char* start = ptr;
+    while (ptr != end &&
+           absl::ascii_isdigit(static_cast<unsigned char>(*ptr))) {
+      ++ptr;
+    }
+    return ptr != start;
+  };
+
+  if (ptr != end && *ptr == '-') {
+    ++ptr;
+  }
+  bool has_digits = consume_digits();
+  bool is_decimal = false;
+  if (ptr != end && *ptr == '.') {
+    ++ptr;
+    has_digits |= consume_digits();
+    is_decimal = true;
+  }
+  if (!has_digits) {
+    return std::nullopt;
+  }
+  if (ptr != end && (*ptr == 'e' || *ptr == 'E')) {
+    ++ptr;
+    if (ptr != end && (*ptr == '+' || *ptr == '-')) {
+      ++ptr;
+    }
+    if (!consume_digits()) {
+      return std::nullopt;
+    }
+    is_decimal = true;
+  }
+  if (!IsNumberDelimiter(ptr, end)) {
+    return std::nullopt;
+  }
+
+  current_ptr_ = ptr;
+  absl::string_view slice =
+      StringViewFromPointers(token_state_.token_start, current_ptr_);
+  if (is_decimal) {
+    CHECK(absl::SimpleAtod(slice, &token_state_.decimal_val));
+    return TokKind::kDecimal;
+  }
+  return LexIntValue(slice);
+}
+
+TokKind HloLexer::LexIntValue(absl::string_view slice) {
+  if (absl::SimpleAtoi(slice, &token_state_.int64_val)) {
+    return TokKind::kInt;
+  }
+  uint64_t uint64_val;
+  if (absl::SimpleAtoi(slice, &uint64_val)) {
+    token_state_.int64_val = absl::bit_cast<int64_t>(uint64_val);
+    return TokKind::kInt;
+  }
+  LOG(ERROR) << "Failed to parse int literal: " << slice;
+  return TokKind::kError;
+}
+
 std::pair<unsigned, unsigned> HloLexer::GetLineAndColumn(LocTy location) const {
   unsigned line_no = 1;
   const char* start = buf_.data();
@@ -104,7 +104,7 @@ class HloLexer {
   TokKind Lex() { return token_state_.current_kind = LexToken(); }
 
   TokKind GetKind() const { return token_state_.current_kind; }
-  std::string GetStrVal() const {
+  const std::string& GetStrVal() const {
     switch (GetKind()) {
       case TokKind::kName:
       case TokKind::kAttributeName:
@@ -182,6 +182,16 @@ class HloLexer {
   TokKind LexNumberOrPattern();
   TokKind LexString();
 
+  // Lexes a plain integer or floating-point literal that is immediately
+  // followed by a delimiter, without going through the regex patterns used by
+  // LexNumberOrPattern. Returns std::nullopt (and leaves the lexer state
+  // untouched) if the token is not such a literal.
+  std::optional<TokKind> LexSimpleNumber();
+
+  // Parses `slice` as a signed, or failing that unsigned, 64-bit integer and
+  // stores it in token_state_.int64_val.
+  TokKind LexIntValue(absl::string_view slice);
+
   std::optional<int64_t> LexNanPayload(absl::string_view& consumable);
 
   absl::string_view buf_;
@@ -0,0 +1,376 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/hlo_module_chunks.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/hlo/ir/hlo_casting_utils.h"
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_instructions.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/literal.h"
+#include "xla/service/hlo.pb.h"
+#include "xla/service/hlo_module_config.h"
+#include "xla/util.h"
+#include "tsl/lib/strings/proto_serialization.h"
+#include "tsl/platform/coding.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
+#include "tsl/platform/file_system.h"
+#include "tsl/platform/fingerprint.h"
+#include "tsl/platform/raw_coding.h"
+#include "tsl/platform/statusor.h"
+
+namespace xla {
+namespace {
+
+constexpr absl::string_view kMagic = "XLAHLOC1";
+constexpr int64_t kIndexEntrySize = 4 * sizeof(uint64_t);
+constexpr int64_t kFooterSize = 4 * sizeof(uint64_t) + kMagic.size();
+
+enum class ChunkKind : uint64_t {
+  kModule = 0,
+  kComputation = 1,
+  kLiteral = 2,
+};
+
+// Folds one chunk into the running fingerprint of the file.
+tsl::Fprint128 FingerprintChunk(const tsl::Fprint128& fingerprint,
+                                ChunkKind kind, int64_t id,
+                                absl::string_view data) {
+  tsl::Fprint128 result =
+      tsl::FingerprintCat128(fingerprint, static_cast<uint64_t>(kind));
+  result = tsl::FingerprintCat128(result, static_cast<uint64_t>(id));
+  return tsl::FingerprintCat128(result, tsl::Fingerprint128(data));
+}
+
+// Appends chunks to an output and builds the index and footer.
+class ChunkWriter {
+ public:
+  explicit ChunkWriter(
+      absl::FunctionRef<absl::Status(absl::string_view)> append)
+      : append_(append) {}
+
+  absl::Status Start() {
+    offset_ = kMagic.size();
+    return append_(kMagic);
+  }
+
+  absl::Status WriteChunk(ChunkKind kind, int64_t id, absl::string_view data) {
+    TF_RETURN_IF_ERROR(append_(data));
+    tsl::core::PutFixed64(&index_, static_cast<uint64_t>(kind));
+    tsl::core::PutFixed64(&index_, static_cast<uint64_t>(id));
+    tsl::core::PutFixed64(&index_, offset_);
+    tsl::core::PutFixed64(&index_, data.size());
+    offset_ += data.size();
+    ++num_chunks_;
+    fingerprint_ = FingerprintChunk(fingerprint_, kind, id, data);
+    return absl::OkStatus();
+  }
+
+  absl::Status WriteProtoChunk(ChunkKind kind, int64_t id,
+                               const tsl::protobuf::MessageLite& proto) {
+    std::string data;
+    if (!tsl::SerializeToStringDeterministic(proto, &data)) {
+      return Internal("Failed to serialize %s chunk %d",
+                      kind == ChunkKind::kModule ? "module" : "computation",
+                      id);
+    }
+    return WriteChunk(kind, id, data);
+  }
+
+  absl::Status Finish() {
+    std::string footer;
+    tsl::core::PutFixed64(&footer, offset_);
+    tsl::core::PutFixed64(&footer, num_chunks_);
+    tsl::core::PutFixed64(&footer, fingerprint_.low64);
+    tsl::core::PutFixed64(&footer, fingerprint_.high64);
+    footer.append(kMagic);
+    TF_RETURN_IF_ERROR(append_(index_));
+    return append_(footer);
+  }
+
+ private:
+  absl::FunctionRef<absl::Status(absl::string_view)> append_;
+  uint64_t offset_ = 0;
+  uint64_t num_chunks_ = 0;
+  std::string index_;
+  tsl::Fprint128 fingerprint_ = {0, 0};
+};
+
+absl::Status WriteChunks(
+    const HloModule& module, const HloModuleChunksOptions& options,
+    absl::FunctionRef<absl::Status(absl::string_view)> append) {
+  ChunkWriter writer(append);
+  TF_RETURN_IF_ERROR(writer.Start());
+
+  TF_RETURN_IF_ERROR(
+      writer.WriteProtoChunk(ChunkKind::kModule, module.unique_id(),
+                             module.ToProtoWithoutComputations()));
+
+  for (const HloComputation* computation :
+       module.MakeComputationPostOrder()) {
+    absl::flat_hash_set<int64_t> out_of_line;
+    for (const HloInstruction* instruction : computation->instructions()) {
+      if (instruction->opcode() != HloOpcode::kConstant) continue;
+      const auto* constant = Cast<HloConstantInstruction>(instruction);
+      if (!constant->HasLiteral() || !constant->literal().shape().IsArray() ||
+          constant->literal().size_bytes() <
+              options.min_out_of_line_literal_bytes) {
+        continue;
+      }
+      TF_ASSIGN_OR_RETURN(std::string literal_data,
+                          constant->literal().SerializeAsString());
+      TF_RETURN_IF_ERROR(writer.WriteChunk(
+          ChunkKind::kLiteral, constant->unique_id(), literal_data));
+      out_of_line.insert(constant->unique_id());
+    }
+
+    HloComputationProto computation_proto = computation->ToProto();
+    for (HloInstructionProto& instruction :
+         *computation_proto.mutable_instructions()) {
+      if (out_of_line.contains(instruction.id())) {
+        instruction.clear_literal();
+      }
+    }
+    TF_RETURN_IF_ERROR(writer.WriteProtoChunk(
+        ChunkKind::kComputation, computation->unique_id(), computation_proto));
+  }
+  return writer.Finish();
+}
+
+}  // namespace
+
+bool IsHloModuleChunks(absl::string_view data) {
+  return data.size() >= kMagic.size() + kFooterSize &&
+         data.substr(0, kMagic.size()) == kMagic &&
+         data.substr(data.size() - kMagic.size()) == kMagic;
+}
+
+absl::Status WriteHloModuleChunks(const HloModule& module,
+                                  tsl::WritableFile* file,
+                                  const HloModuleChunksOptions& options) {
+  return WriteChunks(module, options, [&](absl::string_view data) {
+    return file->Append(data);
+  });
+}
+
+absl::Status WriteHloModuleChunksToFile(const HloModule& module,
+                                        const std::string& path,
+                                        const HloModuleChunksOptions& options,
+                                        tsl::Env* env) {
+  std::unique_ptr<tsl::WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(path, &file));
+  TF_RETURN_IF_ERROR(WriteHloModuleChunks(module, file.get(), options));
+  return file->Close();
+}
+
+absl::StatusOr<std::string> SerializeHloModuleChunks(
+    const HloModule& module, const HloModuleChunksOptions& options) {
+  std::string result;
+  TF_RETURN_IF_ERROR(WriteChunks(module, options, [&](absl::string_view data) {
+    result.append(data);
+    return absl::OkStatus();
+  }));
+  return result;
+}
+
+/*static*/ absl::StatusOr<std::unique_ptr<HloModuleChunksReader>>
+HloModuleChunksReader::OpenFile(const std::string& path, tsl::Env* env) {
+  std::unique_ptr<tsl::ReadOnlyMemoryRegion> region;
+  TF_RETURN_IF_ERROR(env->NewReadOnlyMemoryRegionFromFile(path, &region));
+  absl::string_view data(static_cast<const char*>(region->data()),
+                         region->length());
+  auto reader =
+      std::unique_ptr<HloModuleChunksReader>(new HloModuleChunksReader(data));
+  reader->region_ = std::move(region);
+  TF_RETURN_IF_ERROR(reader->Init());
+  return reader;
+}
+
+/*static*/ absl::StatusOr<std::unique_ptr<HloModuleChunksReader>>
+HloModuleChunksReader::FromData(absl::string_view data) {
+  auto reader =
+      std::unique_ptr<HloModuleChunksReader>(new HloModuleChunksReader(data));
+  TF_RETURN_IF_ERROR(reader->Init());
+  return reader;
+}
+
+absl::Status HloModuleChunksReader::Init() {
+  if (!IsHloModuleChunks(data_)) {
+    return InvalidArgument("Data is not an HLO module in the chunked format");
+  }
+  const char* footer = data_.data() + data_.size() - kFooterSize;
+  const uint64_t index_offset = tsl::core::DecodeFixed64(footer);
+  const uint64_t num_chunks = tsl::core::DecodeFixed64(footer + 8);
+  fingerprint_low_ = tsl::core::DecodeFixed64(footer + 16);
+  fingerprint_high_ = tsl::core::DecodeFixed64(footer + 24);
+
+  const uint64_t index_end = data_.size() - kFooterSize;
+  if (index_offset < kMagic.size() || index_offset > index_end ||
+      (index_end - index_offset) / kIndexEntrySize != num_chunks ||
+      (index_end - index_offset) % kIndexEntrySize != 0) {
+    return InvalidArgument("Corrupted index in chunked HLO module");
+  }
+
+  bool has_module_chunk = false;
+  chunks_.reserve(num_chunks);
+  for (uint64_t i = 0; i < num_chunks; ++i) {
+    const char* entry = data_.data() + index_offset + i * kIndexEntrySize;
+    const uint64_t kind = tsl::core::DecodeFixed64(entry);
+    const auto id = static_cast<int64_t>(tsl::core::DecodeFixed64(entry + 8));
+    const uint64_t offset = tsl::core::DecodeFixed64(entry + 16);
+    const uint64_t size = tsl::core::DecodeFixed64(entry + 24);
+    if (offset < kMagic.size() || offset > index_offset ||
+        size > index_offset - offset) {
+      return InvalidArgument("Chunk %d is out of bounds", i);
+    }
+    Chunk chunk{static_cast<int64_t>(offset), static_cast<int64_t>(size)};
+    chunks_.push_back(chunk);
+
+    switch (static_cast<ChunkKind>(kind)) {
+      case ChunkKind::kModule:
+        if (has_module_chunk) {
+          return InvalidArgument("Duplicate module chunk");
+        }
+        if (!module_header_.ParseFromArray(data_.data() + chunk.offset,
+                                           chunk.size)) {
+          return InvalidArgument("Failed to parse module chunk");
+        }
+        has_module_chunk = true;
+        break;
+      case ChunkKind::kComputation:
+        if (!computation_chunks_.emplace(id, chunk).second) {
+          return InvalidArgument("Duplicate computation chunk %d", id);
+        }
+        computation_ids_.push_back(id);
+        break;
+      case ChunkKind::kLiteral:
+        if (!literal_chunks_.emplace(id, chunk).second) {
+          return InvalidArgument("Duplicate literal chunk %d", id);
+        }
+        break;
+      default:
+        return InvalidArgument("Unknown chunk kind %d", kind);
+    }
+  }
+  if (!has_module_chunk) {
+    return InvalidArgument("Missing module chunk");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<const HloComputationProto*>
+HloModuleChunksReader::GetComputation(int64_t id) const {
+  auto chunk = computation_chunks_.find(id);
+  if (chunk == computation_chunks_.end()) {
+    return NotFound("No computation with id %d", id);
+  }
+
+  absl::MutexLock lock(&mu_);
+  std::unique_ptr<HloComputationProto>& computation = computations_[id];
+  if (computation == nullptr) {
+    auto proto = std::make_unique<HloComputationProto>();
+    absl::string_view data = ChunkData(chunk->second);
+    if (!proto->ParseFromArray(data.data(), data.size())) {
+      computations_.erase(id);
+      return InvalidArgument("Failed to parse computation chunk %d", id);
+    }
+    computation = std::move(proto);
+  }
+  return computation.get();
+}
+
+absl::StatusOr<Literal> HloModuleChunksReader::LoadLiteral(
+    int64_t instruction_id) const {
+  auto chunk = literal_chunks_.find(instruction_id);
+  if (chunk == literal_chunks_.end()) {
+    return NotFound("No out-of-line literal for instruction %d",
+                    instruction_id);
+  }
+  return Literal::DeserializeFromString(ChunkData(chunk->second));
+}
+
+std::string HloModuleChunksReader::Fingerprint128() const {
+  return absl::StrFormat("%016x%016x", fingerprint_high_, fingerprint_low_);
+}
+
+absl::Status HloModuleChunksReader::VerifyFingerprint() const {
+  const char* footer = data_.data() + data_.size() - kFooterSize;
+  const uint64_t index_offset = tsl::core::DecodeFixed64(footer);
+  tsl::Fprint128 fingerprint = {0, 0};
+  for (int64_t i = 0; i < chunks_.size(); ++i) {
+    const char* entry = data_.data() + index_offset + i * kIndexEntrySize;
+    fingerprint = FingerprintChunk(
+        fingerprint, static_cast<ChunkKind>(tsl::core::DecodeFixed64(entry)),
+        static_cast<int64_t>(tsl::core::DecodeFixed64(entry + 8)),
+        ChunkData(chunks_[i]));
+  }
+  if (fingerprint.low64 != fingerprint_low_ ||
+      fingerprint.high64 != fingerprint_high_) {
+    return DataLoss("Fingerprint mismatch in chunked HLO module");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<HloModuleConfig> HloModuleChunksReader::CreateModuleConfig(
+    const DebugOptions& debug_options) const {
+  return HloModule::CreateModuleConfigFromProto(module_header_, debug_options);
+}
+
+absl::StatusOr<std::unique_ptr<HloModule>> HloModuleChunksReader::ToModule(
+    const HloModuleConfig& config) const {
+  HloModuleProto proto = module_header_;
+  for (int64_t id : computation_ids_) {
+    TF_ASSIGN_OR_RETURN(const HloComputationProto* computation,
+                        GetComputation(id));
+    *proto.add_computations() = *computation;
+  }
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<HloModule> module,
+                      HloModule::CreateFromProto(proto, config));
+  // The computation protos are no longer needed; drop the copy before the
+  // literals are materialized.
+  proto.Clear();
+
+  for (HloComputation* computation : module->computations()) {
+    for (HloInstruction* instruction : computation->instructions()) {
+      if (instruction->opcode() != HloOpcode::kConstant ||
+          !HasOutOfLineLiteral(instruction->unique_id())) {
+        continue;
+      }
+      TF_ASSIGN_OR_RETURN(Literal literal,
+                          LoadLiteral(instruction->unique_id()));
+      TF_RETURN_IF_ERROR(Cast<HloConstantInstruction>(instruction)
+                             ->SetLiteral(std::move(literal)));
+    }
+  }
+  return module;
+}
+
+}  // namespace xla
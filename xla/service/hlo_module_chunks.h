@@ -0,0 +1,179 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A chunked binary serialization format for HLO modules.
+//
+// Unlike a serialized HloModuleProto, every computation and every large
+// constant literal is stored in its own chunk, so readers can memory-map the
+// file and decode only the pieces they access. Large literals are stored with
+// Literal::Serialize, which avoids both the protobuf 2GB limit and the cost of
+// converting the literal to and from LiteralProto.
+//
+// File layout (all integers are little-endian fixed64):
+//
+//   magic                            "XLAHLOC1"
+//   chunk data                       one chunk after the other
+//   index                            num_chunks x {kind, id, offset, size}
+//   footer                           {index_offset, num_chunks,
+//                                     fingerprint_low, fingerprint_high}
+//   magic                            "XLAHLOC1"
+//
+// There is exactly one kModule chunk holding the HloModuleProto with all
+// computations removed. kComputation chunks hold one HloComputationProto each,
+// in the order they appear in HloModule::ToProto, with the literals of large
+// constants cleared. Those literals live in kLiteral chunks keyed by the
+// unique id of the constant instruction.
+//
+// The footer carries a fingerprint of all chunks, computed while writing, so
+// that readers can identify a module without reading any of its chunks.
+
+#ifndef XLA_SERVICE_HLO_MODULE_CHUNKS_H_
+#define XLA_SERVICE_HLO_MODULE_CHUNKS_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/literal.h"
+#include "xla/service/hlo.pb.h"
+#include "xla/service/hlo_module_config.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/file_system.h"
+
+namespace xla {
+
+struct HloModuleChunksOptions {
+  // Array constants whose literal is at least this many bytes are stored in
+  // their own chunk instead of inline in the computation proto.
+  int64_t min_out_of_line_literal_bytes = 4096;
+};
+
+// Returns true if `data` looks like a serialized module in the chunked format.
+bool IsHloModuleChunks(absl::string_view data);
+
+// Writes `module` to `file` in the chunked format. Computations are serialized
+// one at a time, so peak memory is bounded by the largest computation rather
+// than by the whole module.
+absl::Status WriteHloModuleChunks(const HloModule& module,
+                                  tsl::WritableFile* file,
+                                  const HloModuleChunksOptions& options = {});
+
+// Writes `module` to the file at `path` in the chunked format.
+absl::Status WriteHloModuleChunksToFile(
+    const HloModule& module, const std::string& path,
+    const HloModuleChunksOptions& options = {},
+    tsl::Env* env = tsl::Env::Default());
+
+// Returns `module` serialized in the chunked format.
+absl::StatusOr<std::string> SerializeHloModuleChunks(
+    const HloModule& module, const HloModuleChunksOptions& options = {});
+
+// Provides lazy access to a module serialized in the chunked format.
+// Computations are decoded on first access and cached; literals are decoded
+// every time they are loaded and are not retained by the reader.
+//
+// This class is thread-safe.
+class HloModuleChunksReader {
+ public:
+  // Memory-maps the file at `path`.
+  static absl::StatusOr<std::unique_ptr<HloModuleChunksReader>> OpenFile(
+      const std::string& path, tsl::Env* env = tsl::Env::Default());
+
+  // Reads from `data`, which must outlive the returned reader.
+  static absl::StatusOr<std::unique_ptr<HloModuleChunksReader>> FromData(
+      absl::string_view data);
+
+  // The module proto without computations.
+  const HloModuleProto& module_header() const { return module_header_; }
+
+  // Returns the ids of all computations in serialization order.
+  const std::vector<int64_t>& computation_ids() const {
+    return computation_ids_;
+  }
+
+  // Returns the computation with the given id. Large constants in the
+  // returned proto have no literal; use LoadLiteral to get them.
+  absl::StatusOr<const HloComputationProto*> GetComputation(int64_t id) const;
+
+  // Returns true if the constant instruction with the given id has its literal
+  // stored in a separate chunk.
+  bool HasOutOfLineLiteral(int64_t instruction_id) const {
+    return literal_chunks_.contains(instruction_id);
+  }
+
+  // Decodes the out-of-line literal of the given constant instruction.
+  absl::StatusOr<Literal> LoadLiteral(int64_t instruction_id) const;
+
+  // Returns the fingerprint recorded when the module was written, as a hex
+  // string of its high and then its low 64 bits, which does not depend on the
+  // byte order of the host. This does not touch any chunk data.
+  std::string Fingerprint128() const;
+
+  // Recomputes the fingerprint from the chunk data and compares it to the one
+  // recorded in the footer.
+  absl::Status VerifyFingerprint() const;
+
+  // Returns the config stored in the module proto, with `debug_options`.
+  absl::StatusOr<HloModuleConfig> CreateModuleConfig(
+      const DebugOptions& debug_options) const;
+
+  // Materializes the whole module. Literals are decoded straight from the
+  // chunk data into the constants, without an intermediate LiteralProto.
+  absl::StatusOr<std::unique_ptr<HloModule>> ToModule(
+      const HloModuleConfig& config) const;
+
+ private:
+  struct Chunk {
+    int64_t offset;
+    int64_t size;
+  };
+
+  explicit HloModuleChunksReader(absl::string_view data) : data_(data) {}
+
+  absl::Status Init();
+
+  absl::string_view ChunkData(const Chunk& chunk) const {
+    return data_.substr(chunk.offset, chunk.size);
+  }
+
+  // Keeps the memory mapping alive when reading from a file.
+  std::unique_ptr<tsl::ReadOnlyMemoryRegion> region_;
+  absl::string_view data_;
+
+  uint64_t fingerprint_low_ = 0;
+  uint64_t fingerprint_high_ = 0;
+  std::vector<Chunk> chunks_;
+
+  HloModuleProto module_header_;
+  std::vector<int64_t> computation_ids_;
+  absl::flat_hash_map<int64_t, Chunk> computation_chunks_;
+  absl::flat_hash_map<int64_t, Chunk> literal_chunks_;
+
+  mutable absl::Mutex mu_;
+  mutable absl::flat_hash_map<int64_t, std::unique_ptr<HloComputationProto>>
+      computations_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace xla
+
+#endif  // XLA_SERVICE_HLO_MODULE_CHUNKS_H_
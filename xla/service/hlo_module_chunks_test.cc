@@ -0,0 +1,159 @@
+/* Copyright 2024 The OpenXLA Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "xla/service/hlo_module_chunks.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "xla/hlo/ir/hlo_computation.h"
+#include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/hlo/ir/hlo_module.h"
+#include "xla/hlo/ir/hlo_opcode.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/service/hlo.pb.h"
+#include "xla/tests/hlo_test_base.h"
+#include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
+#include "tsl/platform/test.h"
+
+namespace xla {
+namespace {
+
+constexpr char kModuleWithConstants[] = R"(
+HloModule m
+
+add {
+  x = f32[] parameter(0)
+  y = f32[] parameter(1)
+  ROOT add = f32[] add(x, y)
+}
+
+ENTRY e {
+  p = f32[1024] parameter(0)
+  small = f32[4] constant({1, 2, 3, 4})
+  big = f32[1024] iota(), iota_dimension=0
+  sum = f32[1024] add(p, big)
+  zero = f32[] constant(0)
+  ROOT r = f32[] reduce(sum, zero), dimensions={0}, to_apply=add
+}
+)";
+
+class HloModuleChunksTest : public HloTestBase {
+ protected:
+  // Parses kModuleWithConstants and replaces the iota with a large constant,
+  // so that the module has both inline and out-of-line literals.
+  std::unique_ptr<HloModule> MakeModule() {
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnVerifiedModule(kModuleWithConstants).value();
+    HloComputation* entry = module->entry_computation();
+    HloInstruction* iota = entry->GetInstructionWithName("big");
+    TF_CHECK_OK(entry->ReplaceWithNewInstruction(
+        iota, HloInstruction::CreateConstant(LargeLiteral())));
+    return module;
+  }
+
+  static Literal LargeLiteral() {
+    return LiteralUtil::CreateR1<float>(std::vector<float>(1024, 2));
+  }
+};
+
+TEST_F(HloModuleChunksTest, RoundTrip) {
+  std::unique_ptr<HloModule> module = MakeModule();
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeHloModuleChunks(*module));
+  EXPECT_TRUE(IsHloModuleChunks(data));
+
+  TF_ASSERT_OK_AND_ASSIGN(auto reader, HloModuleChunksReader::FromData(data));
+  TF_ASSERT_OK(reader->VerifyFingerprint());
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> result,
+                          reader->ToModule(module->config()));
+  EXPECT_EQ(result->ToString(), module->ToString());
+}
+
+TEST_F(HloModuleChunksTest, LargeLiteralsAreStoredOutOfLine) {
+  std::unique_ptr<HloModule> module = MakeModule();
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeHloModuleChunks(*module));
+  TF_ASSERT_OK_AND_ASSIGN(auto reader, HloModuleChunksReader::FromData(data));
+
+  ASSERT_EQ(reader->computation_ids().size(), 2);
+  const int64_t entry_id = reader->computation_ids().back();
+  TF_ASSERT_OK_AND_ASSIGN(const HloComputationProto* entry,
+                          reader->GetComputation(entry_id));
+  int num_out_of_line = 0;
+  for (const HloInstructionProto& instruction : entry->instructions()) {
+    if (instruction.opcode() != HloOpcodeString(HloOpcode::kConstant)) {
+      continue;
+    }
+    if (reader->HasOutOfLineLiteral(instruction.id())) {
+      ++num_out_of_line;
+      EXPECT_FALSE(instruction.has_literal());
+      TF_ASSERT_OK_AND_ASSIGN(Literal literal,
+                              reader->LoadLiteral(instruction.id()));
+      EXPECT_EQ(literal, LargeLiteral());
+    } else {
+      EXPECT_TRUE(instruction.has_literal());
+    }
+  }
+  EXPECT_EQ(num_out_of_line, 1);
+}
+
+TEST_F(HloModuleChunksTest, FingerprintIsStable) {
+  std::unique_ptr<HloModule> module = MakeModule();
+  TF_ASSERT_OK_AND_ASSIGN(std::string data1, SerializeHloModuleChunks(*module));
+  TF_ASSERT_OK_AND_ASSIGN(std::string data2, SerializeHloModuleChunks(*module));
+  TF_ASSERT_OK_AND_ASSIGN(auto reader1, HloModuleChunksReader::FromData(data1));
+  TF_ASSERT_OK_AND_ASSIGN(auto reader2, HloModuleChunksReader::FromData(data2));
+  EXPECT_EQ(reader1->Fingerprint128(), reader2->Fingerprint128());
+
+  module->entry_computation()->root_instruction()->set_metadata_op_name(
+      "changed");
+  TF_ASSERT_OK_AND_ASSIGN(std::string data3, SerializeHloModuleChunks(*module));
+  TF_ASSERT_OK_AND_ASSIGN(auto reader3, HloModuleChunksReader::FromData(data3));
+  EXPECT_NE(reader1->Fingerprint128(), reader3->Fingerprint128());
+}
+
+TEST_F(HloModuleChunksTest, DetectsCorruption) {
+  std::unique_ptr<HloModule> module = MakeModule();
+  TF_ASSERT_OK_AND_ASSIGN(std::string data, SerializeHloModuleChunks(*module));
+  // Flip a byte inside the large literal.
+  data[data.size() / 2] ^= 0xff;
+  TF_ASSERT_OK_AND_ASSIGN(auto reader, HloModuleChunksReader::FromData(data));
+  EXPECT_FALSE(reader->VerifyFingerprint().ok());
+
+  EXPECT_FALSE(HloModuleChunksReader::FromData("not a module").ok());
+}
+
+TEST_F(HloModuleChunksTest, ReadFromFile) {
+  std::unique_ptr<HloModule> module = MakeModule();
+  std::string path =
+      tsl::io::JoinPath(tsl::testing::TmpDir(), "module.hlochunks");
+  TF_ASSERT_OK(WriteHloModuleChunksToFile(*module, path));
+
+  TF_ASSERT_OK_AND_ASSIGN(auto reader, HloModuleChunksReader::OpenFile(path));
+  TF_ASSERT_OK_AND_ASSIGN(HloModuleConfig config,
+                          reader->CreateModuleConfig(GetDebugOptionsForTest()));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<HloModule> result,
+                          reader->ToModule(config));
+  EXPECT_EQ(result->ToString(), module->ToString());
+}
+
+}  // namespace
+}  // namespace xla
@@ -4073,7 +4073,8 @@ bool HloParserImpl::SetValueInLiteralHelper(LocTy loc, ParsedElemT value,
   }
 
   // Check that the index is in range and assign into the literal
-  if (index >= ShapeUtil::ElementsIn(literal->shape())) {
+  absl::Span<LiteralNativeT> data = literal->data<LiteralNativeT>();
+  if (index >= data.size()) {
     return Error(loc, StrCat("tries to set value ", StringifyValue(value),
                              " to a literal in shape ",
                              ShapeUtil::HumanString(literal->shape()),
@@ -4141,9 +4142,8 @@ bool HloParserImpl::SetValueInLiteralHelper(LocTy loc, ParsedElemT value,
       return false;
     }
   }
-  literal->data<LiteralNativeT>().at(index) =
-      LiteralNativeFromRealImag<LiteralNativeT>(literal_real_value,
-                                                literal_imag_value);
+  data[index] = LiteralNativeFromRealImag<LiteralNativeT>(literal_real_value,
+                                                          literal_imag_value);
   return true;
 }
 
@@ -4472,7 +4472,11 @@ bool HloParserImpl::ParseDenseLiteral(Literal* literal, const Shape& shape) {
     }  // end of switch
   } while (nest_level > 0);
 
-  *literal = literal->Relayout(shape.layout());
+  // The literal is built in the default layout; only pay for a copy if the
+  // requested layout differs.
+  if (!LayoutUtil::Equal(literal->shape().layout(), shape.layout())) {
+    *literal = literal->Relayout(shape.layout());
+  }
   return true;
 }
 
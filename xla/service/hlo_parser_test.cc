@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "xla/service/hlo_parser.h"
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -22,9 +24,11 @@ limitations under the License.
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "absl/log/check.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "xla/hlo/ir/collective_device_list.h"
 #include "xla/hlo/ir/hlo_casting_utils.h"
@@ -43,6 +47,7 @@ limitations under the License.
 #include "tsl/platform/status_matchers.h"
 #include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 namespace {
@@ -5390,5 +5395,75 @@ ENTRY %test {
                                      HasSubstr("expects instruction shape")));
 }
 
+TEST_F(HloParserTest, ConstantNumbersFollowedByDelimiters) {
+  const std::string hlo_string = R"(HloModule test
+
+ENTRY %test {
+  %f = f32[8]{0} constant({1, -2, 3.5, -.25, 4., 1e3, -2.5E-1,5})
+  %s = s64[4]{0} constant({-9223372036854775808,0,
+    9223372036854775807 , 7})
+  ROOT %t = (f32[8]{0}, s64[4]{0}) tuple(%f, %s)
+}
+
+)";
+  TF_ASSERT_OK_AND_ASSIGN(auto module,
+                          ParseAndReturnUnverifiedModule(hlo_string));
+  const HloInstruction* root = module->entry_computation()->root_instruction();
+  EXPECT_THAT(root->operand(0)->literal().data<float>(),
+              ElementsAre(1, -2, 3.5, -0.25, 4, 1000, -0.25, 5));
+  EXPECT_THAT(root->operand(1)->literal().data<int64_t>(),
+              ElementsAre(std::numeric_limits<int64_t>::min(), 0,
+                          std::numeric_limits<int64_t>::max(), 7));
+}
+
+// Returns the text of a module with a single f32 constant of `num_elements`
+// elements.
+std::string MakeLargeConstantModuleText(int64_t num_elements) {
+  std::vector<std::string> elements(num_elements);
+  for (int64_t i = 0; i < num_elements; ++i) {
+    elements[i] = absl::StrCat(i % 2 ? "-" : "", i, ".", i % 1000);
+  }
+  return absl::StrCat("HloModule m\n\nENTRY e {\n  ROOT c = f32[", num_elements,
+                      "]{0} constant({", absl::StrJoin(elements, ", "),
+                      "})\n}\n");
+}
+
+// Returns the text of a module with a chain of `num_instructions` elementwise
+// instructions, with attributes and metadata similar to dumped modules.
+std::string MakeLongChainModuleText(int64_t num_instructions) {
+  std::string text = "HloModule m\n\nENTRY e {\n";
+  absl::StrAppend(&text, "  p0 = f32[128,256]{1,0} parameter(0)\n");
+  for (int64_t i = 0; i < num_instructions; ++i) {
+    absl::StrAppend(&text, i + 1 == num_instructions ? "  ROOT" : " ",
+                    " add.", i, " = f32[128,256]{1,0} add(",
+                    i == 0 ? "p0" : absl::StrCat("add.", i - 1),
+                    ", p0), metadata={op_type=\"Add\" op_name=\"layer_", i,
+                    "/add\" source_file=\"model.py\" source_line=", i, "}\n");
+  }
+  absl::StrAppend(&text, "}\n");
+  return text;
+}
+
+void BM_ParseLargeConstant(::testing::benchmark::State& state) {
+  const std::string text = MakeLargeConstantModuleText(state.range(0));
+  for (auto s : state) {
+    auto module = ParseAndReturnUnverifiedModule(text);
+    CHECK_OK(module.status());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+void BM_ParseLongChain(::testing::benchmark::State& state) {
+  const std::string text = MakeLongChainModuleText(state.range(0));
+  for (auto s : state) {
+    auto module = ParseAndReturnUnverifiedModule(text);
+    CHECK_OK(module.status());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+BENCHMARK(BM_ParseLargeConstant)->Range(1 << 10, 1 << 22);
+BENCHMARK(BM_ParseLongChain)->Range(1 << 10, 1 << 20);
+
 }  // namespace
 }  // namespace xla
@@ -17,11 +17,16 @@ limitations under the License.
 #define XLA_SERVICE_HLO_PASS_FIX_H_
 
 #include <algorithm>
+#include <cstdint>
+#include <string>
 #include <type_traits>
 
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/hlo/ir/hlo_module_group.h"
+#include "xla/service/compile_profile.pb.h"
+#include "xla/service/compile_profiler.h"
 #include "xla/service/hlo_pass_interface.h"
 #include "xla/status_macros.h"
 #include "xla/types.h"
@@ -69,9 +74,13 @@ class HloPassFix : public Pass {
     int64_t iteration_count = 0;
     VLOG(3) << "Running HloPassFix.";
     while (changed_this_iteration) {
+      CompileProfiler::ScopedPass iteration_profile(
+          IterationName(iteration_count),
+          HloPassProfileProto::FIXED_POINT_ITERATION, *module_group);
       TF_ASSIGN_OR_RETURN(
           changed_this_iteration,
           Pass::RunOnModuleGroup(module_group, execution_threads));
+      iteration_profile.set_changed(changed_this_iteration);
       changed |= changed_this_iteration;
       VLOG(3) << "changed_this_iteration: " << changed_this_iteration;
       ++iteration_count;
@@ -86,13 +95,22 @@ class HloPassFix : public Pass {
   }
 
  private:
+  std::string IterationName(int64_t iteration) const {
+    return absl::StrCat(Pass::name(), " iteration ", iteration);
+  }
+
   absl::Status RunToFixPoint(
       HloModule* module, RunState* run_state,
       const absl::flat_hash_set<absl::string_view>& execution_threads) {
     VLOG(3) << "Running HloPassFix on " << Pass::name();
     while (!run_state->changed_last_iteration.empty()) {
+      CompileProfiler::ScopedPass iteration_profile(
+          IterationName(run_state->iteration),
+          HloPassProfileProto::FIXED_POINT_ITERATION, *module);
       TF_RETURN_IF_ERROR(
           RunOnChangedComputationsOnce(module, run_state, execution_threads));
+      iteration_profile.set_changed(
+          !run_state->changed_this_iteration.empty());
       VLOG(3) << Pass::name() << " iteration " << run_state->iteration
               << " changed_this_iteration: "
               << !run_state->changed_last_iteration.empty();
@@ -16,12 +16,15 @@ limitations under the License.
 #include "xla/service/hlo_pass_pipeline.h"
 
 #include <functional>
+#include <optional>
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "xla/service/compile_profile.pb.h"
+#include "xla/service/compile_profiler.h"
 #include "xla/service/dump.h"
 #include "xla/service/hlo_graph_dumper.h"
 #include "xla/service/hlo_proto_util.h"
@@ -152,6 +155,9 @@ absl::StatusOr<bool> HloPassPipeline::RunPassesInternal(
                            pipeline_name, hlo->name(), UniqueId(*hlo));
   }};
 
+  CompileProfiler::ScopedPass pipeline_profile(
+      pipeline_name, HloPassProfileProto::PIPELINE, *hlo);
+
   TF_RETURN_IF_ERROR(
       RunInvariantCheckers(hlo, kPipelineStart, execution_threads));
 
@@ -175,8 +181,11 @@ absl::StatusOr<bool> HloPassPipeline::RunPassesInternal(
     }};
     VLOG(1) << "  HLO pass " << pass_name;
     VLOG(2) << "  Module hash " << absl::HashOf(*hlo);
+    // Pipelines record their own profile.
+    std::optional<CompileProfiler::ScopedPass> pass_profile;
     if (!pass->IsPassPipeline()) {
       compilation_stats_->StartPass(pass_name);
+      pass_profile.emplace(pass_name, HloPassProfileProto::PASS, *hlo);
     }
     RecordPassStartMetadata(*hlo, pass_name, pipeline_name);
     auto status_or_changed = RunHelper(pass, hlo, execution_threads);
@@ -185,6 +194,10 @@ absl::StatusOr<bool> HloPassPipeline::RunPassesInternal(
           pass_name, absl::StatusCodeToString(status.code()));
     }
     TF_ASSIGN_OR_RETURN(bool pass_changed, status_or_changed);
+    if (pass_profile.has_value()) {
+      pass_profile->set_changed(pass_changed);
+      pass_profile.reset();
+    }
     if (!dump_regex.empty() && (pass_changed || dump_regex != ".*")) {
       MaybeDumpHloAndSaveFilenames(*hlo,
                                    /*after_pass_name=*/pass_name,
@@ -207,6 +220,7 @@ absl::StatusOr<bool> HloPassPipeline::RunPassesInternal(
       compilation_stats_->EndPass(pass_name);
     }
   }
+  pipeline_profile.set_changed(changed);
   return changed;
 }
 
@@ -573,28 +573,55 @@ void MemoryPressureTracker::Initialize(
   live_memory_usage_ = 0;
   initial_memory_pressure_ = 0;
   pressure_state_ = MemoryPressureState{};
-  output_buffers_.clear();
-  defined_buffers_.clear();
+  buffer_uses_.clear();
   live_buffers_set_.clear();
+  auto in_default_memory_space = [](const BufferInfoTracker::ValueInfo& info) {
+    const Shape& shape = info.value->values()[0]->shape();
+    return !shape.has_layout() ||
+           shape.layout().memory_space() == kDefaultMemorySpace;
+  };
+  // Buffers of each instruction output, with the index they are found at.
+  absl::flat_hash_map<
+      const HloInstruction*,
+      std::vector<std::pair<BufferInfoTracker::ValueInfo, ShapeIndex>>>
+      output_buffers;
   for (auto* instruction : computation->instructions()) {
-    auto& output_values = this->output_buffers_[instruction];
-    auto& defined_values = this->defined_buffers_[instruction];
+    auto& output_values = output_buffers[instruction];
+    InstructionBufferUses& uses = buffer_uses_[instruction];
     ShapeUtil::ForEachSubshape(
         instruction->shape(),
         [&](const Shape& subshape, const ShapeIndex& index) {
           for (const HloBuffer* buffer :
                hlo_alias_analysis_->ComputeBuffersAt(instruction, index)) {
-            output_values.push_back(std::make_pair(
-                buffer_tracker_.GetBufferInfo(buffer->id()), index));
-            if (absl::c_any_of(buffer->values(), [&](const HloValue* value) {
+            const BufferInfoTracker::ValueInfo& info =
+                buffer_tracker_.GetBufferInfo(buffer->id());
+            output_values.push_back(std::make_pair(info, index));
+            if (!ShouldSkipBufferReleases(instruction) &&
+                info.first_definition == instruction &&
+                in_default_memory_space(info) &&
+                absl::c_any_of(buffer->values(), [&](const HloValue* value) {
                   return value->defining_instruction() == instruction;
                 })) {
-              defined_values.push_back(
-                  buffer_tracker_.GetBufferInfo(buffer->id()));
+              uses.released.push_back({buffer->id(), info.buffer_size});
             }
           }
         });
   }
+  for (auto* instruction : computation->instructions()) {
+    InstructionBufferUses& uses = buffer_uses_[instruction];
+    for (auto* op : instruction->operands()) {
+      auto it = output_buffers.find(op);
+      CHECK(it != output_buffers.end());
+      for (auto& [info, index] : it->second) {
+        if (ShouldSkipBufferAllocations(instruction, index,
+                                        info.first_definition) ||
+            !in_default_memory_space(info)) {
+          continue;
+        }
+        uses.allocated.push_back({info.value->id(), info.buffer_size});
+      }
+    }
+  }
   if (!initial_live_buffers.empty()) {
     for (HloBuffer::Id id : initial_live_buffers) {
       auto& buffer = buffer_tracker_.GetBufferInfo(id);
@@ -625,40 +652,21 @@ void MemoryPressureTracker::UpdateBuffers(const HloInstruction* instruction) {
   if (pressure_state_.memory_peak < live_memory_usage_ + computations_peak) {
     pressure_state_.memory_peak = live_memory_usage_ + computations_peak;
   }
-  for (auto* op : instruction->operands()) {
-    auto& output_values = output_buffers_[op];
-    for (auto& info : output_values) {
-      if (ShouldSkipBufferAllocations(instruction, info.second,
-                                      info.first.first_definition) ||
-          (info.first.value->values()[0]->shape().has_layout() &&
-           info.first.value->values()[0]->shape().layout().memory_space() !=
-               kDefaultMemorySpace)) {
-        continue;
-      }
-      if (live_buffers_[info.first.value->id()] == 0) {
-        live_buffers_[info.first.value->id()] = 1;
-        live_buffers_set_.insert(info.first.value->id());
-        live_memory_usage_ += info.first.buffer_size;
-      }
+  auto it = buffer_uses_.find(instruction);
+  CHECK(it != buffer_uses_.end());
+  for (const BufferUse& use : it->second.allocated) {
+    if (live_buffers_[use.id] == 0) {
+      live_buffers_[use.id] = 1;
+      live_buffers_set_.insert(use.id);
+      live_memory_usage_ += use.size;
     }
   }
   pressure_state_.memory_peak =
       std::max(live_memory_usage_, pressure_state_.memory_peak);
-  auto it = defined_buffers_.find(instruction);
-  CHECK(it != defined_buffers_.end());
-  if (!ShouldSkipBufferReleases(instruction)) {
-    for (auto& b : it->second) {
-      if (b.value->values()[0]->shape().has_layout() &&
-          b.value->values()[0]->shape().layout().memory_space() !=
-              kDefaultMemorySpace) {
-        continue;
-      }
-      if (live_buffers_[b.value->id()] != 0) {
-        if (b.first_definition == instruction) {
-          live_memory_usage_ -= b.buffer_size;
-          live_buffers_set_.erase(b.value->id());
-        }
-      }
+  for (const BufferUse& use : it->second.released) {
+    if (live_buffers_[use.id] != 0) {
+      live_memory_usage_ -= use.size;
+      live_buffers_set_.erase(use.id);
     }
   }
 }
@@ -683,39 +691,19 @@ std::pair<int64_t, int64_t> MemoryPressureTracker::MemoryPressureDifference(
           std::max(called_comp_peak, it->second.memory_peak);
     }
   }
+  auto it = buffer_uses_.find(instruction);
+  CHECK(it != buffer_uses_.end());
   // Allocate memory increase from the operand and record increase in peak.
-  for (auto* op : instruction->operands()) {
-    auto it = output_buffers_.find(op);
-    CHECK(it != output_buffers_.end());
-    for (auto& b : it->second) {
-      if (ShouldSkipBufferAllocations(instruction, b.second,
-                                      b.first.first_definition) ||
-          (b.first.value->values()[0]->shape().has_layout() &&
-           b.first.value->values()[0]->shape().layout().memory_space() !=
-               kDefaultMemorySpace)) {
-        continue;
-      }
-      if (!live_buffers_[b.first.value->id()]) {
-        increase += b.first.buffer_size;
-      }
+  for (const BufferUse& use : it->second.allocated) {
+    if (!live_buffers_[use.id]) {
+      increase += use.size;
     }
   }
   peak = std::max(increase, peak);
-  auto it = defined_buffers_.find(instruction);
-  CHECK(it != defined_buffers_.end());
   // Decrease memory pressure if some buffers are released.
-  if (!ShouldSkipBufferReleases(instruction)) {
-    for (auto& b : it->second) {
-      if (b.value->values()[0]->shape().has_layout() &&
-          b.value->values()[0]->shape().layout().memory_space() !=
-              kDefaultMemorySpace) {
-        continue;
-      }
-      if (live_buffers_[b.value->id()]) {
-        if (b.first_definition == instruction) {
-          increase -= b.buffer_size;
-        }
-      }
+  for (const BufferUse& use : it->second.released) {
+    if (live_buffers_[use.id]) {
+      increase -= use.size;
     }
   }
   return std::make_pair(increase, peak);
@@ -695,15 +695,25 @@ class MemoryPressureTracker {
   // Set of live buffer ids.
   LiveBufferSet live_buffers_set_;
   const BufferInfoTracker& buffer_tracker_;
-  // Cache of buffer objects defined that are output of instructions.
-  absl::flat_hash_map<
-      HloInstruction*,
-      std::vector<std::pair<BufferInfoTracker::ValueInfo, ShapeIndex>>>
-      output_buffers_;
-  // Cache of buffer objects defined that are defined by instructions.
-  absl::flat_hash_map<HloInstruction*,
-                      std::vector<BufferInfoTracker::ValueInfo>>
-      defined_buffers_;
+  // A buffer that may change liveness when an instruction is scheduled.
+  struct BufferUse {
+    HloBuffer::Id id;
+    int64_t size;
+  };
+  // Buffers whose liveness depends on an instruction, with all the checks that
+  // don't depend on the current live set already applied. Computed once in
+  // Initialize so that MemoryPressureDifference, which the scheduler calls for
+  // every candidate at every step, only has to walk two flat vectors.
+  struct InstructionBufferUses {
+    // Buffers of the operands that become live when the instruction is
+    // scheduled, in operand order. A buffer can appear more than once.
+    std::vector<BufferUse> allocated;
+    // Buffers first defined by the instruction that are released when it is
+    // scheduled.
+    std::vector<BufferUse> released;
+  };
+  absl::flat_hash_map<const HloInstruction*, InstructionBufferUses>
+      buffer_uses_;
   // Map with pressure_state object for other computations. It's updated by
   // the user of this class.
   const absl::flat_hash_map<const HloComputation*, MemoryPressureState>&
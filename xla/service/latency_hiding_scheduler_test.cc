@@ -32,6 +32,8 @@ limitations under the License.
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -39,11 +41,13 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_schedule.h"
 #include "xla/service/async_collective_creator.h"
 #include "xla/service/hlo_cost_analysis.h"
+#include "xla/service/hlo_parser.h"
 #include "xla/shape.h"
 #include "xla/shape_util.h"
 #include "xla/tests/hlo_test_base.h"
 #include "xla/util.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/test_benchmark.h"
 
 namespace xla {
 
@@ -3239,4 +3243,62 @@ ENTRY %module {
   EXPECT_LT(c2_index, ag_done_index);
 }
 
+namespace {
+
+// Returns a scheduled module with `num_layers` layers, each of which issues a
+// collective-permute and an all-gather on the previous layer and combines
+// their results with some elementwise work that can hide their latency.
+std::string MakeCollectiveHeavyModuleText(int num_layers) {
+  std::string text = R"(
+HloModule module, is_scheduled=true
+
+ENTRY entry {
+  x.0 = f32[1024] parameter(0)
+)";
+  for (int i = 1; i <= num_layers; ++i) {
+    absl::StrAppendFormat(
+        &text,
+        "  cp.%1$d = f32[1024] collective-permute(x.%2$d), "
+        "source_target_pairs={{0,1},{1,0}}\n"
+        "  ag.%1$d = f32[2048] all-gather(x.%2$d), dimensions={0}, "
+        "replica_groups={{0,1}}\n"
+        "  m.%1$d = f32[1024] multiply(x.%2$d, x.%2$d)\n"
+        "  s.%1$d = f32[1024] slice(ag.%1$d), slice={[0:1024]}\n"
+        "  a.%1$d = f32[1024] add(m.%1$d, cp.%1$d)\n"
+        "  x.%1$d = f32[1024] add(a.%1$d, s.%1$d)\n",
+        i, i - 1);
+  }
+  absl::StrAppendFormat(&text, "  ROOT r = f32[1024] negate(x.%d)\n}\n",
+                        num_layers);
+  return text;
+}
+
+void BM_ScheduleCollectiveHeavyModule(::testing::benchmark::State& state) {
+  const std::string text = MakeCollectiveHeavyModuleText(state.range(0));
+  double makespan = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<HloModule> module =
+        ParseAndReturnUnverifiedModule(text).value();
+    state.ResumeTiming();
+    CHECK_OK(RunScheduler(module.get()).status());
+    state.PauseTiming();
+    ApproximateLatencyEstimator latency_estimator;
+    AsyncTracker async_tracker(GetDefaultSchedConfig());
+    makespan = LatencyHidingScheduler::LatencyHidingStatistics(
+                   module->entry_computation(), &latency_estimator,
+                   &async_tracker,
+                   [](const Shape& shape) {
+                     return ShapeUtil::ByteSizeOfElements(shape);
+                   })
+                   .total_cycles;
+    state.ResumeTiming();
+  }
+  state.SetLabel(absl::StrCat("makespan=", makespan));
+}
+
+BENCHMARK(BM_ScheduleCollectiveHeavyModule)->Range(8, 1024);
+
+}  // namespace
+
 }  // namespace xla
@@ -96,6 +96,10 @@ int main(int argc, char* argv[]) {
                 "complete. See export_hlo.h for more on uploads."),
       tsl::Flag("result_output_file", &options.result_output_file,
                 "File to write a serialized xla.CompilationResult proto to."),
+      tsl::Flag("print_top_passes", &options.print_top_passes,
+                "If positive, print how long this many of the slowest HLO "
+                "passes took, with their memory growth and change in HLO "
+                "size."),
   };
 
   tsl::string usage = xla::xla_compile::kUsageHeader;
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <optional>
@@ -25,6 +26,7 @@ limitations under the License.
 #include <utility>
 
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_casting_utils.h"
 #include "xla/hlo/ir/hlo_instructions.h"
 #include "xla/literal_util.h"
@@ -33,6 +35,8 @@ limitations under the License.
 #include "xla/service/hlo_verifier.h"
 #include "xla/service/transfer_manager.h"
 #include "xla/xla_data.pb.h"
+#include "tsl/lib/random/philox_random.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -217,6 +221,97 @@ void PopulateWithRandomIntegralDataWithBounds(Literal* literal,
   }
 }
 
+// Elements are generated in chunks of a fixed size, each of which can be
+// filled by a different thread. Element `i` of an array is always computed
+// from the same Philox counter, so the contents do not depend on how chunks
+// are assigned to threads.
+constexpr int64_t kPhiloxElementsPerChunk = 1 << 14;
+constexpr int64_t kPhiloxElementsPerBatch = 64;
+
+// Fills `data` from the Philox stream identified by `seed` and `stream`.
+// Every element is built by `value_fn` from its own `sizeof(NativeT) / 4`
+// (at least one) consecutive 32-bit words of the stream.
+template <typename NativeT, typename ValueFn>
+void FillWithPhiloxData(absl::Span<NativeT> data, uint64_t seed,
+                        uint64_t stream, tsl::thread::ThreadPool* thread_pool,
+                        ValueFn value_fn) {
+  constexpr int64_t kWordsPerElement =
+      std::max<int64_t>(1, sizeof(NativeT) / sizeof(uint32_t));
+  constexpr int64_t kWordsPerBatch =
+      kPhiloxElementsPerBatch * kWordsPerElement;
+  constexpr int64_t kWordsPerSample =
+      tsl::random::PhiloxRandom::kResultElementCount;
+  static_assert(kPhiloxElementsPerChunk * kWordsPerElement % kWordsPerSample ==
+                0);
+  static_assert(kWordsPerBatch % kWordsPerSample == 0);
+
+  const int64_t size = data.size();
+  const int64_t num_chunks =
+      (size + kPhiloxElementsPerChunk - 1) / kPhiloxElementsPerChunk;
+  auto fill_chunks = [&](int64_t first_chunk, int64_t last_chunk) {
+    uint32_t words[kWordsPerBatch];
+    for (int64_t chunk = first_chunk; chunk < last_chunk; ++chunk) {
+      const int64_t begin = chunk * kPhiloxElementsPerChunk;
+      const int64_t end = std::min(size, begin + kPhiloxElementsPerChunk);
+      tsl::random::PhiloxRandom philox(seed, stream);
+      philox.Skip(begin * kWordsPerElement / kWordsPerSample);
+      for (int64_t i = begin; i < end; i += kPhiloxElementsPerBatch) {
+        for (int64_t w = 0; w < kWordsPerBatch; w += kWordsPerSample) {
+          const tsl::random::PhiloxRandom::ResultType sample = philox();
+          for (int64_t j = 0; j < kWordsPerSample; ++j) {
+            words[w + j] = sample[j];
+          }
+        }
+        const int64_t n = std::min(kPhiloxElementsPerBatch, end - i);
+        NativeT* out = data.data() + i;
+        for (int64_t j = 0; j < n; ++j) {
+          out[j] = value_fn(&words[j * kWordsPerElement]);
+        }
+      }
+    }
+  };
+  if (thread_pool == nullptr || num_chunks <= 1) {
+    fill_chunks(0, num_chunks);
+    return;
+  }
+  thread_pool->ParallelFor(
+      num_chunks,
+      kPhiloxElementsPerChunk * tsl::random::PhiloxRandom::kElementCost,
+      fill_chunks);
+}
+
+// Returns a value in [0, 1) built from one 32-bit word, or from two for
+// 64-bit floating point types.
+template <typename FloatT>
+double PhiloxUnitInterval(const uint32_t* words) {
+  if constexpr (sizeof(FloatT) >= sizeof(double)) {
+    const uint64_t bits =
+        (static_cast<uint64_t>(words[0]) << 21) ^ (words[1] >> 11);
+    return static_cast<double>(bits) * 0x1.0p-53;
+  } else {
+    return static_cast<double>(words[0] >> 8) * 0x1.0p-24;
+  }
+}
+
+// Returns the floating point value for the given words, sampled the same way
+// as PopulateWithRandomFloatingPointData, or as
+// PopulateWithRandomFullRangeFloatingPointData without the special values if
+// `use_large_range` is set.
+template <typename FloatT>
+FloatT PhiloxFloatingPoint(const uint32_t* words, bool use_large_range) {
+  const double unit = PhiloxUnitInterval<FloatT>(words);
+  if (!use_large_range) {
+    return static_cast<FloatT>(-0.1 + 0.3 * unit);
+  }
+  constexpr double kMinExp = std::numeric_limits<FloatT>::min_exponent - 1;
+  constexpr double kMaxExp = std::numeric_limits<FloatT>::max_exponent - 1;
+  // PhiloxUnitInterval does not use the low bits of its last word.
+  constexpr int kSignWord = sizeof(FloatT) >= sizeof(double) ? 1 : 0;
+  const double sign = (words[kSignWord] & 1) ? -1.0 : 1.0;
+  return static_cast<FloatT>(
+      sign * std::exp2(kMinExp + (kMaxExp - kMinExp) * unit));
+}
+
 // Similar to MakeFakeLiteral but takes a random number generator engine to
 // enable reusing the engine across randomly generated literals.
 // 'limit' is a optional pair that contains the min and the max values to be
@@ -321,6 +416,101 @@ absl::StatusOr<Literal> MakeFakeLiteralInternal(
   return std::move(literal);
 }
 
+// Like MakeFakeLiteralInternal, but fills arrays with FillWithPhiloxData.
+// Every array in `shape` is generated from its own stream, starting at
+// `*stream`, which is advanced past the streams that were used.
+absl::StatusOr<Literal> MakeFakeLiteralWithSeedInternal(
+    const Shape& shape, uint64_t seed, uint64_t* stream, bool use_large_range,
+    tsl::thread::ThreadPool* thread_pool) {
+  if (shape.IsTuple()) {
+    std::vector<Literal> elements;
+    const auto& shape_tuple_shapes = shape.tuple_shapes();
+    elements.reserve(shape_tuple_shapes.size());
+    for (const Shape& element_shape : shape_tuple_shapes) {
+      TF_ASSIGN_OR_RETURN(
+          Literal element,
+          MakeFakeLiteralWithSeedInternal(element_shape, seed, stream,
+                                          use_large_range, thread_pool));
+      elements.push_back(std::move(element));
+    }
+    return LiteralUtil::MakeTupleOwned(std::move(elements));
+  }
+  Shape new_shape = shape;
+  new_shape.mutable_layout()->clear_tiles();
+  new_shape.mutable_layout()->set_tail_padding_alignment_in_elements(1);
+  new_shape.mutable_layout()->set_element_size_in_bits(0);
+  Literal literal(new_shape);
+  const uint64_t array_stream = (*stream)++;
+
+  TF_RETURN_IF_ERROR(primitive_util::PrimitiveTypeSwitch<absl::Status>(
+      [&](auto primitive_type_constant) -> absl::Status {
+        if constexpr (primitive_util::IsArrayType(primitive_type_constant)) {
+          using NativeT = primitive_util::NativeTypeOf<primitive_type_constant>;
+          absl::Span<NativeT> data = literal.data<NativeT>();
+          if constexpr (primitive_util::IsFloatingPointType(
+                            primitive_type_constant)) {
+            FillWithPhiloxData(data, seed, array_stream, thread_pool,
+                               [&](const uint32_t* words) {
+                                 return PhiloxFloatingPoint<NativeT>(
+                                     words, use_large_range);
+                               });
+            return absl::OkStatus();
+          }
+          if constexpr (primitive_type_constant == PRED) {
+            FillWithPhiloxData(
+                data, seed, array_stream, thread_pool,
+                [](const uint32_t* words) { return (words[0] & 1) != 0; });
+            return absl::OkStatus();
+          }
+          if constexpr (primitive_util::IsIntegralType(
+                            primitive_type_constant)) {
+            if constexpr (sizeof(NativeT) == sizeof(uint64_t)) {
+              FillWithPhiloxData(data, seed, array_stream, thread_pool,
+                                 [](const uint32_t* words) {
+                                   return static_cast<NativeT>(
+                                       (static_cast<uint64_t>(words[0]) << 32) |
+                                       words[1]);
+                                 });
+            } else {
+              // The number of values of every narrower type is a power of two.
+              const int64_t lowest =
+                  static_cast<int64_t>(std::numeric_limits<NativeT>::lowest());
+              const uint32_t mask = static_cast<uint32_t>(
+                  static_cast<int64_t>(std::numeric_limits<NativeT>::max()) -
+                  lowest);
+              FillWithPhiloxData(data, seed, array_stream, thread_pool,
+                                 [&](const uint32_t* words) {
+                                   return static_cast<NativeT>(
+                                       lowest + (words[0] & mask));
+                                 });
+            }
+            return absl::OkStatus();
+          }
+          if constexpr (primitive_util::IsComplexType(
+                            primitive_type_constant)) {
+            using InnerFloatT = typename NativeT::value_type;
+            constexpr int64_t kWordsPerComponent =
+                std::max<int64_t>(1, sizeof(InnerFloatT) / sizeof(uint32_t));
+            FillWithPhiloxData(
+                data, seed, array_stream, thread_pool,
+                [&](const uint32_t* words) {
+                  return NativeT(PhiloxFloatingPoint<InnerFloatT>(
+                                     words, use_large_range),
+                                 PhiloxFloatingPoint<InnerFloatT>(
+                                     words + kWordsPerComponent,
+                                     use_large_range));
+                });
+            return absl::OkStatus();
+          }
+        }
+        return Unimplemented(
+            "Unsupported type for fake random literal generation: %s",
+            ShapeUtil::HumanString(shape));
+      },
+      shape.element_type()));
+  return std::move(literal);
+}
+
 enum class ConstantType { kUnknown, kZero, kOne };
 
 // Return the constant type required by this computation, if known.
@@ -651,6 +841,55 @@ absl::StatusOr<std::vector<Literal>> MakeFakeArguments(
   return std::move(arguments);
 }
 
+absl::StatusOr<Literal> MakeFakeLiteralWithSeed(
+    const Shape& shape, uint64_t seed, bool use_large_range,
+    tsl::thread::ThreadPool* thread_pool) {
+  uint64_t stream = 0;
+  return MakeFakeLiteralWithSeedInternal(shape, seed, &stream, use_large_range,
+                                         thread_pool);
+}
+
+absl::StatusOr<std::vector<Literal>> MakeFakeArgumentsWithSeed(
+    const HloModule* module, uint64_t seed, bool use_large_range,
+    bool treat_gte_as_data_formatting, tsl::thread::ThreadPool* thread_pool) {
+  TF_ASSIGN_OR_RETURN(auto dataflow, HloDataflowAnalysis::Run(*module));
+  const auto params = module->entry_computation()->parameter_instructions();
+  const HloModuleConfig& module_config = module->config();
+  std::vector<Literal> arguments(params.size());
+  for (int i = 0; i < params.size(); ++i) {
+    const Shape& param_shape = (module_config.has_entry_computation_layout() &&
+                                module_config.entry_computation_layout()
+                                    .parameter_layout(i)
+                                    .shape()
+                                    .is_static())
+                                   ? module_config.entry_computation_layout()
+                                         .parameter_layout(i)
+                                         .shape()
+                                   : params[i]->shape();
+    const auto constrained_uses = FindConstrainedUses(
+        *dataflow, *params[i], treat_gte_as_data_formatting);
+    if (constrained_uses.empty()) {
+      // Give every parameter its own range of streams, so that its data does
+      // not depend on the other parameters.
+      uint64_t stream = static_cast<uint64_t>(i) << 32;
+      TF_ASSIGN_OR_RETURN(
+          arguments[i],
+          MakeFakeLiteralWithSeedInternal(param_shape, seed, &stream,
+                                          use_large_range, thread_pool));
+      continue;
+    }
+    // Constrained parameters are usually small (indices and init values), so
+    // they are generated sequentially with an engine of their own.
+    std::minstd_rand0 engine(seed + i);
+    TF_ASSIGN_OR_RETURN(arguments[i], CreateLiteralForConstrainedUses(
+                                          constrained_uses, *params[i],
+                                          param_shape, &engine, use_large_range,
+                                          /*max_bits_of_precision=*/
+                                          std::nullopt));
+  }
+  return std::move(arguments);
+}
+
 absl::Status VerifyHloModule(HloModule* const module, bool layout_sensitive,
                              bool allow_mixed_precision) {
   return HloVerifier(/*layout_sensitive=*/layout_sensitive,
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef XLA_TESTS_TEST_UTILS_H_
 #define XLA_TESTS_TEST_UTILS_H_
 
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <optional>
@@ -31,6 +32,7 @@ limitations under the License.
 #include "xla/literal.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/protobuf.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 
@@ -112,6 +114,28 @@ absl::StatusOr<std::vector<Literal>> MakeFakeArguments(
     bool use_large_range = false, bool treat_gte_as_data_formatting = false,
     std::optional<int64_t> max_bits_of_precision = std::nullopt);
 
+// Generates fake data in a literal of the given shape with a counter-based
+// (Philox) generator, so that large literals can be filled in parallel on
+// `thread_pool`. Every element is a function of `seed` and of its position
+// only, so the result does not depend on the thread pool or its size.
+//
+// Floating point numbers are sampled as described for MakeFakeArguments,
+// except that no special values are generated when use_large_range is true.
+// Integers are sampled from the whole range of their type.
+absl::StatusOr<Literal> MakeFakeLiteralWithSeed(
+    const Shape& shape, uint64_t seed, bool use_large_range = false,
+    tsl::thread::ThreadPool* thread_pool = nullptr);
+
+// Like MakeFakeArguments, but generates the data of every parameter without
+// constrained uses with MakeFakeLiteralWithSeed. Parameters that are indices,
+// init values or sort keys are generated as by MakeFakeArguments, parameter i
+// from its own std::minstd_rand0 engine seeded with `seed + i`. The arguments
+// only depend on the module and on `seed`.
+absl::StatusOr<std::vector<Literal>> MakeFakeArgumentsWithSeed(
+    const HloModule* module, uint64_t seed, bool use_large_range = false,
+    bool treat_gte_as_data_formatting = false,
+    tsl::thread::ThreadPool* thread_pool = nullptr);
+
 // Check that a given module satisfies various constraints before trying to
 // execute it.
 absl::Status VerifyHloModule(HloModule* const module, bool layout_sensitive,
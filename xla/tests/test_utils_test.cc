@@ -15,16 +15,22 @@ limitations under the License.
 
 #include "xla/tests/test_utils.h"
 
+#include <cmath>
+#include <cstdint>
 #include <vector>
 
 #include "absl/base/casts.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/log/check.h"
 #include "xla/client/xla_builder.h"
 #include "xla/service/hlo_parser.h"
 #include "xla/shape_util.h"
 #include "xla/tests/local_client_test_base.h"
 #include "xla/tests/test_macros.h"
 #include "xla/tsl/lib/core/status_test_util.h"
+#include "tsl/platform/env.h"
+#include "tsl/platform/test_benchmark.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -347,5 +353,93 @@ ENTRY main {
   }
 }
 
+XLA_TEST_F(TestUtilsTest, MakeFakeLiteralWithSeedIgnoresThreadPool) {
+  Shape shape = ShapeUtil::MakeTupleShape(
+      {ShapeUtil::MakeShape(F32, {300, 301}), ShapeUtil::MakeShape(BF16, {7}),
+       ShapeUtil::MakeShape(F64, {40000}), ShapeUtil::MakeShape(C64, {5000}),
+       ShapeUtil::MakeShape(S8, {70000}), ShapeUtil::MakeShape(U64, {3}),
+       ShapeUtil::MakeShape(PRED, {50000})});
+  TF_ASSERT_OK_AND_ASSIGN(Literal expected,
+                          MakeFakeLiteralWithSeed(shape, /*seed=*/42));
+  for (int num_threads : {1, 3, 8}) {
+    tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", num_threads);
+    TF_ASSERT_OK_AND_ASSIGN(
+        Literal actual,
+        MakeFakeLiteralWithSeed(shape, /*seed=*/42,
+                                /*use_large_range=*/false, &pool));
+    EXPECT_EQ(actual, expected);
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(Literal other,
+                          MakeFakeLiteralWithSeed(shape, /*seed=*/43));
+  EXPECT_NE(other, expected);
+  for (float value : expected.data<float>({0})) {
+    EXPECT_GE(value, -0.1f);
+    EXPECT_LE(value, 0.2f);
+  }
+}
+
+XLA_TEST_F(TestUtilsTest, MakeFakeLiteralWithSeedLargeRange) {
+  Shape shape = ShapeUtil::MakeShape(F32, {10000});
+  TF_ASSERT_OK_AND_ASSIGN(
+      Literal literal,
+      MakeFakeLiteralWithSeed(shape, /*seed=*/0, /*use_large_range=*/true));
+  int64_t num_negative = 0;
+  int64_t num_large = 0;
+  for (float value : literal.data<float>()) {
+    num_negative += value < 0;
+    num_large += std::abs(value) > 1e10f;
+  }
+  EXPECT_GT(num_negative, 4000);
+  EXPECT_LT(num_negative, 6000);
+  EXPECT_GT(num_large, 0);
+}
+
+XLA_TEST_F(TestUtilsTest, MakeFakeArgumentsWithSeed) {
+  auto module = ParseAndReturnVerifiedModule(R"(
+    HloModule m
+
+    ENTRY e {
+      index = s32[] parameter(0)
+      array = f32[123,4] parameter(1)
+      other = f32[123,4] parameter(2)
+      sum = f32[123,4] add(array, other)
+      ROOT slice = f32[1,4] dynamic-slice(sum, index, index),
+        dynamic_slice_sizes={1,4}
+    })")
+                    .value();
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<Literal> args,
+                          MakeFakeArgumentsWithSeed(module.get(), /*seed=*/7));
+  ASSERT_EQ(args.size(), 3);
+  EXPECT_GE(args[0].Get<int32_t>({}), 0);
+  EXPECT_LE(args[0].Get<int32_t>({}), 122);
+  EXPECT_NE(args[1], args[2]);
+
+  tsl::thread::ThreadPool pool(tsl::Env::Default(), "test", 4);
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::vector<Literal> args_on_pool,
+      MakeFakeArgumentsWithSeed(module.get(), /*seed=*/7,
+                                /*use_large_range=*/false,
+                                /*treat_gte_as_data_formatting=*/false, &pool));
+  EXPECT_EQ(args_on_pool, args);
+}
+
+void BM_MakeFakeLiteral(::testing::benchmark::State& state) {
+  const bool use_seed = state.range(0) != 0;
+  Shape shape = ShapeUtil::MakeShape(F32, {1024, 1024});
+  tsl::thread::ThreadPool pool(tsl::Env::Default(), "bench", 8);
+  for (auto s : state) {
+    if (use_seed) {
+      CHECK_OK(MakeFakeLiteralWithSeed(shape, /*seed=*/0,
+                                       /*use_large_range=*/false, &pool)
+                   .status());
+    } else {
+      CHECK_OK(MakeFakeLiteral(shape).status());
+    }
+  }
+}
+
+BENCHMARK(BM_MakeFakeLiteral)->Arg(0)->Arg(1);
+
 }  // namespace
 }  // namespace xla
@@ -14,18 +14,26 @@ limitations under the License.
 ==============================================================================*/
 
 // Usage: convert_computation <txt2bin|bin2txt> serialized_computation_proto
+//        convert_computation <bin2chunks|chunks2bin> input_path output_path
 //
 // bin2txt spits out the result to stdout. txt2bin modifies the file in place.
+// bin2chunks and chunks2bin convert between a binary HloSnapshot and the
+// chunked module format (see xla/service/hlo_module_chunks.h).
 #ifndef _WIN32
 #include <unistd.h>
 #endif
 #include <stdio.h>
 
+#include <memory>
 #include <string>
 
 #include "absl/status/statusor.h"
+#include "xla/hlo/ir/hlo_module.h"
 #include "xla/service/hlo.pb.h"
+#include "xla/service/hlo_module_chunks.h"
+#include "xla/service/hlo_module_config.h"
 #include "xla/types.h"
+#include "xla/xla.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/init_main.h"
 #include "tsl/platform/logging.h"
@@ -34,6 +42,32 @@ limitations under the License.
 namespace xla {
 namespace tools {
 
+void ConvertChunks(const std::string& mode, const std::string& input_path,
+                   const std::string& output_path) {
+  tsl::Env* env = tsl::Env::Default();
+  if (mode == "bin2chunks") {
+    HloSnapshot snapshot;
+    TF_CHECK_OK(tsl::ReadBinaryProto(env, input_path, &snapshot));
+    const HloModuleProto& proto = snapshot.hlo().hlo_module();
+    HloModuleConfig config =
+        HloModule::CreateModuleConfigFromProto(proto, DebugOptions()).value();
+    std::unique_ptr<HloModule> module =
+        HloModule::CreateFromProto(proto, config).value();
+    TF_CHECK_OK(WriteHloModuleChunksToFile(*module, output_path));
+  } else if (mode == "chunks2bin") {
+    std::unique_ptr<HloModuleChunksReader> reader =
+        HloModuleChunksReader::OpenFile(input_path, env).value();
+    HloModuleConfig config =
+        reader->CreateModuleConfig(DebugOptions()).value();
+    std::unique_ptr<HloModule> module = reader->ToModule(config).value();
+    HloSnapshot snapshot;
+    *snapshot.mutable_hlo()->mutable_hlo_module() = module->ToProto();
+    TF_CHECK_OK(tsl::WriteBinaryProto(env, output_path, snapshot));
+  } else {
+    LOG(QFATAL) << "unknown mode for computation conversion: " << mode;
+  }
+}
+
 void RealMain(const std::string& mode, const std::string& path) {
   HloSnapshot module;
   tsl::Env* env = tsl::Env::Default();
@@ -56,7 +90,13 @@ void RealMain(const std::string& mode, const std::string& path) {
 int main(int argc, char** argv) {
   tsl::port::InitMain(argv[0], &argc, &argv);
 
-  QCHECK_EQ(argc, 3) << "usage: " << argv[0] << " <txt2bin|bin2txt> <path>";
+  if (argc == 4) {
+    xla::tools::ConvertChunks(argv[1], argv[2], argv[3]);
+    return 0;
+  }
+  QCHECK_EQ(argc, 3) << "usage: " << argv[0]
+                     << " <txt2bin|bin2txt> <path> | "
+                        "<bin2chunks|chunks2bin> <input_path> <output_path>";
   xla::tools::RealMain(argv[1], argv[2]);
   return 0;
 }
@@ -29,6 +29,7 @@ limitations under the License.
 #include "xla/debug_options_flags.h"
 #include "xla/hlo/ir/hlo_computation.h"
 #include "xla/hlo/ir/hlo_instruction.h"
+#include "xla/service/hlo_module_chunks.h"
 #include "xla/service/hlo_module_config.h"
 #include "xla/service/hlo_parser.h"
 #include "tsl/platform/env.h"
@@ -46,6 +47,19 @@ absl::Status OverrideConfig(const hlo_module_loader_details::Config& ovr_config,
   return absl::OkStatus();
 }
 
+absl::StatusOr<std::unique_ptr<HloModule>> LoadModuleFromChunks(
+    const HloModuleChunksReader& reader,
+    const hlo_module_loader_details::Config& ovr_config,
+    const std::function<void(HloModuleConfig*)>& config_modifier_hook) {
+  TF_ASSIGN_OR_RETURN(HloModuleConfig config,
+                      reader.CreateModuleConfig(GetDebugOptionsFromFlags()));
+  TF_RETURN_IF_ERROR(OverrideConfig(ovr_config, &config));
+  if (config_modifier_hook) {
+    config_modifier_hook(&config);
+  }
+  return reader.ToModule(config);
+}
+
 }  // namespace
 
 std::string StripLogHeaders(std::string_view hlo_string) {
@@ -83,6 +97,11 @@ absl::StatusOr<std::unique_ptr<HloModule>> LoadModuleFromData(
     }
     TF_ASSIGN_OR_RETURN(module,
                         ParseAndReturnUnverifiedModule(hlo_string, config));
+  } else if (format == "hlochunks") {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<HloModuleChunksReader> reader,
+                        HloModuleChunksReader::FromData(data));
+    TF_ASSIGN_OR_RETURN(module, LoadModuleFromChunks(*reader, ovr_config,
+                                                     config_modifier_hook));
   } else {
     HloSnapshot proto;
     if (format == "pb") {
@@ -110,7 +129,7 @@ absl::StatusOr<std::unique_ptr<HloModule>> LoadModuleFromData(
     } else {
       return InvalidArgument(
           "Invalid format from file extension: '%s'. Expected: hlo, txt, pb, "
-          "or pbtxt",
+          "pbtxt or hlochunks",
           format);
     }
     TF_ASSIGN_OR_RETURN(HloModuleConfig config,
@@ -135,6 +154,11 @@ absl::StatusOr<std::unique_ptr<HloModule>> LoadModuleFromFile(
   if (format.empty()) {
     format = std::string(tsl::io::Extension(path));
   }
+  if (format == "hlochunks") {
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<HloModuleChunksReader> reader,
+                        HloModuleChunksReader::OpenFile(path));
+    return LoadModuleFromChunks(*reader, ovr_config, config_modifier_hook);
+  }
   TF_RETURN_IF_ERROR(tsl::ReadFileToString(tsl::Env::Default(), path, &data));
   return LoadModuleFromData(data, format, ovr_config, config_modifier_hook,
                             buffer_assignment_proto);
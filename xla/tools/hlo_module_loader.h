@@ -49,6 +49,8 @@ std::string StripLogHeaders(std::string_view hlo_string);
 // 2) A hlo text dump, the string should be in HloModule::ToString() format
 //    (format must be "txt" or "hlo"). The input data can also contain log
 //    headers, which will be stripped.
+// 3) A module in the chunked binary format written by WriteHloModuleChunks
+//    (format must be "hlochunks").
 // The ovr_config data can be used to override certain fields of the
 // HloModuleConfig.
 // The HloModuleConfig is passed to config_modifier_hook for custom
@@ -70,6 +72,9 @@ absl::StatusOr<std::unique_ptr<HloModule>> LoadModuleFromData(
 // 2) A hlo text dump, the string should be in HloModule::ToString() format
 //    (with a .hlo or .txt extension). A text file can also contain log headers,
 //    which will be stripped.
+// 3) A module in the chunked binary format written by WriteHloModuleChunks
+//    (with a .hlochunks extension). The file is memory-mapped rather than read
+//    into memory.
 // If the format is specified (not empty), it overrides the one guessed from the
 // file extension. The ovr_config data can be used to override certain fields of
 // the HloModuleConfig.
@@ -15,9 +15,13 @@ limitations under the License.
 
 #include "xla/tools/run_hlo_module.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
 #include <optional>
@@ -28,12 +32,17 @@ limitations under the License.
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "xla/error_spec.h"
 #include "xla/hlo/ir/hlo_instruction.h"
@@ -41,9 +50,13 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_opcode.h"
 #include "xla/literal.h"
 #include "xla/literal_comparison.h"
+#include "xla/primitive_util.h"
+#include "xla/service/executable.h"
 #include "xla/service/hlo.pb.h"
 #include "xla/service/hlo_module_config.h"
 #include "xla/service/hlo_verifier.h"
+#include "xla/shape.h"
+#include "xla/shape_util.h"
 #include "xla/tests/test_utils.h"
 #include "xla/tools/hlo_control_flow_flattening.h"
 #include "xla/tools/hlo_decomposer.h"
@@ -54,9 +67,11 @@ limitations under the License.
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/errors.h"
+#include "tsl/platform/fingerprint.h"
 #include "tsl/platform/path.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/statusor.h"
+#include "tsl/platform/threadpool.h"
 
 namespace xla {
 namespace {
@@ -459,6 +474,211 @@ absl::Status RunIsolatedAndCompare(
   return status;
 }
 
+// Returns the largest absolute difference between the floating-point elements
+// of 'expected' and 'actual'. Elements that are equal (including the same
+// infinity) or NaN in both are ignored, and a NaN in only one of them counts as
+// an infinite difference.
+double MaxAbsError(const LiteralSlice& expected, const LiteralSlice& actual) {
+  double max_error = 0;
+  ShapeUtil::ForEachSubshape(
+      expected.shape(), [&](const Shape& subshape, const ShapeIndex& index) {
+        if (!subshape.IsArray() ||
+            !primitive_util::IsFloatingPointType(subshape.element_type()) ||
+            !ShapeUtil::Compatible(
+                subshape, ShapeUtil::GetSubshape(actual.shape(), index))) {
+          return;
+        }
+        absl::StatusOr<Literal> expected_f64 =
+            LiteralSlice(expected, index).Convert(F64);
+        absl::StatusOr<Literal> actual_f64 = LiteralSlice(actual, index)
+                                                 .Relayout(subshape.layout())
+                                                 .Convert(F64);
+        if (!expected_f64.ok() || !actual_f64.ok()) {
+          return;
+        }
+        absl::Span<const double> expected_data = expected_f64->data<double>();
+        absl::Span<const double> actual_data = actual_f64->data<double>();
+        for (int64_t i = 0; i < expected_data.size(); ++i) {
+          if (expected_data[i] == actual_data[i] ||
+              (std::isnan(expected_data[i]) && std::isnan(actual_data[i]))) {
+            continue;
+          }
+          double error = std::abs(expected_data[i] - actual_data[i]);
+          if (std::isnan(error)) {
+            error = std::numeric_limits<double>::infinity();
+          }
+          max_error = std::max(max_error, error);
+        }
+      });
+  return max_error;
+}
+
+// State shared by the workers of RunAndCompareBatch.
+struct BatchState {
+  HloRunnerInterface* test_runner;
+  HloRunnerInterface* reference_runner;
+  const RunHloModuleOptions* options;
+  std::function<absl::Status(const HloModule&, HloRunnerInterface*,
+                             HloModule*)>
+      reference_module_modifier_hook;
+
+  absl::Mutex test_execution_mu;
+  absl::Mutex reference_execution_mu;
+
+  absl::Mutex arguments_mu;
+  absl::flat_hash_map<std::string, std::shared_ptr<const std::vector<Literal>>>
+      arguments_by_fingerprint ABSL_GUARDED_BY(arguments_mu);
+};
+
+// Returns the arguments for 'module', which has the given fingerprint,
+// generating them unless a module with the same fingerprint was seen before.
+absl::StatusOr<std::shared_ptr<const std::vector<Literal>>> GetBatchArguments(
+    const HloModule& module, const std::string& fingerprint, BatchState& state,
+    bool* from_cache) {
+  {
+    absl::MutexLock lock(&state.arguments_mu);
+    auto it = state.arguments_by_fingerprint.find(fingerprint);
+    if (it != state.arguments_by_fingerprint.end()) {
+      *from_cache = true;
+      return it->second;
+    }
+  }
+  *from_cache = false;
+  // Seeding from the fingerprint makes the arguments independent of the order
+  // in which the workers pick up modules.
+  std::unique_ptr<std::minstd_rand0> engine;
+  if (state.options->random_init_input_literals) {
+    engine = std::make_unique<std::minstd_rand0>(
+        tsl::Fingerprint64(fingerprint) % std::minstd_rand0::modulus);
+  }
+  TF_ASSIGN_OR_RETURN(
+      std::vector<Literal> arguments,
+      MakeFakeArguments(&module, engine.get(),
+                        state.options->use_large_float_range,
+                        state.options->treat_gte_as_data_formatting));
+  auto shared =
+      std::make_shared<const std::vector<Literal>>(std::move(arguments));
+  absl::MutexLock lock(&state.arguments_mu);
+  return state.arguments_by_fingerprint.try_emplace(fingerprint, shared)
+      .first->second;
+}
+
+// Runs 'executable' on 'runner' while holding 'mu', and sets 'seconds' to the
+// time it took.
+absl::StatusOr<Literal> ExecuteTimed(HloRunnerInterface* runner,
+                                     Executable* executable,
+                                     absl::Span<const Literal> arguments,
+                                     absl::Mutex& mu, double* seconds) {
+  absl::MutexLock lock(&mu);
+  const absl::Time start = absl::Now();
+  absl::StatusOr<Literal> result =
+      runner->ExecuteWithExecutable(executable, arguments);
+  *seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  return result;
+}
+
+absl::Status RunBatchModule(const std::string& hlo_filename, BatchState& state,
+                            RunHloModuleBatchEntry& entry) {
+  const RunHloModuleOptions& options = *state.options;
+  auto config_modifier_hook = [](HloModuleConfig* config) {
+    config->set_seed(42);
+  };
+  TF_ASSIGN_OR_RETURN(
+      std::unique_ptr<HloModule> test_module,
+      LoadModuleFromFile(hlo_filename, options.input_format,
+                         hlo_module_loader_details::Config(),
+                         config_modifier_hook));
+  TF_RETURN_IF_ERROR(VerifyHloModule(test_module.get(),
+                                     /*layout_sensitive=*/false,
+                                     /*allow_mixed_precision=*/true));
+  if (options.flatten_control_flow) {
+    HloControlFlowFlattening control_flow_flattening(
+        HloControlFlowFlattening::Options{/*while_execution_count=*/1});
+    TF_RETURN_IF_ERROR(control_flow_flattening.Run(test_module.get()).status());
+  }
+
+  entry.set_fingerprint(test_module->GetFingerprint128());
+  bool arguments_from_cache = false;
+  TF_ASSIGN_OR_RETURN(std::shared_ptr<const std::vector<Literal>> arguments,
+                      GetBatchArguments(*test_module, entry.fingerprint(),
+                                        state, &arguments_from_cache));
+  entry.set_arguments_from_cache(arguments_from_cache);
+
+  std::unique_ptr<HloModule> reference_module;
+  if (state.reference_runner != nullptr) {
+    TF_ASSIGN_OR_RETURN(reference_module,
+                        PrepareReferenceModule(
+                            *test_module, state.test_runner,
+                            config_modifier_hook,
+                            state.reference_module_modifier_hook));
+    // TODO(b/323849999) Use original computation for the reference platform.
+    if (reference_module->entry_computation()->root_instruction()->opcode() ==
+        HloOpcode::kCustomCall) {
+      reference_module = nullptr;
+    }
+  }
+
+  // Compile the reference module on a separate thread while the test module
+  // is compiled on this one.
+  const bool run_reference = reference_module != nullptr;
+  absl::StatusOr<std::unique_ptr<Executable>> reference_executable;
+  double reference_compile_seconds = 0;
+  std::unique_ptr<tsl::Thread> reference_compile_thread;
+  if (run_reference) {
+    reference_compile_thread.reset(tsl::Env::Default()->StartThread(
+        tsl::ThreadOptions(), "compile_reference", [&] {
+          const absl::Time start = absl::Now();
+          reference_executable = state.reference_runner->CreateExecutable(
+              std::move(reference_module), options.run_reference_hlo_passes);
+          reference_compile_seconds =
+              absl::ToDoubleSeconds(absl::Now() - start);
+        }));
+  }
+  const absl::Time start = absl::Now();
+  absl::StatusOr<std::unique_ptr<Executable>> test_executable =
+      state.test_runner->CreateExecutable(std::move(test_module),
+                                          options.run_test_hlo_passes);
+  entry.set_test_compile_seconds(absl::ToDoubleSeconds(absl::Now() - start));
+  // Joins the thread.
+  reference_compile_thread = nullptr;
+  entry.set_reference_compile_seconds(reference_compile_seconds);
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(
+      test_executable.status(),
+      absl::StrCat("Failed to compile on ", state.test_runner->Name()));
+
+  double seconds = 0;
+  absl::StatusOr<Literal> test_result =
+      ExecuteTimed(state.test_runner, test_executable->get(), *arguments,
+                   state.test_execution_mu, &seconds);
+  entry.set_test_run_seconds(seconds);
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(
+      test_result.status(),
+      absl::StrCat("Failed to execute on ", state.test_runner->Name()));
+
+  if (!run_reference) {
+    return absl::OkStatus();
+  }
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(
+      reference_executable.status(),
+      absl::StrCat("Failed to compile on ", state.reference_runner->Name()));
+  absl::StatusOr<Literal> reference_result =
+      ExecuteTimed(state.reference_runner, reference_executable->get(),
+                   *arguments, state.reference_execution_mu, &seconds);
+  entry.set_reference_run_seconds(seconds);
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(
+      reference_result.status(),
+      absl::StrCat("Failed to execute on ", state.reference_runner->Name()));
+
+  entry.set_max_abs_error(MaxAbsError(*reference_result, *test_result));
+  ErrorSpec error_spec(static_cast<float>(options.abs_error_bound),
+                       static_cast<float>(options.rel_error_bound));
+  return literal_comparison::Near(/*expected=*/*reference_result,
+                                  /*actual=*/*test_result,
+                                  /*error=*/error_spec,
+                                  /*detailed_message=*/false,
+                                  /*miscompare_callback=*/nullptr);
+}
+
 }  // namespace
 
 absl::Status RunAndCompare(
@@ -544,6 +764,51 @@ absl::Status RunAndCompare(
       reference_module_modifier_hook, config_modifier_hook);
 }
 
+absl::StatusOr<RunHloModuleBatchSummary> RunAndCompareBatch(
+    absl::Span<const std::string> hlo_filenames,
+    HloRunnerInterface* test_runner, HloRunnerInterface* reference_runner,
+    const RunHloModuleOptions& options, int num_threads,
+    std::function<absl::Status(const HloModule&, HloRunnerInterface*,
+                               HloModule*)>
+        reference_module_modifier_hook) {
+  if (options.isolate_instructions ||
+      options.use_buffer_assignment_from_proto ||
+      !options.input_literals_file.empty() ||
+      !options.output_literals_file.empty()) {
+    return InvalidArgument(
+        "Batch mode does not support isolating instructions, buffer "
+        "assignment protos or literal files.");
+  }
+  if (num_threads < 1) {
+    return InvalidArgument("Batch mode needs at least one thread, got %d.",
+                           num_threads);
+  }
+  BatchState state;
+  state.test_runner = test_runner;
+  state.reference_runner = reference_runner;
+  state.options = &options;
+  state.reference_module_modifier_hook =
+      std::move(reference_module_modifier_hook);
+
+  RunHloModuleBatchSummary summary;
+  for (const std::string& hlo_filename : hlo_filenames) {
+    summary.add_modules()->set_path(hlo_filename);
+  }
+  {
+    tsl::thread::ThreadPool thread_pool(tsl::Env::Default(), "run_hlo_module",
+                                        num_threads);
+    for (RunHloModuleBatchEntry& entry : *summary.mutable_modules()) {
+      thread_pool.Schedule([&state, &entry] {
+        std::cerr << "Running " << entry.path() << "...\n";
+        absl::Status status = RunBatchModule(entry.path(), state, entry);
+        entry.set_status(status.ToString());
+        std::cerr << entry.path() << ": " << entry.status() << "\n";
+      });
+    }
+  }
+  return summary;
+}
+
 void ReadInputLiteralsFromFile(const std::string& file_path,
                                RunHloModuleLiterals* input_literals_proto) {
   if (!tsl::ReadTextOrBinaryProto(tsl::Env::Default(), file_path,
@@ -22,6 +22,8 @@ limitations under the License.
 #include <string>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xla/hlo/ir/hlo_module.h"
 #include "xla/service/hlo_runner.h"
 #include "xla/tools/run_hlo_module.pb.h"
@@ -92,6 +94,29 @@ absl::Status RunAndCompare(
                                HloModule& module)>
         compilation_env_modifier_hook = {});
 
+// Runs every module in 'hlo_filenames' once on 'test_runner' and, if
+// 'reference_runner' is non-null, on 'reference_runner', and compares the
+// results. Up to 'num_threads' modules are processed at a time, and the test
+// and reference executables of a module are compiled concurrently. Executions
+// on each runner are serialized, which keeps the measured run times
+// meaningful.
+//
+// Arguments are always generated with MakeFakeArguments, from a seed derived
+// from the module fingerprint, and are reused for modules with the same
+// fingerprint. Failures of individual modules are reported in the summary.
+// Isolating instructions, buffer assignment protos and input or output
+// literal files are not supported in this mode.
+//
+// 'reference_module_modifier_hook' is applied as in RunAndCompare, but may be
+// called from several threads at once.
+absl::StatusOr<RunHloModuleBatchSummary> RunAndCompareBatch(
+    absl::Span<const std::string> hlo_filenames,
+    HloRunnerInterface* test_runner, HloRunnerInterface* reference_runner,
+    const RunHloModuleOptions& options, int num_threads,
+    std::function<absl::Status(const HloModule&, HloRunnerInterface*,
+                               HloModule*)>
+        reference_module_modifier_hook = {});
+
 // Read the input literals from 'file_path'. The file can be either a binary
 // proto or a text proto. If it doesn't contain a RunHloModuleLiterals proto, it
 // will fallback to reading a RunHloModuleIterationLiterals proto and use that
@@ -25,6 +25,8 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -34,11 +36,15 @@ limitations under the License.
 #include "xla/service/hlo_runner.h"
 #include "xla/service/platform_util.h"
 #include "xla/tools/run_hlo_module.h"
+#include "xla/tools/run_hlo_module.pb.h"
 #include "xla/translate/mhlo_to_hlo/translate.h"
 #include "xla/translate/stablehlo_to_hlo/translate.h"
 #include "xla/tsl/util/command_line_flags.h"
+#include "tsl/platform/env.h"
 #include "tsl/platform/init_main.h"
 #include "tsl/platform/logging.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/protobuf.h"
 #include "tsl/platform/status.h"
 #include "tsl/platform/test.h"
 
@@ -66,6 +72,13 @@ Usage:
 Multiple files can be run as well:
 
   bazel run run_hlo_module -- --platform=[CPU|CUDA|Interpreter] /path/*.hlo
+
+Large numbers of modules, e.g. a directory of dumps, can be run in batch mode,
+which processes several modules at a time and writes a JSON summary:
+
+  bazel run run_hlo_module -- --platform=[CPU|CUDA|Interpreter] \
+    --input_dir=/path/to/modules --batch_threads=8 \
+    --batch_summary_file=/tmp/summary.json
 )";
 const char kInterpreterPlatformName[] = "Interpreter";
 
@@ -87,6 +100,9 @@ std::string GetReferencePlatformName(std::string reference_platform) {
 int main(int argc, char** argv) {
   xla::RunHloModuleOptions opts;
   bool different_random_seeds = false;
+  std::string input_dir;
+  int batch_threads = 0;
+  std::string batch_summary_file;
   std::vector<tsl::Flag> flag_list = {
       tsl::Flag("platform", &opts.platform,
                 "The test platform that the HLO module will be executed on "
@@ -155,6 +171,18 @@ int main(int argc, char** argv) {
       tsl::Flag("different_random_seeds", &different_random_seeds,
                 "Whether each iteration should use a different random seed for "
                 "the HloModuleConfig."),
+      tsl::Flag("input_dir", &input_dir,
+                "Also run every file in this directory, in addition to the "
+                "files given on the command line."),
+      tsl::Flag("batch_threads", &batch_threads,
+                "If positive, run in batch mode: process this many modules at "
+                "a time, compile the test and reference modules of each "
+                "concurrently, and run every module once. Arguments are "
+                "generated from the module fingerprint and shared by modules "
+                "with the same fingerprint."),
+      tsl::Flag("batch_summary_file", &batch_summary_file,
+                "In batch mode, write a JSON summary with the compile time, "
+                "run time, max error and status of each module to this file."),
   };
   xla::AppendDebugOptionsFlags(&flag_list);
   // The usage string includes the message at the top of the file, the
@@ -185,11 +213,52 @@ int main(int argc, char** argv) {
       reference_platform ? std::make_unique<xla::HloRunner>(reference_platform)
                          : nullptr;
 
-  QCHECK(argc > 1) << "Input HLO file missing.";
+  std::vector<std::string> hlo_filenames(argv + 1, argv + argc);
+  if (!input_dir.empty()) {
+    std::vector<std::string> children;
+    TF_QCHECK_OK(tsl::Env::Default()->GetChildren(input_dir, &children));
+    absl::c_sort(children);
+    for (const std::string& child : children) {
+      std::string path = tsl::io::JoinPath(input_dir, child);
+      if (!tsl::Env::Default()->IsDirectory(path).ok()) {
+        hlo_filenames.push_back(std::move(path));
+      }
+    }
+  }
+  QCHECK(!hlo_filenames.empty()) << "Input HLO file missing.";
+
+  if (batch_threads > 0) {
+    QCHECK(opts.input_format != "stablehlo" && opts.input_format != "mhlo")
+        << "Batch mode does not support " << opts.input_format << " input.";
+    absl::StatusOr<xla::RunHloModuleBatchSummary> summary =
+        xla::RunAndCompareBatch(hlo_filenames, &test_runner,
+                                reference_runner.get(), opts, batch_threads);
+    TF_QCHECK_OK(summary.status());
+    int batch_failure_count = 0;
+    for (const xla::RunHloModuleBatchEntry& entry : summary->modules()) {
+      if (entry.status() != "OK") {
+        ++batch_failure_count;
+      }
+    }
+    std::cerr << batch_failure_count << "/" << summary->modules_size()
+              << " modules failed.\n";
+    if (!batch_summary_file.empty()) {
+      std::string json;
+      tsl::protobuf::util::JsonPrintOptions json_options;
+      json_options.add_whitespace = true;
+      json_options.always_print_primitive_fields = true;
+      QCHECK(tsl::protobuf::util::MessageToJsonString(*summary, &json,
+                                                      json_options)
+                 .ok());
+      TF_QCHECK_OK(tsl::WriteStringToFile(tsl::Env::Default(),
+                                          batch_summary_file, json));
+    }
+    return batch_failure_count == 0 ? 0 : -1;
+  }
 
   int failure_count = 0;
-  for (int c = 1; c < argc; c++) {
-    const char* hlo_filename = argv[c];
+  for (const std::string& filename : hlo_filenames) {
+    const char* hlo_filename = filename.c_str();
     std::cout << "\n ** Running " << hlo_filename << "** \n";
 
     if (opts.input_format == "stablehlo" || opts.input_format == "mhlo") {
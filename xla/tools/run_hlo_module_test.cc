@@ -16,13 +16,18 @@ limitations under the License.
 #include "xla/tools/run_hlo_module.h"
 
 #include <string>
+#include <vector>
 
 #include "xla/literal.h"
 #include "xla/literal_util.h"
+#include "xla/service/hlo_runner.h"
+#include "xla/service/platform_util.h"
 #include "xla/tools/run_hlo_module.pb.h"
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "xla/xla_data.pb.h"
 #include "tsl/platform/env.h"
+#include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
 #include "tsl/platform/test.h"
 
 namespace xla {
@@ -90,5 +95,64 @@ TEST(ReadInputLiteralsFromFile, ReadRunHloModuleIterationLiteralsTextProto) {
             proto.SerializeAsString());
 }
 
+TEST(RunAndCompareBatch, RunsModulesAndSharesArguments) {
+  constexpr char kModule[] = R"(
+    HloModule m
+
+    ENTRY e {
+      p = f32[8] parameter(0)
+      ROOT r = f32[8] add(p, p)
+    })";
+  auto env = tsl::Env::Default();
+  const std::string dir = tsl::io::JoinPath(tsl::testing::TmpDir(), "batch");
+  TF_ASSERT_OK(env->RecursivelyCreateDir(dir));
+  const std::vector<std::string> paths = {tsl::io::JoinPath(dir, "a.hlo"),
+                                          tsl::io::JoinPath(dir, "b.hlo")};
+  for (const std::string& path : paths) {
+    TF_ASSERT_OK(tsl::WriteStringToFile(env, path, kModule));
+  }
+
+  TF_ASSERT_OK_AND_ASSIGN(auto* platform,
+                          PlatformUtil::GetPlatform("Interpreter"));
+  HloRunner test_runner(platform);
+  HloRunner reference_runner(platform);
+  RunHloModuleOptions options;
+  options.platform = "Interpreter";
+  TF_ASSERT_OK_AND_ASSIGN(
+      RunHloModuleBatchSummary summary,
+      RunAndCompareBatch(paths, &test_runner, &reference_runner, options,
+                         /*num_threads=*/1));
+  ASSERT_EQ(summary.modules_size(), 2);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(summary.modules(i).path(), paths[i]);
+    EXPECT_EQ(summary.modules(i).status(), "OK");
+    EXPECT_EQ(summary.modules(i).max_abs_error(), 0);
+  }
+  EXPECT_EQ(summary.modules(0).fingerprint(), summary.modules(1).fingerprint());
+  EXPECT_FALSE(summary.modules(0).arguments_from_cache());
+  EXPECT_TRUE(summary.modules(1).arguments_from_cache());
+}
+
+TEST(RunAndCompareBatch, ReportsFailuresPerModule) {
+  TF_ASSERT_OK_AND_ASSIGN(auto* platform,
+                          PlatformUtil::GetPlatform("Interpreter"));
+  HloRunner test_runner(platform);
+  RunHloModuleOptions options;
+  options.platform = "Interpreter";
+  const std::vector<std::string> paths = {
+      tsl::io::JoinPath(tsl::testing::TmpDir(), "does_not_exist.hlo")};
+  TF_ASSERT_OK_AND_ASSIGN(
+      RunHloModuleBatchSummary summary,
+      RunAndCompareBatch(paths, &test_runner, /*reference_runner=*/nullptr,
+                         options, /*num_threads=*/2));
+  ASSERT_EQ(summary.modules_size(), 1);
+  EXPECT_NE(summary.modules(0).status(), "OK");
+
+  options.isolate_instructions = true;
+  EXPECT_FALSE(RunAndCompareBatch(paths, &test_runner, nullptr, options,
+                                  /*num_threads=*/1)
+                   .ok());
+}
+
 }  // namespace
 }  // namespace xla
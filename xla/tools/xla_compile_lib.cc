@@ -16,6 +16,7 @@ limitations under the License.
 #include "xla/tools/xla_compile_lib.h"
 
 #include <cmath>
+#include <iostream>
 #include <memory>
 #include <optional>
 #include <string>
@@ -43,6 +44,7 @@ limitations under the License.
 #include "xla/hlo/ir/hlo_module_group.h"
 #include "xla/mlir_hlo/mhlo/IR/hlo_ops.h"
 #include "xla/pjrt/mlir_to_hlo.h"
+#include "xla/service/compile_profiler.h"
 #include "xla/service/compiler.h"
 #include "xla/service/cpu/cpu_compiler.h"
 #include "xla/service/cpu/cpu_executable.h"
@@ -358,8 +360,16 @@ absl::Status XlaCompileMain(const XlaCompileOptions& options) {
               : std::make_optional(*std::move(target_config));
 #endif
   }
+  // Record the passes run by the compiler, so that they can be reported in
+  // the result file.
+  CompileProfiler profiler(hlo_module->name());
   auto result = CompileExecutable(std::move(hlo_module), backend,
                                   std::move(cfg), compilation_result);
+  *compilation_result.mutable_compile_profile() = profiler.ToProto();
+  if (options.print_top_passes > 0) {
+    std::cout << FormatTopPasses(compilation_result.compile_profile(),
+                                 options.print_top_passes);
+  }
   *compilation_result.mutable_status() = tsl::StatusToProto(result.status());
   if (!result.ok()) {
     return result.status();
@@ -59,6 +59,8 @@ struct XlaCompileOptions {
   std::string output_path;
   std::string platform;
   std::string result_output_file;
+  // If positive, how many of the slowest HLO passes to print.
+  int print_top_passes = 0;
 
   // Options for SymbolRepository lookup.
   struct SymbolRepoOptions {